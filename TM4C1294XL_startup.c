@@ -14,6 +14,8 @@
 
 #include <stdint.h>
 
+#include "boot_prof.h"
+
 /* User entry point (heartbeat/main) */
 extern void main(void);
 
@@ -23,6 +25,7 @@ void ICDIUARTIntHandler(void);
 void USERUARTIntHandler(void);
 void SysTickIntHandler(void);
 void GPIOMIntHandler(void);
+void PendSVIntHandler(void);
 
 
 /* Standard handlers (prototypes) */
@@ -40,6 +43,14 @@ extern unsigned long _end_data;
 extern unsigned long _start_bss;
 extern unsigned long _end_bss;
 
+/* The build is hard-float (-mfloat-abi=hard): the FPU must be on before any
+   FP instruction, or it UsageFaults. CPACR grants CP10/CP11; FPCCR keeps
+   automatic and lazy FP state stacking on for ISRs. */
+#define SCB_CPACR   (*((volatile unsigned long *)0xE000ED88))
+#define FPU_FPCCR   (*((volatile unsigned long *)0xE000EF34))
+#define FPCCR_ASPEN 0x80000000UL
+#define FPCCR_LSPEN 0x40000000UL
+
 /* NVIC vector table placed at start of flash (copied verbatim from your file) */
 __attribute__ ((section(".nvic_table")))
 void(* myvectors[])(void) = {
@@ -59,7 +70,7 @@ void(* myvectors[])(void) = {
     empty_def_handler,      // SV call                   11
     empty_def_handler,      // Debug monitor             12
     0,                      // Reserved                  13
-    empty_def_handler,      // PendSV                    14
+    PendSVIntHandler,       // PendSV                    14
     SysTickIntHandler,      // SysTick                   15
 
     /* Peripheral interrupts start here. */
@@ -183,6 +194,14 @@ void rst_handler(void)
     unsigned long *src = &_end_text;    /* load address for .data (in flash) */
     unsigned long *dest = &_start_data; /* runtime address in RAM */
 
+    /* Boot profile time 0 (cycle counter; no RAM used) */
+    boot_prof_start();
+
+    /* FPU on (full access to CP10 and CP11) */
+    SCB_CPACR |= (0xFUL << 20);
+    FPU_FPCCR |= FPCCR_ASPEN | FPCCR_LSPEN;
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+
     /* Copy initialized data from flash to RAM */
     while (dest < &_end_data) {
         *dest++ = *src++;
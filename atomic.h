@@ -0,0 +1,86 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include <stdint.h>
+
+/*
+ * Lock-free word operations for state shared between interrupt handlers
+ * and the main context (Cortex-M4, LDREX/STREX).
+ *
+ * An aligned 32-bit load or store is already single-copy atomic; what
+ * atomic_load_u32()/atomic_store_u32() add is the barrier that orders it
+ * against the surrounding accesses. Read-modify-write operations retry
+ * until STREX succeeds: any exception taken between LDREX and STREX clears
+ * the exclusive monitor, so an interrupt that touches the word in between
+ * makes the interrupted side start over instead of losing an update. No
+ * interrupt is ever masked.
+ *
+ * For state that spans several words use seqlock.h.
+ */
+
+static inline void atomic_barrier(void)
+{
+    __asm__ volatile ("dmb" ::: "memory");
+}
+
+static inline uint32_t atomic_load_u32(const volatile uint32_t *p)
+{
+    uint32_t v = *p;
+    atomic_barrier();
+    return v;
+}
+
+static inline void atomic_store_u32(volatile uint32_t *p, uint32_t v)
+{
+    atomic_barrier();
+    *p = v;
+}
+
+/* Store v, return the previous value (e.g. take-and-clear a counter). */
+static inline uint32_t atomic_xchg_u32(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t old;
+    uint32_t failed;
+
+    do {
+        __asm__ volatile ("ldrex %0, [%1]" : "=r" (old) : "r" (p) : "memory");
+        __asm__ volatile ("strex %0, %2, [%1]" : "=&r" (failed) : "r" (p), "r" (v) : "memory");
+    } while (failed != 0U);
+
+    atomic_barrier();
+    return old;
+}
+
+/* Add v, return the new value. */
+static inline uint32_t atomic_add_u32(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t val;
+    uint32_t failed;
+
+    do {
+        __asm__ volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (p) : "memory");
+        val += v;
+        __asm__ volatile ("strex %0, %2, [%1]" : "=&r" (failed) : "r" (p), "r" (val) : "memory");
+    } while (failed != 0U);
+
+    atomic_barrier();
+    return val;
+}
+
+/* Set the bits of v, return the new value. */
+static inline uint32_t atomic_or_u32(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t val;
+    uint32_t failed;
+
+    do {
+        __asm__ volatile ("ldrex %0, [%1]" : "=r" (val) : "r" (p) : "memory");
+        val |= v;
+        __asm__ volatile ("strex %0, %2, [%1]" : "=&r" (failed) : "r" (p), "r" (val) : "memory");
+    } while (failed != 0U);
+
+    atomic_barrier();
+    return val;
+}
+
+#endif /* ATOMIC_H */
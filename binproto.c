@@ -0,0 +1,61 @@
+#include "binproto.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crc.h"
+
+bool binproto_begin(binproto_dump_t *d, const cmd_out_t *out)
+{
+    if (!out || !out->write) {
+        return false;
+    }
+    d->out = out;
+    d->seq = 0;
+    d->frames = 0;
+    d->records = 0;
+    return true;
+}
+
+void binproto_frame(binproto_dump_t *d, uint8_t type, const void *payload,
+                    uint16_t len, uint32_t records)
+{
+    uint8_t hdr[6];
+    uint8_t tail[2];
+    uint32_t crc;
+
+    if (len > BINPROTO_MAX_PAYLOAD) {
+        len = BINPROTO_MAX_PAYLOAD;
+    }
+
+    hdr[0] = BINPROTO_SYNC0;
+    hdr[1] = BINPROTO_SYNC1;
+    hdr[2] = type;
+    hdr[3] = d->seq++;
+    (void)binproto_put_u16(&hdr[4], len);
+
+    /* CRC over type, seq, len and the payload. */
+    crc = crc_calc(CRC_ALG_CRC16_MODBUS, &hdr[2], 4U);
+    crc = crc_continue(CRC_ALG_CRC16_MODBUS, crc, payload, len);
+    (void)binproto_put_u16(tail, (uint16_t)crc);
+
+    d->out->write(d->out->ctx, hdr, sizeof(hdr));
+    if (len != 0U) {
+        d->out->write(d->out->ctx, payload, len);
+    }
+    d->out->write(d->out->ctx, tail, sizeof(tail));
+
+    d->frames++;
+    d->records += records;
+}
+
+void binproto_end(binproto_dump_t *d, uint8_t type)
+{
+    uint8_t p[9];
+    uint8_t *w = p;
+
+    *w++ = type;
+    w = binproto_put_u32(w, d->frames);
+    w = binproto_put_u32(w, d->records);
+    binproto_frame(d, BP_TYPE_END, p, (uint16_t)(w - p), 0U);
+}
@@ -0,0 +1,64 @@
+#ifndef BINPROTO_H
+#define BINPROTO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "commands.h"   /* cmd_out_t */
+
+/*
+ * Framed binary output for dumps that are too large or too lossy as text
+ * (HISTORY ... BIN). A dump is a run of frames on the console that asked
+ * for it, terminated by a BP_TYPE_END frame, then the usual prompt:
+ *
+ *   'B' 'P' type seq len_lo len_hi payload[len] crc_lo crc_hi
+ *
+ * seq counts frames within the dump (mod 256), so a host can spot a lost
+ * frame; crc is CRC-16/MODBUS over type..payload. All payload integers are
+ * little-endian. tools/binproto.py reads and decodes dumps.
+ */
+#define BINPROTO_SYNC0          0x42U   /* 'B' */
+#define BINPROTO_SYNC1          0x50U   /* 'P' */
+#define BINPROTO_MAX_PAYLOAD    512U
+
+typedef enum {
+    BP_TYPE_RRD = 0x01,     /* rrd.c archive rows */
+    BP_TYPE_FLOG = 0x02,    /* flashlog.c raw blocks */
+    BP_TYPE_END = 0x7F,     /* u8 dumped type, u32 frames, u32 records */
+} binproto_type_t;
+
+typedef struct {
+    const cmd_out_t *out;
+    uint8_t seq;
+    uint32_t frames;
+    uint32_t records;
+} binproto_dump_t;
+
+/* False if the sink cannot carry binary (out->write is NULL). */
+bool binproto_begin(binproto_dump_t *d, const cmd_out_t *out);
+
+/* One frame of `records` records; len <= BINPROTO_MAX_PAYLOAD. */
+void binproto_frame(binproto_dump_t *d, uint8_t type, const void *payload,
+                    uint16_t len, uint32_t records);
+
+/* BP_TYPE_END frame with the totals. */
+void binproto_end(binproto_dump_t *d, uint8_t type);
+
+/* Little-endian writers for payload builders. */
+static inline uint8_t *binproto_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *binproto_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+#endif /* BINPROTO_H */
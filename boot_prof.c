@@ -0,0 +1,68 @@
+#include "boot_prof.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_types.h"
+
+/* Data Watchpoint and Trace cycle counter (core debug registers). */
+#define DEMCR               0xE000EDFCU
+#define DEMCR_TRCENA        0x01000000U
+#define DWT_CTRL            0xE0001000U
+#define DWT_CYCCNT          0xE0001004U
+#define DWT_CTRL_CYCCNTENA  0x00000001U
+
+/* Reset clock (PIOSC) until the PLL takes over. */
+#define BOOT_PIOSC_MHZ      16U
+
+static uint32_t g_cyc[BOOT_PH_COUNT];
+static uint32_t g_marked;           /* bit per phase */
+static uint32_t g_sysclk_mhz;
+
+static const char *const g_names[BOOT_PH_COUNT] = {
+    "main", "clock", "pwm", "uarts", "io", "state", "net", "ready",
+};
+
+void boot_prof_start(void)
+{
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+void boot_prof_mark(boot_phase_t ph)
+{
+    if (ph < BOOT_PH_COUNT) {
+        g_cyc[ph] = HWREG(DWT_CYCCNT);
+        g_marked |= 1UL << ph;
+    }
+}
+
+void boot_prof_mark_clock(uint32_t sysclk_hz)
+{
+    g_sysclk_mhz = sysclk_hz / 1000000U;
+    boot_prof_mark(BOOT_PH_CLOCK);
+}
+
+/*
+ * The PLL switch happens at the end of setup_system_clock(), so the whole
+ * call is counted at PIOSC speed.
+ */
+uint32_t boot_prof_us(boot_phase_t ph)
+{
+    uint32_t cyc_clock = g_cyc[BOOT_PH_CLOCK];
+
+    if (ph >= BOOT_PH_COUNT || (g_marked & (1UL << ph)) == 0U) {
+        return 0;
+    }
+    if ((g_marked & (1UL << BOOT_PH_CLOCK)) == 0U || g_sysclk_mhz == 0U ||
+        g_cyc[ph] <= cyc_clock) {
+        return g_cyc[ph] / BOOT_PIOSC_MHZ;
+    }
+    return cyc_clock / BOOT_PIOSC_MHZ + (g_cyc[ph] - cyc_clock) / g_sysclk_mhz;
+}
+
+const char *boot_prof_name(boot_phase_t ph)
+{
+    return (ph < BOOT_PH_COUNT) ? g_names[ph] : "?";
+}
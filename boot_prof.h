@@ -0,0 +1,46 @@
+#ifndef BOOT_PROF_H
+#define BOOT_PROF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Boot-time profile: DWT cycle counter timestamps for each init phase,
+ * counted from the first instruction of rst_handler(). Phases before
+ * BOOT_PH_CLOCK run on PIOSC (16 MHz), later ones on the PLL clock.
+ *
+ * With BOOTLOADER=1 the time spent in the bootloader is not included.
+ */
+
+/* PWM output valid (PF2 at its first duty) this long after reset, at most. */
+#ifndef BOOT_PWM_TARGET_US
+#define BOOT_PWM_TARGET_US  5000U
+#endif
+
+typedef enum {
+    BOOT_PH_MAIN = 0,   /* .data/.bss initialised, main() entered */
+    BOOT_PH_CLOCK,      /* PLL running (setup_system_clock) */
+    BOOT_PH_PWM,        /* PF2 PWM at its first duty */
+    BOOT_PH_UARTS,      /* consoles configured, interrupts on */
+    BOOT_PH_IO,         /* timebase, tach capture, TSYN */
+    BOOT_PH_STATE,      /* retained state, CRC self-test, EEPROM, Modbus */
+    BOOT_PH_NET,        /* Ethernet/lwIP (NET=1 builds) */
+    BOOT_PH_READY,      /* main loop entered */
+    BOOT_PH_COUNT
+} boot_phase_t;
+
+/* First statement of rst_handler(): starts the cycle counter at 0. Touches
+   only core registers, so it may run before .data/.bss are set up. */
+void boot_prof_start(void);
+
+void boot_prof_mark(boot_phase_t ph);
+
+/* Marks BOOT_PH_CLOCK; later stamps are converted at sysclk_hz. */
+void boot_prof_mark_clock(uint32_t sysclk_hz);
+
+/* Microseconds from reset to the phase mark; 0 if not reached (yet). */
+uint32_t boot_prof_us(boot_phase_t ph);
+
+const char *boot_prof_name(boot_phase_t ph);
+
+#endif /* BOOT_PROF_H */
@@ -0,0 +1,194 @@
+/*
+ * bootloader.c - installs a staged firmware update, then starts the application.
+ *
+ * Lives in the first flash sector (FLASH_BOOT_BASE); the application is
+ * linked behind it at FLASH_APP_BASE (make BOOTLOADER=1). The application
+ * receives updates over UART3 into the staging region (fwupdate.c); this
+ * code only has to move a verified image into place, so it needs no UART,
+ * no clock setup and no interrupts.
+ *
+ * On every reset:
+ *   1. If the metadata sector says an image is ready and not yet installed,
+ *      check it again (CRC-32 and vector table), copy it over the
+ *      application, check the copy and record FWUP_INSTALLED. A staged image
+ *      that fails its check is recorded as FWUP_REJECTED and the current
+ *      application is kept. If the copy itself fails BL_COPY_ATTEMPTS
+ *      times, nothing is recorded: the application region holds a partial
+ *      copy, so it is not started. LED D1 (PN1) blinks fast; the next reset
+ *      copies again from the intact staged image.
+ *   2. Start the application if its vector table looks sane; otherwise blink
+ *      LED D1 slowly forever - reflash over ICDI.
+ *
+ * A reset during the copy leaves the update pending (READY, not INSTALLED),
+ * so step 1 runs again before anything is started.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "driverlib/flash.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+
+#include "crc.h"
+#include "flash_layout.h"
+#include "fwupdate.h"
+
+#define BL_COPY_ATTEMPTS    3U
+
+/* Linker symbols (bootloader.ld). */
+extern unsigned long _stack_top;
+extern unsigned long _end_text;
+extern unsigned long _start_data;
+extern unsigned long _end_data;
+extern unsigned long _start_bss;
+extern unsigned long _end_bss;
+
+void bl_reset(void);
+static void bl_fault(void);
+
+/* Only the core vectors: the bootloader never enables an interrupt. */
+__attribute__ ((section(".nvic_table")))
+void (* const g_bl_vectors[])(void) = {
+    (void (*)(void))&_stack_top,
+    bl_reset,
+    bl_fault,               /* NMI */
+    bl_fault,               /* HardFault */
+    bl_fault,               /* MemManage */
+    bl_fault,               /* BusFault */
+    bl_fault,               /* UsageFault */
+};
+
+/* One block at a time through SRAM (FlashProgram() source). */
+static uint32_t g_copy[FWUP_BLOCK_SIZE / 4U];
+
+static bool program_word(const volatile uint32_t *dst, uint32_t value)
+{
+    return FlashProgram(&value, (uint32_t)dst, sizeof(value)) == 0 && *dst == value;
+}
+
+static bool update_pending(const fwup_meta_t *m)
+{
+    return m->magic == FWUP_META_MAGIC &&
+           m->check == crc_calc(CRC_ALG_CRC32, m, 3U * sizeof(uint32_t)) &&
+           m->ready == FWUP_READY && m->installed == FWUP_ERASED &&
+           m->size != 0U && m->size <= FWUP_MAX_IMAGE;
+}
+
+static bool staged_ok(const fwup_meta_t *m)
+{
+    return crc_calc(CRC_ALG_CRC32, (const void *)FLASH_FWSTAGE_BASE, m->size) == m->crc &&
+           fwup_vectors_ok((const uint32_t *)FLASH_FWSTAGE_BASE);
+}
+
+/* Staging -> application; true if the copy reads back with the image CRC. */
+static bool copy_image(const fwup_meta_t *m)
+{
+    uint32_t off, n;
+
+    for (off = 0; off < m->size; off += FWUP_BLOCK_SIZE) {
+        if ((off % FLASH_SECTOR_SIZE) == 0U && FlashErase(FLASH_APP_BASE + off) != 0) {
+            return false;
+        }
+
+        /* The staged tail is padded with 0xFF to whole words. */
+        n = m->size - off;
+        if (n > FWUP_BLOCK_SIZE) n = FWUP_BLOCK_SIZE;
+        n = (n + 3U) & ~3U;
+
+        memcpy(g_copy, (const void *)(FLASH_FWSTAGE_BASE + off), n);
+        if (FlashProgram(g_copy, FLASH_APP_BASE + off, n) != 0) {
+            return false;
+        }
+    }
+
+    return crc_calc(CRC_ALG_CRC32, (const void *)FLASH_APP_BASE, m->size) == m->crc;
+}
+
+/* False if the application region is left with an incomplete copy. */
+static bool install_update(void)
+{
+    const fwup_meta_t *m = FWUP_META;
+    uint32_t attempt;
+
+    if (!update_pending(m)) {
+        return true;
+    }
+
+    if (!staged_ok(m)) {
+        program_word(&m->installed, FWUP_REJECTED);
+        return true;
+    }
+
+    for (attempt = 0; attempt < BL_COPY_ATTEMPTS; attempt++) {
+        if (copy_image(m)) {
+            program_word(&m->installed, FWUP_INSTALLED);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void start_app(void)
+{
+    const uint32_t *vec = (const uint32_t *)FLASH_APP_BASE;
+
+    HWREG(NVIC_VTABLE) = FLASH_APP_BASE;
+    __asm volatile ("msr msp, %0\n\t"
+                    "bx  %1\n\t"
+                    : : "r" (vec[0]), "r" (vec[1]));
+}
+
+/* Blink LED D1 (PN1) forever, delay loops per half period. */
+static void blink_forever(uint32_t half)
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPION);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPION)) {
+    }
+    GPIOPinTypeGPIOOutput(GPIO_PORTN_BASE, GPIO_PIN_1);
+
+    for (;;) {
+        GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_1, GPIO_PIN_1);
+        SysCtlDelay(half);
+        GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_1, 0);
+        SysCtlDelay(half);
+    }
+}
+
+static void bl_main(void)
+{
+    /* Runs from PIOSC (16 MHz); SysCtlDelay() takes 3 cycles per loop. */
+    if (!install_update()) {
+        blink_forever(16000000U / 3U / 32U);        /* ~16 Hz: install failed */
+    }
+
+    if (fwup_vectors_ok((const uint32_t *)FLASH_APP_BASE)) {
+        start_app();
+    }
+    blink_forever(16000000U / 24U);                 /* ~4 Hz: no application */
+}
+
+void bl_reset(void)
+{
+    unsigned long *src = &_end_text;
+    unsigned long *dest = &_start_data;
+
+    while (dest < &_end_data) {
+        *dest++ = *src++;
+    }
+    dest = &_start_bss;
+    while (dest < &_end_bss) {
+        *dest++ = 0;
+    }
+
+    bl_main();
+}
+
+static void bl_fault(void)
+{
+    while (1) {}
+}
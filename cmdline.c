@@ -1,271 +1,144 @@
 /*
- * cmdline.c - Tiva UART3 command-line module (fixed includes / externs)
+ * cmdline.c - UART output for the command line
  *
- * Drop this file into the project (replace previous cmdline.c).
- * After adding to the Makefile, rebuild.
+ * UARTSend() queues output for UART0 (ICDI) or UART3 (USER) in a TX ring
+ * per port, drained by that port's interrupt, so a command reply costs the
+ * caller only the copy into the ring; the console protothreads then wait
+ * for uart_tx_idle() without blocking the scheduler. Diagnostics on UART0
+ * use the same ring, so console replies and diagnostics keep their order.
  *
- * Notes:
- * - main.c must expose set_pwm_percent() with external linkage (remove 'static').
- * - If you keep the old USER UART ISR or old process_user_line(), remove them to avoid duplicate symbols.
+ * The earlier polled session loop (cmdline_run_until_disconnect) and its
+ * own PSYN parser were never wired in and have been removed; commands are
+ * parsed by commands.c for every console.
  */
 
-#include "cmdline.h"   
+#include "cmdline.h"
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <ctype.h>
-
-/* Use the project's strtok_compat if present */
-#include "strtok_compat.h"
 
 /* Tiva DriverLib */
+#include "driverlib/interrupt.h"
 #include "driverlib/rom.h"
 #include "driverlib/rom_map.h"
 #include "driverlib/uart.h"
-#include "driverlib/gpio.h"
-#include "driverlib/sysctl.h"
 
 #include "inc/hw_memmap.h"
 
+#include "irq_prio.h"
+#include "sched.h"
 
-void UARTSend(const uint8_t *pui8Buffer, uint32_t ui32Count, UARTDev destUART)
-{
-    while (ui32Count--) {
-        if (destUART == UARTDEV_USER) MAP_UARTCharPut(UART3_BASE, *pui8Buffer++);
-        else MAP_UARTCharPut(UART0_BASE, *pui8Buffer++);
-    }
-}
-
+/* Powers of two. UART0 runs at 9600 baud, so its ring fills sooner. */
+#define UART0_TX_RING_SIZE  1024U
+#define UART3_TX_RING_SIZE  2048U
 
-/* set_pwm_percent must be visible (non-static) in main.c for linking */
-extern void set_pwm_percent(uint32_t percent);
+typedef struct {
+    uint32_t base;
+    uint8_t *buf;
+    uint32_t mask;
+    volatile uint32_t head;     /* written by producers */
+    volatile uint32_t tail;     /* written by tx_fill() */
+} uart_tx_ring_t;
 
-/* Session / prompt state */
-static volatile bool g_session_active = false;
-static volatile bool g_sent_welcome = false;
-static bool last_output_was_prompt = false;
+static uint8_t g_tx0_buf[UART0_TX_RING_SIZE];
+static uint8_t g_tx3_buf[UART3_TX_RING_SIZE];
 
-/* Local line buffer */
-static char linebuf_local[UART_RX_BUF_SIZE];
-static uint32_t linepos = 0;
+static uart_tx_ring_t g_tx[2] = {
+    { UART0_BASE, g_tx0_buf, UART0_TX_RING_SIZE - 1U, 0, 0 },   /* UARTDEV_ICDI */
+    { UART3_BASE, g_tx3_buf, UART3_TX_RING_SIZE - 1U, 0, 0 },   /* UARTDEV_USER */
+};
 
-/* Low-level blocking write helpers to UART3 (USER) */
-static void uart3_putc_blocking(char c)
-{
-    /* blocking put */
-    ROM_UARTCharPut(UART3_BASE, c);
-}
-static void uart3_puts_blocking(const char *s)
+static uart_tx_ring_t *tx_ring(UARTDev dev)
 {
-    while (*s) uart3_putc_blocking(*s++);
+    return &g_tx[(dev == UARTDEV_USER) ? 1 : 0];
 }
 
-/* mark that we just printed non-prompt */
-static void output_puts(const char *s)
+/* Ring -> TX FIFO while there is room. Callers hold off the port's ISR. */
+static void tx_fill(uart_tx_ring_t *r)
 {
-    last_output_was_prompt = false;
-    uart3_puts_blocking(s);
-}
-/*
-static void output_putc(char c)
-{
-    last_output_was_prompt = false;
-    uart3_putc_blocking(c);
-}
-*/
+    while (r->tail != r->head && ROM_UARTSpaceAvail(r->base)) {
+        ROM_UARTCharPutNonBlocking(r->base, r->buf[r->tail & r->mask]);
+        r->tail++;
+    }
 
-/* print prompt once */
-static void prompt_print_once(void)
-{
-    if (!last_output_was_prompt) {
-        uart3_puts_blocking(ANSI_PROMPT);
-        uart3_puts_blocking(PROMPT_SYMBOL);
-        uart3_puts_blocking(ANSI_RESET);
-        last_output_was_prompt = true;
+    if (r->tail != r->head) {
+        ROM_UARTIntEnable(r->base, UART_INT_TX);
+    } else {
+        ROM_UARTIntDisable(r->base, UART_INT_TX);
     }
 }
 
-/* optional hook to update an on-screen live preview (no-op here) */
-static void uart_line_notify_current(const char *cur_line, uint32_t len)
+static void tx_push(uart_tx_ring_t *r, uint8_t c)
 {
-    (void)cur_line;
-    (void)len;
+    /* Full: move bytes into the FIFO by hand. Works with interrupts masked
+       too, at the price of waiting for the line. The line is moving, so a
+       long dump (HISTORY at 9600 baud) is not a hang. */
+    while ((uint32_t)(r->head - r->tail) > r->mask) {
+        tx_fill(r);
+        sched_watchdog_feed();
+    }
+    r->buf[r->head & r->mask] = c;
+    r->head++;
 }
 
-/* welcome and prompt */
-static void send_welcome_and_prompt_once(void)
+void uart_tx_putc(UARTDev dev, uint8_t c)
 {
-    output_puts(ANSI_WELCOME);
-    output_puts("\r\nPWM Ready. Enter command: PSYN n  (n = 5..96)\r\n");
-    last_output_was_prompt = false;
-    prompt_print_once();
+    uart_tx_ring_t *r = tx_ring(dev);
+
+    tx_push(r, c);
+    tx_fill(r);
 }
 
-/* echo a backspace erase sequence */
-static void uart_echo_bs(void)
+void uart_tx_isr(UARTDev dev)
 {
-    ROM_UARTCharPutNonBlocking(UART3_BASE, '\b');
-    ROM_UARTCharPutNonBlocking(UART3_BASE, ' ');
-    ROM_UARTCharPutNonBlocking(UART3_BASE, '\b');
+    tx_fill(tx_ring(dev));
 }
 
-/* Handle a complete line (NUL-terminated). Prints response and prompt. */
-static void handle_line_and_respond(const char *line)
+bool uart_tx_idle(UARTDev dev)
 {
-    if (!line) { prompt_print_once(); return; }
-
-    /* Trim leading whitespace */
-    while (*line && isspace((unsigned char)*line)) line++;
-
-    if (*line == '\0') { prompt_print_once(); return; }
-
-    char copy[UART_RX_BUF_SIZE];
-    strncpy(copy, line, sizeof(copy)-1);
-    copy[sizeof(copy)-1] = '\0';
+    const uart_tx_ring_t *r = tx_ring(dev);
 
-    char *saveptr = NULL;
-    char *tok = strtok_r(copy, " \t", &saveptr);
-    if (!tok) { prompt_print_once(); return; }
-
-    for (char *p = tok; *p; ++p) *p = (char)toupper((unsigned char)*p);
-
-    if (strcmp(tok, "PSYN") == 0) {
-        char *arg = strtok_r(NULL, " \t", &saveptr);
-        if (!arg) {
-            output_puts(ANSI_ERROR);
-            output_puts("\r\nERROR: missing value. Use: PSYN n (5..96)\r\n");
-            output_puts(ANSI_RESET);
-            prompt_print_once();
-            return;
-        }
-        char *endp = NULL;
-        long val = strtol(arg, &endp, 10);
-        if (*endp != '\0') {
-            output_puts(ANSI_ERROR);
-            output_puts("\r\nERROR: invalid number. Use: PSYN n\r\n");
-            output_puts(ANSI_RESET);
-            prompt_print_once();
-            return;
-        }
-        if (val < PSYN_MIN || val > PSYN_MAX) {
-            output_puts(ANSI_ERROR);
-            output_puts("\r\nERROR: value out of range (5..96)\r\n");
-            output_puts(ANSI_RESET);
-            prompt_print_once();
-            return;
-        }
-
-        /* Apply PWM change via external function */
-        set_pwm_percent((uint32_t)val);
-
-        /* Acknowledge using UARTSend so it goes through the project's wrapper */
-        char ack[64];
-        int n = snprintf(ack, sizeof(ack), "\r\nOK: duty set to %ld%%\r\n", val);
-        if (n > 0) UARTSend((const uint8_t *)ack, (uint32_t)n, UARTDEV_USER);
-
-        prompt_print_once();
-        return;
-    }
-
-    /* Unknown command */
-    output_puts(ANSI_ERROR);
-    output_puts("\r\nERROR: unknown command. Use: PSYN n or HELP\r\n");
-    output_puts(ANSI_RESET);
-    prompt_print_once();
+    return r->tail == r->head && !ROM_UARTBusy(r->base);
 }
 
-/* Public API: initialization */
-void cmdline_init(void)
+uint32_t uart_tx_free(UARTDev dev)
 {
-    g_session_active = true;
-    g_sent_welcome = false;
-    last_output_was_prompt = false;
-    linepos = 0;
+    const uart_tx_ring_t *r = tx_ring(dev);
+
+    return (r->mask + 1U) - (uint32_t)(r->head - r->tail);
 }
 
-/* Run the session until DTR disconnect (returns when disconnect detected).
-   This uses UART3 non-blocking reads and returns when GPIO PQ1 indicates session end. */
-void cmdline_run_until_disconnect(void)
+void uart_tx_flush(UARTDev dev)
 {
-    if (!g_sent_welcome) {
-        send_welcome_and_prompt_once();
-        g_sent_welcome = true;
-    }
+    uart_tx_ring_t *r = tx_ring(dev);
+    uint32_t key = irq_lock(IRQ_PRIO_UART);
 
-    for (;;) {
-        /* Exit if DTR indicates disconnect (same polarity used in main) */
-        if (ROM_GPIOPinRead(GPIO_PORTQ_BASE, GPIO_PIN_1)) {
-            /* session ended */
-            return;
-        }
-
-        int ch = ROM_UARTCharGetNonBlocking(UART3_BASE);
-        if (ch != -1) {
-            char c = (char)ch;
+    while (r->tail != r->head) {
+        tx_fill(r);
+    }
+    ROM_UARTIntDisable(r->base, UART_INT_TX);
+    irq_unlock(key);
 
-            /* Toggle PF4 LED on receive (same behavior as original) */
-            static uint8_t led = 0;
-            led = !led;
-            ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, led ? GPIO_PIN_4 : 0);
+    while (ROM_UARTBusy(r->base)) {
+    }
+}
 
-            /* Backspace / DEL */
-            if (c == '\b' || c == 0x7F) {
-                if (linepos > 0) {
-                    linepos--;
-                    uart_echo_bs();
-                    uart_line_notify_current(linebuf_local, linepos);
-                } else {
-                    ROM_UARTCharPutNonBlocking(UART3_BASE, '\a');
-                    last_output_was_prompt = true;
-                }
-                continue;
-            }
 
-            /* Ctrl-U: kill line */
-            if (c == 0x15) {
-                while (linepos > 0) {
-                    linepos--;
-                    uart_echo_bs();
-                }
-                continue;
-            }
+void UARTSend(const uint8_t *pui8Buffer, uint32_t ui32Count, UARTDev destUART)
+{
+    uart_tx_ring_t *r = tx_ring(destUART);
 
-            /* CR / LF */
-            if (c == '\r' || c == '\n') {
-                if (linepos > 0) {
-                    linebuf_local[linepos] = '\0';
-                    ROM_UARTCharPutNonBlocking(UART3_BASE, '\r');
-                    ROM_UARTCharPutNonBlocking(UART3_BASE, '\n');
-                    handle_line_and_respond(linebuf_local);
-                    linepos = 0;
-                } else {
-                    prompt_print_once();
-                }
-                continue;
-            }
+    while (ui32Count) {
+        /* Short critical sections: one FIFO's worth per pass. Only the
+           UART level and below are held off (irq_prio.h). */
+        uint32_t n = (ui32Count > 16U) ? 16U : ui32Count;
+        uint32_t key = irq_lock(IRQ_PRIO_UART);
 
-            /* Printable char: uppercase-as-you-type */
-            if ((unsigned char)c >= 32) {
-                char uc = (char)toupper((unsigned char)c);
-                ROM_UARTCharPutNonBlocking(UART3_BASE, uc);
-                if (linepos + 1 < UART_RX_BUF_SIZE) {
-                    linebuf_local[linepos++] = uc;
-                    uart_line_notify_current(linebuf_local, linepos);
-                } else {
-                    output_puts("\r\n");
-                    output_puts(ANSI_ERROR);
-                    output_puts("ERROR: line too long\r\n");
-                    output_puts(ANSI_RESET);
-                    prompt_print_once();
-                    linepos = 0;
-                }
-            }
-        } else {
-            /* small sleep to avoid busy-waiting */
-            ROM_SysCtlDelay(ROM_SysCtlClockGet() / 3000);
+        ui32Count -= n;
+        while (n--) {
+            tx_push(r, *pui8Buffer++);
         }
+        tx_fill(r);
+        irq_unlock(key);
     }
 }
@@ -31,17 +31,26 @@
 typedef enum { UARTDEV_ICDI = 0, UARTDEV_USER } UARTDev;
 
 
-/* Low-level UART send to any of the active UART channels */
+/* Low-level UART send to any of the active UART channels: queued in the
+   port's TX ring (see below); waits only if the ring is full. */
 void UARTSend(const uint8_t *pui8Buffer, uint32_t ui32Count, UARTDev destUART);
 
+/* Per-port TX rings. */
 
-/* Initialize command-line module (call after setup_uarts() and before entering session) */
-void cmdline_init(void);
+/* Queue one byte from the port's ISR (or with its interrupt masked): echo. */
+void uart_tx_putc(UARTDev dev, uint8_t c);
 
-/* Run the user-session loop until the DTR session is disconnected.
-   This function returns when the session ends (so main can continue outer logic).
-   It handles input on UART3 and outputs to UART3. */
-void cmdline_run_until_disconnect(void);
+/* Refill the TX FIFO; call from the port's UART ISR (UART_INT_TX). */
+void uart_tx_isr(UARTDev dev);
 
-#endif /* CMDLINE_H */
+/* Everything queued has left the shift register. */
+bool uart_tx_idle(UARTDev dev);
+
+/* Bytes UARTSend() can queue without waiting. */
+uint32_t uart_tx_free(UARTDev dev);
 
+/* Drain the ring by polling, e.g. before UART3 is handed over (firmware
+   transfer, Modbus, reset). */
+void uart_tx_flush(UARTDev dev);
+
+#endif /* CMDLINE_H */
@@ -7,18 +7,42 @@
 
 #include "ctype_helpers.h"
 #include "strtok_compat.h"
-#include "ui_uart3.h"
+#include "cmdline.h"
+#include "console.h"
 
+#include "binproto.h"
+#include "boot_prof.h"
+#include "crc.h"
+#include "flashlog.h"
+#include "flash_layout.h"
+#include "fwupdate.h"
+#include "modbus.h"
+#include "retain.h"
+#include "rrd.h"
+#include "sched.h"
+#include "speedctl.h"
+#include "sspwm.h"
+#include "steptest.h"
+#include "sweep.h"
 #include "tach.h"
+#include "timebase.h"
 #include "tsyn.h"
+#include "watch.h"
 
-#ifndef PSYN_MIN
-#define PSYN_MIN 5
-#endif
-#ifndef PSYN_MAX
-#define PSYN_MAX 96
+#ifdef NET_ENABLED
+#include "net_stats.h"
 #endif
 
+static void out_puts(const cmd_out_t *out, const char *s)
+{
+    out->puts(out->ctx, s);
+}
+
+static void out_prompt(const cmd_out_t *out)
+{
+    out->prompt(out->ctx);
+}
+
 static void u32_to_dec(char *out, size_t out_sz, uint32_t value)
 {
     if (!out || out_sz == 0) return;
@@ -38,28 +62,43 @@ static void u32_to_dec(char *out, size_t out_sz, uint32_t value)
     out[pos] = '\0';
 }
 
-static void cmd_help(void)
+static void cmd_help(const cmd_out_t *out)
 {
-    ui_uart3_puts("\r\nAvailable commands:\r\n");
-    ui_uart3_puts("  PSYN n      Set PWM duty (n=5..96)\r\n");
-    ui_uart3_puts("  PSYN ON     Enable PWM on PF2\r\n");
-    ui_uart3_puts("  PSYN OFF    Disable PWM and force PF2 low\r\n");
-    ui_uart3_puts("  TSYN ON     Start TACH synth on PM3 (bursty waveform)\r\n");
-    ui_uart3_puts("  TSYN OFF    Stop TACH synth and restore PM3 input\r\n");
-    ui_uart3_puts("  TACHIN ON   Start printing RPM on UART0 every 0.5s\r\n");
-    ui_uart3_puts("  TACHIN OFF  Stop printing RPM on UART0\r\n");
-    ui_uart3_puts("  HELP        This help\r\n");
-    ui_uart3_puts("  EXIT        Close UART3 session\r\n");
-    ui_uart3_puts("  DEBUG ON    Enable UART0 diagnostics\r\n");
-    ui_uart3_puts("  DEBUG OFF   Disable UART0 diagnostics (default)\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nAvailable commands:\r\n");
+    out_puts(out, "  PSYN n      Set PWM duty (n=5..96)\r\n");
+    out_puts(out, "  PSYN ON     Enable PWM on PF2\r\n");
+    out_puts(out, "  PSYN OFF    Disable PWM and force PF2 low\r\n");
+    out_puts(out, "  RPM         Speed control to an RPM setpoint (n | OFF | MAP [LOAD | CLEAR])\r\n");
+    out_puts(out, "  SSPWM       Spread-spectrum PWM period dither (OFF | TRI [pct] | RAND [pct])\r\n");
+    out_puts(out, "  TSYN ON     Start TACH synth on PM3 (bursty waveform)\r\n");
+    out_puts(out, "  TSYN OFF    Stop TACH synth and restore PM3 input\r\n");
+    out_puts(out, "  TACHIN ON   Start printing RPM on UART0 every 0.5s\r\n");
+    out_puts(out, "  TACHIN OFF  Stop printing RPM on UART0\r\n");
+    out_puts(out, "  TACHBLANK   Drop tach edges right after PF2 switches (ON [ns] | OFF)\r\n");
+    out_puts(out, "  NETSTATS    lwIP pool usage/peaks (SAVE | RESET)\r\n");
+    out_puts(out, "  MODBUS      Modbus RTU status (ON [addr] | OFF | ADDR n)\r\n");
+    out_puts(out, "  CRC         CRC engine status (BENCH [bytes])\r\n");
+    out_puts(out, "  FWUPDATE    Serial firmware update (BEGIN size crc [baud] | APPLY | ABORT)\r\n");
+    out_puts(out, "  RETAIN      State kept across resets (ON | OFF)\r\n");
+    out_puts(out, "  BOOT        Boot phase timestamps since reset\r\n");
+    out_puts(out, "  TASKS       Main loop tasks, CPU load, watchdog\r\n");
+    out_puts(out, "  WATCH [ms]  Live dashboard on this UART (any key stops)\r\n");
+    out_puts(out, "  HISTORY     RPM/duty/rejects/burst history (1S|10S|1M|10M [CSV|BIN] | CLEAR)\r\n");
+    out_puts(out, "  LOG         RPM/duty flash log (ON [ms] | OFF | DUMP | CLEAR)\r\n");
+    out_puts(out, "  SWEEP       Fan duty->RPM/burst sweep (RUN [from to step [max_s]] | TABLE)\r\n");
+    out_puts(out, "  STEP        Fan step response (RUN [from to [reps [hold_s]]])\r\n");
+    out_puts(out, "  HELP        This help\r\n");
+    out_puts(out, "  EXIT        Close this session\r\n");
+    out_puts(out, "  DEBUG ON    Enable UART0 diagnostics\r\n");
+    out_puts(out, "  DEBUG OFF   Disable UART0 diagnostics (default)\r\n");
+    out_prompt(out);
 }
 
-static void cmd_tsyn(const char *arg)
+static void cmd_tsyn(const cmd_out_t *out, const char *arg)
 {
     if (!arg || *arg == '\0') {
-        ui_uart3_puts("\r\nERROR: missing value. Use: TSYN ON | TSYN OFF\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: missing value. Use: TSYN ON | TSYN OFF\r\n");
+        out_prompt(out);
         return;
     }
 
@@ -73,28 +112,28 @@ static void cmd_tsyn(const char *arg)
 
     if (strcmp(mode, "ON") == 0) {
         tsyn_set_enabled(true);
-        ui_uart3_puts("\r\nOK: TSYN ON (PM3 driven; tach capture disabled)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: TSYN ON (PM3 driven; tach capture disabled)\r\n");
+        out_prompt(out);
         return;
     }
 
     if (strcmp(mode, "OFF") == 0) {
         tsyn_set_enabled(false);
-        ui_uart3_puts("\r\nOK: TSYN OFF (PM3 restored to tach input)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: TSYN OFF (PM3 restored to tach input)\r\n");
+        out_prompt(out);
         return;
     }
 
-    ui_uart3_puts("\r\nERROR: invalid value. Use: TSYN ON | TSYN OFF\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nERROR: invalid value. Use: TSYN ON | TSYN OFF\r\n");
+    out_prompt(out);
 }
 
-static void cmd_tachin(const char *arg)
+static void cmd_tachin(const cmd_out_t *out, const char *arg)
 {
     if (!arg || *arg == '\0') {
         tach_set_reporting(true);
-        ui_uart3_puts("\r\nOK: TACHIN ON (printing RPM on UART0)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: TACHIN ON (printing RPM on UART0)\r\n");
+        out_prompt(out);
         return;
     }
 
@@ -108,40 +147,41 @@ static void cmd_tachin(const char *arg)
 
     if (strcmp(mode, "ON") == 0) {
         tach_set_reporting(true);
-        ui_uart3_puts("\r\nOK: TACHIN ON (printing RPM on UART0)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: TACHIN ON (printing RPM on UART0)\r\n");
+        out_prompt(out);
         return;
     }
 
     if (strcmp(mode, "OFF") == 0) {
         tach_set_reporting(false);
-        ui_uart3_puts("\r\nOK: TACHIN OFF\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: TACHIN OFF\r\n");
+        out_prompt(out);
         return;
     }
 
-    ui_uart3_puts("\r\nERROR: invalid value. Use: TACHIN ON | TACHIN OFF\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nERROR: invalid value. Use: TACHIN ON | TACHIN OFF\r\n");
+    out_prompt(out);
 }
 
-static void cmd_exit(const char *arg)
+static void cmd_exit(const cmd_out_t *out, const char *arg)
 {
     if (arg && *arg != '\0') {
-        ui_uart3_puts("\r\nERROR: EXIT takes no arguments\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: EXIT takes no arguments\r\n");
+        out_prompt(out);
         return;
     }
 
-    ui_uart3_puts("\r\nClosing session...\r\n");
-    uart3_request_disconnect();
-    /* No prompt here; session will close and UART0 will emit disconnect diagnostics. */
+    out_puts(out, "\r\nClosing session...\r\n");
+    /* No prompt here; the sink closes its session (for UART3, UART0 will emit
+       disconnect diagnostics). */
+    out->close(out->ctx);
 }
 
-static void cmd_debug(const char *arg)
+static void cmd_debug(const cmd_out_t *out, const char *arg)
 {
     if (!arg || *arg == '\0') {
-        ui_uart3_puts("\r\nERROR: missing value. Use: DEBUG ON | DEBUG OFF\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: missing value. Use: DEBUG ON | DEBUG OFF\r\n");
+        out_prompt(out);
         return;
     }
 
@@ -155,27 +195,27 @@ static void cmd_debug(const char *arg)
 
     if (strcmp(mode, "ON") == 0) {
         debug_set_enabled(true);
-        ui_uart3_puts("\r\nOK: DEBUG ON\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: DEBUG ON\r\n");
+        out_prompt(out);
         return;
     }
 
     if (strcmp(mode, "OFF") == 0) {
         debug_set_enabled(false);
-        ui_uart3_puts("\r\nOK: DEBUG OFF\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: DEBUG OFF\r\n");
+        out_prompt(out);
         return;
     }
 
-    ui_uart3_puts("\r\nERROR: invalid value. Use: DEBUG ON | DEBUG OFF\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nERROR: invalid value. Use: DEBUG ON | DEBUG OFF\r\n");
+    out_prompt(out);
 }
 
-static void cmd_psyn(const char *arg)
+static void cmd_psyn(const cmd_out_t *out, const char *arg)
 {
     if (!arg || *arg == '\0') {
-        ui_uart3_puts("\r\nERROR: missing value. Use: PSYN n | PSYN ON | PSYN OFF\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: missing value. Use: PSYN n | PSYN ON | PSYN OFF\r\n");
+        out_prompt(out);
         return;
     }
 
@@ -188,33 +228,37 @@ static void cmd_psyn(const char *arg)
     }
     mode[mi] = '\0';
 
+    /* A manual duty or PWM state ends RPM control. */
     if (strcmp(mode, "OFF") == 0) {
+        speedctl_set_rpm(0);
         pwm_set_enabled(false);
-        ui_uart3_puts("\r\nOK: PWM OFF (PF2 forced low)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: PWM OFF (PF2 forced low)\r\n");
+        out_prompt(out);
         return;
     }
     if (strcmp(mode, "ON") == 0) {
+        speedctl_set_rpm(0);
         pwm_set_enabled(true);
-        ui_uart3_puts("\r\nOK: PWM ON\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nOK: PWM ON\r\n");
+        out_prompt(out);
         return;
     }
 
     char *endptr = NULL;
     long val = strtol(arg, &endptr, 10);
     if (!endptr || *endptr != '\0') {
-        ui_uart3_puts("\r\nERROR: invalid number. Use: PSYN n\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: invalid number. Use: PSYN n\r\n");
+        out_prompt(out);
         return;
     }
 
     if (val < PSYN_MIN || val > PSYN_MAX) {
-        ui_uart3_puts("\r\nERROR: value out of range (5..96)\r\n");
-        ui_uart3_prompt_once();
+        out_puts(out, "\r\nERROR: value out of range (5..96)\r\n");
+        out_prompt(out);
         return;
     }
 
+    speedctl_set_rpm(0);
     pwm_set_percent((uint32_t)val);
     /* If PWM was previously disabled for scope/debug, numeric PSYN turns it back on. */
     if (!pwm_is_enabled()) {
@@ -224,22 +268,1309 @@ static void cmd_psyn(const char *arg)
     /* Avoid snprintf (newlib stalls were previously observed). */
     char num[11];
     u32_to_dec(num, sizeof(num), (uint32_t)val);
-    ui_uart3_puts("\r\nOK: duty set to ");
-    ui_uart3_puts(num);
-    ui_uart3_puts("%\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nOK: duty set to ");
+    out_puts(out, num);
+    out_puts(out, "%\r\n");
+    out_prompt(out);
 }
 
-void commands_process_line(const char *line)
+/* Right-aligned decimal column (value wider than the column is not cut). */
+static void out_col_u32(const cmd_out_t *out, uint32_t value, size_t width)
+{
+    char num[11];
+    char pad[12];
+    size_t len;
+    size_t i = 0;
+
+    u32_to_dec(num, sizeof(num), value);
+    len = strlen(num);
+    while (len + i < width && i + 1 < sizeof(pad)) {
+        pad[i++] = ' ';
+    }
+    pad[i] = '\0';
+    out_puts(out, pad);
+    out_puts(out, num);
+}
+
+#ifdef NET_ENABLED
+
+static void out_proto_line(const cmd_out_t *out, const char *name, const net_proto_stat_t *p)
+{
+    char num[11];
+
+    out_puts(out, name);
+    out_puts(out, " rx=");
+    u32_to_dec(num, sizeof(num), p->rx);
+    out_puts(out, num);
+    out_puts(out, " tx=");
+    u32_to_dec(num, sizeof(num), p->tx);
+    out_puts(out, num);
+    out_puts(out, " drop=");
+    u32_to_dec(num, sizeof(num), p->drop);
+    out_puts(out, num);
+    out_puts(out, " memerr=");
+    u32_to_dec(num, sizeof(num), p->memerr);
+    out_puts(out, num);
+    out_puts(out, "\r\n");
+}
+#endif
+
+static void cmd_netstats(const cmd_out_t *out, const char *arg)
+{
+#ifdef NET_ENABLED
+    char mode[8];
+    size_t i = 0;
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "SAVE") == 0) {
+        out_puts(out, net_stats_save() ? "\r\nOK: peaks saved\r\n"
+                                       : "\r\nERROR: config store unavailable or busy\r\n");
+        out_prompt(out);
+        return;
+    }
+    if (strcmp(mode, "RESET") == 0) {
+        net_stats_reset();
+        out_puts(out, "\r\nOK: NETSTATS peaks, errors and saved record cleared\r\n");
+        out_prompt(out);
+        return;
+    }
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: NETSTATS | NETSTATS SAVE | NETSTATS RESET\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    net_stats_t st;
+    net_stats_get(&st);
+
+    out_puts(out, "\r\nPOOL          USED   MAX  PEAK  SIZE   ERR  ERR(all)\r\n");
+    for (uint32_t p = 0; p < NET_POOL_COUNT; p++) {
+        const char *name = net_stats_pool_name((net_pool_t)p);
+        size_t n = strlen(name);
+
+        out_puts(out, name);
+        while (n++ < 10U) out_puts(out, " ");
+        out_col_u32(out, st.pool[p].used, 6);
+        out_col_u32(out, st.pool[p].max, 6);
+        out_col_u32(out, st.pool[p].peak, 6);
+        out_col_u32(out, st.pool[p].size, 6);
+        out_col_u32(out, st.pool[p].err, 6);
+        out_col_u32(out, st.pool[p].err_total, 10);
+        out_puts(out, (st.pool[p].peak >= st.pool[p].size && st.pool[p].size != 0U)
+                      ? "  FULL\r\n" : "\r\n");
+    }
+    out_proto_line(out, "LINK", &st.link);
+    out_proto_line(out, "TCP ", &st.tcp);
+
+    char num[11];
+    out_puts(out, "Saved records: ");
+    u32_to_dec(num, sizeof(num), st.saves);
+    out_puts(out, num);
+    out_puts(out, " (PEAK/ERR(all) include earlier boots)\r\n");
+    if (st.proxy_overflows != 0U) {
+        out_puts(out, "Proxy requests too long (not sent): ");
+        u32_to_dec(num, sizeof(num), st.proxy_overflows);
+        out_puts(out, num);
+        out_puts(out, "\r\n");
+    }
+#else
+    (void)arg;
+    out_puts(out, "\r\nERROR: network support not built (make NET=1)\r\n");
+#endif
+    out_prompt(out);
+}
+
+static void out_u32(const cmd_out_t *out, const char *label, uint32_t value)
+{
+    char num[11];
+
+    out_puts(out, label);
+    u32_to_dec(num, sizeof(num), value);
+    out_puts(out, num);
+}
+
+static bool parse_modbus_addr(const char *arg, uint8_t *addr)
+{
+    char *endptr = NULL;
+    long val;
+
+    if (!arg || *arg == '\0') return false;
+    val = strtol(arg, &endptr, 10);
+    if (!endptr || *endptr != '\0' || val < 1 || val > 247) return false;
+    *addr = (uint8_t)val;
+    return true;
+}
+
+static void cmd_modbus(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    char mode[8];
+    size_t i = 0;
+    uint8_t addr;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "ON") == 0) {
+        if (arg2) {
+            if (!parse_modbus_addr(arg2, &addr)) {
+                out_puts(out, "\r\nERROR: address out of range (1..247)\r\n");
+                out_prompt(out);
+                return;
+            }
+            modbus_set_address(addr);
+        }
+        out_u32(out, "\r\nOK: MODBUS ON, UART3 is now an RTU slave at address ", modbus_get_address());
+        out_puts(out, "\r\n(return with MODBUS OFF on another console, or 0 -> holding register 5)\r\n");
+        out_prompt(out);
+        /* Last: on UART3 this reply must leave before the port changes hands. */
+        modbus_set_enabled(true);
+        return;
+    }
+
+    if (strcmp(mode, "OFF") == 0) {
+        modbus_set_enabled(false);
+        out_puts(out, "\r\nOK: MODBUS OFF, UART3 console restored\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "ADDR") == 0) {
+        if (!parse_modbus_addr(arg2, &addr)) {
+            out_puts(out, "\r\nERROR: invalid address. Use: MODBUS ADDR n  (n=1..247)\r\n");
+            out_prompt(out);
+            return;
+        }
+        modbus_set_address(addr);
+        out_u32(out, "\r\nOK: Modbus address ", addr);
+        out_puts(out, "\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: MODBUS | MODBUS ON [addr] | MODBUS OFF | MODBUS ADDR n\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    modbus_stats_t st;
+    modbus_get_stats(&st);
+
+    out_puts(out, modbus_is_enabled() ? "\r\nMODBUS ON" : "\r\nMODBUS OFF");
+    out_u32(out, " addr=", modbus_get_address());
+    out_u32(out, " rpm_setpoint=", modbus_get_rpm_setpoint());
+    out_u32(out, "\r\nframes=", st.frames);
+    out_u32(out, " foreign=", st.foreign);
+    out_u32(out, " crc_errors=", st.crc_errors);
+    out_u32(out, " bad=", st.bad_frames);
+    out_u32(out, " exceptions=", st.exceptions);
+    out_u32(out, "\r\nturnaround=", st.turnaround_us);
+    out_u32(out, "us max=", st.turnaround_max_us);
+    out_puts(out, "us\r\n");
+    out_prompt(out);
+}
+
+#ifndef CRC_BENCH_DEFAULT_BYTES
+#define CRC_BENCH_DEFAULT_BYTES 16384U
+#endif
+#define CRC_BENCH_MAX_BYTES 65536U
+
+/* Benchmark source: the application image, past the vector table. */
+#define CRC_BENCH_SRC (FLASH_APP_BASE + 0x400U)
+
+static uint32_t crc_bench_us(crc_alg_t alg, crc_path_t path, uint32_t len, uint32_t *crc)
+{
+    uint32_t cycles_per_us = timebase_sysclk_hz() / 1000000U;
+    uint32_t t0 = timebase_cycles32();
+
+    *crc = crc_continue_path(alg, path, 0, (const void *)CRC_BENCH_SRC, len);
+    if (cycles_per_us == 0) cycles_per_us = 1;
+    return (timebase_cycles32() - t0) / cycles_per_us;
+}
+
+static void cmd_crc(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    char mode[8];
+    size_t i = 0;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (mode[0] == '\0') {
+        out_puts(out, "\r\n");
+        for (uint32_t a = 0; a < CRC_ALG_COUNT; a++) {
+            out_puts(out, crc_alg_name((crc_alg_t)a));
+            out_puts(out, crc_hw_active((crc_alg_t)a) ? ": CCM0 engine\r\n"
+                                                      : ": software (engine failed self-test)\r\n");
+        }
+        out_puts(out, crc_dma_active() ? "uDMA feed: on\r\n" : "uDMA feed: off\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "BENCH") != 0) {
+        out_puts(out, "\r\nERROR: invalid value. Use: CRC | CRC BENCH [bytes]\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    uint32_t len = CRC_BENCH_DEFAULT_BYTES;
+    if (arg2) {
+        char *endptr = NULL;
+        long val = strtol(arg2, &endptr, 10);
+        if (!endptr || *endptr != '\0' || val < 16 || val > (long)CRC_BENCH_MAX_BYTES) {
+            out_puts(out, "\r\nERROR: bytes out of range (16..65536)\r\n");
+            out_prompt(out);
+            return;
+        }
+        len = (uint32_t)val;
+    }
+
+    out_u32(out, "\r\nCRC BENCH ", len);
+    out_puts(out, " bytes of flash, time in us\r\nALG              SW   ENGINE    uDMA  MATCH\r\n");
+    for (uint32_t a = 0; a < CRC_ALG_COUNT; a++) {
+        const char *name = crc_alg_name((crc_alg_t)a);
+        size_t n = strlen(name);
+        uint32_t sw, cpu, dma;
+        uint32_t t_sw = crc_bench_us((crc_alg_t)a, CRC_PATH_SW, len, &sw);
+        uint32_t t_cpu = crc_bench_us((crc_alg_t)a, CRC_PATH_HW_CPU, len, &cpu);
+        uint32_t t_dma = crc_bench_us((crc_alg_t)a, CRC_PATH_HW_DMA, len, &dma);
+
+        out_puts(out, name);
+        while (n++ < 12U) out_puts(out, " ");
+        out_col_u32(out, t_sw, 8);
+        if (crc_hw_active((crc_alg_t)a)) {
+            out_col_u32(out, t_cpu, 9);
+        } else {
+            out_puts(out, "        -");
+        }
+        if (crc_hw_active((crc_alg_t)a) && crc_dma_active()) {
+            out_col_u32(out, t_dma, 8);
+        } else {
+            out_puts(out, "       -");
+        }
+        out_puts(out, (sw == cpu && sw == dma) ? "  yes\r\n" : "  NO\r\n");
+    }
+    out_prompt(out);
+}
+
+static void cmd_retain(const cmd_out_t *out, const char *arg)
+{
+    retain_state_t st;
+    char mode[8];
+    size_t i = 0;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "ON") == 0 || strcmp(mode, "OFF") == 0) {
+        retain_set_enabled(mode[1] == 'N');
+        out_puts(out, mode[1] == 'N' ? "\r\nOK: RETAIN ON\r\n"
+                                     : "\r\nOK: RETAIN OFF (next reset starts at defaults)\r\n");
+        out_prompt(out);
+        return;
+    }
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: RETAIN [ON | OFF]\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_puts(out, retain_is_enabled() ? "\r\nRETAIN: on" : "\r\nRETAIN: off");
+    if (retain_get_saved(&st)) {
+        out_u32(out, "\r\n  saved: duty ", st.duty_pct);
+        out_puts(out, st.pwm_enabled ? "%, PWM on" : "%, PWM off");
+        out_puts(out, st.tsyn_enabled ? ", TSYN on" : ", TSYN off");
+        out_u32(out, ", TSYN profile ", st.tsyn_profile);
+    } else {
+        out_puts(out, "\r\n  saved: none");
+    }
+    out_u32(out, "\r\n  last boot: duty applied ", boot_prof_us(BOOT_PH_PWM));
+    out_puts(out, retain_was_restored() ? " us after reset (restored)\r\n"
+                                        : " us after reset (defaults)\r\n");
+    out_prompt(out);
+}
+
+static void cmd_boot(const cmd_out_t *out, const char *arg)
+{
+    uint32_t prev = 0;
+    uint32_t pwm_us = boot_prof_us(BOOT_PH_PWM);
+
+    if (arg && *arg != '\0') {
+        out_puts(out, "\r\nERROR: BOOT takes no arguments\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_puts(out, "\r\nBOOT phase      us  +us (since reset)\r\n");
+    for (uint32_t ph = 0; ph < BOOT_PH_COUNT; ph++) {
+        uint32_t us = boot_prof_us((boot_phase_t)ph);
+        const char *name = boot_prof_name((boot_phase_t)ph);
+        size_t len = strlen(name);
+
+        if (us == 0U) {
+            continue;       /* phase not in this build */
+        }
+        out_puts(out, "  ");
+        out_puts(out, name);
+        while (len++ < 8U) {
+            out_puts(out, " ");
+        }
+        out_col_u32(out, us, 8U);
+        out_col_u32(out, us - prev, 7U);
+        out_puts(out, "\r\n");
+        prev = us;
+    }
+    out_u32(out, "PWM valid after ", pwm_us);
+    out_u32(out, " us (target ", BOOT_PWM_TARGET_US);
+    out_puts(out, pwm_us <= BOOT_PWM_TARGET_US ? " us, met)\r\n" : " us, MISSED)\r\n");
+    out_prompt(out);
+}
+
+static void cmd_tasks(const cmd_out_t *out, const char *arg)
+{
+    sched_task_info_t t;
+
+    if (arg && *arg != '\0') {
+        out_puts(out, "\r\nERROR: TASKS takes no arguments\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_u32(out, "\r\nCPU load ", sched_cpu_load_pct());
+    out_puts(out, "% (last 1 s)");
+    if (SCHED_WDOG_MS > 0U) {
+        out_u32(out, ", watchdog ", SCHED_WDOG_MS);
+        out_puts(out, " ms");
+    } else {
+        out_puts(out, ", watchdog off");
+    }
+    out_puts(out, sched_watchdog_caused_reset() ? ", last reset by watchdog\r\n" : "\r\n");
+
+    out_puts(out, "  task     period ms       runs  last us   max us\r\n");
+    for (uint32_t i = 0; sched_get_task(i, &t); i++) {
+        size_t len = strlen(t.name);
+
+        out_puts(out, "  ");
+        out_puts(out, t.name);
+        while (len++ < 8U) {
+            out_puts(out, " ");
+        }
+        out_col_u32(out, t.period_ms, 10U);
+        out_col_u32(out, t.runs, 11U);
+        out_col_u32(out, t.last_us, 9U);
+        out_col_u32(out, t.max_us, 9U);
+        out_puts(out, "\r\n");
+    }
+    out_prompt(out);
+}
+
+/* "," + decimal at line[pos]; returns the new length. */
+static size_t csv_put_u32(char *line, size_t pos, size_t size, uint32_t value, bool comma)
+{
+    if (comma && pos + 1 < size) {
+        line[pos++] = ',';
+    }
+    u32_to_dec(&line[pos], size - pos, value);
+    return pos + strlen(&line[pos]);
+}
+
+static void history_csv(const cmd_out_t *out, rrd_res_t res)
+{
+    rrd_cell_t cells[RRD_M_COUNT];
+    uint32_t n = rrd_count(res);
+    uint32_t secs = rrd_res_seconds(res);
+    char line[128];
+
+    out_puts(out, "\r\nago_s");
+    for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+        const char *name = rrd_metric_name((rrd_metric_t)m);
+
+        out_puts(out, ",");
+        out_puts(out, name);
+        out_puts(out, "_min,");
+        out_puts(out, name);
+        out_puts(out, "_max,");
+        out_puts(out, name);
+        out_puts(out, "_avg");
+    }
+    out_puts(out, "\r\n");
+
+    /* Oldest first; ago_s counts back from the newest closed bucket. */
+    for (uint32_t i = 0; rrd_get(res, i, cells); i++) {
+        size_t pos = csv_put_u32(line, 0, sizeof(line), (n - 1U - i) * secs, false);
+
+        for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+            pos = csv_put_u32(line, pos, sizeof(line), cells[m].min, true);
+            pos = csv_put_u32(line, pos, sizeof(line), cells[m].max, true);
+            pos = csv_put_u32(line, pos, sizeof(line), cells[m].avg, true);
+        }
+        if (pos + 3 <= sizeof(line)) {
+            memcpy(&line[pos], "\r\n", 3);
+        }
+        out_puts(out, line);
+    }
+}
+
+/* BP_TYPE_RRD payload: u8 res, u8 metrics, u16 seconds, u16 first index,
+   u16 rows, then per row and metric u16 min, max, avg. */
+#define HISTORY_BIN_ROWS    16U
+
+static void history_bin(binproto_dump_t *d, rrd_res_t res)
+{
+    uint8_t p[8U + HISTORY_BIN_ROWS * RRD_M_COUNT * 6U];
+    rrd_cell_t cells[RRD_M_COUNT];
+    uint32_t n = rrd_count(res);
+
+    for (uint32_t first = 0; first < n; first += HISTORY_BIN_ROWS) {
+        uint32_t rows = (n - first > HISTORY_BIN_ROWS) ? HISTORY_BIN_ROWS : n - first;
+        uint8_t *w = p;
+
+        *w++ = (uint8_t)res;
+        *w++ = (uint8_t)RRD_M_COUNT;
+        w = binproto_put_u16(w, (uint16_t)rrd_res_seconds(res));
+        w = binproto_put_u16(w, (uint16_t)first);
+        w = binproto_put_u16(w, (uint16_t)rows);
+        for (uint32_t r = 0; r < rows && rrd_get(res, first + r, cells); r++) {
+            for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+                w = binproto_put_u16(w, cells[m].min);
+                w = binproto_put_u16(w, cells[m].max);
+                w = binproto_put_u16(w, cells[m].avg);
+            }
+        }
+        binproto_frame(d, BP_TYPE_RRD, p, (uint16_t)(w - p), rows);
+    }
+    binproto_end(d, BP_TYPE_RRD);
+}
+
+static void cmd_history(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    char mode[8];
+    char fmt[8];
+    size_t i = 0;
+    uint32_t res;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+    i = 0;
+    while (arg2 && arg2[i] && i + 1 < sizeof(fmt)) {
+        fmt[i] = (char)my_toupper((unsigned char)arg2[i]);
+        i++;
+    }
+    fmt[i] = '\0';
+
+    if (mode[0] == '\0') {
+        out_puts(out, "\r\nHISTORY  res  buckets     span s\r\n");
+        for (res = 0; res < RRD_RES_COUNT; res++) {
+            size_t len = strlen(rrd_res_name((rrd_res_t)res));
+
+            out_puts(out, "  ");
+            out_puts(out, rrd_res_name((rrd_res_t)res));
+            while (len++ < 9U) {
+                out_puts(out, " ");
+            }
+            out_col_u32(out, rrd_count((rrd_res_t)res), 4U);
+            out_puts(out, "/");
+            out_u32(out, "", rrd_capacity((rrd_res_t)res));
+            out_col_u32(out, rrd_count((rrd_res_t)res) * rrd_res_seconds((rrd_res_t)res), 8U);
+            out_puts(out, "\r\n");
+        }
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "CLEAR") == 0) {
+        rrd_clear();
+        out_puts(out, "\r\nOK: history cleared\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    for (res = 0; res < RRD_RES_COUNT; res++) {
+        if (strcmp(mode, rrd_res_name((rrd_res_t)res)) == 0) break;
+    }
+    if (res == RRD_RES_COUNT || (fmt[0] != '\0' && strcmp(fmt, "CSV") != 0 && strcmp(fmt, "BIN") != 0)) {
+        out_puts(out, "\r\nERROR: invalid value. Use: HISTORY [1S|10S|1M|10M [CSV|BIN] | CLEAR]\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(fmt, "BIN") == 0) {
+        binproto_dump_t d;
+
+        if (!binproto_begin(&d, out)) {
+            out_puts(out, "\r\nERROR: binary output needs a UART console\r\n");
+            out_prompt(out);
+            return;
+        }
+        out_puts(out, "\r\n");
+        history_bin(&d, (rrd_res_t)res);
+        out_puts(out, "\r\n");
+    } else {
+        history_csv(out, (rrd_res_t)res);
+    }
+    out_prompt(out);
+}
+
+/* The UART console behind a sink; NULL for the TCP console. */
+static console_t *out_console(const cmd_out_t *out)
+{
+    if (out == &g_console_uart3.out) {
+        return &g_console_uart3;
+    }
+    if (out == &g_console_uart0.out) {
+        return &g_console_uart0;
+    }
+    return NULL;
+}
+
+static void cmd_log(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    char mode[8];
+    size_t i = 0;
+    flashlog_stats_t st;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "ON") == 0) {
+        uint32_t ms = 0;
+
+        if (arg2) {
+            char *endptr = NULL;
+            long val = strtol(arg2, &endptr, 10);
+
+            if (!endptr || *endptr != '\0' || val < (long)FLASHLOG_MIN_MS || val > (long)FLASHLOG_MAX_MS) {
+                out_puts(out, "\r\nERROR: invalid value. Use: LOG ON [ms] (100..60000)\r\n");
+                out_prompt(out);
+                return;
+            }
+            ms = (uint32_t)val;
+        }
+        flashlog_set_enabled(true, ms);
+        flashlog_get_stats(&st);
+        out_u32(out, "\r\nOK: LOG ON, one sample every ", st.period_ms);
+        out_puts(out, " ms\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "OFF") == 0) {
+        flashlog_set_enabled(false, 0);
+        out_puts(out, "\r\nOK: LOG OFF\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "CLEAR") == 0) {
+        flashlog_clear();
+        out_puts(out, "\r\nOK: erasing the log in the background\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "DUMP") == 0) {
+        console_t *c = out_console(out);
+
+        if (!c) {
+            out_puts(out, "\r\nERROR: LOG DUMP needs a UART console\r\n");
+            out_prompt(out);
+            return;
+        }
+        if (!flashlog_dump_start(c)) {
+            out_puts(out, "\r\nERROR: a LOG DUMP is already running\r\n");
+            out_prompt(out);
+            return;
+        }
+        /* No prompt: flashlog_task() sends the frames, then the prompt. */
+        return;
+    }
+
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: LOG | LOG ON [ms] | LOG OFF | LOG DUMP | LOG CLEAR\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    flashlog_get_stats(&st);
+    out_puts(out, st.enabled ? "\r\nLOG ON" : "\r\nLOG OFF");
+    out_u32(out, " period_ms=", st.period_ms);
+    if (st.clearing) {
+        out_puts(out, " (clearing)");
+    }
+    if (st.dumping) {
+        out_puts(out, " (dump running)");
+    }
+    if (st.seq == 0xFFFFFFFFU) {
+        out_puts(out, "\r\n  empty");
+    } else {
+        out_u32(out, "\r\n  sector seq=", st.seq);
+        out_u32(out, " block=", st.block);
+        out_u32(out, "/", FLASH_SECTOR_SIZE / 32U);
+    }
+    out_u32(out, " of ", st.sectors);
+    out_puts(out, " sectors");
+    out_u32(out, "\r\n  since boot: samples=", st.samples);
+    out_u32(out, " bytes=", st.bytes);
+    out_u32(out, " dropped=", st.dropped);
+    out_u32(out, " erases=", st.erases);
+    if (st.erase_held) {
+        out_puts(out, " (erase held: control running)");
+    }
+    out_u32(out, "\r\n  last dump blocks=", st.dumped_blocks);
+    out_puts(out, "\r\n");
+    out_prompt(out);
+}
+
+static void cmd_watch(const cmd_out_t *out, const char *arg)
+{
+    console_t *c = out_console(out);
+    uint32_t ms = WATCH_DEFAULT_MS;
+
+    if (!c) {
+        out_puts(out, "\r\nERROR: WATCH needs a UART console (ANSI terminal)\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (arg && *arg != '\0') {
+        char *endptr = NULL;
+        long val = strtol(arg, &endptr, 10);
+
+        if (!endptr || *endptr != '\0' || val < (long)WATCH_MIN_MS || val > 10000L) {
+            out_puts(out, "\r\nERROR: invalid value. Use: WATCH [ms] (20..10000)\r\n");
+            out_prompt(out);
+            return;
+        }
+        ms = (uint32_t)val;
+    }
+
+    if (!watch_start(c, ms)) {
+        out_puts(out, "\r\nERROR: WATCH is running on the other console\r\n");
+        out_prompt(out);
+        return;
+    }
+    /* No prompt: the dashboard takes the screen until a key is pressed. */
+}
+
+static void sweep_table_row(const cmd_out_t *out, const sweep_point_t *p, bool ff)
+{
+    out_u32(out, "    { ", p->duty);
+    if (ff) {
+        out_u32(out, ", ", p->rpm);
+    } else {
+        out_u32(out, ", ", p->pulses_per_burst);
+        out_u32(out, ", ", p->tail_us);
+    }
+    out_puts(out, p->timeout ? " },  /* not settled */\r\n" : " },\r\n");
+}
+
+static void cmd_sweep(const cmd_out_t *out, char *const args[5])
+{
+    static const uint32_t defaults[4] = {
+        SWEEP_DEFAULT_FROM, SWEEP_DEFAULT_TO, SWEEP_DEFAULT_STEP, SWEEP_DEFAULT_MAX_S,
+    };
+    sweep_point_t p;
+    char mode[8];
+    size_t i = 0;
+
+    while (args[0] && args[0][i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)args[0][i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "RUN") == 0) {
+        console_t *c = out_console(out);
+        uint32_t v[4];
+        sweep_err_t err;
+
+        /* from, to and step come together; max_s only after them. */
+        bool bad = (args[1] && !args[3]);
+
+        for (int a = 0; a < 4; a++) {
+            char *endptr = NULL;
+            long val;
+
+            v[a] = defaults[a];
+            if (!args[a + 1]) continue;
+            val = strtol(args[a + 1], &endptr, 10);
+            if (bad || !endptr || *endptr != '\0' || val < 1L) {
+                out_puts(out, "\r\nERROR: invalid value. Use: SWEEP RUN [from to step [max_s]]\r\n");
+                out_prompt(out);
+                return;
+            }
+            v[a] = (uint32_t)val;
+        }
+
+        if (!c) {
+            out_puts(out, "\r\nERROR: SWEEP RUN needs a UART console\r\n");
+            out_prompt(out);
+            return;
+        }
+        err = sweep_start(c, v[0], v[1], v[2], v[3]);
+        if (err == SWEEP_ERR_BUSY) {
+            out_puts(out, "\r\nERROR: a SWEEP or STEP is already running\r\n");
+        } else if (err == SWEEP_ERR_TSYN) {
+            out_puts(out, "\r\nERROR: TSYN drives the tach pin; TSYN OFF first\r\n");
+        } else if (err == SWEEP_ERR_RANGE) {
+            out_puts(out, "\r\nERROR: value out of range (duty 5..96, at most 32 points, max_s 1..600)\r\n");
+        } else {
+            /* No prompt: sweep_task() prints each point, then the prompt. */
+            return;
+        }
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "TABLE") == 0) {
+        if (sweep_count() == 0U) {
+            out_puts(out, "\r\nSWEEP: no results (SWEEP RUN first)\r\n");
+            out_prompt(out);
+            return;
+        }
+        out_puts(out, "\r\n/* tsyn.c g_points: { psyn_n, pulses_per_burst, tail_us_mid } */\r\n");
+        for (uint32_t n = 0; sweep_get(n, &p); n++) {
+            sweep_table_row(out, &p, false);
+        }
+        out_puts(out, "/* feed-forward: { psyn_n, rpm } */\r\n");
+        for (uint32_t n = 0; sweep_get(n, &p); n++) {
+            sweep_table_row(out, &p, true);
+        }
+        out_prompt(out);
+        return;
+    }
+
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: SWEEP | SWEEP RUN [from to step [max_s]] | SWEEP TABLE\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_puts(out, sweep_is_running() ? "\r\nSWEEP running" : "\r\nSWEEP idle");
+    out_u32(out, ", points=", sweep_count());
+    out_puts(out, "\r\n");
+    if (sweep_count() != 0U) {
+        char row[SWEEP_ROW_MAX];
+
+        out_puts(out, sweep_header());
+        for (uint32_t n = 0; sweep_get(n, &p); n++) {
+            sweep_format_row(row, &p);
+            out_puts(out, row);
+        }
+    }
+    out_prompt(out);
+}
+
+static void cmd_step(const cmd_out_t *out, char *const args[5])
+{
+    static const uint32_t defaults[4] = {
+        STEP_DEFAULT_FROM, STEP_DEFAULT_TO, STEP_DEFAULT_REPS, STEP_DEFAULT_HOLD_S,
+    };
+    step_result_t r, mn, mean, mx;
+    char row[STEP_ROW_MAX];
+    char num[11];
+    char mode[8];
+    size_t i = 0;
+
+    while (args[0] && args[0][i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)args[0][i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "RUN") == 0) {
+        console_t *c = out_console(out);
+        uint32_t v[4];
+        step_err_t err;
+        /* from and to come together; reps and hold_s only after them. */
+        bool bad = (args[1] && !args[2]);
+
+        for (int a = 0; a < 4; a++) {
+            char *endptr = NULL;
+            long val;
+
+            v[a] = defaults[a];
+            if (!args[a + 1]) continue;
+            val = strtol(args[a + 1], &endptr, 10);
+            if (bad || !endptr || *endptr != '\0' || val < 1L) {
+                out_puts(out, "\r\nERROR: invalid value. Use: STEP RUN [from to [reps [hold_s]]]\r\n");
+                out_prompt(out);
+                return;
+            }
+            v[a] = (uint32_t)val;
+        }
+
+        if (!c) {
+            out_puts(out, "\r\nERROR: STEP RUN needs a UART console\r\n");
+            out_prompt(out);
+            return;
+        }
+        err = steptest_start(c, v[0], v[1], v[2], v[3]);
+        if (err == STEP_ERR_BUSY) {
+            out_puts(out, "\r\nERROR: a SWEEP or STEP is already running\r\n");
+        } else if (err == STEP_ERR_TSYN) {
+            out_puts(out, "\r\nERROR: TSYN drives the tach pin; TSYN OFF first\r\n");
+        } else if (err == STEP_ERR_RANGE) {
+            out_puts(out, "\r\nERROR: value out of range (duty 5..96 and from != to, reps 1..20, hold_s 2..10)\r\n");
+        } else {
+            /* No prompt: steptest_task() prints each repetition, then the prompt. */
+            return;
+        }
+        out_prompt(out);
+        return;
+    }
+
+    if (mode[0] != '\0') {
+        out_puts(out, "\r\nERROR: invalid value. Use: STEP | STEP RUN [from to [reps [hold_s]]]\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_puts(out, steptest_is_running() ? "\r\nSTEP running" : "\r\nSTEP idle");
+    out_u32(out, ", repetitions=", steptest_count());
+    out_puts(out, "\r\n");
+    if (steptest_count() != 0U) {
+        out_puts(out, steptest_header());
+        for (uint32_t n = 0; steptest_get(n, &r); n++) {
+            u32_to_dec(num, sizeof(num), n + 1U);
+            steptest_format_row(row, num, &r);
+            out_puts(out, row);
+        }
+        if (steptest_summary(&mn, &mean, &mx)) {
+            steptest_format_row(row, "min", &mn);
+            out_puts(out, row);
+            steptest_format_row(row, "mean", &mean);
+            out_puts(out, row);
+            steptest_format_row(row, "max", &mx);
+            out_puts(out, row);
+        }
+    }
+    out_prompt(out);
+}
+
+/* Duty in 1/256 % as "n.nn". */
+static void out_q8_pct(const cmd_out_t *out, const char *label, int32_t q8)
+{
+    char num[11];
+    uint32_t v;
+    uint32_t frac;
+
+    out_puts(out, label);
+    if (q8 < 0) {
+        out_puts(out, "-");
+        q8 = -q8;
+    }
+    v = (uint32_t)q8;
+    u32_to_dec(num, sizeof(num), v >> 8);
+    out_puts(out, num);
+    frac = ((v & 0xFFU) * 100U + 128U) >> 8;
+    if (frac > 99U) frac = 99U;
+    num[0] = '.';
+    num[1] = (char)('0' + frac / 10U);
+    num[2] = (char)('0' + frac % 10U);
+    num[3] = '\0';
+    out_puts(out, num);
+}
+
+static void cmd_rpm(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    speedctl_status_t st;
+    speed_point_t p;
+    char mode[8];
+    size_t i = 0;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (strcmp(mode, "OFF") == 0) {
+        speedctl_set_rpm(0);
+        out_puts(out, "\r\nOK: RPM control off, duty kept\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "MAP") == 0) {
+        char mode2[8];
+        size_t j = 0;
+
+        while (arg2 && arg2[j] && j + 1 < sizeof(mode2)) {
+            mode2[j] = (char)my_toupper((unsigned char)arg2[j]);
+            j++;
+        }
+        mode2[j] = '\0';
+
+        if (strcmp(mode2, "LOAD") == 0) {
+            uint32_t n = speedctl_map_load_sweep();
+
+            if (n == 0U) {
+                out_puts(out, "\r\nERROR: no settled SWEEP points with RPM (SWEEP RUN first)\r\n");
+            } else {
+                out_u32(out, "\r\nOK: map loaded from SWEEP, points=", n);
+                out_puts(out, "\r\n");
+            }
+            out_prompt(out);
+            return;
+        }
+        if (strcmp(mode2, "CLEAR") == 0) {
+            speedctl_map_clear();
+            out_puts(out, "\r\nOK: map cleared (PI only)\r\n");
+            out_prompt(out);
+            return;
+        }
+        if (mode2[0] != '\0') {
+            out_puts(out, "\r\nERROR: invalid value. Use: RPM MAP | RPM MAP LOAD | RPM MAP CLEAR\r\n");
+            out_prompt(out);
+            return;
+        }
+
+        speedctl_get_status(&st);
+        out_u32(out, "\r\nRPM MAP points=", st.map_points);
+        out_u32(out, " ff_step_rpm=", st.ff_step_rpm);
+        out_puts(out, "\r\n  duty    rpm\r\n");
+        for (uint32_t n = 0; speedctl_map_get(n, &p); n++) {
+            out_col_u32(out, p.duty, 6);
+            out_col_u32(out, p.rpm, 7);
+            out_puts(out, "\r\n");
+        }
+        out_prompt(out);
+        return;
+    }
+
+    if (mode[0] != '\0') {
+        char *endptr = NULL;
+        long val = strtol(arg, &endptr, 10);
+
+        if (!endptr || *endptr != '\0' || val < 0L || val > 65535L) {
+            out_puts(out, "\r\nERROR: invalid value. Use: RPM | RPM n (0..65535) | RPM OFF | RPM MAP [LOAD | CLEAR]\r\n");
+            out_prompt(out);
+            return;
+        }
+        speedctl_set_rpm((uint32_t)val);
+        if (val == 0L) {
+            out_puts(out, "\r\nOK: RPM control off, duty kept\r\n");
+        } else {
+            int32_t ff = speedctl_ff_q8((uint32_t)val);
+
+            out_u32(out, "\r\nOK: RPM setpoint ", (uint32_t)val);
+            if (ff >= 0) {
+                out_q8_pct(out, ", feed-forward duty ", ff);
+                out_puts(out, "%");
+            } else {
+                out_puts(out, " (no map: PI from the current duty)");
+            }
+            out_puts(out, "\r\n");
+        }
+        out_prompt(out);
+        return;
+    }
+
+    speedctl_get_status(&st);
+    if (st.setpoint == 0U) {
+        out_puts(out, "\r\nRPM control off");
+    } else {
+        out_u32(out, "\r\nRPM setpoint=", st.setpoint);
+        out_u32(out, " rpm=", st.rpm);
+        out_u32(out, " duty=", st.duty);
+        out_q8_pct(out, "\r\n  ff=", st.ff_q8);
+        out_q8_pct(out, " trim=", st.trim_q8);
+        if (st.paused) {
+            out_puts(out, " (paused: SWEEP or STEP running)");
+        }
+    }
+    out_u32(out, "\r\n  map points=", st.map_points);
+    out_puts(out, "\r\n");
+    out_prompt(out);
+}
+
+static void cmd_tachblank(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    tach_snapshot_t t;
+    uint32_t ns = 0;
+    char mode[8];
+    size_t i = 0;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (mode[0] != '\0') {
+        bool on = (strcmp(mode, "ON") == 0);
+
+        if (arg2 && on) {
+            char *endptr = NULL;
+            long val = strtol(arg2, &endptr, 10);
+
+            if (!endptr || *endptr != '\0' || val < (long)TACH_BLANK_MIN_NS || val > (long)TACH_BLANK_MAX_NS) {
+                out_puts(out, "\r\nERROR: invalid value. Use: TACHBLANK ON [ns] (100..20000)\r\n");
+                out_prompt(out);
+                return;
+            }
+            ns = (uint32_t)val;
+        }
+        if (!on && strcmp(mode, "OFF") != 0) {
+            out_puts(out, "\r\nERROR: invalid value. Use: TACHBLANK | TACHBLANK ON [ns] | TACHBLANK OFF\r\n");
+            out_prompt(out);
+            return;
+        }
+        (void)tach_set_blanking(on, ns);
+    }
+
+    tach_get_snapshot(&t);
+    out_puts(out, (mode[0] != '\0') ? "\r\nOK: TACHBLANK " : "\r\nTACHBLANK ");
+    out_puts(out, tach_is_blanking() ? "ON" : "OFF");
+    out_u32(out, "\r\n  window=", tach_get_blank_ns());
+    out_puts(out, " ns after each PF2 transition");
+    out_u32(out, "\r\n  blanked=", t.blanked_total);
+    out_u32(out, " rejects=", t.rejects_total);
+    out_u32(out, " pulses=", t.pulses_total);
+    out_puts(out, "\r\n");
+    out_prompt(out);
+}
+
+static void cmd_sspwm(const cmd_out_t *out, const char *arg, const char *arg2)
+{
+    static const char *const mode_names[] = { "OFF", "TRI", "RAND" };
+    sspwm_mode_t m;
+    sspwm_stats_t st;
+    uint32_t span = SSPWM_DEFAULT_SPAN_PCT;
+    uint32_t hz = timebase_sysclk_hz();
+    char mode[8];
+    size_t i = 0;
+
+    while (arg && arg[i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)arg[i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (mode[0] != '\0') {
+        if (strcmp(mode, "OFF") == 0) {
+            m = SSPWM_OFF;
+        } else if (strcmp(mode, "TRI") == 0) {
+            m = SSPWM_TRI;
+        } else if (strcmp(mode, "RAND") == 0) {
+            m = SSPWM_RAND;
+        } else {
+            out_puts(out, "\r\nERROR: invalid value. Use: SSPWM | SSPWM OFF | SSPWM TRI [pct] | SSPWM RAND [pct]\r\n");
+            out_prompt(out);
+            return;
+        }
+
+        if (arg2 && m != SSPWM_OFF) {
+            char *endptr = NULL;
+            long val = strtol(arg2, &endptr, 10);
+
+            if (!endptr || *endptr != '\0' || val < 1L || val > (long)SSPWM_MAX_SPAN_PCT) {
+                out_puts(out, "\r\nERROR: invalid value. Use: SSPWM TRI|RAND [pct] (1..10)\r\n");
+                out_prompt(out);
+                return;
+            }
+            span = (uint32_t)val;
+        }
+        (void)sspwm_set_mode(m, span);
+    }
+
+    sspwm_get_stats(&st);
+    out_puts(out, (mode[0] != '\0') ? "\r\nOK: SSPWM " : "\r\nSSPWM ");
+    out_puts(out, mode_names[st.mode]);
+    if (st.mode != SSPWM_OFF) {
+        out_u32(out, " +/-", st.span_pct);
+        out_puts(out, "%");
+    }
+    out_u32(out, "\r\n  nominal period=", st.period_nom);
+    out_u32(out, " (", (st.period_nom != 0U) ? hz / st.period_nom : 0U);
+    out_puts(out, " Hz)");
+    if (st.mode != SSPWM_OFF) {
+        out_u32(out, "\r\n  applied period=", st.period_min);
+        out_u32(out, "..", st.period_max);
+        out_u32(out, " (", (st.period_max != 0U) ? hz / st.period_max : 0U);
+        out_u32(out, "..", (st.period_min != 0U) ? hz / st.period_min : 0U);
+        out_u32(out, " Hz) updates=", st.updates);
+    }
+    out_puts(out, "\r\n");
+    out_prompt(out);
+}
+
+static void u32_to_hex8(char *out, uint32_t value)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (int i = 7; i >= 0; i--) {
+        out[i] = hex[value & 0xFU];
+        value >>= 4;
+    }
+    out[8] = '\0';
+}
+
+static void cmd_fwupdate(const cmd_out_t *out, char *const args[4])
+{
+    static const char *const state_names[] = {
+        "none", "partial", "staged (FWUPDATE APPLY to install)", "ready (installs on reset)",
+        "installed", "rejected by bootloader",
+    };
+    const char *err = NULL;
+    char mode[8];
+    char hex[9];
+    size_t i = 0;
+
+    while (args[0] && args[0][i] && i + 1 < sizeof(mode)) {
+        mode[i] = (char)my_toupper((unsigned char)args[0][i]);
+        i++;
+    }
+    mode[i] = '\0';
+
+    if (mode[0] == '\0') {
+        fwup_status_t st;
+
+        fwupdate_get_status(&st);
+        out_puts(out, "\r\nFWUPDATE: ");
+        out_puts(out, state_names[st.state]);
+        if (st.state != FWUP_STATE_EMPTY) {
+            out_u32(out, "\r\n  image bytes: ", st.size);
+            out_u32(out, "\r\n  staged bytes: ", st.staged);
+            u32_to_hex8(hex, st.crc);
+            out_puts(out, "\r\n  crc32: ");
+            out_puts(out, hex);
+        }
+#ifdef BOOTLOADER_ENABLED
+        out_puts(out, "\r\n  bootloader: yes\r\n");
+#else
+        out_puts(out, "\r\n  bootloader: no (staging only)\r\n");
+#endif
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "BEGIN") == 0) {
+        char *endptr = NULL;
+        unsigned long size = args[1] ? strtoul(args[1], &endptr, 10) : 0UL;
+        unsigned long crc = 0;
+        unsigned long baud = FWUP_BAUD_DEFAULT;
+        uint32_t next = 0;
+        fwup_result_t res;
+
+        if (!args[1] || *endptr != '\0' || !args[2]) {
+            out_puts(out, "\r\nERROR: Use: FWUPDATE BEGIN size crc32hex [baud]\r\n");
+            out_prompt(out);
+            return;
+        }
+        crc = strtoul(args[2], &endptr, 16);
+        if (*endptr != '\0') {
+            out_puts(out, "\r\nERROR: invalid crc32 (hex)\r\n");
+            out_prompt(out);
+            return;
+        }
+        if (args[3]) {
+            baud = strtoul(args[3], &endptr, 10);
+            if (*endptr != '\0' || baud < 9600UL || baud > FWUP_BAUD_MAX) {
+                out_puts(out, "\r\nERROR: baud out of range (9600..3000000)\r\n");
+                out_prompt(out);
+                return;
+            }
+        }
+        /* The binary transfer can only run on the UART3 console. */
+        if (out != &g_console_uart3.out) {
+            out_puts(out, "\r\nERROR: FWUPDATE BEGIN only on the UART3 console\r\n");
+            out_prompt(out);
+            return;
+        }
+        if (!fwupdate_begin((uint32_t)size, (uint32_t)crc, &next, &err)) {
+            out_puts(out, "\r\nERROR: ");
+            out_puts(out, err);
+            out_puts(out, "\r\n");
+            out_prompt(out);
+            return;
+        }
+
+        /* tools/fwupdate.py waits for this line, then switches to binary. */
+        out_u32(out, "\r\nFWUP READY ", next);
+        out_u32(out, " ", (uint32_t)baud);
+        out_puts(out, "\r\n");
+        uart_tx_flush(UARTDEV_USER);
+        fwupdate_receive((uint32_t)baud, &res);
+
+        out_u32(out, "\r\nFWUPDATE: ", res.blocks);
+        out_u32(out, " blocks, ", res.retries);
+        out_u32(out, " retries, ", res.ms);
+        out_puts(out, " ms: ");
+        switch (res.last_status) {
+        case FWUP_ST_DONE:  out_puts(out, "image verified (FWUPDATE APPLY to install)"); break;
+        case FWUP_ST_BAD:   out_puts(out, "image FAILED verification"); break;
+        case FWUP_ST_FLASH: out_puts(out, "flash error (FWUPDATE ABORT, then start over)"); break;
+        case 0:             out_puts(out, "host went silent (repeat BEGIN to resume)"); break;
+        default:            out_puts(out, "stopped (repeat BEGIN to resume)"); break;
+        }
+        out_puts(out, "\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    if (strcmp(mode, "APPLY") == 0) {
+        if (!fwupdate_apply(&err)) {
+            out_puts(out, "\r\nERROR: ");
+            out_puts(out, err);
+            out_puts(out, "\r\n");
+            out_prompt(out);
+            return;
+        }
+        out_puts(out, "\r\nOK: image verified, resetting into the bootloader\r\n");
+        uart_tx_flush(UARTDEV_USER);
+        fwupdate_reset();
+        return;
+    }
+
+    if (strcmp(mode, "ABORT") == 0) {
+        if (!fwupdate_abort(&err)) {
+            out_puts(out, "\r\nERROR: ");
+            out_puts(out, err);
+            out_puts(out, "\r\n");
+            out_prompt(out);
+            return;
+        }
+        out_puts(out, "\r\nOK: staged image discarded\r\n");
+        out_prompt(out);
+        return;
+    }
+
+    out_puts(out, "\r\nERROR: invalid value. Use: FWUPDATE [BEGIN size crc [baud] | APPLY | ABORT]\r\n");
+    out_prompt(out);
+}
+
+void commands_process_line_to(const cmd_out_t *out, const char *line)
 {
     if (!line) {
-        ui_uart3_prompt_once();
+        out_prompt(out);
         return;
     }
 
     while (*line && my_isspace((unsigned char)*line)) line++;
     if (*line == '\0') {
-        ui_uart3_prompt_once();
+        out_prompt(out);
         return;
     }
 
@@ -250,42 +1581,141 @@ void commands_process_line(const char *line)
     char *saveptr = NULL;
     char *tok = strtok_r(buf, " \t", &saveptr);
     if (!tok) {
-        ui_uart3_prompt_once();
+        out_prompt(out);
         return;
     }
 
     for (char *p = tok; *p; ++p) *p = (char)my_toupper((unsigned char)*p);
 
     if (strcmp(tok, "PSYN") == 0) {
-        cmd_psyn(strtok_r(NULL, " \t", &saveptr));
+        cmd_psyn(out, strtok_r(NULL, " \t", &saveptr));
         return;
     }
 
     if (strcmp(tok, "HELP") == 0) {
-        cmd_help();
+        cmd_help(out);
         return;
     }
 
     if (strcmp(tok, "DEBUG") == 0) {
-        cmd_debug(strtok_r(NULL, " \t", &saveptr));
+        cmd_debug(out, strtok_r(NULL, " \t", &saveptr));
         return;
     }
 
     if (strcmp(tok, "TACHIN") == 0) {
-        cmd_tachin(strtok_r(NULL, " \t", &saveptr));
+        cmd_tachin(out, strtok_r(NULL, " \t", &saveptr));
         return;
     }
 
     if (strcmp(tok, "TSYN") == 0) {
-        cmd_tsyn(strtok_r(NULL, " \t", &saveptr));
+        cmd_tsyn(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "NETSTATS") == 0) {
+        cmd_netstats(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "MODBUS") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_modbus(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "CRC") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_crc(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "TASKS") == 0) {
+        cmd_tasks(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "HISTORY") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_history(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "LOG") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_log(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "SWEEP") == 0) {
+        char *args[5];
+        for (int a = 0; a < 5; a++) {
+            args[a] = strtok_r(NULL, " \t", &saveptr);
+        }
+        cmd_sweep(out, args);
+        return;
+    }
+
+    if (strcmp(tok, "STEP") == 0) {
+        char *args[5];
+        for (int a = 0; a < 5; a++) {
+            args[a] = strtok_r(NULL, " \t", &saveptr);
+        }
+        cmd_step(out, args);
+        return;
+    }
+
+    if (strcmp(tok, "RPM") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_rpm(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "TACHBLANK") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_tachblank(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "SSPWM") == 0) {
+        char *arg = strtok_r(NULL, " \t", &saveptr);
+        cmd_sspwm(out, arg, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "WATCH") == 0) {
+        cmd_watch(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "BOOT") == 0) {
+        cmd_boot(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "RETAIN") == 0) {
+        cmd_retain(out, strtok_r(NULL, " \t", &saveptr));
+        return;
+    }
+
+    if (strcmp(tok, "FWUPDATE") == 0) {
+        char *args[4];
+        for (int a = 0; a < 4; a++) {
+            args[a] = strtok_r(NULL, " \t", &saveptr);
+        }
+        cmd_fwupdate(out, args);
         return;
     }
 
     if (strcmp(tok, "EXIT") == 0) {
-        cmd_exit(strtok_r(NULL, " \t", &saveptr));
+        cmd_exit(out, strtok_r(NULL, " \t", &saveptr));
         return;
     }
 
-    ui_uart3_puts("\r\nERROR: unknown command. Type HELP\r\n");
-    ui_uart3_prompt_once();
+    out_puts(out, "\r\nERROR: unknown command. Type HELP\r\n");
+    out_prompt(out);
+}
+
+void commands_process_line(const char *line)
+{
+    commands_process_line_to(&g_console_uart3.out, line);
 }
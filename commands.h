@@ -4,6 +4,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Valid PSYN duty range (percent), shared by the UART and network front ends. */
+#ifndef PSYN_MIN
+#define PSYN_MIN 5
+#endif
+#ifndef PSYN_MAX
+#define PSYN_MAX 96
+#endif
+
 /* Must be provided by the platform (TM4C main.c). */
 void pwm_set_percent(uint32_t percent);
 
@@ -23,7 +31,26 @@ bool debug_is_enabled(void);
 	Implemented in main.c; the existing UART0 disconnect diagnostics will fire automatically. */
 void uart3_request_disconnect(void);
 
-/* Process one complete command line (NUL-terminated). */
+/*
+ * Output sink for command responses. Lets the same dispatcher serve UART3
+ * and other consoles (e.g. TCP sessions in net_console.c).
+ *   puts:   write a NUL-terminated string (may be a stack buffer: copy it)
+ *   prompt: print the prompt unless the last output already was one
+ *   close:  EXIT was requested; end this session
+ *   write:  raw bytes (binary dumps, binproto.h); NULL if the sink is text only
+ */
+typedef struct {
+    void (*puts)(void *ctx, const char *s);
+    void (*prompt)(void *ctx);
+    void (*close)(void *ctx);
+    void *ctx;
+    void (*write)(void *ctx, const void *data, uint32_t len);
+} cmd_out_t;
+
+/* Process one complete command line (NUL-terminated), replying to 'out'. */
+void commands_process_line_to(const cmd_out_t *out, const char *line);
+
+/* Same, replying on UART3 (the DTR session console). */
 void commands_process_line(const char *line);
 
 #endif /* COMMANDS_H */
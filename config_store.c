@@ -0,0 +1,153 @@
+#include "config_store.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driverlib/eeprom.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+
+#include "atomic.h"
+#include "crc.h"
+
+#define CONFIG_MAGIC        0x43464732U     /* "CFG2" (CRC-32 check) */
+#define CONFIG_HEADER_SIZE  12U
+#define CONFIG_DATA_MAX     (CONFIG_STORE_SLOT_SIZE - CONFIG_HEADER_SIZE)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t id;
+    uint16_t len;
+    uint32_t check;
+} config_header_t;
+
+/* EEPROM transfers are whole words from word-aligned buffers. */
+static uint32_t g_cfg_buf[CONFIG_DATA_MAX / 4U];
+static bool g_cfg_ready = false;
+static volatile uint32_t g_cfg_busy = 0;
+
+/*
+ * Commands reach the store from the main loop (UART3) and from the lwIP
+ * interrupt (TCP console). They share g_cfg_buf, so a call that would
+ * overlap another one is refused instead of waiting.
+ */
+static bool cfg_lock(void)
+{
+    /* Test-and-set with LDREX/STREX; no interrupt mask needed. */
+    return atomic_xchg_u32(&g_cfg_busy, 1U) == 0U;
+}
+
+static void cfg_unlock(void)
+{
+    atomic_store_u32(&g_cfg_busy, 0U);
+}
+
+/* CRC-32 over the id, length and payload. */
+static uint32_t cfg_check(uint32_t id, uint32_t len, const uint8_t *data)
+{
+    uint32_t key[2];
+
+    key[0] = id;
+    key[1] = len;
+    return crc_continue(CRC_ALG_CRC32, crc_calc(CRC_ALG_CRC32, key, sizeof(key)), data, len);
+}
+
+static uint32_t cfg_slot_addr(config_rec_t id)
+{
+    return (uint32_t)id * CONFIG_STORE_SLOT_SIZE;
+}
+
+static bool cfg_args_ok(config_rec_t id, uint32_t len)
+{
+    return g_cfg_ready && (id < CONFIG_REC_COUNT) && (len != 0U) &&
+           (len <= CONFIG_DATA_MAX) && ((len & 3U) == 0U);
+}
+
+/* Reads the slot into g_cfg_buf; true if it holds a valid record of len bytes. */
+static bool cfg_load(config_rec_t id, uint32_t len)
+{
+    config_header_t hdr;
+    uint32_t addr = cfg_slot_addr(id);
+
+    EEPROMRead((uint32_t *)&hdr, addr, sizeof(hdr));
+    if (hdr.magic != CONFIG_MAGIC || hdr.id != (uint16_t)id || hdr.len != len) {
+        return false;
+    }
+
+    EEPROMRead(g_cfg_buf, addr + CONFIG_HEADER_SIZE, len);
+    return hdr.check == cfg_check(id, len, (const uint8_t *)g_cfg_buf);
+}
+
+bool config_store_init(void)
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0)) {
+    }
+
+    /* Also completes a write interrupted by a reset (see EEPROMInit()). */
+    g_cfg_ready = (EEPROMInit() == EEPROM_INIT_OK) &&
+                  ((uint32_t)CONFIG_REC_COUNT * CONFIG_STORE_SLOT_SIZE <= EEPROMSizeGet());
+    return g_cfg_ready;
+}
+
+bool config_store_read(config_rec_t id, void *data, uint32_t len)
+{
+    bool ok;
+
+    if (!cfg_args_ok(id, len) || !cfg_lock()) {
+        return false;
+    }
+
+    ok = cfg_load(id, len);
+    if (ok) {
+        memcpy(data, g_cfg_buf, len);
+    }
+
+    cfg_unlock();
+    return ok;
+}
+
+bool config_store_write(config_rec_t id, const void *data, uint32_t len)
+{
+    config_header_t hdr;
+    uint32_t addr;
+    bool ok;
+
+    if (!cfg_args_ok(id, len) || !cfg_lock()) {
+        return false;
+    }
+
+    /* Unchanged records cost no write cycles. */
+    if (cfg_load(id, len) && memcmp(g_cfg_buf, data, len) == 0) {
+        cfg_unlock();
+        return true;
+    }
+
+    addr = cfg_slot_addr(id);
+    memcpy(g_cfg_buf, data, len);
+
+    hdr.magic = CONFIG_MAGIC;
+    hdr.id = (uint16_t)id;
+    hdr.len = (uint16_t)len;
+    hdr.check = cfg_check(id, len, (const uint8_t *)g_cfg_buf);
+
+    /* Payload first: until the header matches it, the slot reads as empty
+       or fails the checksum. */
+    ok = (EEPROMProgram(g_cfg_buf, addr + CONFIG_HEADER_SIZE, len) == 0U) &&
+         (EEPROMProgram((uint32_t *)&hdr, addr, sizeof(hdr)) == 0U);
+
+    cfg_unlock();
+    return ok;
+}
+
+void config_store_erase(config_rec_t id)
+{
+    uint32_t zero = 0;
+
+    if (!g_cfg_ready || id >= CONFIG_REC_COUNT || !cfg_lock()) {
+        return;
+    }
+    EEPROMProgram(&zero, cfg_slot_addr(id), sizeof(zero));
+    cfg_unlock();
+}
@@ -0,0 +1,45 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Small persistent record store in the on-chip EEPROM (6 KB, 500k write
+ * cycles per word, untouched by reflashing the application).
+ *
+ * Every record type owns a fixed slot. A record is stored behind a header
+ * (magic, id, length, checksum), so a blank slot, a slot written by a build
+ * with a different record layout (length differs) or a write cut short by a
+ * reset all read back as "no record". Record sizes must be a multiple of 4
+ * bytes and fit in CONFIG_STORE_SLOT_SIZE minus the header.
+ *
+ * Safe to call from the main loop and from interrupt handlers, but a call
+ * that overlaps another one fails rather than waits. A write programs one
+ * EEPROM word per 4 bytes (about 0.1 ms each), so keep records small.
+ */
+#ifndef CONFIG_STORE_SLOT_SIZE
+#define CONFIG_STORE_SLOT_SIZE 256U
+#endif
+
+typedef enum {
+    CONFIG_REC_NETSTATS = 0,    /* net_stats.c: lwIP pool high-watermarks */
+    CONFIG_REC_MODBUS,          /* modbus.c: UART3 mode and slave address */
+    CONFIG_REC_FLASHLOG,        /* flashlog.c: logging on/off and period */
+    CONFIG_REC_SPEEDMAP,        /* speedctl.c: duty -> RPM feed-forward map */
+    CONFIG_REC_COUNT
+} config_rec_t;
+
+/* Power up the EEPROM. Returns false if it is unusable (then reads fail). */
+bool config_store_init(void);
+
+/* Copy record 'id' into data. False if absent, corrupt or of another size. */
+bool config_store_read(config_rec_t id, void *data, uint32_t len);
+
+/* Store record 'id'. Skips the write if the slot already holds the same data. */
+bool config_store_write(config_rec_t id, const void *data, uint32_t len);
+
+/* Invalidate record 'id'. */
+void config_store_erase(config_rec_t id);
+
+#endif /* CONFIG_STORE_H */
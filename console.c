@@ -0,0 +1,270 @@
+#include "console.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/uart.h"
+
+/* Extra ANSI colors for the rainbow banner (ESP32 reference style). */
+#define ANSI_RED          "\x1B[31m"
+#define ANSI_YELLOW_BOLD  "\x1B[93m"
+#define ANSI_GREEN        "\x1B[32m"
+#define ANSI_CYAN         "\x1B[36m"
+#define ANSI_MAGENTA      "\x1B[35m"
+#define ANSI_BLUE         "\x1B[34m"
+#define ANSI_WHITE        "\x1B[37m"
+#define ANSI_BOLD_GREEN   "\x1B[1;32m"
+
+/* ---- Output sink --------------------------------------------------------- */
+
+static void console_out_puts(void *ctx, const char *s)
+{
+    console_puts((console_t *)ctx, s);
+}
+
+static void console_out_prompt(void *ctx)
+{
+    console_prompt_once((console_t *)ctx);
+}
+
+static void console_out_write(void *ctx, const void *data, uint32_t len)
+{
+    console_t *c = (console_t *)ctx;
+
+    c->at_prompt = false;
+    UARTSend((const uint8_t *)data, len, c->dev);
+}
+
+/* EXIT on UART3 ends the DTR session (main.c). */
+static void console3_out_close(void *ctx)
+{
+    (void)ctx;
+    uart3_request_disconnect();
+}
+
+/* The ICDI link has no session to end. */
+static void console0_out_close(void *ctx)
+{
+    console_t *c = (console_t *)ctx;
+
+    console_puts(c, "(the UART0 console stays open)\r\n");
+    console_prompt_once(c);
+}
+
+console_t g_console_uart0 = {
+    .name = "UART0",
+    .dev = UARTDEV_ICDI,
+    .base = UART0_BASE,
+    .irq = INT_UART0,
+    .out = { console_out_puts, console_out_prompt, console0_out_close, &g_console_uart0,
+             console_out_write },
+};
+
+console_t g_console_uart3 = {
+    .name = "UART3",
+    .dev = UARTDEV_USER,
+    .base = UART3_BASE,
+    .irq = INT_UART3,
+    .out = { console_out_puts, console_out_prompt, console3_out_close, &g_console_uart3,
+             console_out_write },
+};
+
+static void echo_str(console_t *c, const char *s)
+{
+    while (*s) {
+        uart_tx_putc(c->dev, (uint8_t)*s++);
+    }
+}
+
+/* ---- Input --------------------------------------------------------------- */
+
+void console_rx(console_t *c, uint8_t ch)
+{
+    if (c->busy) {
+        /* Any key ends WATCH (watch.c) or LOG DUMP (flashlog.c); the key is dropped. */
+        c->busy = false;
+        return;
+    }
+
+    if (c->line_ready) {
+        /* Ignore extra RX bytes until the session thread takes the line. */
+        return;
+    }
+
+    /* Handle backspace/delete locally (do not allow erasing prompt). */
+    if (ch == '\b' || ch == 0x7FU) {
+        if (c->len > 0) {
+            c->len--;
+            echo_str(c, "\b \b");
+        } else {
+            /* Bell if user tries to backspace past prompt. */
+            uart_tx_putc(c->dev, '\a');
+        }
+        return;
+    }
+
+    /* Enter handling */
+    if (ch == '\r' || ch == '\n') {
+        if (c->len > 0) {
+            /* Echo newline once, finalize command. */
+            echo_str(c, "\r\n");
+            c->line[c->len] = '\0';
+            c->line_ready = true;
+        }
+        /* Empty line: do NOTHING (no extra newline, no extra prompt). */
+        return;
+    }
+
+    /* Uppercase-as-you-type for printable letters (ESP32-style). */
+    if (ch >= 'a' && ch <= 'z') {
+        ch = (uint8_t)(ch - 'a' + 'A');
+    }
+
+    uart_tx_putc(c->dev, ch);
+
+    if (c->len + 1 < UART_RX_BUF_SIZE) {
+        c->line[c->len++] = (char)ch;
+    } else {
+        /* Overflow - reset */
+        c->len = 0;
+        echo_str(c, "\r\nERROR: line too long\r\n> ");
+    }
+}
+
+/*
+   When terminals send CRLF, the ISR will typically mark the command ready
+   on '\r' and later echo '\n'. If we print the prompt while the port's RX
+   interrupt is disabled (as we do while taking the line), that delayed '\n'
+   can arrive after the prompt and move the cursor to a new line with no
+   prompt, creating the "needs an extra ENTER" symptom.
+
+   So pending RX bytes are consumed here (while the IRQ is disabled): lone
+   EOL tails are swallowed and real characters (user typed quickly) go
+   through the normal editing path so they are not lost.
+*/
+static void console_consume_pending_input(console_t *c)
+{
+    while (ROM_UARTCharsAvail(c->base)) {
+        int32_t rc = ROM_UARTCharGetNonBlocking(c->base);
+        if (rc < 0) {
+            break;
+        }
+        if (rc == '\n' || rc == '\r') {
+            continue;
+        }
+        console_rx(c, (uint8_t)rc);
+    }
+}
+
+bool console_take_line(console_t *c, char *dst, size_t size)
+{
+    uint32_t len;
+
+    if (!c->line_ready || size == 0) {
+        return false;
+    }
+
+    IntDisable(c->irq);
+
+    len = c->len;
+    if (len >= size) len = (uint32_t)size - 1U;
+    for (uint32_t i = 0; i < len; i++) {
+        dst[i] = c->line[i];
+    }
+    dst[len] = '\0';
+
+    c->len = 0;
+    c->line_ready = false;
+
+    /* Consume any pending CR/LF tail (and preserve real chars if any). */
+    console_consume_pending_input(c);
+
+    IntEnable(c->irq);
+    return true;
+}
+
+void console_reset_input(console_t *c)
+{
+    c->len = 0;
+    c->line_ready = false;
+    c->busy = false;
+}
+
+/* ---- Output -------------------------------------------------------------- */
+
+void console_puts(console_t *c, const char *s)
+{
+    size_t n;
+
+    c->at_prompt = false;
+    if (!s) return;
+    n = strlen(s);
+    if (n == 0) return;
+    UARTSend((const uint8_t *)s, (uint32_t)n, c->dev);
+}
+
+char *console_put_col(char *dst, uint32_t v, uint32_t width)
+{
+    char tmp[10];
+    uint32_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + (v % 10U));
+        v /= 10U;
+    } while (v != 0U);
+
+    while (width > n) {
+        *dst++ = ' ';
+        width--;
+    }
+    while (n > 0U) {
+        *dst++ = tmp[--n];
+    }
+    return dst;
+}
+
+void console_prompt_once(console_t *c)
+{
+    if (c->at_prompt) return;
+
+    console_puts(c, ANSI_PROMPT PROMPT_SYMBOL ANSI_RESET);
+    c->at_prompt = true;
+}
+
+void console_prompt_force_next(console_t *c)
+{
+    c->at_prompt = false;
+}
+
+void console_session_begin(console_t *c)
+{
+    /*
+     * Keep this banner implementation extremely simple and deterministic.
+     * Avoid libc-heavy helpers (strstr, variable-length pointer math), since
+     * session-begin output must never stall the MCU.
+     */
+    static const char banner[] =
+        ANSI_WHITE "=== "
+        ANSI_BOLD_GREEN "IBM PS FAN CONTROL"
+        ANSI_WHITE " (c) 2025 by Purposeful Designs, Inc. === "
+        /* Rainbow-ish "--- booting ---" (spaces preserved) */
+        ANSI_RED "-" ANSI_YELLOW_BOLD "-" ANSI_GREEN "-" ANSI_WHITE " "
+        ANSI_CYAN "b" ANSI_MAGENTA "o" ANSI_BLUE "o" ANSI_RED "t" ANSI_YELLOW_BOLD "i" ANSI_GREEN "n" ANSI_CYAN "g"
+        ANSI_WHITE " "
+        ANSI_MAGENTA "-" ANSI_BLUE "-" ANSI_RED "-"
+        ANSI_RESET "\r\n";
+
+    /* Start-of-session always permits a welcome+prompt. */
+    c->at_prompt = false;
+
+    console_puts(c, banner);
+    console_puts(c, ANSI_WELCOME);
+    console_puts(c, "PWM Ready. Commands: PSYN n | HELP | EXIT\r\n");
+    console_puts(c, ANSI_RESET);
+    console_prompt_once(c);
+}
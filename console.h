@@ -0,0 +1,62 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cmdline.h"    /* UARTDev, UART_RX_BUF_SIZE */
+#include "commands.h"   /* cmd_out_t */
+#include "pt.h"
+
+/*
+ * Command shell instance for one UART port. Each port has its own line
+ * buffer, prompt state, output sink and session protothread, so the UART0
+ * (ICDI) and UART3 consoles run side by side; commands from either are
+ * dispatched by commands.c.
+ *
+ * Input is edited in the port's RX interrupt (console_rx()): echo,
+ * backspace, uppercase-as-you-type, one complete line at a time. The
+ * session thread in main.c picks the line up with console_take_line().
+ */
+typedef struct {
+    const char *name;
+    UARTDev dev;                    /* UARTSend()/TX ring channel */
+    uint32_t base;                  /* UART base, for pending input */
+    uint32_t irq;                   /* INT_UARTn */
+    cmd_out_t out;                  /* sink handed to the dispatcher */
+    volatile char line[UART_RX_BUF_SIZE];
+    volatile uint32_t len;
+    volatile bool line_ready;       /* complete line not yet taken */
+    volatile bool busy;             /* WATCH, LOG DUMP, SWEEP or STEP owns the port; any key clears */
+    bool at_prompt;
+    pt_t pt;                        /* console protothread state (main.c) */
+} console_t;
+
+extern console_t g_console_uart0;
+extern console_t g_console_uart3;
+
+/* One received byte (from the port's RX interrupt). */
+void console_rx(console_t *c, uint8_t ch);
+
+/* Copy the finished line into dst (NUL-terminated) and accept the next one.
+   False if no line is ready. Main context. */
+bool console_take_line(console_t *c, char *dst, size_t size);
+
+/* Drop any partial line and stop a WATCH or LOG DUMP (session start/end). */
+void console_reset_input(console_t *c);
+
+void console_puts(console_t *c, const char *s);
+
+/* v in decimal, right-aligned in width columns (wider if it does not fit);
+   no NUL. Returns the end. For the SWEEP and STEP table rows. */
+char *console_put_col(char *dst, uint32_t v, uint32_t width);
+
+/* Print the prompt unless the last output already was one. */
+void console_prompt_once(console_t *c);
+void console_prompt_force_next(console_t *c);
+
+/* Session start: banner, welcome line, prompt. */
+void console_session_begin(console_t *c);
+
+#endif /* CONSOLE_H */
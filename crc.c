@@ -0,0 +1,431 @@
+#include "crc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driverlib/interrupt.h"
+
+#ifndef CRC_SW_ONLY
+#include "inc/hw_ccm.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/crc.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#include "atomic.h"
+#endif
+
+typedef struct {
+    const char *name;
+    uint8_t width;
+    uint32_t init;          /* reflected register before the first byte */
+    uint32_t xorout;
+    uint32_t check;         /* CRC of "123456789" */
+#ifndef CRC_SW_ONLY
+    uint32_t hw_cfg;
+#endif
+} crc_def_t;
+
+static const crc_def_t g_defs[CRC_ALG_COUNT] = {
+#ifndef CRC_SW_ONLY
+    { "CRC16/MODBUS", 16, 0xFFFFU, 0x0U, 0x4B37U,
+      CRC_CFG_TYPE_P8005 | CRC_CFG_IBR | CRC_CFG_OBR },
+    { "CRC32", 32, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xCBF43926U,
+      CRC_CFG_TYPE_P4C11DB7 | CRC_CFG_IBR | CRC_CFG_OBR | CRC_CFG_RESINV },
+    { "CRC32C", 32, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xE3069283U,
+      CRC_CFG_TYPE_P1EDC6F41 | CRC_CFG_IBR | CRC_CFG_OBR | CRC_CFG_RESINV },
+#else
+    { "CRC16/MODBUS", 16, 0xFFFFU, 0x0U, 0x4B37U },
+    { "CRC32", 32, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xCBF43926U },
+    { "CRC32C", 32, 0xFFFFFFFFU, 0xFFFFFFFFU, 0xE3069283U },
+#endif
+};
+
+/* Reflected tables: poly 0xA001 (0x8005), 0xEDB88320 (0x04C11DB7),
+   0x82F63B78 (0x1EDC6F41). */
+static const uint16_t g_tab16[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+static const uint32_t g_tab32[256] = {
+    0x00000000U, 0x77073096U, 0xEE0E612CU, 0x990951BAU, 0x076DC419U, 0x706AF48FU,
+    0xE963A535U, 0x9E6495A3U, 0x0EDB8832U, 0x79DCB8A4U, 0xE0D5E91EU, 0x97D2D988U,
+    0x09B64C2BU, 0x7EB17CBDU, 0xE7B82D07U, 0x90BF1D91U, 0x1DB71064U, 0x6AB020F2U,
+    0xF3B97148U, 0x84BE41DEU, 0x1ADAD47DU, 0x6DDDE4EBU, 0xF4D4B551U, 0x83D385C7U,
+    0x136C9856U, 0x646BA8C0U, 0xFD62F97AU, 0x8A65C9ECU, 0x14015C4FU, 0x63066CD9U,
+    0xFA0F3D63U, 0x8D080DF5U, 0x3B6E20C8U, 0x4C69105EU, 0xD56041E4U, 0xA2677172U,
+    0x3C03E4D1U, 0x4B04D447U, 0xD20D85FDU, 0xA50AB56BU, 0x35B5A8FAU, 0x42B2986CU,
+    0xDBBBC9D6U, 0xACBCF940U, 0x32D86CE3U, 0x45DF5C75U, 0xDCD60DCFU, 0xABD13D59U,
+    0x26D930ACU, 0x51DE003AU, 0xC8D75180U, 0xBFD06116U, 0x21B4F4B5U, 0x56B3C423U,
+    0xCFBA9599U, 0xB8BDA50FU, 0x2802B89EU, 0x5F058808U, 0xC60CD9B2U, 0xB10BE924U,
+    0x2F6F7C87U, 0x58684C11U, 0xC1611DABU, 0xB6662D3DU, 0x76DC4190U, 0x01DB7106U,
+    0x98D220BCU, 0xEFD5102AU, 0x71B18589U, 0x06B6B51FU, 0x9FBFE4A5U, 0xE8B8D433U,
+    0x7807C9A2U, 0x0F00F934U, 0x9609A88EU, 0xE10E9818U, 0x7F6A0DBBU, 0x086D3D2DU,
+    0x91646C97U, 0xE6635C01U, 0x6B6B51F4U, 0x1C6C6162U, 0x856530D8U, 0xF262004EU,
+    0x6C0695EDU, 0x1B01A57BU, 0x8208F4C1U, 0xF50FC457U, 0x65B0D9C6U, 0x12B7E950U,
+    0x8BBEB8EAU, 0xFCB9887CU, 0x62DD1DDFU, 0x15DA2D49U, 0x8CD37CF3U, 0xFBD44C65U,
+    0x4DB26158U, 0x3AB551CEU, 0xA3BC0074U, 0xD4BB30E2U, 0x4ADFA541U, 0x3DD895D7U,
+    0xA4D1C46DU, 0xD3D6F4FBU, 0x4369E96AU, 0x346ED9FCU, 0xAD678846U, 0xDA60B8D0U,
+    0x44042D73U, 0x33031DE5U, 0xAA0A4C5FU, 0xDD0D7CC9U, 0x5005713CU, 0x270241AAU,
+    0xBE0B1010U, 0xC90C2086U, 0x5768B525U, 0x206F85B3U, 0xB966D409U, 0xCE61E49FU,
+    0x5EDEF90EU, 0x29D9C998U, 0xB0D09822U, 0xC7D7A8B4U, 0x59B33D17U, 0x2EB40D81U,
+    0xB7BD5C3BU, 0xC0BA6CADU, 0xEDB88320U, 0x9ABFB3B6U, 0x03B6E20CU, 0x74B1D29AU,
+    0xEAD54739U, 0x9DD277AFU, 0x04DB2615U, 0x73DC1683U, 0xE3630B12U, 0x94643B84U,
+    0x0D6D6A3EU, 0x7A6A5AA8U, 0xE40ECF0BU, 0x9309FF9DU, 0x0A00AE27U, 0x7D079EB1U,
+    0xF00F9344U, 0x8708A3D2U, 0x1E01F268U, 0x6906C2FEU, 0xF762575DU, 0x806567CBU,
+    0x196C3671U, 0x6E6B06E7U, 0xFED41B76U, 0x89D32BE0U, 0x10DA7A5AU, 0x67DD4ACCU,
+    0xF9B9DF6FU, 0x8EBEEFF9U, 0x17B7BE43U, 0x60B08ED5U, 0xD6D6A3E8U, 0xA1D1937EU,
+    0x38D8C2C4U, 0x4FDFF252U, 0xD1BB67F1U, 0xA6BC5767U, 0x3FB506DDU, 0x48B2364BU,
+    0xD80D2BDAU, 0xAF0A1B4CU, 0x36034AF6U, 0x41047A60U, 0xDF60EFC3U, 0xA867DF55U,
+    0x316E8EEFU, 0x4669BE79U, 0xCB61B38CU, 0xBC66831AU, 0x256FD2A0U, 0x5268E236U,
+    0xCC0C7795U, 0xBB0B4703U, 0x220216B9U, 0x5505262FU, 0xC5BA3BBEU, 0xB2BD0B28U,
+    0x2BB45A92U, 0x5CB36A04U, 0xC2D7FFA7U, 0xB5D0CF31U, 0x2CD99E8BU, 0x5BDEAE1DU,
+    0x9B64C2B0U, 0xEC63F226U, 0x756AA39CU, 0x026D930AU, 0x9C0906A9U, 0xEB0E363FU,
+    0x72076785U, 0x05005713U, 0x95BF4A82U, 0xE2B87A14U, 0x7BB12BAEU, 0x0CB61B38U,
+    0x92D28E9BU, 0xE5D5BE0DU, 0x7CDCEFB7U, 0x0BDBDF21U, 0x86D3D2D4U, 0xF1D4E242U,
+    0x68DDB3F8U, 0x1FDA836EU, 0x81BE16CDU, 0xF6B9265BU, 0x6FB077E1U, 0x18B74777U,
+    0x88085AE6U, 0xFF0F6A70U, 0x66063BCAU, 0x11010B5CU, 0x8F659EFFU, 0xF862AE69U,
+    0x616BFFD3U, 0x166CCF45U, 0xA00AE278U, 0xD70DD2EEU, 0x4E048354U, 0x3903B3C2U,
+    0xA7672661U, 0xD06016F7U, 0x4969474DU, 0x3E6E77DBU, 0xAED16A4AU, 0xD9D65ADCU,
+    0x40DF0B66U, 0x37D83BF0U, 0xA9BCAE53U, 0xDEBB9EC5U, 0x47B2CF7FU, 0x30B5FFE9U,
+    0xBDBDF21CU, 0xCABAC28AU, 0x53B39330U, 0x24B4A3A6U, 0xBAD03605U, 0xCDD70693U,
+    0x54DE5729U, 0x23D967BFU, 0xB3667A2EU, 0xC4614AB8U, 0x5D681B02U, 0x2A6F2B94U,
+    0xB40BBE37U, 0xC30C8EA1U, 0x5A05DF1BU, 0x2D02EF8DU,
+};
+
+static const uint32_t g_tab32c[256] = {
+    0x00000000U, 0xF26B8303U, 0xE13B70F7U, 0x1350F3F4U, 0xC79A971FU, 0x35F1141CU,
+    0x26A1E7E8U, 0xD4CA64EBU, 0x8AD958CFU, 0x78B2DBCCU, 0x6BE22838U, 0x9989AB3BU,
+    0x4D43CFD0U, 0xBF284CD3U, 0xAC78BF27U, 0x5E133C24U, 0x105EC76FU, 0xE235446CU,
+    0xF165B798U, 0x030E349BU, 0xD7C45070U, 0x25AFD373U, 0x36FF2087U, 0xC494A384U,
+    0x9A879FA0U, 0x68EC1CA3U, 0x7BBCEF57U, 0x89D76C54U, 0x5D1D08BFU, 0xAF768BBCU,
+    0xBC267848U, 0x4E4DFB4BU, 0x20BD8EDEU, 0xD2D60DDDU, 0xC186FE29U, 0x33ED7D2AU,
+    0xE72719C1U, 0x154C9AC2U, 0x061C6936U, 0xF477EA35U, 0xAA64D611U, 0x580F5512U,
+    0x4B5FA6E6U, 0xB93425E5U, 0x6DFE410EU, 0x9F95C20DU, 0x8CC531F9U, 0x7EAEB2FAU,
+    0x30E349B1U, 0xC288CAB2U, 0xD1D83946U, 0x23B3BA45U, 0xF779DEAEU, 0x05125DADU,
+    0x1642AE59U, 0xE4292D5AU, 0xBA3A117EU, 0x4851927DU, 0x5B016189U, 0xA96AE28AU,
+    0x7DA08661U, 0x8FCB0562U, 0x9C9BF696U, 0x6EF07595U, 0x417B1DBCU, 0xB3109EBFU,
+    0xA0406D4BU, 0x522BEE48U, 0x86E18AA3U, 0x748A09A0U, 0x67DAFA54U, 0x95B17957U,
+    0xCBA24573U, 0x39C9C670U, 0x2A993584U, 0xD8F2B687U, 0x0C38D26CU, 0xFE53516FU,
+    0xED03A29BU, 0x1F682198U, 0x5125DAD3U, 0xA34E59D0U, 0xB01EAA24U, 0x42752927U,
+    0x96BF4DCCU, 0x64D4CECFU, 0x77843D3BU, 0x85EFBE38U, 0xDBFC821CU, 0x2997011FU,
+    0x3AC7F2EBU, 0xC8AC71E8U, 0x1C661503U, 0xEE0D9600U, 0xFD5D65F4U, 0x0F36E6F7U,
+    0x61C69362U, 0x93AD1061U, 0x80FDE395U, 0x72966096U, 0xA65C047DU, 0x5437877EU,
+    0x4767748AU, 0xB50CF789U, 0xEB1FCBADU, 0x197448AEU, 0x0A24BB5AU, 0xF84F3859U,
+    0x2C855CB2U, 0xDEEEDFB1U, 0xCDBE2C45U, 0x3FD5AF46U, 0x7198540DU, 0x83F3D70EU,
+    0x90A324FAU, 0x62C8A7F9U, 0xB602C312U, 0x44694011U, 0x5739B3E5U, 0xA55230E6U,
+    0xFB410CC2U, 0x092A8FC1U, 0x1A7A7C35U, 0xE811FF36U, 0x3CDB9BDDU, 0xCEB018DEU,
+    0xDDE0EB2AU, 0x2F8B6829U, 0x82F63B78U, 0x709DB87BU, 0x63CD4B8FU, 0x91A6C88CU,
+    0x456CAC67U, 0xB7072F64U, 0xA457DC90U, 0x563C5F93U, 0x082F63B7U, 0xFA44E0B4U,
+    0xE9141340U, 0x1B7F9043U, 0xCFB5F4A8U, 0x3DDE77ABU, 0x2E8E845FU, 0xDCE5075CU,
+    0x92A8FC17U, 0x60C37F14U, 0x73938CE0U, 0x81F80FE3U, 0x55326B08U, 0xA759E80BU,
+    0xB4091BFFU, 0x466298FCU, 0x1871A4D8U, 0xEA1A27DBU, 0xF94AD42FU, 0x0B21572CU,
+    0xDFEB33C7U, 0x2D80B0C4U, 0x3ED04330U, 0xCCBBC033U, 0xA24BB5A6U, 0x502036A5U,
+    0x4370C551U, 0xB11B4652U, 0x65D122B9U, 0x97BAA1BAU, 0x84EA524EU, 0x7681D14DU,
+    0x2892ED69U, 0xDAF96E6AU, 0xC9A99D9EU, 0x3BC21E9DU, 0xEF087A76U, 0x1D63F975U,
+    0x0E330A81U, 0xFC588982U, 0xB21572C9U, 0x407EF1CAU, 0x532E023EU, 0xA145813DU,
+    0x758FE5D6U, 0x87E466D5U, 0x94B49521U, 0x66DF1622U, 0x38CC2A06U, 0xCAA7A905U,
+    0xD9F75AF1U, 0x2B9CD9F2U, 0xFF56BD19U, 0x0D3D3E1AU, 0x1E6DCDEEU, 0xEC064EEDU,
+    0xC38D26C4U, 0x31E6A5C7U, 0x22B65633U, 0xD0DDD530U, 0x0417B1DBU, 0xF67C32D8U,
+    0xE52CC12CU, 0x1747422FU, 0x49547E0BU, 0xBB3FFD08U, 0xA86F0EFCU, 0x5A048DFFU,
+    0x8ECEE914U, 0x7CA56A17U, 0x6FF599E3U, 0x9D9E1AE0U, 0xD3D3E1ABU, 0x21B862A8U,
+    0x32E8915CU, 0xC083125FU, 0x144976B4U, 0xE622F5B7U, 0xF5720643U, 0x07198540U,
+    0x590AB964U, 0xAB613A67U, 0xB831C993U, 0x4A5A4A90U, 0x9E902E7BU, 0x6CFBAD78U,
+    0x7FAB5E8CU, 0x8DC0DD8FU, 0xE330A81AU, 0x115B2B19U, 0x020BD8EDU, 0xF0605BEEU,
+    0x24AA3F05U, 0xD6C1BC06U, 0xC5914FF2U, 0x37FACCF1U, 0x69E9F0D5U, 0x9B8273D6U,
+    0x88D28022U, 0x7AB90321U, 0xAE7367CAU, 0x5C18E4C9U, 0x4F48173DU, 0xBD23943EU,
+    0xF36E6F75U, 0x0105EC76U, 0x12551F82U, 0xE03E9C81U, 0x34F4F86AU, 0xC69F7B69U,
+    0xD5CF889DU, 0x27A40B9EU, 0x79B737BAU, 0x8BDCB4B9U, 0x988C474DU, 0x6AE7C44EU,
+    0xBE2DA0A5U, 0x4C4623A6U, 0x5F16D052U, 0xAD7D5351U,
+};
+
+/* ---- Software ----------------------------------------------------------- */
+
+static uint32_t sw_update(crc_alg_t alg, uint32_t reg, const uint8_t *p, uint32_t len)
+{
+    if (alg == CRC_ALG_CRC16_MODBUS) {
+        uint16_t r = (uint16_t)reg;
+        while (len--) {
+            r = (uint16_t)((r >> 8) ^ g_tab16[(r ^ *p++) & 0xFFU]);
+        }
+        return r;
+    }
+
+    const uint32_t *tab = (alg == CRC_ALG_CRC32) ? g_tab32 : g_tab32c;
+    while (len--) {
+        reg = (reg >> 8) ^ tab[(reg ^ *p++) & 0xFFU];
+    }
+    return reg;
+}
+
+static uint32_t sw_continue(crc_alg_t alg, uint32_t crc, const void *data, uint32_t len)
+{
+    const crc_def_t *d = &g_defs[alg];
+
+    return sw_update(alg, crc ^ d->xorout, (const uint8_t *)data, len) ^ d->xorout;
+}
+
+/* ---- CCM0 engine -------------------------------------------------------- */
+
+#ifndef CRC_SW_ONLY
+
+/* Only the primary entry of the software channel (30) is used, but the
+   table base must be 1024-byte aligned. */
+static tDMAControlTable g_dma_table[32] __attribute__((aligned(1024)));
+
+static bool g_hw_ok[CRC_ALG_COUNT];
+static bool g_dma_ok = false;
+static volatile uint32_t g_hw_busy = 0;
+
+/*
+ * Settings found by the self-test: whether words need their bytes swapped
+ * to be processed in memory order, and whether a 16-bit result comes out
+ * in the upper half of RSLTPP once bit-reversed.
+ */
+static uint32_t g_word_cfg[CRC_ALG_COUNT];
+static bool g_hi16[CRC_ALG_COUNT];
+
+static bool hw_lock(void)
+{
+    /* Test-and-set with LDREX/STREX; no interrupt mask needed. */
+    return atomic_xchg_u32(&g_hw_busy, 1U) == 0U;
+}
+
+static void hw_unlock(void)
+{
+    atomic_store_u32(&g_hw_busy, 0U);
+}
+
+static uint32_t bitrev(uint32_t v, uint32_t width)
+{
+    uint32_t r = 0;
+
+    while (width--) {
+        r = (r << 1) | (v & 1U);
+        v >>= 1;
+    }
+    return r;
+}
+
+static void hw_bytes(const uint8_t *p, uint32_t n)
+{
+    while (n--) {
+        HWREG(CCM0_BASE + CCM_O_CRCDIN) = *p++;
+    }
+}
+
+static void hw_words_cpu(const uint32_t *w, uint32_t n)
+{
+    while (n--) {
+        HWREG(CCM0_BASE + CCM_O_CRCDIN) = *w++;
+    }
+}
+
+static void hw_words_dma(const uint32_t *w, uint32_t n)
+{
+    while (n) {
+        uint32_t chunk = (n > 1024U) ? 1024U : n;
+
+        uDMAChannelTransferSet(UDMA_CH30_SW | UDMA_PRI_SELECT, UDMA_MODE_AUTO,
+                               (void *)w, (void *)(CCM0_BASE + CCM_O_CRCDIN), chunk);
+        uDMAChannelEnable(UDMA_CH30_SW);
+        uDMAChannelRequest(UDMA_CH30_SW);
+        while (uDMAChannelIsEnabled(UDMA_CH30_SW)) {
+        }
+        w += chunk;
+        n -= chunk;
+    }
+}
+
+/*
+ * Unaligned head and tail bytes go through the 8-bit data size, the aligned
+ * middle as words. Rewriting CRCCTRL with INIT_SEED keeps the running value.
+ */
+static uint32_t hw_continue(crc_alg_t alg, bool dma, uint32_t crc, const uint8_t *p, uint32_t len)
+{
+    const crc_def_t *d = &g_defs[alg];
+    uint32_t head = (uint32_t)(-(uintptr_t)p & 3U);
+    uint32_t words, result;
+
+    if (head > len) head = len;
+    words = (len - head) / 4U;
+
+    CRCConfigSet(CCM0_BASE, d->hw_cfg | CRC_CFG_INIT_SEED | CRC_CFG_SIZE_8BIT);
+    CRCSeedSet(CCM0_BASE, bitrev(crc ^ d->xorout, d->width));
+    hw_bytes(p, head);
+    p += head;
+
+    if (words) {
+        CRCConfigSet(CCM0_BASE, d->hw_cfg | g_word_cfg[alg] | CRC_CFG_INIT_SEED | CRC_CFG_SIZE_32BIT);
+        if (dma) {
+            hw_words_dma((const uint32_t *)p, words);
+        } else {
+            hw_words_cpu((const uint32_t *)p, words);
+        }
+        p += words * 4U;
+        CRCConfigSet(CCM0_BASE, d->hw_cfg | CRC_CFG_INIT_SEED | CRC_CFG_SIZE_8BIT);
+    }
+    hw_bytes(p, len - head - words * 4U);
+
+    result = CRCResultRead(CCM0_BASE, true);
+    if (d->width == 16U) {
+        result = (g_hi16[alg] ? (result >> 16) : result) & 0xFFFFU;
+    }
+    return result;
+}
+
+/* "123456789" starting one byte past a word boundary: 3 head bytes, one
+   word, 2 tail bytes. */
+static const char g_vec[12] __attribute__((aligned(4))) = "0123456789";
+
+static bool hw_self_test(crc_alg_t alg)
+{
+    const uint8_t *v = (const uint8_t *)&g_vec[1];
+    uint32_t expect = g_defs[alg].check;
+    uint32_t e, h;
+
+    for (e = 0; e < 2U; e++) {
+        g_word_cfg[alg] = (e == 0U) ? CRC_CFG_ENDIAN_SBHW : 0U;
+        for (h = 0; h < 2U; h++) {
+            g_hi16[alg] = (h != 0U);
+            if (hw_continue(alg, false, g_defs[alg].init ^ g_defs[alg].xorout, v, 9U) != expect) {
+                continue;
+            }
+            /* Continuing from a previous result must match too. */
+            uint32_t part = hw_continue(alg, false, g_defs[alg].init ^ g_defs[alg].xorout, v, 4U);
+            return hw_continue(alg, false, part, v + 4, 5U) == expect;
+        }
+    }
+    return false;
+}
+
+static bool hw_path_ok(crc_alg_t alg, crc_path_t path)
+{
+    if (path == CRC_PATH_SW) return false;
+    if (path == CRC_PATH_HW_DMA) return g_hw_ok[alg] && g_dma_ok;
+    return g_hw_ok[alg];
+}
+
+#endif /* !CRC_SW_ONLY */
+
+/* ---- API ---------------------------------------------------------------- */
+
+uint32_t crc_continue_path(crc_alg_t alg, crc_path_t path, uint32_t crc,
+                           const void *data, uint32_t len)
+{
+    if (alg >= CRC_ALG_COUNT) return 0;
+
+#ifndef CRC_SW_ONLY
+    if (path == CRC_PATH_AUTO) {
+        path = (len >= CRC_DMA_MIN_BYTES && g_dma_ok) ? CRC_PATH_HW_DMA : CRC_PATH_HW_CPU;
+    }
+    if (len != 0U && hw_path_ok(alg, path) && hw_lock()) {
+        crc = hw_continue(alg, path == CRC_PATH_HW_DMA, crc, (const uint8_t *)data, len);
+        hw_unlock();
+        return crc;
+    }
+#else
+    (void)path;
+#endif
+    return sw_continue(alg, crc, data, len);
+}
+
+uint32_t crc_continue(crc_alg_t alg, uint32_t crc, const void *data, uint32_t len)
+{
+    return crc_continue_path(alg, CRC_PATH_AUTO, crc, data, len);
+}
+
+uint32_t crc_calc(crc_alg_t alg, const void *data, uint32_t len)
+{
+    if (alg >= CRC_ALG_COUNT) return 0;
+    return crc_continue(alg, g_defs[alg].init ^ g_defs[alg].xorout, data, len);
+}
+
+bool crc_hw_active(crc_alg_t alg)
+{
+#ifndef CRC_SW_ONLY
+    return alg < CRC_ALG_COUNT && g_hw_ok[alg];
+#else
+    (void)alg;
+    return false;
+#endif
+}
+
+bool crc_dma_active(void)
+{
+#ifndef CRC_SW_ONLY
+    return g_dma_ok;
+#else
+    return false;
+#endif
+}
+
+const char *crc_alg_name(crc_alg_t alg)
+{
+    return (alg < CRC_ALG_COUNT) ? g_defs[alg].name : "?";
+}
+
+void crc_init(void)
+{
+#ifndef CRC_SW_ONLY
+    uint32_t a;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_CCM0);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_CCM0)) { }
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA)) { }
+
+    uDMAEnable();
+    uDMAControlBaseSet(g_dma_table);
+    uDMAChannelAttributeDisable(UDMA_CH30_SW, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UDMA_CH30_SW | UDMA_PRI_SELECT,
+                          UDMA_SIZE_32 | UDMA_SRC_INC_32 | UDMA_DST_INC_NONE | UDMA_ARB_8);
+
+    for (a = 0; a < CRC_ALG_COUNT; a++) {
+        g_hw_ok[a] = hw_self_test((crc_alg_t)a);
+    }
+
+    /* uDMA against software over a table in flash (aligned, 1 KB). */
+    g_dma_ok = false;
+    for (a = 0; a < CRC_ALG_COUNT; a++) {
+        if (g_hw_ok[a]) {
+            uint32_t start = g_defs[a].init ^ g_defs[a].xorout;
+            g_dma_ok = hw_continue((crc_alg_t)a, true, start, (const uint8_t *)g_tab32, sizeof(g_tab32)) ==
+                       sw_continue((crc_alg_t)a, start, g_tab32, sizeof(g_tab32));
+            break;
+        }
+    }
+#endif
+}
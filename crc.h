@@ -0,0 +1,68 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * CRC service on the CCM0 CRC engine, with a table-driven software path.
+ *
+ * All algorithms are the usual reflected variants:
+ *   CRC_ALG_CRC16_MODBUS  poly 0x8005, init 0xFFFF, no final xor ("123456789" -> 0x4B37)
+ *   CRC_ALG_CRC32         poly 0x04C11DB7, init/xorout 0xFFFFFFFF (-> 0xCBF43926)
+ *   CRC_ALG_CRC32C        poly 0x1EDC6F41 (Castagnoli), init/xorout 0xFFFFFFFF (-> 0xE3069283)
+ *
+ * crc_init() checks the engine against the software result for every
+ * algorithm (unaligned head/tail, word and uDMA paths) and only uses it
+ * where they agree. Blocks of CRC_DMA_MIN_BYTES or more are fed by the
+ * uDMA software channel, smaller ones by the CPU.
+ *
+ * The engine is shared: a call that finds it busy (an interrupt handler
+ * preempting another user) quietly computes in software, so every function
+ * is safe from any context. Build with CRC_SW_ONLY to leave the engine out
+ * (host builds, parts without CCM0).
+ */
+
+typedef enum {
+    CRC_ALG_CRC16_MODBUS = 0,
+    CRC_ALG_CRC32,
+    CRC_ALG_CRC32C,
+    CRC_ALG_COUNT
+} crc_alg_t;
+
+/* Forced path, for benchmarks and self-tests. */
+typedef enum {
+    CRC_PATH_AUTO = 0,  /* what crc_calc() uses */
+    CRC_PATH_SW,        /* table lookups */
+    CRC_PATH_HW_CPU,    /* engine, words written by the CPU */
+    CRC_PATH_HW_DMA,    /* engine, words written by uDMA */
+} crc_path_t;
+
+#ifndef CRC_DMA_MIN_BYTES
+#define CRC_DMA_MIN_BYTES 256U
+#endif
+
+/* Power up CCM0/uDMA and self-test. Call before any other user. */
+void crc_init(void);
+
+/* CRC of len bytes. */
+uint32_t crc_calc(crc_alg_t alg, const void *data, uint32_t len);
+
+/*
+ * Extend a CRC: crc_continue(alg, crc_calc(alg, a, na), b, nb) equals the
+ * CRC of a followed by b.
+ */
+uint32_t crc_continue(crc_alg_t alg, uint32_t crc, const void *data, uint32_t len);
+
+/* Same as crc_continue() on a given path. A hardware path that is not
+   available (self-test failed, engine busy) falls back to software. */
+uint32_t crc_continue_path(crc_alg_t alg, crc_path_t path, uint32_t crc,
+                           const void *data, uint32_t len);
+
+/* True if crc_calc() uses the engine for this algorithm / uDMA for large blocks. */
+bool crc_hw_active(crc_alg_t alg);
+bool crc_dma_active(void);
+
+const char *crc_alg_name(crc_alg_t alg);
+
+#endif /* CRC_H */
@@ -20,4 +20,22 @@ static inline int my_toupper(int c)
     return c;
 }
 
+static inline int my_tolower(int c)
+{
+    if ((unsigned)c >= 'A' && (unsigned)c <= 'Z')
+        return c + ('a' - 'A');
+    return c;
+}
+
+static inline int my_isdigit(int c)
+{
+    return ((unsigned)c >= '0') && ((unsigned)c <= '9');
+}
+
+static inline int my_isalpha(int c)
+{
+    return (((unsigned)c >= 'a') && ((unsigned)c <= 'z')) ||
+           (((unsigned)c >= 'A') && ((unsigned)c <= 'Z'));
+}
+
 #endif /* CTYPE_HELPERS_H */
\ No newline at end of file
@@ -12,7 +12,8 @@
  *   from main/context code (not from ISRs) to send diagnostics to ICDI UART0.
  *
  * Notes:
- * - This file writes diagnostic output using UART0 (ICDI) via UARTCharPut - blocking.
+ * - This file writes diagnostic output to UART0 (ICDI) through UARTSend(), i.e. the
+ *   same TX ring as the UART0 console, so both keep their order.
  * - Ensure linker defines the symbols: _end_bss, _heap_start, _heap_end, _stack_top,
  *   and that _sbrk(ptrdiff_t) is present (syscalls).
  * - If you want to inspect application globals in diag_print_variables_summary(),
@@ -116,10 +117,8 @@ int diag_snprintf_heap_send(const char *fmt, ...)
     if (!buf) return -1;
 
     int len = (int)strlen(buf);
-    /* Send directly to UART0 (ICDI) using ROM functions */
-    for (int i = 0; i < len; i++) {
-        ROM_UARTCharPut(UART0_BASE, buf[i]);
-    }
+    /* Queue to UART0 (ICDI), shared with the UART0 console */
+    UARTSend((const uint8_t *)buf, (uint32_t)len, UARTDEV_ICDI);
     free(buf);
     return len;
 }    
@@ -419,8 +418,9 @@ static int diag_putc_nb(char c)
 /* diag_putc: write one character using simple blocking approach */
 void diag_putc(char c)
 {
-    /* Use simple blocking put to avoid clock dependency issues */
-    ROM_UARTCharPut(UART0_BASE, c);
+    /* Through the UART0 TX ring, so it cannot interleave with the console */
+    uint8_t b = (uint8_t)c;
+    UARTSend(&b, 1U, UARTDEV_ICDI);
 }
 /* --- end diag_putc implementations --- */
 
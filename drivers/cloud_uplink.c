@@ -0,0 +1,1167 @@
+//*****************************************************************************
+//
+// cloud_uplink.c - Batched, store-and-forward telemetry upload over HTTP.
+//
+// Datapoints are queued in RAM and uploaded in batches, many points per HTTP
+// POST, over a connection that is kept open between requests.  While the
+// server is unreachable the queue keeps filling; once it passes
+// CLOUD_SPILL_THRESHOLD the oldest points are moved to a ring of blocks in
+// on-chip flash (FLASH_CLOUD_SPILL_BASE).  When the link returns, the backlog
+// is replayed oldest first, flash before RAM, no faster than one request per
+// CLOUD_REPLAY_INTERVAL_MS.  A batch is only removed from the queue once the
+// server has answered it with a 2xx status, so delivery is at-least-once.
+//
+// Request body:
+//
+//     {"up":<uptime ms>,"p":[[<time ms>,"<channel>",<value>],...]}
+//
+// where <time ms> is the uptime at which the point was queued; the server can
+// turn it into wall-clock time using "up", which is the uptime at the moment
+// the request was built.
+//
+// Integration: pass CloudUplinkEnetEvent() to EthClientInit() (or call it
+// from the application's own event handler) and call CloudUplinkTick() with
+// the elapsed milliseconds, and CloudUplinkPointAdd(), from the lwIP context
+// (the lwIP host timer handler).  The flash writes are not done there: the
+// application calls CloudUplinkSpill() from its main loop, with the lwIP
+// interrupt masked and after it has made sure that nothing else is using the
+// flash controller.
+//
+//*****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "driverlib/flash.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/ustdlib.h"
+#include "drivers/eth_client_lwip.h"
+#include "drivers/http.h"
+#include "drivers/cloud_uplink.h"
+#include "flash_layout.h"
+
+//*****************************************************************************
+//
+// One queued datapoint.  The size is a multiple of 4 bytes so that points can
+// be programmed into flash directly from the RAM queue.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32TimeMS;
+    uint32_t ui32Channel;
+    int32_t i32Value;
+}
+tCloudPoint;
+
+//*****************************************************************************
+//
+// Flash spill area layout.  The area is a ring of fixed-size blocks; each
+// 16 KB erase sector holds SPILL_BLOCKS_PER_SECTOR of them.  The block
+// trailer is programmed after the points, with the magic word last, so a
+// block interrupted by a reset is never mistaken for a valid one.
+//
+// ui32AckSeq records the sequence number of the newest block the server had
+// acknowledged when this block was written.  At start-up, blocks at or below
+// the highest recorded ui32AckSeq are known to be delivered.  This avoids
+// reprogramming already written flash words to mark blocks as consumed.
+//
+//*****************************************************************************
+#define SPILL_BLOCK_SIZE        1024
+#define SPILL_TRAILER_SIZE      16
+#define SPILL_BLOCK_POINTS      ((SPILL_BLOCK_SIZE - SPILL_TRAILER_SIZE) /    \
+                                 sizeof(tCloudPoint))
+#define SPILL_NUM_BLOCKS        (FLASH_CLOUD_SPILL_SIZE / SPILL_BLOCK_SIZE)
+#define SPILL_BLOCKS_PER_SECTOR (FLASH_SECTOR_SIZE / SPILL_BLOCK_SIZE)
+#define SPILL_MAGIC             0x434C5531
+
+typedef struct
+{
+    tCloudPoint psPoints[SPILL_BLOCK_POINTS];
+    uint32_t ui32Pad[(SPILL_BLOCK_SIZE - SPILL_TRAILER_SIZE -
+                      (SPILL_BLOCK_POINTS * sizeof(tCloudPoint))) / 4];
+    uint32_t ui32Seq;
+    uint32_t ui32Count;
+    uint32_t ui32AckSeq;
+    uint32_t ui32Magic;
+}
+tSpillBlock;
+
+#define SPILL_BLOCK(ui32Block)                                                \
+        ((const tSpillBlock *)(FLASH_CLOUD_SPILL_BASE +                       \
+                               ((ui32Block) * SPILL_BLOCK_SIZE)))
+
+//*****************************************************************************
+//
+// Where the batch currently in flight was taken from.
+//
+//*****************************************************************************
+#define BATCH_NONE              0
+#define BATCH_RAM               1
+#define BATCH_FLASH             2
+
+//*****************************************************************************
+//
+// Uplink connection states.
+//
+//*****************************************************************************
+typedef enum
+{
+    //
+    // No IP address yet, or the link was lost.
+    //
+    CLOUD_STATE_NO_LINK,
+
+    //
+    // Link is up but there is no connection to the server.
+    //
+    CLOUD_STATE_DISCONNECTED,
+
+    //
+    // Waiting for DNS, then for the TCP connection.
+    //
+    CLOUD_STATE_DNS_WAIT,
+    CLOUD_STATE_CONNECT_WAIT,
+
+    //
+    // Connected, no request outstanding.
+    //
+    CLOUD_STATE_IDLE,
+
+    //
+    // Request sent, waiting for the complete response.
+    //
+    CLOUD_STATE_RESPONSE_WAIT
+}
+tCloudState;
+
+//*****************************************************************************
+//
+// The uplink state.
+//
+//*****************************************************************************
+static struct
+{
+    //
+    // Server and resource configured by CloudUplinkInit().
+    //
+    const char *pcHost;
+    uint16_t ui16Port;
+    const char *pcPath;
+    const char * const *ppcChannels;
+    uint32_t ui32NumChannels;
+
+    //
+    // Uptime in milliseconds, advanced by CloudUplinkTick().
+    //
+    uint32_t ui32NowMS;
+
+    //
+    // RAM queue.  The indices run freely; the fill level is their difference.
+    //
+    tCloudPoint psRing[CLOUD_RAM_POINTS];
+    uint32_t ui32Head;
+    uint32_t ui32Tail;
+
+    //
+    // Flash spill ring.  ui32ReadBlock/ui32ReadOffset locate the oldest
+    // undelivered point, ui32WriteBlock is the next block to program and
+    // ui32FlashBlocks is the number of blocks from the read block up to the
+    // write block.  That span can include progress records (blocks without
+    // points), which are skipped when reading.
+    //
+    uint32_t ui32ReadBlock;
+    uint32_t ui32ReadOffset;
+    uint32_t ui32WriteBlock;
+    uint32_t ui32FlashBlocks;
+    uint32_t ui32FlashPoints;
+    uint32_t ui32NextSeq;
+    uint32_t ui32AckSeq;
+    uint32_t ui32AckUnrecorded;
+    bool bAckPending;
+
+    //
+    // Connection state and the time (ui32NowMS) at which the current wait
+    // expires.
+    //
+    tCloudState eState;
+    uint32_t ui32Deadline;
+    uint32_t ui32RetryMS;
+
+    //
+    // Earliest time the next request may be sent.
+    //
+    uint32_t ui32NextSendMS;
+
+    //
+    // Batch in flight.
+    //
+    uint32_t ui32BatchSource;
+    uint32_t ui32BatchCount;
+
+    //
+    // Response parsing.
+    //
+    tHTTPParser sParser;
+    bool bResponseDone;
+    bool bResponseOK;
+    bool bServerClose;
+
+    tCloudUplinkStats sStats;
+
+    char pcRequest[CLOUD_REQUEST_SIZE];
+}
+g_sCloud;
+
+//*****************************************************************************
+//
+// Returns true if time ui32A is at or after time ui32B (wrap safe).
+//
+//*****************************************************************************
+static bool
+TimeReached(uint32_t ui32A, uint32_t ui32B)
+{
+    return((int32_t)(ui32A - ui32B) >= 0);
+}
+
+//*****************************************************************************
+//
+// Returns the number of points in the RAM queue.
+//
+//*****************************************************************************
+static uint32_t
+RingUsed(void)
+{
+    return(g_sCloud.ui32Head - g_sCloud.ui32Tail);
+}
+
+//*****************************************************************************
+//
+// Returns a pointer to the point ui32Index places after the oldest queued
+// RAM point.
+//
+//*****************************************************************************
+static tCloudPoint *
+RingPoint(uint32_t ui32Index)
+{
+    return(&g_sCloud.psRing[(g_sCloud.ui32Tail + ui32Index) %
+                            CLOUD_RAM_POINTS]);
+}
+
+//*****************************************************************************
+//
+// Scan the spill area and recover the undelivered blocks left by a previous
+// run.
+//
+//*****************************************************************************
+static void
+SpillScan(void)
+{
+    const tSpillBlock *psBlock;
+    uint32_t ui32Block, ui32MaxSeq, ui32MinSeq;
+    bool bFound, bPending;
+
+    bFound = false;
+    bPending = false;
+    ui32MaxSeq = 0;
+    ui32MinSeq = 0;
+    g_sCloud.ui32AckSeq = 0;
+
+    //
+    // First pass: newest block (where writing resumes) and the newest
+    // acknowledgment recorded in any block.
+    //
+    for(ui32Block = 0; ui32Block < SPILL_NUM_BLOCKS; ui32Block++)
+    {
+        psBlock = SPILL_BLOCK(ui32Block);
+        if(psBlock->ui32Magic != SPILL_MAGIC)
+        {
+            continue;
+        }
+
+        if(!bFound || ((int32_t)(psBlock->ui32Seq - ui32MaxSeq) > 0))
+        {
+            ui32MaxSeq = psBlock->ui32Seq;
+            g_sCloud.ui32WriteBlock = (ui32Block + 1) % SPILL_NUM_BLOCKS;
+        }
+        if(!bFound ||
+           ((int32_t)(psBlock->ui32AckSeq - g_sCloud.ui32AckSeq) > 0))
+        {
+            g_sCloud.ui32AckSeq = psBlock->ui32AckSeq;
+        }
+        bFound = true;
+    }
+
+    if(!bFound)
+    {
+        //
+        // Nothing usable.  Start at a sector boundary so the first spill
+        // erases whatever the area contains.
+        //
+        g_sCloud.ui32WriteBlock = 0;
+        g_sCloud.ui32NextSeq = 1;
+        return;
+    }
+
+    g_sCloud.ui32NextSeq = ui32MaxSeq + 1;
+
+    //
+    // Second pass: undelivered blocks.  They are contiguous in ring order
+    // and end just before the write block, so the oldest one and the count
+    // are all that is needed.
+    //
+    for(ui32Block = 0; ui32Block < SPILL_NUM_BLOCKS; ui32Block++)
+    {
+        psBlock = SPILL_BLOCK(ui32Block);
+        if((psBlock->ui32Magic != SPILL_MAGIC) || (psBlock->ui32Count == 0) ||
+           ((int32_t)(psBlock->ui32Seq - g_sCloud.ui32AckSeq) <= 0))
+        {
+            continue;
+        }
+
+        if(!bPending || ((int32_t)(psBlock->ui32Seq - ui32MinSeq) < 0))
+        {
+            ui32MinSeq = psBlock->ui32Seq;
+            g_sCloud.ui32ReadBlock = ui32Block;
+        }
+        bPending = true;
+        g_sCloud.ui32FlashPoints += psBlock->ui32Count;
+    }
+
+    if(!bPending)
+    {
+        g_sCloud.ui32ReadBlock = g_sCloud.ui32WriteBlock;
+        return;
+    }
+
+    g_sCloud.ui32FlashBlocks = ((g_sCloud.ui32WriteBlock + SPILL_NUM_BLOCKS -
+                                 g_sCloud.ui32ReadBlock) % SPILL_NUM_BLOCKS);
+    if(g_sCloud.ui32FlashBlocks == 0)
+    {
+        g_sCloud.ui32FlashBlocks = SPILL_NUM_BLOCKS;
+    }
+}
+
+//*****************************************************************************
+//
+// Advance the read position past the current block, and past any progress
+// records that follow it.
+//
+//*****************************************************************************
+static void
+SpillReadNext(void)
+{
+    do
+    {
+        g_sCloud.ui32ReadOffset = 0;
+        g_sCloud.ui32ReadBlock = (g_sCloud.ui32ReadBlock + 1) %
+                                 SPILL_NUM_BLOCKS;
+        g_sCloud.ui32FlashBlocks--;
+    }
+    while(g_sCloud.ui32FlashBlocks &&
+          (SPILL_BLOCK(g_sCloud.ui32ReadBlock)->ui32Count == 0));
+}
+
+//*****************************************************************************
+//
+// Returns true if programming the next block would first have to erase a
+// sector that still holds undelivered blocks.
+//
+//*****************************************************************************
+static bool
+SpillWriteErases(void)
+{
+    return(((g_sCloud.ui32WriteBlock % SPILL_BLOCKS_PER_SECTOR) == 0) &&
+           (g_sCloud.ui32FlashBlocks != 0) &&
+           ((g_sCloud.ui32ReadBlock / SPILL_BLOCKS_PER_SECTOR) ==
+            (g_sCloud.ui32WriteBlock / SPILL_BLOCKS_PER_SECTOR)));
+}
+
+//*****************************************************************************
+//
+// Program one block into the spill ring.  pui32Data/ui32Count are the points
+// to store; they may be split in two runs because the RAM queue wraps.
+// Entering a new sector erases it first, which discards any undelivered
+// blocks it still holds (the ring is full at that point).
+//
+// Erasing a sector takes tens of milliseconds and the CPU stalls on flash
+// while it runs; this only happens once every SPILL_BLOCKS_PER_SECTOR
+// blocks, i.e. during an extended outage.  Only called from
+// CloudUplinkSpill().
+//
+//*****************************************************************************
+static void
+SpillWrite(tCloudPoint *psRun1, uint32_t ui32Count1, tCloudPoint *psRun2,
+           uint32_t ui32Count2)
+{
+    uint32_t pui32Trailer[4];
+    uint32_t ui32Addr, ui32Sector;
+    const tSpillBlock *psBlock;
+
+    ui32Addr = (uint32_t)SPILL_BLOCK(g_sCloud.ui32WriteBlock);
+
+    if((g_sCloud.ui32WriteBlock % SPILL_BLOCKS_PER_SECTOR) == 0)
+    {
+        ui32Sector = g_sCloud.ui32WriteBlock / SPILL_BLOCKS_PER_SECTOR;
+
+        while(g_sCloud.ui32FlashBlocks &&
+              ((g_sCloud.ui32ReadBlock / SPILL_BLOCKS_PER_SECTOR) ==
+               ui32Sector))
+        {
+            psBlock = SPILL_BLOCK(g_sCloud.ui32ReadBlock);
+            g_sCloud.sStats.ui32Dropped += psBlock->ui32Count -
+                                           g_sCloud.ui32ReadOffset;
+            g_sCloud.ui32FlashPoints -= psBlock->ui32Count -
+                                        g_sCloud.ui32ReadOffset;
+            SpillReadNext();
+        }
+
+        MAP_FlashErase(ui32Addr);
+    }
+
+    if(ui32Count1)
+    {
+        MAP_FlashProgram((uint32_t *)psRun1, ui32Addr,
+                         ui32Count1 * sizeof(tCloudPoint));
+    }
+    if(ui32Count2)
+    {
+        MAP_FlashProgram((uint32_t *)psRun2,
+                         ui32Addr + (ui32Count1 * sizeof(tCloudPoint)),
+                         ui32Count2 * sizeof(tCloudPoint));
+    }
+
+    pui32Trailer[0] = g_sCloud.ui32NextSeq++;
+    pui32Trailer[1] = ui32Count1 + ui32Count2;
+    pui32Trailer[2] = g_sCloud.ui32AckSeq;
+    pui32Trailer[3] = SPILL_MAGIC;
+    MAP_FlashProgram(pui32Trailer,
+                     ui32Addr + SPILL_BLOCK_SIZE - SPILL_TRAILER_SIZE,
+                     sizeof(pui32Trailer));
+
+    g_sCloud.ui32WriteBlock = (g_sCloud.ui32WriteBlock + 1) %
+                              SPILL_NUM_BLOCKS;
+
+    //
+    // A progress record written with nothing pending is not part of the
+    // span; otherwise the span grows by one block.
+    //
+    if(g_sCloud.ui32FlashBlocks == 0)
+    {
+        if((ui32Count1 + ui32Count2) == 0)
+        {
+            g_sCloud.ui32ReadBlock = g_sCloud.ui32WriteBlock;
+            return;
+        }
+
+        g_sCloud.ui32ReadBlock = (g_sCloud.ui32WriteBlock +
+                                  SPILL_NUM_BLOCKS - 1) % SPILL_NUM_BLOCKS;
+        g_sCloud.ui32ReadOffset = 0;
+    }
+
+    g_sCloud.ui32FlashBlocks++;
+    g_sCloud.ui32FlashPoints += ui32Count1 + ui32Count2;
+}
+
+//*****************************************************************************
+//
+// Move the oldest block's worth of RAM points to flash.
+//
+//*****************************************************************************
+static void
+SpillFromRAM(void)
+{
+    uint32_t ui32Count, ui32First, ui32Index;
+
+    ui32Count = RingUsed();
+    if(ui32Count > SPILL_BLOCK_POINTS)
+    {
+        ui32Count = SPILL_BLOCK_POINTS;
+    }
+
+    //
+    // The queue is contiguous up to the end of the array.
+    //
+    ui32Index = g_sCloud.ui32Tail % CLOUD_RAM_POINTS;
+    ui32First = CLOUD_RAM_POINTS - ui32Index;
+    if(ui32First > ui32Count)
+    {
+        ui32First = ui32Count;
+    }
+
+    SpillWrite(&g_sCloud.psRing[ui32Index], ui32First, g_sCloud.psRing,
+               ui32Count - ui32First);
+
+    g_sCloud.ui32Tail += ui32Count;
+    g_sCloud.sStats.ui32Spilled += ui32Count;
+}
+
+//*****************************************************************************
+//
+// Append the JSON for one point to the request, or when psRequest is NULL
+// just return its length.
+//
+//*****************************************************************************
+static uint32_t
+PointRender(tHTTPRequest *psRequest, const tCloudPoint *psPoint, bool bFirst)
+{
+    char pcTemp[48];
+    const char *pcName;
+    uint32_t ui32Len;
+
+    if(psPoint->ui32Channel < g_sCloud.ui32NumChannels)
+    {
+        pcName = g_sCloud.ppcChannels[psPoint->ui32Channel];
+    }
+    else
+    {
+        pcName = "?";
+    }
+
+    ui32Len = usnprintf(pcTemp, sizeof(pcTemp), "%s[%u,\"%s\",%d]",
+                        bFirst ? "" : ",", psPoint->ui32TimeMS, pcName,
+                        psPoint->i32Value);
+    if(ui32Len >= sizeof(pcTemp))
+    {
+        ui32Len = sizeof(pcTemp) - 1;
+    }
+
+    if(psRequest)
+    {
+        HTTPRequestAppend(psRequest, pcTemp, ui32Len);
+    }
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+// Build the next batch into g_sCloud.pcRequest and send it.  Returns false if
+// there was nothing to send or the request could not be queued.
+//
+//*****************************************************************************
+static bool
+BatchSend(void)
+{
+    const tCloudPoint *psPoints;
+    tHTTPRequest sRequest;
+    char pcPrefix[24];
+    uint32_t ui32Avail, ui32Count, ui32Idx, ui32BodyLen, ui32PrefixLen;
+    uint32_t ui32HeadLen;
+    bool bFlash;
+
+    //
+    // Oldest data first: the flash backlog, then RAM.
+    //
+    bFlash = (g_sCloud.ui32FlashPoints != 0);
+    if(bFlash)
+    {
+        psPoints = SPILL_BLOCK(g_sCloud.ui32ReadBlock)->psPoints +
+                   g_sCloud.ui32ReadOffset;
+        ui32Avail = SPILL_BLOCK(g_sCloud.ui32ReadBlock)->ui32Count -
+                    g_sCloud.ui32ReadOffset;
+    }
+    else
+    {
+        psPoints = 0;
+        ui32Avail = RingUsed();
+    }
+
+    if(ui32Avail == 0)
+    {
+        return(false);
+    }
+    if(ui32Avail > CLOUD_BATCH_MAX)
+    {
+        ui32Avail = CLOUD_BATCH_MAX;
+    }
+
+    //
+    // Start the request so that the space left for the body is known.
+    //
+    HTTPRequestInit(&sRequest, g_sCloud.pcRequest, CLOUD_REQUEST_SIZE);
+    HTTPRequestStart(&sRequest, HTTP_MESSAGE_POST, g_sCloud.pcPath);
+    HTTPRequestHeaderAdd(&sRequest, "Host", g_sCloud.pcHost);
+    HTTPRequestHeaderAdd(&sRequest, "Connection", "keep-alive");
+    HTTPRequestHeaderAdd(&sRequest, "Content-Type", "application/json");
+    ui32HeadLen = HTTPRequestLenGet(&sRequest);
+
+    ui32PrefixLen = usnprintf(pcPrefix, sizeof(pcPrefix), "{\"up\":%u,\"p\":[",
+                              g_sCloud.ui32NowMS);
+
+    //
+    // First pass: how many points fit, and the exact body length.  The
+    // Content-Length header needs room for up to 10 digits, plus the blank
+    // line, the closing "]}" and the terminating NUL.
+    //
+    ui32BodyLen = ui32PrefixLen + 2;
+    for(ui32Count = 0; ui32Count < ui32Avail; ui32Count++)
+    {
+        ui32Idx = PointRender(0, bFlash ? &psPoints[ui32Count] :
+                                          RingPoint(ui32Count),
+                              ui32Count == 0);
+        if((ui32HeadLen + 16 + 10 + 4 + ui32BodyLen + ui32Idx) >=
+           CLOUD_REQUEST_SIZE)
+        {
+            break;
+        }
+        ui32BodyLen += ui32Idx;
+    }
+
+    if(ui32Count == 0)
+    {
+        return(false);
+    }
+
+    //
+    // Second pass: render.
+    //
+    HTTPRequestHeaderAddU32(&sRequest, "Content-Length", ui32BodyLen);
+    HTTPRequestHeadersEnd(&sRequest);
+    HTTPRequestAppend(&sRequest, pcPrefix, ui32PrefixLen);
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        PointRender(&sRequest, bFlash ? &psPoints[ui32Idx] :
+                                        RingPoint(ui32Idx),
+                    ui32Idx == 0);
+    }
+    HTTPRequestAppend(&sRequest, "]}", 2);
+
+    if((HTTPRequestFlagsGet(&sRequest) & HTTP_REQUEST_FLAG_OVERFLOW) ||
+       (EthClientSend((int8_t *)g_sCloud.pcRequest,
+                      HTTPRequestLenGet(&sRequest)) != 0))
+    {
+        return(false);
+    }
+
+    g_sCloud.ui32BatchSource = bFlash ? BATCH_FLASH : BATCH_RAM;
+    g_sCloud.ui32BatchCount = ui32Count;
+    g_sCloud.bResponseDone = false;
+    g_sCloud.bResponseOK = false;
+    g_sCloud.bServerClose = false;
+    HTTPParserReset(&g_sCloud.sParser);
+
+    g_sCloud.eState = CLOUD_STATE_RESPONSE_WAIT;
+    g_sCloud.ui32Deadline = g_sCloud.ui32NowMS + CLOUD_RESPONSE_TIMEOUT_MS;
+    g_sCloud.sStats.ui32Requests++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// The server acknowledged the batch in flight: drop it from the queue.
+//
+//*****************************************************************************
+static void
+BatchCommit(void)
+{
+    const tSpillBlock *psBlock;
+
+    g_sCloud.sStats.ui32Sent += g_sCloud.ui32BatchCount;
+
+    if(g_sCloud.ui32BatchSource == BATCH_RAM)
+    {
+        g_sCloud.ui32Tail += g_sCloud.ui32BatchCount;
+    }
+    else if(g_sCloud.ui32BatchSource == BATCH_FLASH)
+    {
+        g_sCloud.ui32FlashPoints -= g_sCloud.ui32BatchCount;
+        g_sCloud.ui32ReadOffset += g_sCloud.ui32BatchCount;
+
+        psBlock = SPILL_BLOCK(g_sCloud.ui32ReadBlock);
+        if(g_sCloud.ui32ReadOffset >= psBlock->ui32Count)
+        {
+            g_sCloud.ui32AckSeq = psBlock->ui32Seq;
+            SpillReadNext();
+
+            //
+            // Record progress in flash once the backlog is drained, and every
+            // half sector during a long replay, so that delivered blocks are
+            // not replayed again after a reset.
+            //
+            g_sCloud.ui32AckUnrecorded++;
+            if((g_sCloud.ui32FlashPoints == 0) ||
+               (g_sCloud.ui32AckUnrecorded >= (SPILL_BLOCKS_PER_SECTOR / 2)))
+            {
+                g_sCloud.bAckPending = true;
+            }
+        }
+    }
+
+    g_sCloud.ui32BatchSource = BATCH_NONE;
+    g_sCloud.ui32BatchCount = 0;
+    g_sCloud.ui32RetryMS = CLOUD_RETRY_MIN_MS;
+}
+
+//*****************************************************************************
+//
+// A request or connection attempt failed.  The batch stays queued; wait
+// before trying again, backing off on repeated failures.
+//
+//*****************************************************************************
+static void
+UplinkFailed(void)
+{
+    g_sCloud.sStats.ui32Failures++;
+    g_sCloud.ui32BatchSource = BATCH_NONE;
+    g_sCloud.ui32BatchCount = 0;
+
+    g_sCloud.ui32NextSendMS = g_sCloud.ui32NowMS + g_sCloud.ui32RetryMS;
+    g_sCloud.ui32RetryMS *= 2;
+    if(g_sCloud.ui32RetryMS > CLOUD_RETRY_MAX_MS)
+    {
+        g_sCloud.ui32RetryMS = CLOUD_RETRY_MAX_MS;
+    }
+}
+
+//*****************************************************************************
+//
+// A DNS lookup or connection attempt failed.  No batch is in flight yet, and
+// the Ethernet client holds off the next attempt itself (see
+// EthClientRetryDelayGet()), so there is nothing to delay here.
+//
+//*****************************************************************************
+static void
+ConnectFailed(void)
+{
+    g_sCloud.sStats.ui32Failures++;
+}
+
+//*****************************************************************************
+//
+// Close the connection to the server.
+//
+//*****************************************************************************
+static void
+UplinkClose(void)
+{
+    EthClientTCPDisconnect();
+
+    if(g_sCloud.eState != CLOUD_STATE_NO_LINK)
+    {
+        g_sCloud.eState = CLOUD_STATE_DISCONNECTED;
+    }
+}
+
+//*****************************************************************************
+//
+// Response parser events.
+//
+//*****************************************************************************
+static void
+CloudParserEvent(void *pvCBData, uint32_t ui32Event, const char *pcData1,
+                 uint32_t ui32Len1, const char *pcData2, uint32_t ui32Len2)
+{
+    if(ui32Event == HTTP_PARSE_EVENT_COMPLETE)
+    {
+        g_sCloud.bResponseDone = true;
+        g_sCloud.bResponseOK = (ui32Len2 >= 200) && (ui32Len2 < 300);
+        g_sCloud.bServerClose = ((HTTPParserFlagsGet(&g_sCloud.sParser) &
+                                  HTTP_PARSER_FLAG_CLOSE) != 0);
+    }
+    else if(ui32Event == HTTP_PARSE_EVENT_ERROR)
+    {
+        g_sCloud.bResponseDone = true;
+        g_sCloud.bResponseOK = false;
+        g_sCloud.bServerClose = true;
+    }
+}
+
+//*****************************************************************************
+//
+// Finish the request in flight once its response is complete.  bConnected is
+// false when called because the connection has already gone away.
+//
+//*****************************************************************************
+static void
+ResponseHandle(bool bConnected)
+{
+    if(g_sCloud.bResponseOK)
+    {
+        BatchCommit();
+
+        //
+        // Pace backlog replay; live data goes out as soon as it is due.
+        //
+        g_sCloud.ui32NextSendMS = g_sCloud.ui32NowMS;
+        if(g_sCloud.ui32FlashPoints || (RingUsed() >= CLOUD_BATCH_MIN))
+        {
+            g_sCloud.ui32NextSendMS += CLOUD_REPLAY_INTERVAL_MS;
+        }
+    }
+    else
+    {
+        UplinkFailed();
+    }
+
+    g_sCloud.eState = CLOUD_STATE_IDLE;
+
+    //
+    // Do not reuse a connection the server is about to close, or one that
+    // produced an error.
+    //
+    if(bConnected && (g_sCloud.bServerClose || !g_sCloud.bResponseOK))
+    {
+        UplinkClose();
+    }
+}
+
+//*****************************************************************************
+//
+// Returns true if a request should be sent now.
+//
+//*****************************************************************************
+static bool
+SendDue(void)
+{
+    if(!TimeReached(g_sCloud.ui32NowMS, g_sCloud.ui32NextSendMS))
+    {
+        return(false);
+    }
+
+    if(g_sCloud.ui32FlashPoints || (RingUsed() >= CLOUD_BATCH_MIN))
+    {
+        return(true);
+    }
+
+    return((RingUsed() != 0) &&
+           TimeReached(g_sCloud.ui32NowMS,
+                       RingPoint(0)->ui32TimeMS + CLOUD_FLUSH_MS));
+}
+
+//*****************************************************************************
+//
+//! Initialize the cloud uplink.
+//!
+//! \param pcHost is the server host name, also sent as the Host header.
+//! \param ui16Port is the server TCP port.
+//! \param pcPath is the resource the batches are POSTed to.
+//! \param ppcChannels is an array of channel names used in the request body.
+//! \param ui32NumChannels is the number of entries in \e ppcChannels.
+//!
+//! All strings are referenced, not copied.  Undelivered data spilled to
+//! flash before a reset is recovered and will be replayed.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CloudUplinkInit(const char *pcHost, uint16_t ui16Port, const char *pcPath,
+                const char * const *ppcChannels, uint32_t ui32NumChannels)
+{
+    memset(&g_sCloud, 0, sizeof(g_sCloud));
+
+    g_sCloud.pcHost = pcHost;
+    g_sCloud.ui16Port = ui16Port;
+    g_sCloud.pcPath = pcPath;
+    g_sCloud.ppcChannels = ppcChannels;
+    g_sCloud.ui32NumChannels = ui32NumChannels;
+
+    g_sCloud.eState = CLOUD_STATE_NO_LINK;
+    g_sCloud.ui32RetryMS = CLOUD_RETRY_MIN_MS;
+
+    HTTPParserInit(&g_sCloud.sParser, CloudParserEvent, 0);
+
+    SpillScan();
+}
+
+//*****************************************************************************
+//
+//! Queue a datapoint for upload.
+//!
+//! \param ui32Channel is the index of the channel name in the table passed to
+//! CloudUplinkInit().
+//! \param i32Value is the value.
+//!
+//! The point is timestamped with the uplink's uptime.  This function must be
+//! called from the same context as CloudUplinkTick(); it is not interrupt
+//! safe.
+//!
+//! \return Returns \b false if the RAM queue was full and the point was
+//! dropped.
+//
+//*****************************************************************************
+bool
+CloudUplinkPointAdd(uint32_t ui32Channel, int32_t i32Value)
+{
+    tCloudPoint *psPoint;
+
+    if(RingUsed() >= CLOUD_RAM_POINTS)
+    {
+        g_sCloud.sStats.ui32Dropped++;
+        return(false);
+    }
+
+    psPoint = &g_sCloud.psRing[g_sCloud.ui32Head % CLOUD_RAM_POINTS];
+    psPoint->ui32TimeMS = g_sCloud.ui32NowMS;
+    psPoint->ui32Channel = ui32Channel;
+    psPoint->i32Value = i32Value;
+    g_sCloud.ui32Head++;
+
+    g_sCloud.sStats.ui32Queued++;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Move queued points to the flash spill area.
+//!
+//! Programs at most one spill block: the oldest RAM points once the queue
+//! holds CLOUD_SPILL_THRESHOLD of them, or else a pending acknowledgment
+//! record.  Nothing is moved while a batch is in flight, so that the points
+//! being moved can never be the ones awaiting acknowledgment.
+//!
+//! \param bMayErase is \b false when the caller cannot accept the stall of a
+//! sector erase.  A block that would start a new sector then waits, and the
+//! RAM queue keeps filling in the meantime.
+//!
+//! This function erases and programs flash, so it must not be called from an
+//! interrupt handler.  The caller must keep CloudUplinkTick(),
+//! CloudUplinkPointAdd() and CloudUplinkEnetEvent() from running during the
+//! call (for example by masking the Ethernet interrupt) and must own the
+//! flash controller.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CloudUplinkSpill(bool bMayErase)
+{
+    if((g_sCloud.ui32BatchSource != BATCH_NONE) ||
+       (!bMayErase &&
+        ((g_sCloud.ui32WriteBlock % SPILL_BLOCKS_PER_SECTOR) == 0)))
+    {
+        return;
+    }
+
+    if(RingUsed() >= CLOUD_SPILL_THRESHOLD)
+    {
+        SpillFromRAM();
+    }
+    else if(g_sCloud.bAckPending && !SpillWriteErases())
+    {
+        SpillWrite(0, 0, 0, 0);
+        g_sCloud.bAckPending = false;
+        g_sCloud.ui32AckUnrecorded = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Run the uplink.
+//!
+//! \param ui32TickMS is the number of milliseconds since the previous call.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CloudUplinkTick(uint32_t ui32TickMS)
+{
+    int32_t i32Error;
+
+    g_sCloud.ui32NowMS += ui32TickMS;
+
+    switch(g_sCloud.eState)
+    {
+        case CLOUD_STATE_DISCONNECTED:
+        {
+            //
+            // Connect only when there is something to send, and not before
+            // the Ethernet client's reconnect backoff has expired.
+            //
+            if(SendDue() && (EthClientRetryDelayGet() == 0))
+            {
+                //
+                // ERR_INPROGRESS (-5) means the lookup was queued.
+                //
+                EthClientHostSet(g_sCloud.pcHost, g_sCloud.ui16Port);
+                i32Error = EthClientDNSResolve();
+                if((i32Error == 0) || (i32Error == -5))
+                {
+                    g_sCloud.eState = CLOUD_STATE_DNS_WAIT;
+                    g_sCloud.ui32Deadline = g_sCloud.ui32NowMS +
+                                            CLOUD_RESPONSE_TIMEOUT_MS;
+                }
+                else
+                {
+                    ConnectFailed();
+                }
+            }
+            break;
+        }
+
+        case CLOUD_STATE_DNS_WAIT:
+        case CLOUD_STATE_CONNECT_WAIT:
+        {
+            if(TimeReached(g_sCloud.ui32NowMS, g_sCloud.ui32Deadline))
+            {
+                ConnectFailed();
+                UplinkClose();
+            }
+            break;
+        }
+
+        case CLOUD_STATE_IDLE:
+        {
+            if(SendDue() && !BatchSend())
+            {
+                UplinkFailed();
+            }
+            break;
+        }
+
+        case CLOUD_STATE_RESPONSE_WAIT:
+        {
+            if(g_sCloud.bResponseDone)
+            {
+                ResponseHandle(true);
+            }
+            else if(TimeReached(g_sCloud.ui32NowMS, g_sCloud.ui32Deadline))
+            {
+                UplinkFailed();
+                UplinkClose();
+            }
+            break;
+        }
+
+        case CLOUD_STATE_NO_LINK:
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Handle Ethernet client events for the uplink.
+//!
+//! \param ui32Event is the ETH_CLIENT_EVENT_* value.
+//! \param pvData is the event data.
+//! \param ui32Param is the event parameter.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CloudUplinkEnetEvent(uint32_t ui32Event, void *pvData, uint32_t ui32Param)
+{
+    switch(ui32Event)
+    {
+        case ETH_CLIENT_EVENT_DHCP:
+        {
+            g_sCloud.eState = CLOUD_STATE_DISCONNECTED;
+            break;
+        }
+
+        case ETH_CLIENT_EVENT_DNS:
+        {
+            if(g_sCloud.eState != CLOUD_STATE_DNS_WAIT)
+            {
+                break;
+            }
+
+            if(pvData && (EthClientTCPConnect() == 0))
+            {
+                g_sCloud.eState = CLOUD_STATE_CONNECT_WAIT;
+                g_sCloud.ui32Deadline = g_sCloud.ui32NowMS +
+                                        CLOUD_RESPONSE_TIMEOUT_MS;
+            }
+            else
+            {
+                ConnectFailed();
+                g_sCloud.eState = CLOUD_STATE_DISCONNECTED;
+            }
+            break;
+        }
+
+        case ETH_CLIENT_EVENT_CONNECT:
+        {
+            if(g_sCloud.eState == CLOUD_STATE_CONNECT_WAIT)
+            {
+                g_sCloud.eState = CLOUD_STATE_IDLE;
+                g_sCloud.sStats.ui32Connects++;
+            }
+            break;
+        }
+
+        case ETH_CLIENT_EVENT_RECEIVE:
+        {
+            if(g_sCloud.eState == CLOUD_STATE_RESPONSE_WAIT)
+            {
+                HTTPParserFeed(&g_sCloud.sParser, (const char *)pvData,
+                               ui32Param);
+            }
+            break;
+        }
+
+        case ETH_CLIENT_EVENT_DISCONNECT:
+        case ETH_CLIENT_EVENT_ERROR:
+        {
+            //
+            // A response delimited by the connection closing is complete
+            // now; anything else in flight has failed.
+            //
+            if(g_sCloud.eState == CLOUD_STATE_RESPONSE_WAIT)
+            {
+                if(!g_sCloud.bResponseDone)
+                {
+                    HTTPParserFinish(&g_sCloud.sParser);
+                }
+                if(g_sCloud.bResponseDone)
+                {
+                    ResponseHandle(false);
+                }
+                else
+                {
+                    UplinkFailed();
+                }
+            }
+            else if((g_sCloud.eState == CLOUD_STATE_DNS_WAIT) ||
+                    (g_sCloud.eState == CLOUD_STATE_CONNECT_WAIT))
+            {
+                ConnectFailed();
+            }
+
+            //
+            // Loss of the IP address means waiting for DHCP again.
+            //
+            if((EthClientAddrGet() == 0) ||
+               (EthClientAddrGet() == 0xffffffff))
+            {
+                g_sCloud.eState = CLOUD_STATE_NO_LINK;
+            }
+            else if(g_sCloud.eState != CLOUD_STATE_NO_LINK)
+            {
+                g_sCloud.eState = CLOUD_STATE_DISCONNECTED;
+            }
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Return the uplink statistics.
+//!
+//! \param psStats is a pointer to the structure that receives the statistics.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CloudUplinkStatsGet(tCloudUplinkStats *psStats)
+{
+    *psStats = g_sCloud.sStats;
+    psStats->ui32RAMBacklog = RingUsed();
+    psStats->ui32FlashBacklog = g_sCloud.ui32FlashPoints;
+}
@@ -0,0 +1,169 @@
+//*****************************************************************************
+//
+// cloud_uplink.h - Batched, store-and-forward telemetry upload over HTTP.
+//
+//*****************************************************************************
+#ifndef CLOUD_UPLINK_H_
+#define CLOUD_UPLINK_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Number of datapoints held in the RAM queue.
+//
+//*****************************************************************************
+#ifndef CLOUD_RAM_POINTS
+#define CLOUD_RAM_POINTS                128
+#endif
+
+//*****************************************************************************
+//
+// When the RAM queue holds this many points the oldest ones are moved to the
+// flash spill area, one block at a time.
+//
+//*****************************************************************************
+#ifndef CLOUD_SPILL_THRESHOLD
+#define CLOUD_SPILL_THRESHOLD           ((CLOUD_RAM_POINTS * 3) / 4)
+#endif
+
+//*****************************************************************************
+//
+// Upload batching.  A live batch is sent once CLOUD_BATCH_MIN points are
+// queued or the oldest queued point is CLOUD_FLUSH_MS old.  No request carries
+// more than CLOUD_BATCH_MAX points.
+//
+//*****************************************************************************
+#ifndef CLOUD_BATCH_MIN
+#define CLOUD_BATCH_MIN                 16
+#endif
+#ifndef CLOUD_BATCH_MAX
+#define CLOUD_BATCH_MAX                 48
+#endif
+#ifndef CLOUD_FLUSH_MS
+#define CLOUD_FLUSH_MS                  10000
+#endif
+
+//*****************************************************************************
+//
+// Minimum time between two backlog (replay) requests, so that catching up
+// after an outage does not monopolize the link or the server.
+//
+//*****************************************************************************
+#ifndef CLOUD_REPLAY_INTERVAL_MS
+#define CLOUD_REPLAY_INTERVAL_MS        250
+#endif
+
+//*****************************************************************************
+//
+// Retry delay after a failed request.  The delay doubles on each consecutive
+// failure up to CLOUD_RETRY_MAX_MS.  Failed DNS lookups and connection
+// attempts are paced by the Ethernet client instead (ETH_CLIENT_RETRY_MIN_MS
+// and ETH_CLIENT_RETRY_MAX_MS).
+//
+//*****************************************************************************
+#ifndef CLOUD_RETRY_MIN_MS
+#define CLOUD_RETRY_MIN_MS              1000
+#endif
+#ifndef CLOUD_RETRY_MAX_MS
+#define CLOUD_RETRY_MAX_MS              60000
+#endif
+
+//*****************************************************************************
+//
+// Time allowed for the server to answer a request.
+//
+//*****************************************************************************
+#ifndef CLOUD_RESPONSE_TIMEOUT_MS
+#define CLOUD_RESPONSE_TIMEOUT_MS       5000
+#endif
+
+//*****************************************************************************
+//
+// Size of the buffer the upload request is rendered into.  It must hold the
+// request head plus CLOUD_BATCH_MAX points; batches are cut short when it
+// does not.
+//
+//*****************************************************************************
+#ifndef CLOUD_REQUEST_SIZE
+#define CLOUD_REQUEST_SIZE              1536
+#endif
+
+//*****************************************************************************
+//
+// Upload statistics returned by CloudUplinkStatsGet().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Points accepted by CloudUplinkPointAdd().
+    //
+    uint32_t ui32Queued;
+
+    //
+    // Points acknowledged by the server.
+    //
+    uint32_t ui32Sent;
+
+    //
+    // Points moved from RAM to the flash spill area.
+    //
+    uint32_t ui32Spilled;
+
+    //
+    // Points lost because both the RAM queue and the spill area were full.
+    //
+    uint32_t ui32Dropped;
+
+    //
+    // Requests sent, and requests that failed (error status, timeout or
+    // connection loss).
+    //
+    uint32_t ui32Requests;
+    uint32_t ui32Failures;
+
+    //
+    // TCP connections opened (including ones reused by the Ethernet client).
+    // With keep-alive this stays far below ui32Requests.
+    //
+    uint32_t ui32Connects;
+
+    //
+    // Points currently waiting in RAM and in flash.
+    //
+    uint32_t ui32RAMBacklog;
+    uint32_t ui32FlashBacklog;
+}
+tCloudUplinkStats;
+
+//*****************************************************************************
+//
+// Exported function prototypes.
+//
+//*****************************************************************************
+extern void CloudUplinkInit(const char *pcHost, uint16_t ui16Port,
+                            const char *pcPath,
+                            const char * const *ppcChannels,
+                            uint32_t ui32NumChannels);
+extern bool CloudUplinkPointAdd(uint32_t ui32Channel, int32_t i32Value);
+extern void CloudUplinkTick(uint32_t ui32TickMS);
+extern void CloudUplinkSpill(bool bMayErase);
+extern void CloudUplinkEnetEvent(uint32_t ui32Event, void *pvData,
+                                 uint32_t ui32Param);
+extern void CloudUplinkStatsGet(tCloudUplinkStats *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLOUD_UPLINK_H_
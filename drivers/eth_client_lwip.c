@@ -53,6 +53,8 @@
 #define FLAG_TIMER_TCP_EN       2
 #define FLAG_DHCP_STARTED       3
 #define FLAG_DNS_ADDRFOUND      4
+#define FLAG_TCP_CONNECTING     5
+#define FLAG_TCP_REUSED         6
 
 //*****************************************************************************
 //
@@ -118,6 +120,38 @@ struct
     //
     tEventFunction pfnEvent;
 
+    //
+    // Optional application hook run from the lwIP host timer.
+    //
+    tTimerFunction pfnTimer;
+
+    //
+    // Milliseconds counted by the host timer, and the time left until the
+    // next DNS timer call.
+    //
+    uint32_t ui32NowMS;
+    uint32_t ui32DNSTimerMS;
+
+    //
+    // Reconnect backoff: the current (unrandomized) delay, the time the next
+    // attempt is allowed, whether that time applies, and the state of the
+    // random number generator used for jitter.
+    //
+    uint32_t ui32RetryMS;
+    uint32_t ui32RetryAtMS;
+    bool bRetryWait;
+    uint32_t ui32Random;
+
+    //
+    // Start time of the connection attempt in progress.
+    //
+    uint32_t ui32ConnectStartMS;
+
+    //
+    // Connection statistics.
+    //
+    tEthClientStats sStats;
+
     //
     // States.
     //
@@ -148,6 +182,94 @@ g_sEnet;
 //*****************************************************************************
 uint8_t g_pui8SendBuff[SEND_BUFFER_SIZE];
 
+//*****************************************************************************
+//
+// Returns true if time ui32A is at or after time ui32B (wrap safe).
+//
+//*****************************************************************************
+static bool
+TimeReached(uint32_t ui32A, uint32_t ui32B)
+{
+    return((int32_t)(ui32A - ui32B) >= 0);
+}
+
+//*****************************************************************************
+//
+// Returns the next value of a xorshift32 generator.  It only spreads out
+// retry times, so statistical quality does not matter.
+//
+//*****************************************************************************
+static uint32_t
+RandomNext(void)
+{
+    uint32_t ui32X;
+
+    ui32X = g_sEnet.ui32Random;
+    ui32X ^= ui32X << 13;
+    ui32X ^= ui32X >> 17;
+    ui32X ^= ui32X << 5;
+    g_sEnet.ui32Random = ui32X;
+
+    return(ui32X);
+}
+
+//*****************************************************************************
+//
+// Record a failed lookup or connection attempt and hold off the next one.
+// The wait is a random time between half and all of the current delay, which
+// then doubles up to ETH_CLIENT_RETRY_MAX_MS.
+//
+//*****************************************************************************
+static void
+BackoffFailure(void)
+{
+    uint32_t ui32Half;
+
+    ui32Half = g_sEnet.ui32RetryMS / 2;
+    g_sEnet.ui32RetryAtMS = g_sEnet.ui32NowMS + ui32Half +
+                            (RandomNext() % (ui32Half + 1));
+    g_sEnet.bRetryWait = true;
+
+    g_sEnet.ui32RetryMS *= 2;
+    if(g_sEnet.ui32RetryMS > ETH_CLIENT_RETRY_MAX_MS)
+    {
+        g_sEnet.ui32RetryMS = ETH_CLIENT_RETRY_MAX_MS;
+    }
+
+    g_sEnet.sStats.ui32ConsecutiveFailures++;
+}
+
+//*****************************************************************************
+//
+// Clear the backoff so that the next attempt may start at once.
+//
+//*****************************************************************************
+static void
+BackoffReset(void)
+{
+    g_sEnet.ui32RetryMS = ETH_CLIENT_RETRY_MIN_MS;
+    g_sEnet.bRetryWait = false;
+    g_sEnet.sStats.ui32ConsecutiveFailures = 0;
+}
+
+//*****************************************************************************
+//
+// Returns true, and counts the refusal, if the backoff delay has not expired.
+//
+//*****************************************************************************
+static bool
+BackoffActive(void)
+{
+    if(g_sEnet.bRetryWait &&
+       !TimeReached(g_sEnet.ui32NowMS, g_sEnet.ui32RetryAtMS))
+    {
+        g_sEnet.sStats.ui32Deferred++;
+        return(true);
+    }
+
+    return(false);
+}
+
 //*****************************************************************************
 //
 // Reset the state to a non-connected state.
@@ -174,6 +296,9 @@ ResetConnection(void)
         tcp_abort(g_sEnet.psTCP);
         g_sEnet.psTCP = NULL;
     }
+
+    HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) = 0;
+    HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED) = 0;
 }
 
 //*****************************************************************************
@@ -226,7 +351,9 @@ DNSServerFound(const char *pcName, struct ip_addr *psIPAddr, void *vpArg)
 //! \param iErr is the error that was detected.
 //!
 //! This function is called when the lwIP TCP/IP stack has detected an error.
-//! The connection is no longer valid.
+//! The connection is no longer valid and lwIP has already freed its control
+//! structure, so it must not be used again.  An error before the connection
+//! was established is a failed attempt and starts the backoff delay.
 //!
 //! \return None.
 //
@@ -234,6 +361,20 @@ DNSServerFound(const char *pcName, struct ip_addr *psIPAddr, void *vpArg)
 void
 TCPError(void *vPArg, err_t iErr)
 {
+    g_sEnet.psTCP = NULL;
+    HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED) = 0;
+
+    if(HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING))
+    {
+        HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) = 0;
+        g_sEnet.sStats.ui32ConnectFailures++;
+        BackoffFailure();
+    }
+    else
+    {
+        g_sEnet.sStats.ui32Errors++;
+    }
+
     //
     // Signal event handler that there was an error.
     //
@@ -261,45 +402,56 @@ TCPReceived(void *pvArg, struct tcp_pcb *psPcb, struct pbuf *psBuf, err_t iErr)
     struct pbuf *psBufCur;
 
     //
-    // Signal event handler that data is available.
+    // A NULL buffer means the remote end closed the connection.  Close our
+    // side as well and let the application know, so that a response that is
+    // delimited by the connection closing can be completed.
     //
-    g_sEnet.pfnEvent(ETH_CLIENT_EVENT_RECEIVE, (void *)psBuf->payload,
-            (uint32_t)psBuf->len);
+    if(psBuf == NULL)
+    {
+        if(psPcb == g_sEnet.psTCP)
+        {
+            tcp_sent(psPcb, NULL);
+            tcp_recv(psPcb, NULL);
+            tcp_err(psPcb, NULL);
+            g_sEnet.psTCP = NULL;
+            HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED) = 0;
+        }
 
-    //
-    // Indicate that you have received and processed this set of TCP data.
-    //
-    tcp_recved(psPcb, psBuf->len);
+        g_sEnet.sStats.ui32Disconnects++;
 
-    //
-    // Initialize the linked list pointer to parse.
-    //
-    psBufCur = psBuf;
+        if(tcp_close(psPcb) != ERR_OK)
+        {
+            tcp_abort(psPcb);
+            g_sEnet.pfnEvent(ETH_CLIENT_EVENT_DISCONNECT, 0, 0);
+            return(ERR_ABRT);
+        }
+
+        g_sEnet.pfnEvent(ETH_CLIENT_EVENT_DISCONNECT, 0, 0);
+
+        return(ERR_OK);
+    }
 
     //
-    // Free the buffers used since they have been processed.
+    // Hand every buffer in the chain to the event handler in order.  Each
+    // one is passed in place; the handler is expected to consume the data
+    // incrementally (see HTTPParserFeed()) rather than copy it.
     //
-    while(psBufCur->len != 0)
+    for(psBufCur = psBuf; psBufCur != NULL; psBufCur = psBufCur->next)
     {
-        //
-        // Indicate that you have received and processed this set of TCP data.
-        //
-        tcp_recved(psPcb, psBufCur->len);
-
-        //
-        // Go to the next buffer.
-        //
-        psBufCur = psBufCur->next;
-
-        //
-        // Terminate if there are no more buffers.
-        //
-        if(psBufCur == 0)
+        if(psBufCur->len != 0)
         {
-            break;
+            g_sEnet.pfnEvent(ETH_CLIENT_EVENT_RECEIVE,
+                             (void *)psBufCur->payload,
+                             (uint32_t)psBufCur->len);
         }
     }
 
+    //
+    // Indicate that you have received and processed this set of TCP data.
+    // The total length of the chain is acknowledged once.
+    //
+    tcp_recved(psPcb, psBuf->tot_len);
+
     //
     // Free the memory space allocated for this receive.
     //
@@ -378,6 +530,10 @@ TCPConnected(void *pvArg, struct tcp_pcb *psPcb, err_t iErr)
             g_sEnet.psTCP = 0;
         }
 
+        HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) = 0;
+        g_sEnet.sStats.ui32ConnectFailures++;
+        BackoffFailure();
+
         //
         // And return.
         //
@@ -385,14 +541,18 @@ TCPConnected(void *pvArg, struct tcp_pcb *psPcb, err_t iErr)
     }
 
     //
-    // Setup the TCP receive function.
+    // The attempt succeeded: record how long it took and clear the backoff.
     //
-    tcp_recv(psPcb, TCPReceived);
+    HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) = 0;
+    g_sEnet.sStats.ui32Connects++;
+    g_sEnet.sStats.ui32LastConnectMS = g_sEnet.ui32NowMS -
+                                       g_sEnet.ui32ConnectStartMS;
+    BackoffReset();
 
     //
-    // Setup the TCP error function.
+    // Setup the TCP receive function.
     //
-    tcp_err(psPcb, TCPError);
+    tcp_recv(psPcb, TCPReceived);
 
     //
     // Setup the TCP sent callback function.
@@ -414,67 +574,97 @@ TCPConnected(void *pvArg, struct tcp_pcb *psPcb, err_t iErr)
 //
 //! TCP connect
 //!
-//! This function attempts to connect to a TCP endpoint.
+//! This function attempts to connect to a TCP endpoint.  If the connection
+//! from a previous call is still established to the same address and port it
+//! is reused, and \b ETH_CLIENT_EVENT_CONNECT follows on the next host timer
+//! tick just as for a new connection.
 //!
-//! \return None.
+//! \return Returns 0 if the connection is established or in progress, or 1 if
+//! it could not be started or the backoff delay after a previous failure has
+//! not expired (see EthClientRetryDelayGet()).
 //
 //*****************************************************************************
 int32_t
 EthClientTCPConnect(void)
 {
     err_t eTCPReturnCode;
+    uint16_t ui16Port;
+
+    //
+    // Check if you need to go through a proxy.
+    //
+    if(g_sEnet.pcProxyName != 0)
+    {
+        ui16Port = g_sEnet.ui16ProxyPort;
+    }
+    else
+    {
+        ui16Port = g_sEnet.ui16HostPort;
+    }
 
     //
     // Enable the TCP timer function calls.
     //
     HWREGBITW(&g_sEnet.ui32Flags, FLAG_TIMER_TCP_EN) = 1;
 
-    if(g_sEnet.psTCP)
+    //
+    // Reuse the open connection if it goes to the same place.
+    //
+    if((g_sEnet.psTCP != NULL) &&
+       !HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) &&
+       (g_sEnet.psTCP->state == ESTABLISHED) &&
+       (g_sEnet.psTCP->remote_ip.addr == g_sEnet.sResolvedIP.addr) &&
+       (g_sEnet.psTCP->remote_port == ui16Port))
     {
-        //
-        // Initially clear out all of the TCP callbacks.
-        //
-        tcp_sent(g_sEnet.psTCP, NULL);
-        tcp_recv(g_sEnet.psTCP, NULL);
-        tcp_err(g_sEnet.psTCP, NULL);
+        g_sEnet.sStats.ui32ConnectReuses++;
+        HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED) = 1;
+        return(0);
+    }
 
-        //
-        // Make sure there is no lingering TCP connection.
-        //
-        tcp_close(g_sEnet.psTCP);
+    if(BackoffActive())
+    {
+        return(1);
     }
 
     //
-    // Create a new TCP socket.
+    // Make sure there is no lingering TCP connection.
     //
-    g_sEnet.psTCP = tcp_new();
+    ResetConnection();
+
+    g_sEnet.sStats.ui32ConnectAttempts++;
 
     //
-    // Check if you need to go through a proxy.
+    // Create a new TCP socket.
     //
-    if(g_sEnet.pcProxyName != 0)
-    {
-        //
-        // Attempt to connect through the proxy server.
-        //
-        eTCPReturnCode = tcp_connect(g_sEnet.psTCP, &g_sEnet.sResolvedIP,
-                g_sEnet.ui16ProxyPort, TCPConnected);
-    }
-    else
+    g_sEnet.psTCP = tcp_new();
+    if(g_sEnet.psTCP == NULL)
     {
-        //
-        // Attempt to connect to the server directly.
-        //
-        eTCPReturnCode = tcp_connect(g_sEnet.psTCP, &g_sEnet.sResolvedIP,
-                g_sEnet.ui16HostPort, TCPConnected);
+        g_sEnet.sStats.ui32ConnectFailures++;
+        BackoffFailure();
+        return(1);
     }
 
+    //
+    // Install the error callback before connecting, so that a refused or
+    // timed out attempt is reported instead of leaving a stale pointer.
+    //
+    tcp_err(g_sEnet.psTCP, TCPError);
+
+    HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING) = 1;
+    g_sEnet.ui32ConnectStartMS = g_sEnet.ui32NowMS;
+
+    eTCPReturnCode = tcp_connect(g_sEnet.psTCP, &g_sEnet.sResolvedIP,
+                                 ui16Port, TCPConnected);
+
     if((eTCPReturnCode == ERR_OK) || (eTCPReturnCode == ERR_INPROGRESS))
     {
         return(0);
     }
     else
     {
+        ResetConnection();
+        g_sEnet.sStats.ui32ConnectFailures++;
+        BackoffFailure();
         return(1);
     }
 }
@@ -483,7 +673,9 @@ EthClientTCPConnect(void)
 //
 //! TCP discconnect
 //!
-//! This function attempts to disconnect a TCP endpoint.
+//! This function attempts to disconnect a TCP endpoint.  Abandoning an
+//! attempt that has not connected yet (for example on an application
+//! timeout) counts as a failure for the backoff delay.
 //!
 //! \return None.
 //
@@ -491,6 +683,12 @@ EthClientTCPConnect(void)
 void
 EthClientTCPDisconnect(void)
 {
+    if(HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_CONNECTING))
+    {
+        g_sEnet.sStats.ui32ConnectFailures++;
+        BackoffFailure();
+    }
+
     //
     // Reset connection.
     //
@@ -622,13 +820,17 @@ EthClientDHCPConnect(void)
 
 //*****************************************************************************
 //
-//! Handler function when the DNS server gets a response or times out.
+//! Resolve the host (or proxy) name.
 //!
-//! This function is called when the DNS server resolves an IP or times out.
-//! If the DNS server returns an IP structure that is not NULL, add the IP to
-//! to the g_sEnet.sResolvedIP IP structure.
+//! The result is reported with \b ETH_CLIENT_EVENT_DNS.  lwIP keeps each
+//! answer for the TTL the DNS server gave it (capped at DNS_MAX_TTL), so
+//! repeated lookups of the same name are answered without a query until it
+//! expires.
 //!
-//! \return None.
+//! \return Returns \b ERR_OK if the name was found in the cache,
+//! \b ERR_INPROGRESS if a query was sent or one is already outstanding,
+//! \b ERR_WOULDBLOCK if the backoff delay after a previous failure has not
+//! expired, or another lwIP error code.
 //
 //*****************************************************************************
 int32_t
@@ -641,6 +843,13 @@ EthClientDNSResolve(void)
         return(ERR_INPROGRESS);
     }
 
+    if(BackoffActive())
+    {
+        return(ERR_WOULDBLOCK);
+    }
+
+    g_sEnet.sStats.ui32DNSLookups++;
+
     //
     // Set DNS config timer to true.
     //
@@ -681,6 +890,14 @@ EthClientDNSResolve(void)
         // Tell the main program that a DNS address was found.
         //
         HWREGBITW(&g_sEnet.ui32Flags, FLAG_DNS_ADDRFOUND) = 1;
+        g_sEnet.sStats.ui32DNSCacheHits++;
+    }
+    else if(iRet != ERR_INPROGRESS)
+    {
+        HWREGBITW(&g_sEnet.ui32Flags, FLAG_TIMER_DNS_EN) = 0;
+        g_sEnet.eState = iEthIdle;
+        g_sEnet.sStats.ui32DNSFailures++;
+        BackoffFailure();
     }
 
     //
@@ -770,6 +987,15 @@ EthClientMACAddrGet(uint8_t *pui8MACAddr)
 void
 EthClientProxySet(const char *pcProxyName, uint16_t ui16Port)
 {
+    //
+    // Setting the same proxy again keeps the connection (and any backoff).
+    //
+    if((g_sEnet.pcProxyName == pcProxyName) &&
+       (g_sEnet.ui16ProxyPort == ui16Port))
+    {
+        return;
+    }
+
     //
     // Save the new proxy string.
     //
@@ -780,11 +1006,29 @@ EthClientProxySet(const char *pcProxyName, uint16_t ui16Port)
     // Reset the connection on any change to the proxy.
     //
     ResetConnection();
+    BackoffReset();
 }
 
+//*****************************************************************************
+//
+// Set the host name and port to connect to.
+//
+// As with EthClientProxySet(), only the pointer is stored.  Setting the same
+// host and port again keeps an open connection so that it can be reused by
+// EthClientTCPConnect().
+//
+// \return None.
+//
+//*****************************************************************************
 void
 EthClientHostSet(const char *pcHostName, uint16_t ui16Port)
 {
+    if((g_sEnet.pcHostName == pcHostName) &&
+       (g_sEnet.ui16HostPort == ui16Port))
+    {
+        return;
+    }
+
     //
     // Save the new host setting.
     //
@@ -795,6 +1039,43 @@ EthClientHostSet(const char *pcHostName, uint16_t ui16Port)
     // Reset the connection on any change to the host.
     //
     ResetConnection();
+    BackoffReset();
+}
+
+//*****************************************************************************
+//
+//! Returns the time until a new lookup or connection attempt is allowed.
+//!
+//! \return Returns the remaining backoff delay in milliseconds, or 0 if
+//! EthClientDNSResolve() and EthClientTCPConnect() may be called now.
+//
+//*****************************************************************************
+uint32_t
+EthClientRetryDelayGet(void)
+{
+    if(!g_sEnet.bRetryWait ||
+       TimeReached(g_sEnet.ui32NowMS, g_sEnet.ui32RetryAtMS))
+    {
+        return(0);
+    }
+
+    return(g_sEnet.ui32RetryAtMS - g_sEnet.ui32NowMS);
+}
+
+//*****************************************************************************
+//
+//! Returns the connection statistics.
+//!
+//! \param psStats points to the structure to fill in.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+EthClientStatsGet(tEthClientStats *psStats)
+{
+    *psStats = g_sEnet.sStats;
+    psStats->ui32RetryDelayMS = EthClientRetryDelayGet();
 }
 
 //*****************************************************************************
@@ -822,7 +1103,11 @@ EthClientInit(uint32_t ui32SysClock, tEventFunction pfnEvent)
 
     g_sEnet.eState = iEthNoConnection;
     g_sEnet.pfnEvent = pfnEvent;
+    g_sEnet.pfnTimer = 0;
     g_sEnet.pcProxyName = 0;
+    g_sEnet.ui32NowMS = 0;
+    g_sEnet.ui32DNSTimerMS = DNS_TMR_INTERVAL;
+    BackoffReset();
 
     //
     // Convert the 24/24 split MAC address from NV ram into a 32/16 split MAC
@@ -838,6 +1123,16 @@ EthClientInit(uint32_t ui32SysClock, tEventFunction pfnEvent)
     g_sEnet.pui8MACAddr[4] = ((ui32User1 >> 8) & 0xff);
     g_sEnet.pui8MACAddr[5] = ((ui32User1 >> 16) & 0xff);
 
+    //
+    // Seed the retry jitter from the MAC address, which differs between
+    // boards, and the SysTick counter.  Zero would stall the generator.
+    //
+    g_sEnet.ui32Random = ui32User0 ^ (ui32User1 << 8) ^ SysTickValueGet();
+    if(g_sEnet.ui32Random == 0)
+    {
+        g_sEnet.ui32Random = 0x9E3779B9;
+    }
+
     //
     // Initialize lwIP with the system clock, MAC and use DHCP.
     //
@@ -849,6 +1144,23 @@ EthClientInit(uint32_t ui32SysClock, tEventFunction pfnEvent)
     HWREGBITW(&g_sEnet.ui32Flags, FLAG_TIMER_DHCP_EN) = 1;
 }
 
+//*****************************************************************************
+//
+// Register a function to be called from the lwIP host timer
+//
+// The function runs every HOST_TMR_INTERVAL milliseconds in the same context
+// as the lwIP callbacks, after the client state machine, so it may use the
+// raw lwIP API directly.  Pass 0 to remove the hook.
+//
+// \return None.
+//
+//*****************************************************************************
+void
+EthClientTimerHandlerSet(tTimerFunction pfnTimer)
+{
+    g_sEnet.pfnTimer = pfnTimer;
+}
+
 //*****************************************************************************
 //
 // Periodic Tick for the Ethernet client
@@ -879,10 +1191,26 @@ lwIPHostTimerHandler(void)
 {
     uint32_t ui32IPAddr;
     err_t eError;
+
+    g_sEnet.ui32NowMS += HOST_TMR_INTERVAL;
+
 #if NO_SYS
-    if(HWREGBITW(&g_sEnet.ui32Flags, FLAG_TIMER_DNS_EN))
+    //
+    // dns_tmr() expects to run every DNS_TMR_INTERVAL.  It both retries
+    // outstanding queries and ages the cached answers, so keep it running
+    // whenever there is an address; otherwise cached names never expire.
+    //
+    if(g_sEnet.eState != iEthNoConnection)
     {
-        dns_tmr();
+        if(g_sEnet.ui32DNSTimerMS <= HOST_TMR_INTERVAL)
+        {
+            g_sEnet.ui32DNSTimerMS = DNS_TMR_INTERVAL;
+            dns_tmr();
+        }
+        else
+        {
+            g_sEnet.ui32DNSTimerMS -= HOST_TMR_INTERVAL;
+        }
     }
 
     if(HWREGBITW(&g_sEnet.ui32Flags, FLAG_TIMER_TCP_EN))
@@ -983,6 +1311,12 @@ lwIPHostTimerHandler(void)
             //
             HWREGBITW(&g_sEnet.ui32Flags, FLAG_DHCP_STARTED) = 0;
 
+            //
+            // Failures while the link was down say nothing about the
+            // server; reconnect at once.
+            //
+            BackoffReset();
+
             //
             // Signal a connect event.
             //
@@ -1002,6 +1336,9 @@ lwIPHostTimerHandler(void)
             //
             g_sEnet.eState = iEthIdle;
 
+            g_sEnet.sStats.ui32DNSFailures++;
+            BackoffFailure();
+
             //
             // Signal failure.
             //
@@ -1030,4 +1367,25 @@ lwIPHostTimerHandler(void)
                              4);
         }
     }
+
+    //
+    // Report a reused connection as connected, now that the caller of
+    // EthClientTCPConnect() has returned.
+    //
+    if(HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED))
+    {
+        HWREGBITW(&g_sEnet.ui32Flags, FLAG_TCP_REUSED) = 0;
+        if(g_sEnet.psTCP != NULL)
+        {
+            g_sEnet.pfnEvent(ETH_CLIENT_EVENT_CONNECT, 0, 0);
+        }
+    }
+
+    //
+    // Give the application its periodic slot in the lwIP context.
+    //
+    if(g_sEnet.pfnTimer)
+    {
+        g_sEnet.pfnTimer();
+    }
 }
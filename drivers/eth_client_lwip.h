@@ -55,6 +55,74 @@ extern "C"
 #define ETH_CLIENT_EVENT_SEND          0x00000006
 #define ETH_CLIENT_EVENT_ERROR         0x00000007
 
+//*****************************************************************************
+//
+// Reconnect backoff.  After a failed DNS lookup or connection attempt,
+// EthClientDNSResolve() and EthClientTCPConnect() refuse new attempts for a
+// delay that doubles with each consecutive failure, from
+// ETH_CLIENT_RETRY_MIN_MS up to ETH_CLIENT_RETRY_MAX_MS.  The actual delay is
+// randomized between half and all of that value, so that devices recovering
+// from the same outage do not reconnect in lock step.  A successful
+// connection, or a new DHCP lease, resets the delay.
+//
+//*****************************************************************************
+#ifndef ETH_CLIENT_RETRY_MIN_MS
+#define ETH_CLIENT_RETRY_MIN_MS        1000
+#endif
+#ifndef ETH_CLIENT_RETRY_MAX_MS
+#define ETH_CLIENT_RETRY_MAX_MS        60000
+#endif
+
+//*****************************************************************************
+//
+// Connection statistics returned by EthClientStatsGet().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // Host name lookups started, and how many of them were answered from
+    // the lwIP DNS cache without a query.
+    //
+    uint32_t ui32DNSLookups;
+    uint32_t ui32DNSCacheHits;
+    uint32_t ui32DNSFailures;
+
+    //
+    // TCP connection attempts, successful connections, and requests that
+    // were satisfied by the connection already open to the same server.
+    //
+    uint32_t ui32ConnectAttempts;
+    uint32_t ui32Connects;
+    uint32_t ui32ConnectReuses;
+    uint32_t ui32ConnectFailures;
+
+    //
+    // Established connections closed by the server, and connections lost
+    // to a TCP error (reset, retransmission timeout).
+    //
+    uint32_t ui32Disconnects;
+    uint32_t ui32Errors;
+
+    //
+    // Attempts refused because the backoff delay had not expired.
+    //
+    uint32_t ui32Deferred;
+
+    //
+    // Current backoff: consecutive failures and the time until the next
+    // attempt is allowed (0 when one is allowed now).
+    //
+    uint32_t ui32ConsecutiveFailures;
+    uint32_t ui32RetryDelayMS;
+
+    //
+    // Time taken by the most recent successful connection attempt.
+    //
+    uint32_t ui32LastConnectMS;
+}
+tEthClientStats;
+
 //*****************************************************************************
 //
 // The type definition for event functions.
@@ -63,6 +131,14 @@ extern "C"
 typedef void (* tEventFunction)(uint32_t ui32Event, void* pvData,
                                 uint32_t ui32Param);
 
+//*****************************************************************************
+//
+// The type definition for the host timer hook set by
+// EthClientTimerHandlerSet().
+//
+//*****************************************************************************
+typedef void (* tTimerFunction)(void);
+
 //*****************************************************************************
 //
 // Exported Ethernet function prototypes.
@@ -70,6 +146,7 @@ typedef void (* tEventFunction)(uint32_t ui32Event, void* pvData,
 //*****************************************************************************
 extern void EthClientInit(uint32_t ui32SysClock, tEventFunction pfnEvent);
 extern void EthClientTick(uint32_t ui32TickMS);
+extern void EthClientTimerHandlerSet(tTimerFunction pfnTimer);
 extern uint32_t EthClientAddrGet(void);
 extern void EthClientMACAddrGet(uint8_t *pui8Addr);
 
@@ -80,6 +157,8 @@ extern void EthClientHostSet(const char *pcHostName, uint16_t ui16Port);
 extern int32_t EthClientDNSResolve(void);
 extern uint32_t EthClientServerAddrGet(void);
 extern int32_t EthClientSend(int8_t *pi8Request, uint32_t ui32Size);
+extern uint32_t EthClientRetryDelayGet(void);
+extern void EthClientStatsGet(tEthClientStats *psStats);
 
 #ifdef __cplusplus
 }
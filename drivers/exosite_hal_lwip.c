@@ -93,6 +93,24 @@ extern uint32_t g_ui32SysClock;
 char g_pcRequest[256] = {0};
 uint8_t g_ui8RequestSize = 0;
 
+//*****************************************************************************
+//
+// Number of proxy requests that did not fit g_pcRequest and were not sent.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32ProxyOverflows = 0;
+
+//*****************************************************************************
+//
+// Parser for the proxy's reply to the CONNECT request.  The reply is fed to
+// the parser as it arrives, so it may span any number of receive events.
+// g_bProxyAccepted is set once the proxy has sent a complete 200 header
+// section.
+//
+//*****************************************************************************
+static tHTTPParser g_sProxyParser;
+static volatile bool g_bProxyAccepted = false;
+
 //*****************************************************************************
 //
 // IP address.
@@ -325,6 +343,7 @@ exoHAL_ResetConnection(void)
     HWREGBITW(&g_sExosite.ui32Flags, FLAG_RECEIVED) = 0;
     HWREGBITW(&g_sExosite.ui32Flags, FLAG_BUSY) = 0;
     HWREGBITW(&g_sExosite.ui32Flags, FLAG_PROXY_SET) = 0;
+    HWREGBITW(&g_sExosite.ui32Flags, FLAG_PROXY_ERROR) = 0;
 
     //
     // Empty the receive buffer.
@@ -339,24 +358,58 @@ exoHAL_ResetConnection(void)
 
 //*****************************************************************************
 //
-// Constructs proxy CONNECT request.
+// Constructs proxy CONNECT request.  Returns false, with g_ui8RequestSize set
+// to 0, if the request does not fit g_pcRequest.
 //
 //*****************************************************************************
-static void
+static bool
 exoHAL_ExositeConstructProxyRequest(void)
 {
     char pcTemp[128];
+    tHTTPRequest sRequest;
 
     //
-    // Construct the request.
+    // Construct the request.  The builder never writes past the end of
+    // g_pcRequest; an oversized request is not sent at all.
     //
-    usprintf(pcTemp, "%s:%d" ,EXOSITE_ADDRESS, EXOSITE_PORT);
-    HTTPMessageTypeSet(g_pcRequest, HTTP_MESSAGE_CONNECT, pcTemp);
+    usnprintf(pcTemp, sizeof(pcTemp), "%s:%d" ,EXOSITE_ADDRESS, EXOSITE_PORT);
+    HTTPRequestInit(&sRequest, g_pcRequest, sizeof(g_pcRequest));
+    HTTPRequestStart(&sRequest, HTTP_MESSAGE_CONNECT, pcTemp);
+    HTTPRequestHeaderAdd(&sRequest, "Host", pcTemp);
+    HTTPRequestHeadersEnd(&sRequest);
 
     //
     // Count the number of bytes in the transfer.
     //
-    g_ui8RequestSize = strlen(g_pcRequest);
+    if(HTTPRequestFlagsGet(&sRequest) & HTTP_REQUEST_FLAG_OVERFLOW)
+    {
+        g_ui8RequestSize = 0;
+        g_ui32ProxyOverflows++;
+        return(false);
+    }
+
+    g_ui8RequestSize = HTTPRequestLenGet(&sRequest);
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Parser events for the proxy CONNECT reply.
+//
+//*****************************************************************************
+static void
+exoHAL_ProxyParserEvent(void *pvCBData, uint32_t ui32Event,
+                        const char *pcData1, uint32_t ui32Len1,
+                        const char *pcData2, uint32_t ui32Len2)
+{
+    //
+    // Once the header section of a 2xx reply is complete the connection is a
+    // tunnel to the server and nothing that follows belongs to the proxy.
+    //
+    if((ui32Event == HTTP_PARSE_EVENT_HEADERS_DONE) && (ui32Len2 == 200))
+    {
+        g_bProxyAccepted = true;
+    }
 }
 
 //*****************************************************************************
@@ -367,7 +420,6 @@ exoHAL_ExositeConstructProxyRequest(void)
 void
 exoHAL_ExositeEnetEvents(uint32_t ui32Event, void *pvData, uint32_t ui32Param)
 {
-    uint32_t ui32NumHeaders;
     uint8_t *pD = (uint8_t *)pvData;
 
     //
@@ -413,15 +465,11 @@ exoHAL_ExositeEnetEvents(uint32_t ui32Event, void *pvData, uint32_t ui32Param)
                 case EXOSITE_STATE_PROXY_WAIT:
                 {
                     //
-                    // Check the response.
+                    // Feed the reply to the parser; it may arrive in pieces.
                     //
-                    if(!HTTPResponseParse((char *)pD, g_pcRequest,
-                                          (uint32_t *)&ui32NumHeaders))
-                    {
-                        break;
-                    }
+                    HTTPParserFeed(&g_sProxyParser, (char *)pD, ui32Param);
 
-                    if (ustrncmp((char *)pD, "200", 3))
+                    if(g_bProxyAccepted)
                     {
                         //
                         // Empty the receive buffer.
@@ -465,9 +513,18 @@ exoHAL_ExositeEnetEvents(uint32_t ui32Event, void *pvData, uint32_t ui32Param)
             if(g_bUseProxy && HWREGBITW(&g_sExosite.ui32Flags, FLAG_PROXY_SET))
             {
                 //
-                // Construct the CONNECT request.
+                // Construct the CONNECT request.  One too long for the
+                // buffer would be too long on every retry as well, so
+                // nothing is sent and exoHAL_SocketOpenTCP() gives up.
                 //
-                exoHAL_ExositeConstructProxyRequest();
+                if(!exoHAL_ExositeConstructProxyRequest())
+                {
+                    HWREGBITW(&g_sExosite.ui32Flags, FLAG_PROXY_ERROR) = 1;
+                    g_sExosite.eState = EXOSITE_STATE_NOT_CONNECTED;
+                    break;
+                }
+                HTTPParserInit(&g_sProxyParser, exoHAL_ProxyParserEvent, 0);
+                g_bProxyAccepted = false;
                 EthClientSend((int8_t *)g_pcRequest, g_ui8RequestSize);
 
                 //
@@ -686,6 +743,22 @@ exoHAL_ExositeProxySet(char *pcProxy, uint16_t ui16Port)
 
 }
 
+//*****************************************************************************
+//
+//! Returns the number of proxy CONNECT requests that were too long to build.
+//!
+//! Such a request is not sent and exoHAL_SocketOpenTCP() fails without
+//! retrying (FLAG_PROXY_ERROR).  The count is kept from boot.
+//!
+//! \return The number of requests not sent.
+//
+//*****************************************************************************
+uint32_t
+exoHAL_ProxyOverflowsGet(void)
+{
+    return(g_ui32ProxyOverflows);
+}
+
 //*****************************************************************************
 //
 //! Closes a socket.
@@ -836,6 +909,13 @@ exoHAL_SocketOpenTCP(unsigned char *pucServer)
         {
             return 0;
         }
+        else if (HWREGBITW(&g_sExosite.ui32Flags, FLAG_PROXY_ERROR))
+        {
+            //
+            // The proxy request could not be built: no retry.
+            //
+            break;
+        }
         else
         {
             //
@@ -102,6 +102,7 @@ extern uint16_t g_ui16ProxyPort;
 #define FLAG_SENT               5
 #define FLAG_RECEIVED           6
 #define FLAG_CONNECT_WAIT       7
+#define FLAG_PROXY_ERROR        8
 
 //*****************************************************************************
 //
@@ -124,6 +125,7 @@ unsigned char exoHAL_SocketSend(long lSocket, char * pcBuffer, int iLength);
 unsigned char exoHAL_SocketRecv(long lSocket, char * pcBuffer, int iLength);
 void exoHAL_MSDelay(unsigned short usDelay);
 void exoHAL_Tick(unsigned long ulDelay);
+uint32_t exoHAL_ProxyOverflowsGet(void);
 
 //*****************************************************************************
 //
@@ -30,10 +30,19 @@
 
 //*****************************************************************************
 //
-// Buffer used to store temporary strings for constructing/parsing requests.
+// Internal states of the incremental response parser (tHTTPParser).
 //
 //*****************************************************************************
-static char g_pcTempData[256];
+#define PARSE_STATE_STATUS          0
+#define PARSE_STATE_HEADER          1
+#define PARSE_STATE_BODY_LENGTH     2
+#define PARSE_STATE_BODY_EOF        3
+#define PARSE_STATE_CHUNK_SIZE      4
+#define PARSE_STATE_CHUNK_EXT       5
+#define PARSE_STATE_CHUNK_DATA      6
+#define PARSE_STATE_CHUNK_DATA_END  7
+#define PARSE_STATE_TRAILER         8
+#define PARSE_STATE_ERROR           9
 
 //*****************************************************************************
 //
@@ -50,6 +59,27 @@ static char g_pcHttpTrace[] = "TRACE ";
 static char g_pcHttpOptions[] = "OPTIONS ";
 static char g_pcHttpPatch[] = "PATCH ";
 
+//*****************************************************************************
+//
+// Request type strings indexed by HTTP_MESSAGE_* for the request builder.
+//
+//*****************************************************************************
+static const char * const g_ppcHttpMethods[] =
+{
+    g_pcHttpConnect,
+    g_pcHttpGet,
+    g_pcHttpPost,
+    g_pcHttpPut,
+    g_pcHttpDelete,
+    g_pcHttpHead,
+    g_pcHttpTrace,
+    g_pcHttpOptions,
+    g_pcHttpPatch
+};
+
+#define NUM_HTTP_METHODS    (sizeof(g_ppcHttpMethods) /                       \
+                             sizeof(g_ppcHttpMethods[0]))
+
 //*****************************************************************************
 //
 // HTTP suffixes used by HTTPMessageTypeSet().  Default is HTTP 1.1.
@@ -63,81 +93,15 @@ static const char g_pcSuffixHttp11[] = " HTTP/1.1\r\n\r\n";
 
 //*****************************************************************************
 //
-//! Extract the portion of a string up to a specified character.
-//!
-//! \param cWhichOne specifies the character to compare against.
-//! \param pcSource is a pointer to the source/input string.
-//! \param pcOutput is a pointer to the destination/output string.
-//! \param pui32Size is a pointer to a variable that will receive the size of
-//!  the destination/output string.
-//!
-//! \return None.
-//
-//*****************************************************************************
-static void
-BufferFillToCharacter(char cWhichOne, char *pcSource, char *pcOutput,
-                      uint32_t *pui32Size)
-{
-    //
-    // Search the string until the character is found.
-    //
-    *pui32Size = 0;
-    while(*pcSource)
-    {
-        if(*pcSource == cWhichOne)
-        {
-            pcOutput[*pui32Size] = 0;
-            pcSource++;
-            return;
-        }
-        else
-        {
-            pcOutput[*pui32Size] = *pcSource;
-            pcSource++;
-            *pui32Size += 1;
-        }
-    }
-
-    return;
-}
-
-//*****************************************************************************
-//
-//! Extract the portion of a string up to end-of-line (EOL).
-//!
-//! \param pcSource is a pointer to the source/input string.
-//! \param pcOutput is a pointer to the destination/output string.
-//! \param pui32Size is a pointer to a variable that will receive the size of
-//!  the destination/output string.
-//!
-//! \return None.
+// Request line suffix used by the request builder.  Unlike the suffixes
+// above this does not end the header section.
 //
 //*****************************************************************************
-static void
-BufferFillToEOL(char *pcSource, char *pcOutput, uint32_t *pui32Size)
-{
-    //
-    // Search the string until EOL is found.
-    //
-    *pui32Size = 0;
-    while(*pcSource)
-    {
-        if((*pcSource == '\r') && (*(pcSource+ 1) == '\n'))
-        {
-            pcOutput[*pui32Size] = 0;
-            pcSource += 2;
-            return;
-        }
-        else
-        {
-            pcOutput[*pui32Size] = *pcSource;
-            pcSource++;
-            *pui32Size += 1;
-        }
-    }
-
-    return;
-}
+#ifdef USE_HTTP_1_0
+static const char g_pcRequestSuffix[] = " HTTP/1.0\r\n";
+#else
+static const char g_pcRequestSuffix[] = " HTTP/1.1\r\n";
+#endif
 
 static void
 InsertRequest(char *pcDest, char *pcRequest)
@@ -383,205 +347,1465 @@ HTTPMessageBodyAdd(char *pcDest, char *pcBodyData)
 
 //*****************************************************************************
 //
-//! Parse a HTTP response.
+//! Initialize a HTTP request builder.
 //!
-//! \param pcData is a pointer to the source string/buffer.
-//! \param pcResponseText is a pointer to a string that will receive the
-//! response text from the first line of the HTTP response.
-//! \param pui32NumHeaders is a pointer to a variable that will receive the
-//! number of headers detected in pcData.
+//! \param psRequest is a pointer to the builder state.
+//! \param pcBuf is the buffer that will receive the request.
+//! \param ui32Size is the size of \e pcBuf in bytes, including room for the
+//! terminating NUL.
 //!
-//! Note that this function must be called after HTTPMessageTypeSet() as it
-//! simply appends a header to an existing string/buffer.
+//! The builder tracks its write position and the buffer capacity, so each
+//! append only touches the bytes being added and can never write past the
+//! end of \e pcBuf.  If a piece does not fit, HTTP_REQUEST_FLAG_OVERFLOW is
+//! set, the piece is dropped and all further appends fail; the request must
+//! then be discarded.
 //!
-//! \return Returns the HTTP response code.  If parsing error occurs, returns 0.
+//! \return None.
 //
 //*****************************************************************************
-uint32_t
-HTTPResponseParse(char *pcData, char *pcResponseText, uint32_t *pui32NumHeaders)
+void
+HTTPRequestInit(tHTTPRequest *psRequest, char *pcBuf, uint32_t ui32Size)
 {
-    uint32_t ui32Response = 0;
-    uint32_t ui32Size;
+    psRequest->pcBuf = pcBuf;
+    psRequest->ui32Size = ui32Size;
+    psRequest->ui32Len = 0;
+    psRequest->ui32Flags = 0;
 
-    //
-    // Look for "HTTP/n.n" piece.
-    //
-    BufferFillToCharacter(' ', pcData, g_pcTempData, &ui32Size);
-    pcData += (ui32Size + 1);
+    if(ui32Size)
+    {
+        pcBuf[0] = 0;
+    }
+    else
+    {
+        psRequest->ui32Flags = HTTP_REQUEST_FLAG_OVERFLOW;
+    }
+}
 
-    //
-    // Fail if not a HTTP response.
-    //
-    if(ustrncmp(g_pcTempData, "HTTP/", 5))
+//*****************************************************************************
+//
+//! Append raw bytes to a HTTP request.
+//!
+//! \param psRequest is a pointer to the builder state.
+//! \param pcData is a pointer to the bytes to append.
+//! \param ui32Len is the number of bytes to append.
+//!
+//! \return Returns \b true if the bytes were appended or \b false if the
+//! request has overflowed.
+//
+//*****************************************************************************
+bool
+HTTPRequestAppend(tHTTPRequest *psRequest, const char *pcData,
+                  uint32_t ui32Len)
+{
+    if(psRequest->ui32Flags & HTTP_REQUEST_FLAG_OVERFLOW)
     {
-        *pcResponseText = 0;
-        *pui32NumHeaders = 0;
-        return 0;
+        return(false);
     }
 
     //
-    // Get the return code.
+    // Always keep room for the terminating NUL.
     //
-    BufferFillToCharacter(' ', pcData, g_pcTempData, &ui32Size);
-    pcData += (ui32Size + 1);
+    if(ui32Len >= (psRequest->ui32Size - psRequest->ui32Len))
+    {
+        psRequest->ui32Flags |= HTTP_REQUEST_FLAG_OVERFLOW;
+        return(false);
+    }
 
-    //
-    // Convert return code to unsigned long.
-    //
-    ui32Response = ustrtoul(g_pcTempData, 0, 10);
+    memcpy(&psRequest->pcBuf[psRequest->ui32Len], pcData, ui32Len);
+    psRequest->ui32Len += ui32Len;
+    psRequest->pcBuf[psRequest->ui32Len] = 0;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Start a new HTTP request.
+//!
+//! \param psRequest is a pointer to the builder state.
+//! \param ui8Type is the HTTP request type.  Macros such as HTTP_MESSAGE_GET
+//! are defined in http.h.
+//! \param pcResource is a pointer to a string containing the resource portion
+//! of the request line.
+//!
+//! Any previous content of the builder is discarded.  Headers are added with
+//! HTTPRequestHeaderAdd() and the header section is terminated either by
+//! HTTPRequestBodyAdd() or by HTTPRequestHeadersEnd().
+//!
+//! \return Returns \b true on success or \b false if the request line does
+//! not fit or \e ui8Type is unknown.
+//
+//*****************************************************************************
+bool
+HTTPRequestStart(tHTTPRequest *psRequest, uint8_t ui8Type,
+                 const char *pcResource)
+{
+    const char *pcMethod;
+
+    psRequest->ui32Len = 0;
+    psRequest->ui32Flags = 0;
+
+    if(ui8Type >= NUM_HTTP_METHODS)
+    {
+        psRequest->ui32Flags = HTTP_REQUEST_FLAG_OVERFLOW;
+        return(false);
+    }
+
+    pcMethod = g_ppcHttpMethods[ui8Type];
+
+    HTTPRequestAppend(psRequest, pcMethod, strlen(pcMethod));
+    HTTPRequestAppend(psRequest, pcResource, strlen(pcResource));
+
+    return(HTTPRequestAppend(psRequest, g_pcRequestSuffix,
+                             sizeof(g_pcRequestSuffix) - 1));
+}
+
+//*****************************************************************************
+//
+//! Add a header to a HTTP request.
+//!
+//! \param psRequest is a pointer to the builder state.
+//! \param pcName is a pointer to a string containing the header name.
+//! \param pcValue is a pointer to a string containing the header value.
+//!
+//! \return Returns \b true on success or \b false if the header does not fit
+//! or the header section has already been closed.
+//
+//*****************************************************************************
+bool
+HTTPRequestHeaderAdd(tHTTPRequest *psRequest, const char *pcName,
+                     const char *pcValue)
+{
+    uint32_t ui32NameLen, ui32ValueLen;
+
+    if(psRequest->ui32Flags & HTTP_REQUEST_FLAG_HEADERS_DONE)
+    {
+        return(false);
+    }
+
+    ui32NameLen = strlen(pcName);
+    ui32ValueLen = strlen(pcValue);
 
     //
-    // Get the response text.
+    // Check the whole line up front so a header is never half written.
     //
-    BufferFillToEOL(pcData, pcResponseText, &ui32Size);
-    pcData += (ui32Size + 2);
+    if((ui32NameLen + ui32ValueLen + 4) >=
+       (psRequest->ui32Size - psRequest->ui32Len))
+    {
+        psRequest->ui32Flags |= HTTP_REQUEST_FLAG_OVERFLOW;
+        return(false);
+    }
+
+    HTTPRequestAppend(psRequest, pcName, ui32NameLen);
+    HTTPRequestAppend(psRequest, ": ", 2);
+    HTTPRequestAppend(psRequest, pcValue, ui32ValueLen);
+
+    return(HTTPRequestAppend(psRequest, "\r\n", 2));
+}
+
+//*****************************************************************************
+//
+//! Add a header with a decimal numeric value to a HTTP request.
+//!
+//! \param psRequest is a pointer to the builder state.
+//! \param pcName is a pointer to a string containing the header name.
+//! \param ui32Value is the value to write.
+//!
+//! \return Returns \b true on success or \b false if the header does not fit.
+//
+//*****************************************************************************
+bool
+HTTPRequestHeaderAddU32(tHTTPRequest *psRequest, const char *pcName,
+                        uint32_t ui32Value)
+{
+    char pcNum[11];
+    uint32_t ui32Idx;
 
     //
-    // Parse the remainder of the packet.
+    // Convert from the least significant digit into the end of the buffer.
     //
-    *pui32NumHeaders = 0;
-    while(*pcData)
+    ui32Idx = sizeof(pcNum) - 1;
+    pcNum[ui32Idx] = 0;
+    do
     {
-        //
-        // Search line by line and count headers.  Search until there is a blank
-        // line, which means end of headers.
-        //
-        BufferFillToEOL(pcData, g_pcTempData, &ui32Size);
-        pcData += (ui32Size + 2);
+        pcNum[--ui32Idx] = '0' + (ui32Value % 10);
+        ui32Value /= 10;
+    }
+    while(ui32Value);
 
-        //
-        // Blank line.  For the purposes of this function, we're done.
-        //
-        if(ui32Size == 0)
-        {
-            break;
-        }
-        else
-        {
-            //
-            // Increment header counter.
-            //
-            *pui32NumHeaders += 1;
-        }
+    return(HTTPRequestHeaderAdd(psRequest, pcName, &pcNum[ui32Idx]));
+}
+
+//*****************************************************************************
+//
+//! Terminate the header section of a HTTP request that has no body.
+//!
+//! \param psRequest is a pointer to the builder state.
+//!
+//! \return Returns \b true on success or \b false if the request overflowed.
+//
+//*****************************************************************************
+bool
+HTTPRequestHeadersEnd(tHTTPRequest *psRequest)
+{
+    if(psRequest->ui32Flags & HTTP_REQUEST_FLAG_HEADERS_DONE)
+    {
+        return(!(psRequest->ui32Flags & HTTP_REQUEST_FLAG_OVERFLOW));
     }
 
-    return ui32Response;
+    if(!HTTPRequestAppend(psRequest, "\r\n", 2))
+    {
+        return(false);
+    }
+
+    psRequest->ui32Flags |= HTTP_REQUEST_FLAG_HEADERS_DONE;
+
+    return(true);
 }
 
 //*****************************************************************************
 //
-//! Extract a specified header from a HTTP response string/buffer.
+//! Add body data to a HTTP request.
 //!
-//! \param pcData is a pointer to the source string/buffer.
-//! \param ui32HeaderIdx specifies the index of the header to extract.
-//! \param pcHeaderName is a pointer to a string that will receive the name of
-//! the header specified by ui32HeaderIdx.
-//! \param pcHeaderValue is a pointer to a string that will receive the value of
-//! the header specified by ui32HeaderIdx.
+//! \param psRequest is a pointer to the builder state.
+//! \param pcBody is a pointer to the body data.
+//! \param ui32Len is the number of bytes at \e pcBody.
 //!
-//! Note that this function should be used in conjunction with
-//! HTTPResponseParse() since it notifies the application of the number of
-//! headers in a string/buffer.
+//! The first call adds a Content-Length header for \e ui32Len bytes and
+//! closes the header section.  The body must therefore be added in a single
+//! call; for bodies assembled from pieces use HTTPRequestHeaderAddU32(),
+//! HTTPRequestHeadersEnd() and HTTPRequestAppend(), or a template.
 //!
-//! \return None.
+//! \return Returns \b true on success or \b false if the body does not fit.
 //
 //*****************************************************************************
-void
-HTTPResponseHeaderExtract(char *pcData, uint32_t ui32HeaderIdx,
-                          char *pcHeaderName, char *pcHeaderValue)
+bool
+HTTPRequestBodyAdd(tHTTPRequest *psRequest, const char *pcBody,
+                   uint32_t ui32Len)
 {
-    uint32_t ui32Size;
-    uint32_t ui32HeaderNumber = 0;
+    if(!(psRequest->ui32Flags & HTTP_REQUEST_FLAG_HEADERS_DONE))
+    {
+        HTTPRequestHeaderAddU32(psRequest, "Content-Length", ui32Len);
+        HTTPRequestHeadersEnd(psRequest);
+    }
 
-    //
-    // Read first line and discard.
-    //
-    BufferFillToEOL(pcData, g_pcTempData, &ui32Size);
-    pcData += (ui32Size + 2);
+    return(HTTPRequestAppend(psRequest, pcBody, ui32Len));
+}
 
-    //
-    // Find and return the requested header.
-    //
-    while(*pcData)
-    {
-        BufferFillToEOL(pcData, g_pcTempData, &ui32Size);
-        pcData += (ui32Size + 2);
+//*****************************************************************************
+//
+//! Return the number of bytes in a HTTP request.
+//!
+//! \param psRequest is a pointer to the builder state.
+//!
+//! \return Returns the request length, not counting the terminating NUL.
+//
+//*****************************************************************************
+uint32_t
+HTTPRequestLenGet(tHTTPRequest *psRequest)
+{
+    return(psRequest->ui32Len);
+}
+
+//*****************************************************************************
+//
+//! Return the state flags of a HTTP request builder.
+//!
+//! \param psRequest is a pointer to the builder state.
+//!
+//! \return Returns a combination of the HTTP_REQUEST_FLAG_* values.
+//
+//*****************************************************************************
+uint32_t
+HTTPRequestFlagsGet(tHTTPRequest *psRequest)
+{
+    return(psRequest->ui32Flags);
+}
+
+//*****************************************************************************
+//
+//! Compile a request template.
+//!
+//! \param psTemplate is a pointer to the template to fill in.
+//! \param pcHead is the request line followed by any fixed headers, each
+//! terminated by "\r\n", for example
+//! "POST /api HTTP/1.1\r\nHost: example.com\r\n".
+//! \param pcBody is the body text.  Placeholders "{0}" to "{9}" mark where
+//! values are substituted; "{{" produces a literal "{".
+//!
+//! The template text is scanned once here.  Rendering then only copies the
+//! literal runs and the values, and the Content-Length header is computed
+//! from the lengths without touching the body twice.  Both strings are
+//! referenced by the template and must remain valid while it is in use.
+//!
+//! \return Returns \b true on success or \b false if the body has more than
+//! HTTP_TEMPLATE_MAX_SEGS pieces.
+//
+//*****************************************************************************
+bool
+HTTPTemplateCompile(tHTTPTemplate *psTemplate, const char *pcHead,
+                    const char *pcBody)
+{
+    tHTTPTemplateSeg *psSeg;
+    uint32_t ui32Idx, ui32Start;
+
+    psTemplate->pcHead = pcHead;
+    psTemplate->ui32HeadLen = strlen(pcHead);
+    psTemplate->pcBody = pcBody;
+    psTemplate->ui32LiteralLen = 0;
+    psTemplate->ui8NumSegs = 0;
+    psTemplate->ui8NumValues = 0;
 
+    ui32Idx = 0;
+    ui32Start = 0;
+
+    for(;;)
+    {
         //
-        // Blank line, end of header section.
+        // Close the current literal run at a placeholder, an escaped brace
+        // or the end of the text.
         //
-        if(ui32Size == 0)
-        {
-            break;
-        }
-        else
+        if((pcBody[ui32Idx] == 0) ||
+           ((pcBody[ui32Idx] == '{') &&
+            (((pcBody[ui32Idx + 1] >= '0') && (pcBody[ui32Idx + 1] <= '9') &&
+              (pcBody[ui32Idx + 2] == '}')) ||
+             (pcBody[ui32Idx + 1] == '{'))))
         {
-            if(ui32HeaderNumber == ui32HeaderIdx)
+            if(ui32Idx > ui32Start)
             {
-                BufferFillToCharacter(':', g_pcTempData, pcHeaderName,
-                                      &ui32Size);
-                BufferFillToCharacter(0, &g_pcTempData[ui32Size + 2],
-                                      pcHeaderValue, &ui32Size);
-                pcHeaderValue[ui32Size] = 0;
+                if(psTemplate->ui8NumSegs == HTTP_TEMPLATE_MAX_SEGS)
+                {
+                    return(false);
+                }
+                psSeg = &psTemplate->psSegs[psTemplate->ui8NumSegs++];
+                psSeg->ui16Offset = ui32Start;
+                psSeg->ui16Len = ui32Idx - ui32Start;
+                psSeg->ui8Value = HTTP_TEMPLATE_LITERAL;
+                psTemplate->ui32LiteralLen += ui32Idx - ui32Start;
+            }
 
+            if(pcBody[ui32Idx] == 0)
+            {
                 break;
             }
-            else
+
+            if(pcBody[ui32Idx + 1] == '{')
             {
                 //
-                // Increment header counter.
+                // "{{": the second brace starts the next literal run.
                 //
-                ui32HeaderNumber++;
+                ui32Idx++;
+                ui32Start = ui32Idx;
+                ui32Idx++;
+                continue;
+            }
+
+            if(psTemplate->ui8NumSegs == HTTP_TEMPLATE_MAX_SEGS)
+            {
+                return(false);
+            }
+            psSeg = &psTemplate->psSegs[psTemplate->ui8NumSegs++];
+            psSeg->ui16Offset = ui32Idx;
+            psSeg->ui16Len = 0;
+            psSeg->ui8Value = pcBody[ui32Idx + 1] - '0';
+
+            if(psSeg->ui8Value >= psTemplate->ui8NumValues)
+            {
+                psTemplate->ui8NumValues = psSeg->ui8Value + 1;
             }
+
+            ui32Idx += 3;
+            ui32Start = ui32Idx;
+            continue;
         }
+
+        ui32Idx++;
     }
+
+    return(true);
 }
 
 //*****************************************************************************
 //
-//! Extract the body from a HTTP response string/buffer.
+//! Return the body length a template renders to for a set of values.
 //!
-//! \param pcData is a pointer to the source string/buffer.
-//! \param pcDest is a pointer to a string that will receive the body data.
+//! \param psTemplate is a pointer to a compiled template.
+//! \param ppcValues is an array of at least as many NUL terminated strings as
+//! the highest placeholder index used plus one.
 //!
-//! \return None.
+//! \return Returns the body length in bytes.
 //
 //*****************************************************************************
-void
-HTTPResponseBodyExtract(char *pcData, char *pcDest)
+uint32_t
+HTTPTemplateBodyLenGet(const tHTTPTemplate *psTemplate,
+                       const char * const *ppcValues)
 {
-    bool bBodyFound = false;
-    uint32_t ui32Size;
+    uint32_t ui32Idx, ui32Len;
 
-    //
-    // Find and return the body.
-    //
-    while(*pcData)
-    {
-        //
-        // Read lines until a blank line is found.  This is the start of the
-        // body.
-        //
-        BufferFillToEOL(pcData, g_pcTempData, &ui32Size);
-        pcData += (ui32Size + 2);
+    ui32Len = psTemplate->ui32LiteralLen;
 
-        //
-        // Blank line, end of header section.
-        //
-        if(ui32Size == 0)
+    for(ui32Idx = 0; ui32Idx < psTemplate->ui8NumSegs; ui32Idx++)
+    {
+        if(psTemplate->psSegs[ui32Idx].ui8Value != HTTP_TEMPLATE_LITERAL)
         {
-            bBodyFound = true;
+            ui32Len += strlen(ppcValues[psTemplate->psSegs[ui32Idx].ui8Value]);
         }
+    }
 
-        //
-        // If the body has been found, start filling the buffer.
-        //
-        if(bBodyFound)
-        {
+    return(ui32Len);
+}
 
-            pcDest[0] = 0;
-            strcat(pcDest, pcData);
-            break;
-        }
-    }
+//*****************************************************************************
+//
+//! Render a compiled template into a request.
+//!
+//! \param psTemplate is a pointer to a compiled template.
+//! \param psRequest is a pointer to the builder that receives the request.
+//! Any previous content is discarded.
+//! \param ppcValues is an array of NUL terminated strings substituted for the
+//! placeholders.
+//!
+//! The complete request size is computed before anything is written, so a
+//! request that would not fit leaves the buffer empty with
+//! HTTP_REQUEST_FLAG_OVERFLOW set rather than partially rendered.
+//!
+//! \return Returns the request length, or 0 if it does not fit.
+//
+//*****************************************************************************
+uint32_t
+HTTPTemplateRender(const tHTTPTemplate *psTemplate, tHTTPRequest *psRequest,
+                   const char * const *ppcValues)
+{
+    const tHTTPTemplateSeg *psSeg;
+    const char *pcValue;
+    uint32_t ui32Idx, ui32BodyLen;
+
+    ui32BodyLen = HTTPTemplateBodyLenGet(psTemplate, ppcValues);
+
+    psRequest->ui32Len = 0;
+    psRequest->ui32Flags = 0;
+    if(psRequest->ui32Size)
+    {
+        psRequest->pcBuf[0] = 0;
+    }
+
+    //
+    // Head, "Content-Length: " (16), up to 10 digits, "\r\n\r\n" (4) and the
+    // body.  Reject up front instead of producing a truncated request.
+    //
+    if((psTemplate->ui32HeadLen + 30 + ui32BodyLen) >= psRequest->ui32Size)
+    {
+        psRequest->ui32Flags = HTTP_REQUEST_FLAG_OVERFLOW;
+        return(0);
+    }
+
+    HTTPRequestAppend(psRequest, psTemplate->pcHead, psTemplate->ui32HeadLen);
+    HTTPRequestHeaderAddU32(psRequest, "Content-Length", ui32BodyLen);
+    HTTPRequestHeadersEnd(psRequest);
+
+    for(ui32Idx = 0; ui32Idx < psTemplate->ui8NumSegs; ui32Idx++)
+    {
+        psSeg = &psTemplate->psSegs[ui32Idx];
+
+        if(psSeg->ui8Value == HTTP_TEMPLATE_LITERAL)
+        {
+            HTTPRequestAppend(psRequest, &psTemplate->pcBody[psSeg->ui16Offset],
+                              psSeg->ui16Len);
+        }
+        else
+        {
+            pcValue = ppcValues[psSeg->ui8Value];
+            HTTPRequestAppend(psRequest, pcValue, strlen(pcValue));
+        }
+    }
+
+    return(psRequest->ui32Len);
+}
+
+//*****************************************************************************
+//
+// Case-insensitive comparison of the first ui32Len characters of two strings.
+//
+//*****************************************************************************
+static bool
+MatchNoCase(const char *pcA, const char *pcB, uint32_t ui32Len)
+{
+    char cA, cB;
+
+    while(ui32Len--)
+    {
+        cA = *pcA++;
+        cB = *pcB++;
+
+        if((cA >= 'A') && (cA <= 'Z'))
+        {
+            cA += 'a' - 'A';
+        }
+        if((cB >= 'A') && (cB <= 'Z'))
+        {
+            cB += 'a' - 'A';
+        }
+        if(cA != cB)
+        {
+            return(false);
+        }
+        if(cA == 0)
+        {
+            break;
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns true if pcToken appears (case-insensitively) anywhere in pcValue.
+//
+//*****************************************************************************
+static bool
+ContainsNoCase(const char *pcValue, const char *pcToken)
+{
+    uint32_t ui32TokLen;
+
+    ui32TokLen = strlen(pcToken);
+
+    while(*pcValue)
+    {
+        if(MatchNoCase(pcValue, pcToken, ui32TokLen))
+        {
+            return(true);
+        }
+        pcValue++;
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Append one character of a status/header/trailer line to the line buffer.
+// Carriage returns are dropped, the first ':' of a header line splits name
+// from value and leading whitespace of the value is skipped.  Characters that
+// do not fit are discarded and the line is flagged as truncated.
+//
+//*****************************************************************************
+static void
+ParserLineAppend(tHTTPParser *psParser, char cChar)
+{
+    if(cChar == '\r')
+    {
+        return;
+    }
+
+    if(psParser->ui8State == PARSE_STATE_HEADER)
+    {
+        if((cChar == ':') && (psParser->ui16ValueIdx == 0))
+        {
+            //
+            // A name that fills the buffer cannot be split off; leaving
+            // ui16ValueIdx at 0 makes ParserHeaderLine() skip the line.
+            //
+            if(psParser->ui16LineLen >= (HTTP_PARSER_LINE_SIZE - 1))
+            {
+                psParser->ui8Flags |= HTTP_PARSER_FLAG_TRUNCATED;
+                return;
+            }
+            psParser->pcLine[psParser->ui16LineLen++] = 0;
+            psParser->ui16ValueIdx = psParser->ui16LineLen;
+            return;
+        }
+
+        if(((cChar == ' ') || (cChar == '\t')) &&
+           (psParser->ui16ValueIdx != 0) &&
+           (psParser->ui16ValueIdx == psParser->ui16LineLen))
+        {
+            return;
+        }
+    }
+
+    //
+    // Always keep room for the terminating NUL.
+    //
+    if(psParser->ui16LineLen < (HTTP_PARSER_LINE_SIZE - 1))
+    {
+        psParser->pcLine[psParser->ui16LineLen++] = cChar;
+    }
+    else
+    {
+        psParser->ui8Flags |= HTTP_PARSER_FLAG_TRUNCATED;
+    }
+}
+
+//*****************************************************************************
+//
+// Report a malformed response and stop parsing.
+//
+//*****************************************************************************
+static void
+ParserError(tHTTPParser *psParser)
+{
+    psParser->ui8State = PARSE_STATE_ERROR;
+    psParser->pfnCallback(psParser->pvCBData, HTTP_PARSE_EVENT_ERROR, 0, 0, 0,
+                          0);
+}
+
+//*****************************************************************************
+//
+// Report the end of the response and prepare for the next one on the same
+// (keep-alive) connection.
+//
+//*****************************************************************************
+static void
+ParserComplete(tHTTPParser *psParser)
+{
+    psParser->pfnCallback(psParser->pvCBData, HTTP_PARSE_EVENT_COMPLETE, 0, 0,
+                          0, psParser->ui16Status);
+
+    psParser->ui8State = PARSE_STATE_STATUS;
+    psParser->ui16LineLen = 0;
+    psParser->ui16ValueIdx = 0;
+}
+
+//*****************************************************************************
+//
+// Handle a completed request line ("GET /status HTTP/1.1").  The method and
+// target are split in place in the line buffer.
+//
+//*****************************************************************************
+static void
+ParserRequestLine(tHTTPParser *psParser)
+{
+    char *pcMethod, *pcTarget, *pcLine;
+    uint32_t ui32MethodLen, ui32TargetLen;
+
+    pcMethod = psParser->pcLine;
+    pcLine = pcMethod;
+    while(*pcLine && (*pcLine != ' '))
+    {
+        pcLine++;
+    }
+    ui32MethodLen = (uint32_t)(pcLine - pcMethod);
+    while(*pcLine == ' ')
+    {
+        *pcLine++ = 0;
+    }
+
+    pcTarget = pcLine;
+    while(*pcLine && (*pcLine != ' '))
+    {
+        pcLine++;
+    }
+    ui32TargetLen = (uint32_t)(pcLine - pcTarget);
+    while(*pcLine == ' ')
+    {
+        *pcLine++ = 0;
+    }
+
+    if((ui32MethodLen == 0) || (ui32TargetLen == 0) ||
+       !MatchNoCase(pcLine, "HTTP/", 5))
+    {
+        ParserError(psParser);
+        return;
+    }
+
+    //
+    // Start a fresh header section for this request.
+    //
+    psParser->ui16Status = 0;
+    psParser->ui8Flags = HTTP_PARSER_FLAG_REQUEST;
+    psParser->ui32Remaining = 0;
+    psParser->ui8State = PARSE_STATE_HEADER;
+
+    psParser->pfnCallback(psParser->pvCBData, HTTP_PARSE_EVENT_REQUEST,
+                          pcMethod, ui32MethodLen, pcTarget, ui32TargetLen);
+}
+
+//*****************************************************************************
+//
+// Handle a completed status line ("HTTP/1.1 200 OK").
+//
+//*****************************************************************************
+static void
+ParserStatusLine(tHTTPParser *psParser)
+{
+    char *pcLine;
+    uint32_t ui32Code, ui32Digits;
+
+    pcLine = psParser->pcLine;
+    if(psParser->ui16LineLen > (HTTP_PARSER_LINE_SIZE - 1))
+    {
+        psParser->ui16LineLen = HTTP_PARSER_LINE_SIZE - 1;
+    }
+    pcLine[psParser->ui16LineLen] = 0;
+
+    //
+    // Tolerate stray blank lines between pipelined responses.
+    //
+    if(psParser->ui16LineLen == 0)
+    {
+        return;
+    }
+
+    if(psParser->ui8Flags & HTTP_PARSER_FLAG_REQUEST)
+    {
+        ParserRequestLine(psParser);
+        return;
+    }
+
+    if(!MatchNoCase(pcLine, "HTTP/", 5))
+    {
+        ParserError(psParser);
+        return;
+    }
+
+    //
+    // Skip the protocol version.
+    //
+    while(*pcLine && (*pcLine != ' '))
+    {
+        pcLine++;
+    }
+    while(*pcLine == ' ')
+    {
+        pcLine++;
+    }
+
+    //
+    // Three digit status code.
+    //
+    ui32Code = 0;
+    ui32Digits = 0;
+    while((*pcLine >= '0') && (*pcLine <= '9'))
+    {
+        ui32Code = (ui32Code * 10) + (uint32_t)(*pcLine - '0');
+        ui32Digits++;
+        pcLine++;
+    }
+    if(ui32Digits != 3)
+    {
+        ParserError(psParser);
+        return;
+    }
+    while(*pcLine == ' ')
+    {
+        pcLine++;
+    }
+
+    //
+    // Start a fresh header section for this response.
+    //
+    psParser->ui16Status = (uint16_t)ui32Code;
+    psParser->ui8Flags = 0;
+    psParser->ui32Remaining = 0;
+    psParser->ui8State = PARSE_STATE_HEADER;
+
+    psParser->pfnCallback(psParser->pvCBData, HTTP_PARSE_EVENT_STATUS, pcLine,
+                          strlen(pcLine), 0, ui32Code);
+}
+
+//*****************************************************************************
+//
+// Handle a completed header line, or the blank line that ends the headers.
+//
+//*****************************************************************************
+static void
+ParserHeaderLine(tHTTPParser *psParser)
+{
+    char *pcName, *pcValue;
+    uint32_t ui32ValueLen, ui32Length, ui32Digit;
+
+    //
+    // Blank line: pick the body framing from what the headers told us.
+    //
+    if(psParser->ui16LineLen == 0)
+    {
+        psParser->pfnCallback(psParser->pvCBData,
+                              HTTP_PARSE_EVENT_HEADERS_DONE, 0, 0, 0,
+                              psParser->ui16Status);
+
+        if(((psParser->ui16Status >= 100) && (psParser->ui16Status < 200)) ||
+           (psParser->ui16Status == 204) || (psParser->ui16Status == 304))
+        {
+            ParserComplete(psParser);
+        }
+        else if(psParser->ui8Flags & HTTP_PARSER_FLAG_CHUNKED)
+        {
+            psParser->ui32Remaining = 0;
+            psParser->ui8State = PARSE_STATE_CHUNK_SIZE;
+        }
+        else if(psParser->ui8Flags & HTTP_PARSER_FLAG_LENGTH)
+        {
+            if(psParser->ui32Remaining == 0)
+            {
+                ParserComplete(psParser);
+            }
+            else
+            {
+                psParser->ui8State = PARSE_STATE_BODY_LENGTH;
+            }
+        }
+        else if(psParser->ui8Flags & HTTP_PARSER_FLAG_REQUEST)
+        {
+            //
+            // A request without framing headers has no body.
+            //
+            ParserComplete(psParser);
+        }
+        else
+        {
+            //
+            // No framing information; the body runs until the connection
+            // closes (see HTTPParserFinish()).
+            //
+            psParser->ui8Flags |= HTTP_PARSER_FLAG_CLOSE;
+            psParser->ui8State = PARSE_STATE_BODY_EOF;
+        }
+        return;
+    }
+
+    //
+    // Lines without a ':' are not headers; skip them.
+    //
+    if(psParser->ui16ValueIdx == 0)
+    {
+        psParser->ui16LineLen = 0;
+        return;
+    }
+
+    if(psParser->ui16LineLen > (HTTP_PARSER_LINE_SIZE - 1))
+    {
+        psParser->ui16LineLen = HTTP_PARSER_LINE_SIZE - 1;
+    }
+    psParser->pcLine[psParser->ui16LineLen] = 0;
+    pcName = psParser->pcLine;
+    pcValue = &psParser->pcLine[psParser->ui16ValueIdx];
+
+    //
+    // Trim trailing whitespace from the value.
+    //
+    ui32ValueLen = psParser->ui16LineLen - psParser->ui16ValueIdx;
+    while(ui32ValueLen &&
+          ((pcValue[ui32ValueLen - 1] == ' ') ||
+           (pcValue[ui32ValueLen - 1] == '\t')))
+    {
+        pcValue[--ui32ValueLen] = 0;
+    }
+
+    //
+    // Pick out the headers that affect framing.
+    //
+    if(MatchNoCase(pcName, "Content-Length", 15))
+    {
+        ui32Length = 0;
+        while((*pcValue >= '0') && (*pcValue <= '9'))
+        {
+            //
+            // A length that does not fit in 32 bits would wrap to a short
+            // one and misframe the body; reject the response instead.
+            //
+            ui32Digit = (uint32_t)(*pcValue - '0');
+            if(ui32Length > ((0xFFFFFFFF - ui32Digit) / 10))
+            {
+                ParserError(psParser);
+                return;
+            }
+            ui32Length = (ui32Length * 10) + ui32Digit;
+            pcValue++;
+        }
+        pcValue = &psParser->pcLine[psParser->ui16ValueIdx];
+        psParser->ui32Remaining = ui32Length;
+        psParser->ui8Flags |= HTTP_PARSER_FLAG_LENGTH;
+    }
+    else if(MatchNoCase(pcName, "Transfer-Encoding", 18))
+    {
+        if(ContainsNoCase(pcValue, "chunked"))
+        {
+            psParser->ui8Flags |= HTTP_PARSER_FLAG_CHUNKED;
+        }
+    }
+    else if(MatchNoCase(pcName, "Connection", 11))
+    {
+        if(ContainsNoCase(pcValue, "close"))
+        {
+            psParser->ui8Flags |= HTTP_PARSER_FLAG_CLOSE;
+        }
+    }
+
+    psParser->pfnCallback(psParser->pvCBData, HTTP_PARSE_EVENT_HEADER, pcName,
+                          psParser->ui16ValueIdx - 1, pcValue, ui32ValueLen);
+
+    psParser->ui16LineLen = 0;
+    psParser->ui16ValueIdx = 0;
+}
+
+//*****************************************************************************
+//
+//! Initialize an incremental HTTP response parser.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param pfnCallback is the function that receives parser events.
+//! \param pvCBData is passed unmodified to \e pfnCallback.
+//!
+//! The parser consumes a response in arbitrary pieces, as they arrive from
+//! the network, and reports the status line, each header and each slice of
+//! body data through \e pfnCallback.  Every input byte is examined once.
+//! Body data is never copied: HTTP_PARSE_EVENT_BODY points straight into the
+//! buffer passed to HTTPParserFeed().  Only the status line and the current
+//! header line are held, in a buffer of HTTP_PARSER_LINE_SIZE bytes, so
+//! memory use does not depend on the size of the response.
+//!
+//! After HTTP_PARSE_EVENT_COMPLETE the parser is ready for the next response
+//! on the same connection.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPParserInit(tHTTPParser *psParser, tHTTPParserCallback pfnCallback,
+               void *pvCBData)
+{
+    psParser->pfnCallback = pfnCallback;
+    psParser->pvCBData = pvCBData;
+    psParser->ui8Flags = 0;
+    HTTPParserReset(psParser);
+}
+
+//*****************************************************************************
+//
+//! Initialize an incremental HTTP request parser.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param pfnCallback is the function that receives parser events.
+//! \param pvCBData is passed unmodified to \e pfnCallback.
+//!
+//! This is the server side counterpart of HTTPParserInit().  The first line
+//! of each message is parsed as a request line and reported with
+//! HTTP_PARSE_EVENT_REQUEST; headers and body are handled exactly as for a
+//! response, except that a request with neither Content-Length nor chunked
+//! framing has no body.  The parser stays in request mode across
+//! HTTPParserReset() and HTTP_PARSE_EVENT_COMPLETE, so pipelined requests on
+//! a keep-alive connection are parsed back to back.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPParserRequestInit(tHTTPParser *psParser, tHTTPParserCallback pfnCallback,
+                      void *pvCBData)
+{
+    psParser->pfnCallback = pfnCallback;
+    psParser->pvCBData = pvCBData;
+    psParser->ui8Flags = HTTP_PARSER_FLAG_REQUEST;
+    HTTPParserReset(psParser);
+}
+
+//*****************************************************************************
+//
+//! Reset a parser so that it expects the start of a new response.
+//!
+//! \param psParser is a pointer to the parser state.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPParserReset(tHTTPParser *psParser)
+{
+    psParser->ui8State = PARSE_STATE_STATUS;
+    psParser->ui8Flags &= HTTP_PARSER_FLAG_REQUEST;
+    psParser->ui16Status = 0;
+    psParser->ui32Remaining = 0;
+    psParser->ui16LineLen = 0;
+    psParser->ui16ValueIdx = 0;
+}
+
+//*****************************************************************************
+//
+//! Feed response bytes to the parser.
+//!
+//! \param psParser is a pointer to the parser state.
+//! \param pcData is a pointer to the received bytes.
+//! \param ui32Len is the number of bytes at \e pcData.
+//!
+//! This function can be called directly from the receive path (for example
+//! the ETH_CLIENT_EVENT_RECEIVE handler) with each piece of data as it
+//! arrives.  There is no requirement for lines or chunks to be contained in a
+//! single call.
+//!
+//! \return Returns the number of bytes consumed.  This is less than
+//! \e ui32Len only if the response turned out to be malformed.
+//
+//*****************************************************************************
+uint32_t
+HTTPParserFeed(tHTTPParser *psParser, const char *pcData, uint32_t ui32Len)
+{
+    uint32_t ui32Idx, ui32Count;
+    char cChar;
+
+    ui32Idx = 0;
+
+    while(ui32Idx < ui32Len)
+    {
+        switch(psParser->ui8State)
+        {
+            //
+            // Body bytes are handed out in place, as large slices as possible.
+            //
+            case PARSE_STATE_BODY_LENGTH:
+            case PARSE_STATE_CHUNK_DATA:
+            {
+                ui32Count = ui32Len - ui32Idx;
+                if(ui32Count > psParser->ui32Remaining)
+                {
+                    ui32Count = psParser->ui32Remaining;
+                }
+
+                psParser->pfnCallback(psParser->pvCBData,
+                                      HTTP_PARSE_EVENT_BODY, &pcData[ui32Idx],
+                                      ui32Count, 0, 0);
+
+                ui32Idx += ui32Count;
+                psParser->ui32Remaining -= ui32Count;
+
+                if(psParser->ui32Remaining == 0)
+                {
+                    if(psParser->ui8State == PARSE_STATE_BODY_LENGTH)
+                    {
+                        ParserComplete(psParser);
+                    }
+                    else
+                    {
+                        psParser->ui8State = PARSE_STATE_CHUNK_DATA_END;
+                    }
+                }
+                break;
+            }
+
+            case PARSE_STATE_BODY_EOF:
+            {
+                psParser->pfnCallback(psParser->pvCBData,
+                                      HTTP_PARSE_EVENT_BODY, &pcData[ui32Idx],
+                                      ui32Len - ui32Idx, 0, 0);
+                ui32Idx = ui32Len;
+                break;
+            }
+
+            case PARSE_STATE_STATUS:
+            case PARSE_STATE_HEADER:
+            {
+                cChar = pcData[ui32Idx++];
+                if(cChar != '\n')
+                {
+                    ParserLineAppend(psParser, cChar);
+                }
+                else if(psParser->ui8State == PARSE_STATE_STATUS)
+                {
+                    ParserStatusLine(psParser);
+                    psParser->ui16LineLen = 0;
+                    psParser->ui16ValueIdx = 0;
+                }
+                else
+                {
+                    ParserHeaderLine(psParser);
+                }
+                break;
+            }
+
+            //
+            // Chunk size is hex, optionally followed by ";extensions".  The
+            // line length counter doubles as the digit counter here.
+            //
+            case PARSE_STATE_CHUNK_SIZE:
+            case PARSE_STATE_CHUNK_EXT:
+            {
+                cChar = pcData[ui32Idx++];
+
+                if(cChar == '\n')
+                {
+                    if(psParser->ui16LineLen == 0)
+                    {
+                        ParserError(psParser);
+                        return(ui32Idx);
+                    }
+
+                    psParser->ui16LineLen = 0;
+                    psParser->ui8State = psParser->ui32Remaining ?
+                                         PARSE_STATE_CHUNK_DATA :
+                                         PARSE_STATE_TRAILER;
+                }
+                else if(psParser->ui8State == PARSE_STATE_CHUNK_EXT)
+                {
+                    //
+                    // Ignore chunk extensions.
+                    //
+                }
+                else if((cChar >= '0') && (cChar <= '9'))
+                {
+                    ui32Count = (uint32_t)(cChar - '0');
+                }
+                else if((cChar >= 'a') && (cChar <= 'f'))
+                {
+                    ui32Count = (uint32_t)(cChar - 'a' + 10);
+                }
+                else if((cChar >= 'A') && (cChar <= 'F'))
+                {
+                    ui32Count = (uint32_t)(cChar - 'A' + 10);
+                }
+                else if((cChar == ';') || (cChar == ' ') || (cChar == '\t'))
+                {
+                    psParser->ui8State = PARSE_STATE_CHUNK_EXT;
+                    break;
+                }
+                else if(cChar == '\r')
+                {
+                    break;
+                }
+                else
+                {
+                    ParserError(psParser);
+                    return(ui32Idx);
+                }
+
+                if((psParser->ui8State == PARSE_STATE_CHUNK_SIZE) &&
+                   (cChar != '\n'))
+                {
+                    if(psParser->ui32Remaining > 0x07FFFFFF)
+                    {
+                        ParserError(psParser);
+                        return(ui32Idx);
+                    }
+                    psParser->ui32Remaining = (psParser->ui32Remaining << 4) +
+                                              ui32Count;
+                    psParser->ui16LineLen++;
+                }
+                break;
+            }
+
+            //
+            // CRLF that follows the data of each chunk.
+            //
+            case PARSE_STATE_CHUNK_DATA_END:
+            {
+                cChar = pcData[ui32Idx++];
+                if(cChar == '\n')
+                {
+                    psParser->ui16LineLen = 0;
+                    psParser->ui32Remaining = 0;
+                    psParser->ui8State = PARSE_STATE_CHUNK_SIZE;
+                }
+                else if(cChar != '\r')
+                {
+                    ParserError(psParser);
+                    return(ui32Idx);
+                }
+                break;
+            }
+
+            //
+            // Optional trailer headers after the last chunk; they are skipped
+            // and only the terminating blank line matters.
+            //
+            case PARSE_STATE_TRAILER:
+            {
+                cChar = pcData[ui32Idx++];
+                if(cChar == '\n')
+                {
+                    if(psParser->ui16LineLen == 0)
+                    {
+                        ParserComplete(psParser);
+                    }
+                    psParser->ui16LineLen = 0;
+                }
+                else if(cChar != '\r')
+                {
+                    psParser->ui16LineLen = 1;
+                }
+                break;
+            }
+
+            case PARSE_STATE_ERROR:
+            default:
+            {
+                return(ui32Idx);
+            }
+        }
+    }
+
+    return(ui32Idx);
+}
+
+//*****************************************************************************
+//
+//! Signal that the connection carrying the response has closed.
+//!
+//! \param psParser is a pointer to the parser state.
+//!
+//! Responses without Content-Length or chunked framing end when the server
+//! closes the connection.  This function completes such a response, or
+//! reports an error if the close truncated a response that had framing.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPParserFinish(tHTTPParser *psParser)
+{
+    if(psParser->ui8State == PARSE_STATE_BODY_EOF)
+    {
+        ParserComplete(psParser);
+    }
+    else if((psParser->ui8State != PARSE_STATE_STATUS) ||
+            (psParser->ui16LineLen != 0))
+    {
+        if(psParser->ui8State != PARSE_STATE_ERROR)
+        {
+            ParserError(psParser);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Return the status code of the response being (or last) parsed.
+//!
+//! \param psParser is a pointer to the parser state.
+//!
+//! \return Returns the HTTP status code, or 0 if no status line was parsed.
+//
+//*****************************************************************************
+uint32_t
+HTTPParserStatusGet(tHTTPParser *psParser)
+{
+    return(psParser->ui16Status);
+}
+
+//*****************************************************************************
+//
+//! Return the framing flags of the response being parsed.
+//!
+//! \param psParser is a pointer to the parser state.
+//!
+//! \return Returns a combination of the HTTP_PARSER_FLAG_* values.
+//
+//*****************************************************************************
+uint32_t
+HTTPParserFlagsGet(tHTTPParser *psParser)
+{
+    return(psParser->ui8Flags);
+}
+
+//*****************************************************************************
+//
+// Context used by the single-shot helpers below, which run the incremental
+// parser over a complete, NUL terminated response held in memory.
+//
+//*****************************************************************************
+typedef struct
+{
+    char *pcText;
+    char *pcValue;
+    uint32_t ui32Count;
+    uint32_t ui32Target;
+    bool bDone;
+}
+tHTTPExtract;
+
+//*****************************************************************************
+//
+// Parser callback for HTTPResponseParse().
+//
+//*****************************************************************************
+static void
+ResponseParseCallback(void *pvCBData, uint32_t ui32Event, const char *pcData1,
+                      uint32_t ui32Len1, const char *pcData2,
+                      uint32_t ui32Len2)
+{
+    tHTTPExtract *psExtract = (tHTTPExtract *)pvCBData;
+
+    if(psExtract->bDone)
+    {
+        return;
+    }
+
+    if(ui32Event == HTTP_PARSE_EVENT_STATUS)
+    {
+        memcpy(psExtract->pcText, pcData1, ui32Len1);
+        psExtract->pcText[ui32Len1] = 0;
+    }
+    else if(ui32Event == HTTP_PARSE_EVENT_HEADER)
+    {
+        psExtract->ui32Count++;
+    }
+    else if(ui32Event != HTTP_PARSE_EVENT_BODY)
+    {
+        psExtract->bDone = true;
+    }
+}
+
+//*****************************************************************************
+//
+//! Parse a HTTP response.
+//!
+//! \param pcData is a pointer to the source string/buffer.
+//! \param pcResponseText is a pointer to a string that will receive the
+//! response text from the first line of the HTTP response.
+//! \param pui32NumHeaders is a pointer to a variable that will receive the
+//! number of headers detected in pcData.
+//!
+//! This is a convenience wrapper that runs HTTPParserFeed() over a complete
+//! response.  Code that receives the response in pieces should use the
+//! incremental parser directly.
+//!
+//! \return Returns the HTTP response code.  If parsing error occurs, returns 0.
+//
+//*****************************************************************************
+uint32_t
+HTTPResponseParse(char *pcData, char *pcResponseText, uint32_t *pui32NumHeaders)
+{
+    tHTTPParser sParser;
+    tHTTPExtract sExtract;
+
+    *pcResponseText = 0;
+
+    sExtract.pcText = pcResponseText;
+    sExtract.ui32Count = 0;
+    sExtract.bDone = false;
+
+    HTTPParserInit(&sParser, ResponseParseCallback, &sExtract);
+    HTTPParserFeed(&sParser, pcData, strlen(pcData));
+
+    if(sParser.ui8State == PARSE_STATE_ERROR)
+    {
+        *pcResponseText = 0;
+        *pui32NumHeaders = 0;
+        return(0);
+    }
+
+    *pui32NumHeaders = sExtract.ui32Count;
+
+    return(HTTPParserStatusGet(&sParser));
+}
+
+//*****************************************************************************
+//
+// Parser callback for HTTPResponseHeaderExtract().
+//
+//*****************************************************************************
+static void
+HeaderExtractCallback(void *pvCBData, uint32_t ui32Event, const char *pcData1,
+                      uint32_t ui32Len1, const char *pcData2,
+                      uint32_t ui32Len2)
+{
+    tHTTPExtract *psExtract = (tHTTPExtract *)pvCBData;
+
+    if(psExtract->bDone || (ui32Event != HTTP_PARSE_EVENT_HEADER))
+    {
+        if(ui32Event == HTTP_PARSE_EVENT_HEADERS_DONE)
+        {
+            psExtract->bDone = true;
+        }
+        return;
+    }
+
+    if(psExtract->ui32Count++ == psExtract->ui32Target)
+    {
+        memcpy(psExtract->pcText, pcData1, ui32Len1);
+        psExtract->pcText[ui32Len1] = 0;
+        memcpy(psExtract->pcValue, pcData2, ui32Len2);
+        psExtract->pcValue[ui32Len2] = 0;
+        psExtract->bDone = true;
+    }
+}
+
+//*****************************************************************************
+//
+//! Extract a specified header from a HTTP response string/buffer.
+//!
+//! \param pcData is a pointer to the source string/buffer.
+//! \param ui32HeaderIdx specifies the index of the header to extract.
+//! \param pcHeaderName is a pointer to a string that will receive the name of
+//! the header specified by ui32HeaderIdx.
+//! \param pcHeaderValue is a pointer to a string that will receive the value of
+//! the header specified by ui32HeaderIdx.
+//!
+//! Note that this function should be used in conjunction with
+//! HTTPResponseParse() since it notifies the application of the number of
+//! headers in a string/buffer.  Code that needs several headers should use
+//! the incremental parser, which reports all of them in one pass.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPResponseHeaderExtract(char *pcData, uint32_t ui32HeaderIdx,
+                          char *pcHeaderName, char *pcHeaderValue)
+{
+    tHTTPParser sParser;
+    tHTTPExtract sExtract;
+
+    sExtract.pcText = pcHeaderName;
+    sExtract.pcValue = pcHeaderValue;
+    sExtract.ui32Count = 0;
+    sExtract.ui32Target = ui32HeaderIdx;
+    sExtract.bDone = false;
+
+    HTTPParserInit(&sParser, HeaderExtractCallback, &sExtract);
+    HTTPParserFeed(&sParser, pcData, strlen(pcData));
+}
+
+//*****************************************************************************
+//
+// Parser callback for HTTPResponseBodyExtract().
+//
+//*****************************************************************************
+static void
+BodyExtractCallback(void *pvCBData, uint32_t ui32Event, const char *pcData1,
+                    uint32_t ui32Len1, const char *pcData2, uint32_t ui32Len2)
+{
+    tHTTPExtract *psExtract = (tHTTPExtract *)pvCBData;
+
+    if(psExtract->bDone)
+    {
+        return;
+    }
+
+    if(ui32Event == HTTP_PARSE_EVENT_BODY)
+    {
+        memcpy(&psExtract->pcText[psExtract->ui32Count], pcData1, ui32Len1);
+        psExtract->ui32Count += ui32Len1;
+    }
+    else if((ui32Event == HTTP_PARSE_EVENT_COMPLETE) ||
+            (ui32Event == HTTP_PARSE_EVENT_ERROR))
+    {
+        psExtract->bDone = true;
+    }
+}
+
+//*****************************************************************************
+//
+//! Extract the body from a HTTP response string/buffer.
+//!
+//! \param pcData is a pointer to the source string/buffer.
+//! \param pcDest is a pointer to a string that will receive the body data.
+//!
+//! Chunked bodies are returned with the chunk framing removed.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPResponseBodyExtract(char *pcData, char *pcDest)
+{
+    tHTTPParser sParser;
+    tHTTPExtract sExtract;
+
+    sExtract.pcText = pcDest;
+    sExtract.ui32Count = 0;
+    sExtract.bDone = false;
+
+    HTTPParserInit(&sParser, BodyExtractCallback, &sExtract);
+    HTTPParserFeed(&sParser, pcData, strlen(pcData));
+
+    pcDest[sExtract.ui32Count] = 0;
 }
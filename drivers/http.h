@@ -50,11 +50,200 @@ extern "C"
 #define HTTP_MESSAGE_OPTIONS    0x7
 #define HTTP_MESSAGE_PATCH      0x8
 
+//*****************************************************************************
+//
+// Events passed to a tHTTPParserCallback by HTTPParserFeed().
+//
+// HTTP_PARSE_EVENT_STATUS: pvData1/ui32Len1 is the reason phrase and
+//   ui32Len2 holds the numeric status code.
+// HTTP_PARSE_EVENT_HEADER: pvData1/ui32Len1 is the header name and
+//   pvData2/ui32Len2 is the header value.  Both are NUL terminated.
+// HTTP_PARSE_EVENT_HEADERS_DONE: the blank line ending the headers was seen.
+// HTTP_PARSE_EVENT_BODY: pvData1/ui32Len1 is a slice of body data.  For
+//   chunked responses the chunk framing has already been removed.
+// HTTP_PARSE_EVENT_COMPLETE: the full response has been consumed.
+// HTTP_PARSE_EVENT_ERROR: the response is malformed; further input is
+//   ignored until HTTPParserReset() is called.
+// HTTP_PARSE_EVENT_REQUEST: (request parsers only, see HTTPParserRequestInit)
+//   pvData1/ui32Len1 is the method and pvData2/ui32Len2 is the request
+//   target.  Both are NUL terminated.  It takes the place of
+//   HTTP_PARSE_EVENT_STATUS.
+//
+//*****************************************************************************
+#define HTTP_PARSE_EVENT_STATUS         0x1
+#define HTTP_PARSE_EVENT_HEADER         0x2
+#define HTTP_PARSE_EVENT_HEADERS_DONE   0x3
+#define HTTP_PARSE_EVENT_BODY           0x4
+#define HTTP_PARSE_EVENT_COMPLETE       0x5
+#define HTTP_PARSE_EVENT_ERROR          0x6
+#define HTTP_PARSE_EVENT_REQUEST        0x7
+
+//*****************************************************************************
+//
+// Size of the line buffer used for the status line and header lines.  Lines
+// longer than this are truncated (the remainder is skipped, not buffered).
+//
+//*****************************************************************************
+#ifndef HTTP_PARSER_LINE_SIZE
+#define HTTP_PARSER_LINE_SIZE           128
+#endif
+
+//*****************************************************************************
+//
+// Bits returned by HTTPParserFlagsGet().
+//
+//*****************************************************************************
+#define HTTP_PARSER_FLAG_CHUNKED        0x01
+#define HTTP_PARSER_FLAG_LENGTH         0x02
+#define HTTP_PARSER_FLAG_CLOSE          0x04
+#define HTTP_PARSER_FLAG_TRUNCATED      0x08
+#define HTTP_PARSER_FLAG_REQUEST        0x10
+
+//*****************************************************************************
+//
+// The type definition for parser event callbacks.
+//
+//*****************************************************************************
+typedef void (* tHTTPParserCallback)(void *pvCBData, uint32_t ui32Event,
+                                     const char *pcData1, uint32_t ui32Len1,
+                                     const char *pcData2, uint32_t ui32Len2);
+
+//*****************************************************************************
+//
+// Incremental response (or request) parser state.  The contents are private to http.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8State;
+    uint8_t ui8Flags;
+    uint16_t ui16Status;
+    uint32_t ui32Remaining;
+    uint16_t ui16LineLen;
+    uint16_t ui16ValueIdx;
+    tHTTPParserCallback pfnCallback;
+    void *pvCBData;
+    char pcLine[HTTP_PARSER_LINE_SIZE];
+}
+tHTTPParser;
+
+//*****************************************************************************
+//
+// Bits returned by HTTPRequestFlagsGet().
+//
+// HTTP_REQUEST_FLAG_OVERFLOW: a piece did not fit in the buffer.  Nothing of
+//   that piece was written and all further appends are refused.
+// HTTP_REQUEST_FLAG_HEADERS_DONE: the blank line ending the header section
+//   has been written; only body data can follow.
+//
+//*****************************************************************************
+#define HTTP_REQUEST_FLAG_OVERFLOW      0x01
+#define HTTP_REQUEST_FLAG_HEADERS_DONE  0x02
+
+//*****************************************************************************
+//
+// HTTP request builder.  The caller supplies the buffer; the builder keeps
+// the write position so that each append costs only the length of the piece
+// being added.  The buffer is always kept NUL terminated.
+//
+//*****************************************************************************
+typedef struct
+{
+    char *pcBuf;
+    uint32_t ui32Size;
+    uint32_t ui32Len;
+    uint32_t ui32Flags;
+}
+tHTTPRequest;
+
+//*****************************************************************************
+//
+// Limits for precompiled request templates.  Placeholders in a template body
+// are written "{0}" to "{9}" and HTTP_TEMPLATE_MAX_SEGS bounds the number of
+// literal runs plus placeholders in one body.
+//
+//*****************************************************************************
+#ifndef HTTP_TEMPLATE_MAX_SEGS
+#define HTTP_TEMPLATE_MAX_SEGS          16
+#endif
+#define HTTP_TEMPLATE_MAX_VALUES        10
+
+//*****************************************************************************
+//
+// One piece of a compiled template body: either a literal run of template
+// text or (when ui8Value is not HTTP_TEMPLATE_LITERAL) a value reference.
+//
+//*****************************************************************************
+#define HTTP_TEMPLATE_LITERAL           0xFF
+
+typedef struct
+{
+    uint16_t ui16Offset;
+    uint16_t ui16Len;
+    uint8_t ui8Value;
+}
+tHTTPTemplateSeg;
+
+//*****************************************************************************
+//
+// A request template compiled by HTTPTemplateCompile().  The head (request
+// line and fixed headers) and the literal body text are referenced, not
+// copied, so the strings passed in must stay valid.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcHead;
+    uint32_t ui32HeadLen;
+    const char *pcBody;
+    uint32_t ui32LiteralLen;
+    uint8_t ui8NumSegs;
+    uint8_t ui8NumValues;
+    tHTTPTemplateSeg psSegs[HTTP_TEMPLATE_MAX_SEGS];
+}
+tHTTPTemplate;
+
 //*****************************************************************************
 //
 // Exported function prototypes.
 //
 //*****************************************************************************
+extern void HTTPParserInit(tHTTPParser *psParser,
+                           tHTTPParserCallback pfnCallback, void *pvCBData);
+extern void HTTPParserRequestInit(tHTTPParser *psParser,
+                                  tHTTPParserCallback pfnCallback,
+                                  void *pvCBData);
+extern void HTTPParserReset(tHTTPParser *psParser);
+extern uint32_t HTTPParserFeed(tHTTPParser *psParser, const char *pcData,
+                               uint32_t ui32Len);
+extern void HTTPParserFinish(tHTTPParser *psParser);
+extern uint32_t HTTPParserStatusGet(tHTTPParser *psParser);
+extern uint32_t HTTPParserFlagsGet(tHTTPParser *psParser);
+
+extern void HTTPRequestInit(tHTTPRequest *psRequest, char *pcBuf,
+                            uint32_t ui32Size);
+extern bool HTTPRequestStart(tHTTPRequest *psRequest, uint8_t ui8Type,
+                             const char *pcResource);
+extern bool HTTPRequestAppend(tHTTPRequest *psRequest, const char *pcData,
+                              uint32_t ui32Len);
+extern bool HTTPRequestHeaderAdd(tHTTPRequest *psRequest, const char *pcName,
+                                 const char *pcValue);
+extern bool HTTPRequestHeaderAddU32(tHTTPRequest *psRequest,
+                                    const char *pcName, uint32_t ui32Value);
+extern bool HTTPRequestHeadersEnd(tHTTPRequest *psRequest);
+extern bool HTTPRequestBodyAdd(tHTTPRequest *psRequest, const char *pcBody,
+                               uint32_t ui32Len);
+extern uint32_t HTTPRequestLenGet(tHTTPRequest *psRequest);
+extern uint32_t HTTPRequestFlagsGet(tHTTPRequest *psRequest);
+
+extern bool HTTPTemplateCompile(tHTTPTemplate *psTemplate, const char *pcHead,
+                                const char *pcBody);
+extern uint32_t HTTPTemplateBodyLenGet(const tHTTPTemplate *psTemplate,
+                                       const char * const *ppcValues);
+extern uint32_t HTTPTemplateRender(const tHTTPTemplate *psTemplate,
+                                   tHTTPRequest *psRequest,
+                                   const char * const *ppcValues);
+
 extern void HTTPMessageTypeSet(char *pcDest, uint8_t ui8Type, char *pcResource);
 extern void HTTPMessageHeaderAdd(char *pcDest, char *pcHeaderName,
                                  char *pcHeaderValue);
@@ -0,0 +1,862 @@
+//*****************************************************************************
+//
+// http_server.c - Minimal HTTP/1.1 server on the lwIP raw TCP API.
+//
+// Requests are parsed incrementally with the request mode of the HTTP parser
+// in http.c, straight out of the received pbufs, so nothing but a small body
+// buffer is held per connection.  Responses are queued with tcp_write()
+// without an intermediate buffer: constant text (status lines, header names,
+// JSON keys) is referenced in place and only formatted numbers are copied.
+// To emit Content-Length and chunk sizes without buffering, every body is
+// produced twice by the application's body function: once to measure it and
+// once to send it.
+//
+// Streamed responses use chunked transfer encoding.  A new chunk is sent
+// every HTTP_SERVER_STREAM_MS from HTTPServerTimer() for as long as the
+// client stays connected and the sample function returns true.
+//
+// Integration: call HTTPServerInit() once the lwIP stack is initialized and
+// HTTPServerTimer() periodically from the lwIP context (for example from the
+// hook set with EthClientTimerHandlerSet()).  All callbacks run in that same
+// context.
+//
+//*****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "utils/lwiplib.h"
+#include "drivers/http.h"
+#include "drivers/http_server.h"
+
+//*****************************************************************************
+//
+// Connection states.
+//
+//*****************************************************************************
+#define CONN_STATE_FREE         0
+#define CONN_STATE_REQUEST      1
+#define CONN_STATE_STREAM       2
+
+//*****************************************************************************
+//
+// Connection flags.
+//
+// CONN_FLAG_ANSWERED: the handler has queued a response for this request.
+// CONN_FLAG_TOO_LARGE: the request body did not fit in pcBody.
+// CONN_FLAG_COUNTING: writes only measure the output (first pass).
+// CONN_FLAG_WRITE_ERROR: tcp_write() refused part of the output.
+// CONN_FLAG_CLOSE: the connection ends after the current response; any
+//   pipelined requests behind it are ignored.
+//
+//*****************************************************************************
+#define CONN_FLAG_ANSWERED      0x01
+#define CONN_FLAG_TOO_LARGE     0x02
+#define CONN_FLAG_COUNTING      0x04
+#define CONN_FLAG_WRITE_ERROR   0x08
+#define CONN_FLAG_CLOSE         0x10
+
+//*****************************************************************************
+//
+// Worst case number of pbufs a response adds to the send queue beyond its
+// byte count: every write can become a separate pbuf.  Used to check that a
+// response fits before any of it is queued.  ConnHasRoom() still checks the
+// actual queue, so this only needs to stay within TCP_SND_QUEUELEN.
+//
+//*****************************************************************************
+#define RESPONSE_MAX_WRITES     64
+
+//*****************************************************************************
+//
+// Per-connection state.
+//
+//*****************************************************************************
+struct tHTTPServerConnStruct
+{
+    struct tcp_pcb *psPCB;
+    uint8_t ui8State;
+    uint8_t ui8Flags;
+
+    //
+    // Route picked from the request line, or 0 with the error status to
+    // answer with in ui16Error.
+    //
+    const tHTTPServerRoute *psRoute;
+    uint16_t ui16Error;
+
+    //
+    // Request body.
+    //
+    uint16_t ui16BodyLen;
+    char pcBody[HTTP_SERVER_BODY_SIZE + 1];
+
+    //
+    // Bytes produced by the writer in the current pass, and the number of
+    // writes (to bound the pbuf count).
+    //
+    uint32_t ui32Count;
+    uint32_t ui32Writes;
+
+    //
+    // Streaming state.
+    //
+    tHTTPServerSampleFunction pfnSample;
+    tHTTPServerBodyFunction pfnBody;
+    void *pvArg;
+    uint32_t ui32StreamMS;
+
+    //
+    // Time since the last request, for the idle timeout.
+    //
+    uint32_t ui32IdleMS;
+
+    tHTTPParser sParser;
+};
+
+//*****************************************************************************
+//
+// Server state.
+//
+//*****************************************************************************
+static struct
+{
+    struct tcp_pcb *psListen;
+    const tHTTPServerRoute *psRoutes;
+    uint32_t ui32NumRoutes;
+    tHTTPServerConn psConns[HTTP_SERVER_MAX_CONNS];
+}
+g_sHTTPServer;
+
+//*****************************************************************************
+//
+// Status lines for the codes the server produces.
+//
+//*****************************************************************************
+static const struct
+{
+    uint16_t ui16Code;
+    const char *pcLine;
+}
+g_psStatusLines[] =
+{
+    { 200, "HTTP/1.1 200 OK\r\n" },
+    { 400, "HTTP/1.1 400 Bad Request\r\n" },
+    { 404, "HTTP/1.1 404 Not Found\r\n" },
+    { 405, "HTTP/1.1 405 Method Not Allowed\r\n" },
+    { 413, "HTTP/1.1 413 Payload Too Large\r\n" },
+    { 500, "HTTP/1.1 500 Internal Server Error\r\n" },
+    { 503, "HTTP/1.1 503 Service Unavailable\r\n" }
+};
+
+#define NUM_STATUS_LINES        (sizeof(g_psStatusLines) /                    \
+                                 sizeof(g_psStatusLines[0]))
+
+//*****************************************************************************
+//
+// Queue bytes on the connection, or only count them in the measuring pass.
+// Constant text is referenced in place; anything else must be copied.
+//
+//*****************************************************************************
+static void
+ConnWrite(tHTTPServerConn *psConn, const char *pcData, uint32_t ui32Len,
+          bool bCopy)
+{
+    err_t iErr;
+
+    if(ui32Len == 0)
+    {
+        return;
+    }
+
+    psConn->ui32Count += ui32Len;
+    psConn->ui32Writes++;
+
+    if(psConn->ui8Flags & (CONN_FLAG_COUNTING | CONN_FLAG_WRITE_ERROR))
+    {
+        return;
+    }
+
+    iErr = tcp_write(psConn->psPCB, pcData, (u16_t)ui32Len,
+                     TCP_WRITE_FLAG_MORE | (bCopy ? TCP_WRITE_FLAG_COPY : 0));
+    if(iErr != ERR_OK)
+    {
+        psConn->ui8Flags |= CONN_FLAG_WRITE_ERROR;
+    }
+}
+
+//*****************************************************************************
+//
+// Format a number in the given base (10 or 16) and write it.
+//
+//*****************************************************************************
+static void
+ConnWriteNumber(tHTTPServerConn *psConn, uint32_t ui32Value,
+                uint32_t ui32Base)
+{
+    char pcBuf[10];
+    uint32_t ui32Idx, ui32Digit;
+
+    ui32Idx = sizeof(pcBuf);
+    do
+    {
+        ui32Digit = ui32Value % ui32Base;
+        pcBuf[--ui32Idx] = (char)((ui32Digit < 10) ? ('0' + ui32Digit) :
+                                                     ('a' + ui32Digit - 10));
+        ui32Value /= ui32Base;
+    }
+    while(ui32Value);
+
+    ConnWrite(psConn, &pcBuf[ui32Idx], sizeof(pcBuf) - ui32Idx, true);
+}
+
+//*****************************************************************************
+//
+// Return true if the connection can take ui32Len more bytes in ui32Writes
+// more pbufs without tcp_write() failing part way.
+//
+//*****************************************************************************
+static bool
+ConnHasRoom(tHTTPServerConn *psConn, uint32_t ui32Len, uint32_t ui32Writes)
+{
+    return((tcp_sndbuf(psConn->psPCB) >= ui32Len) &&
+           ((tcp_sndqueuelen(psConn->psPCB) + ui32Writes) <= TCP_SND_QUEUELEN));
+}
+
+//*****************************************************************************
+//
+// Return a connection slot to the pool.  The pcb, if any, is closed (or
+// aborted if lwIP has no memory to close it).  Returns true if the pcb was
+// aborted, in which case an lwIP callback must return ERR_ABRT.
+//
+//*****************************************************************************
+static bool
+ConnRelease(tHTTPServerConn *psConn)
+{
+    struct tcp_pcb *psPCB;
+    bool bAborted;
+
+    psPCB = psConn->psPCB;
+    bAborted = false;
+
+    psConn->psPCB = 0;
+    psConn->ui8State = CONN_STATE_FREE;
+
+    if(psPCB)
+    {
+        tcp_arg(psPCB, 0);
+        tcp_recv(psPCB, 0);
+        tcp_sent(psPCB, 0);
+        tcp_err(psPCB, 0);
+
+        if(tcp_close(psPCB) != ERR_OK)
+        {
+            tcp_abort(psPCB);
+            bAborted = true;
+        }
+    }
+
+    return(bAborted);
+}
+
+//*****************************************************************************
+//
+// Send the status line and headers.  A zero ui32Length selects chunked
+// encoding.
+//
+//*****************************************************************************
+static void
+ConnWriteHead(tHTTPServerConn *psConn, uint32_t ui32Status,
+              const char *pcType, uint32_t ui32Length, bool bChunked,
+              bool bClose)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < (NUM_STATUS_LINES - 1); ui32Idx++)
+    {
+        if(g_psStatusLines[ui32Idx].ui16Code == ui32Status)
+        {
+            break;
+        }
+    }
+
+    //
+    // Unknown codes fall through to the last entry of the table.
+    //
+    HTTPServerWrite(psConn, g_psStatusLines[ui32Idx].pcLine);
+    HTTPServerWrite(psConn, "Content-Type: ");
+    HTTPServerWrite(psConn, pcType);
+    if(bChunked)
+    {
+        HTTPServerWrite(psConn, "\r\nTransfer-Encoding: chunked\r\n"
+                                "Cache-Control: no-store\r\n");
+    }
+    else
+    {
+        HTTPServerWrite(psConn, "\r\nContent-Length: ");
+        HTTPServerWriteU32(psConn, ui32Length);
+        HTTPServerWrite(psConn, "\r\n");
+    }
+    if(bClose)
+    {
+        HTTPServerWrite(psConn, "Connection: close\r\n");
+    }
+    HTTPServerWrite(psConn, "\r\n");
+}
+
+//*****************************************************************************
+//
+// Body function for the fixed error responses.  pvArg is the status code.
+//
+//*****************************************************************************
+static void
+ErrorBody(tHTTPServerConn *psConn, void *pvArg)
+{
+    HTTPServerWrite(psConn, "{\"error\":");
+    HTTPServerWriteU32(psConn, (uint32_t)(uintptr_t)pvArg);
+    HTTPServerWrite(psConn, "}\n");
+}
+
+//*****************************************************************************
+//
+// Send one chunk of a streamed response.  Returns false if the stream has
+// ended and the connection was released.
+//
+//*****************************************************************************
+static bool
+ConnStreamChunk(tHTTPServerConn *psConn)
+{
+    uint32_t ui32Len, ui32Writes, ui32Digits;
+
+    if(!psConn->pfnSample(psConn->pvArg))
+    {
+        //
+        // Last chunk.  Failing to queue it only loses the clean end of the
+        // stream; the connection is closed either way.
+        //
+        ConnWrite(psConn, "0\r\n\r\n", 5, false);
+        tcp_output(psConn->psPCB);
+        ConnRelease(psConn);
+        return(false);
+    }
+
+    //
+    // Measure the chunk.
+    //
+    psConn->ui8Flags |= CONN_FLAG_COUNTING;
+    psConn->ui32Count = 0;
+    psConn->ui32Writes = 0;
+    psConn->pfnBody(psConn, psConn->pvArg);
+    ui32Len = psConn->ui32Count;
+    ui32Writes = psConn->ui32Writes + 3;
+    psConn->ui8Flags &= ~CONN_FLAG_COUNTING;
+
+    if(ui32Len == 0)
+    {
+        return(true);
+    }
+
+    //
+    // A slow client only misses samples; it never gets a partial chunk.
+    //
+    for(ui32Digits = 1; (ui32Len >> (ui32Digits * 4)) != 0; ui32Digits++)
+    {
+    }
+    if(!ConnHasRoom(psConn, ui32Len + ui32Digits + 4, ui32Writes))
+    {
+        return(true);
+    }
+
+    ConnWriteNumber(psConn, ui32Len, 16);
+    ConnWrite(psConn, "\r\n", 2, false);
+    psConn->pfnBody(psConn, psConn->pvArg);
+    ConnWrite(psConn, "\r\n", 2, false);
+
+    //
+    // A chunk cut short would corrupt the stream for the client.
+    //
+    if(psConn->ui8Flags & CONN_FLAG_WRITE_ERROR)
+    {
+        ConnRelease(psConn);
+        return(false);
+    }
+
+    tcp_output(psConn->psPCB);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Parser callback: route the request, collect the body and dispatch once the
+// request is complete.
+//
+//*****************************************************************************
+static void
+ConnParserEvent(void *pvCBData, uint32_t ui32Event, const char *pcData1,
+                uint32_t ui32Len1, const char *pcData2, uint32_t ui32Len2)
+{
+    tHTTPServerConn *psConn;
+    const tHTTPServerRoute *psRoute;
+    uint32_t ui32Idx, ui32PathLen;
+    bool bPathFound;
+
+    psConn = (tHTTPServerConn *)pvCBData;
+
+    //
+    // Nothing more is answered once the connection is on its way out.
+    //
+    if(psConn->ui8Flags & (CONN_FLAG_CLOSE | CONN_FLAG_WRITE_ERROR))
+    {
+        return;
+    }
+
+    switch(ui32Event)
+    {
+        case HTTP_PARSE_EVENT_REQUEST:
+        {
+            psConn->ui8Flags = 0;
+            psConn->ui16BodyLen = 0;
+            psConn->psRoute = 0;
+            psConn->ui16Error = 404;
+            psConn->ui32IdleMS = 0;
+
+            //
+            // Match the path without its query string.
+            //
+            for(ui32PathLen = 0; ui32PathLen < ui32Len2; ui32PathLen++)
+            {
+                if(pcData2[ui32PathLen] == '?')
+                {
+                    break;
+                }
+            }
+
+            bPathFound = false;
+            for(ui32Idx = 0; ui32Idx < g_sHTTPServer.ui32NumRoutes; ui32Idx++)
+            {
+                psRoute = &g_sHTTPServer.psRoutes[ui32Idx];
+                if((strlen(psRoute->pcPath) != ui32PathLen) ||
+                   strncmp(psRoute->pcPath, pcData2, ui32PathLen))
+                {
+                    continue;
+                }
+                bPathFound = true;
+                if(!strcmp(psRoute->pcMethod, pcData1))
+                {
+                    psConn->psRoute = psRoute;
+                    break;
+                }
+            }
+            if(!psConn->psRoute && bPathFound)
+            {
+                psConn->ui16Error = 405;
+            }
+            break;
+        }
+
+        case HTTP_PARSE_EVENT_BODY:
+        {
+            if((psConn->ui16BodyLen + ui32Len1) > HTTP_SERVER_BODY_SIZE)
+            {
+                psConn->ui8Flags |= CONN_FLAG_TOO_LARGE;
+            }
+            else
+            {
+                memcpy(&psConn->pcBody[psConn->ui16BodyLen], pcData1,
+                       ui32Len1);
+                psConn->ui16BodyLen += (uint16_t)ui32Len1;
+            }
+            break;
+        }
+
+        case HTTP_PARSE_EVENT_COMPLETE:
+        {
+            psConn->pcBody[psConn->ui16BodyLen] = 0;
+
+            if(psConn->ui8Flags & CONN_FLAG_TOO_LARGE)
+            {
+                HTTPServerError(psConn, 413);
+            }
+            else if(!psConn->psRoute)
+            {
+                HTTPServerError(psConn, psConn->ui16Error);
+            }
+            else
+            {
+                psConn->psRoute->pfnHandler(psConn, psConn->pcBody,
+                                            psConn->ui16BodyLen);
+                if(!(psConn->ui8Flags & CONN_FLAG_ANSWERED))
+                {
+                    HTTPServerError(psConn, 500);
+                }
+            }
+            break;
+        }
+
+        case HTTP_PARSE_EVENT_ERROR:
+        {
+            psConn->ui8Flags |= CONN_FLAG_CLOSE;
+            HTTPServerError(psConn, 400);
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// lwIP callback: data received (or the client closed the connection).
+//
+//*****************************************************************************
+static err_t
+ConnReceived(void *pvArg, struct tcp_pcb *psPCB, struct pbuf *psBuf,
+             err_t iErr)
+{
+    tHTTPServerConn *psConn;
+    struct pbuf *psNext;
+
+    psConn = (tHTTPServerConn *)pvArg;
+
+    if(psBuf == 0)
+    {
+        return(ConnRelease(psConn) ? ERR_ABRT : ERR_OK);
+    }
+
+    tcp_recved(psPCB, psBuf->tot_len);
+
+    //
+    // Requests are parsed in place, pbuf by pbuf.  Input that arrives while a
+    // stream is running is discarded.
+    //
+    for(psNext = psBuf;
+        psNext && (psConn->ui8State == CONN_STATE_REQUEST) &&
+        !(psConn->ui8Flags & (CONN_FLAG_CLOSE | CONN_FLAG_WRITE_ERROR));
+        psNext = psNext->next)
+    {
+        HTTPParserFeed(&psConn->sParser, psNext->payload, psNext->len);
+    }
+
+    pbuf_free(psBuf);
+
+    //
+    // The connection ends after a "Connection: close" request, a request the
+    // parser rejected, or a response that could not be queued whole.
+    //
+    if((psConn->ui8State == CONN_STATE_REQUEST) &&
+       (psConn->ui8Flags & (CONN_FLAG_CLOSE | CONN_FLAG_WRITE_ERROR)))
+    {
+        if(!(psConn->ui8Flags & CONN_FLAG_WRITE_ERROR))
+        {
+            tcp_output(psPCB);
+        }
+        return(ConnRelease(psConn) ? ERR_ABRT : ERR_OK);
+    }
+
+    return(ERR_OK);
+}
+
+//*****************************************************************************
+//
+// lwIP callback: the connection was reset or aborted.  The pcb is already
+// gone.
+//
+//*****************************************************************************
+static void
+ConnError(void *pvArg, err_t iErr)
+{
+    tHTTPServerConn *psConn;
+
+    psConn = (tHTTPServerConn *)pvArg;
+    if(psConn)
+    {
+        psConn->psPCB = 0;
+        psConn->ui8State = CONN_STATE_FREE;
+    }
+}
+
+//*****************************************************************************
+//
+// lwIP callback: a client connected.
+//
+//*****************************************************************************
+static err_t
+ConnAccept(void *pvArg, struct tcp_pcb *psPCB, err_t iErr)
+{
+    tHTTPServerConn *psConn;
+    uint32_t ui32Idx;
+
+    tcp_accepted(g_sHTTPServer.psListen);
+
+    psConn = 0;
+    for(ui32Idx = 0; ui32Idx < HTTP_SERVER_MAX_CONNS; ui32Idx++)
+    {
+        if(g_sHTTPServer.psConns[ui32Idx].ui8State == CONN_STATE_FREE)
+        {
+            psConn = &g_sHTTPServer.psConns[ui32Idx];
+            break;
+        }
+    }
+
+    //
+    // All slots busy: lwIP aborts the new connection.
+    //
+    if(!psConn)
+    {
+        return(ERR_MEM);
+    }
+
+    psConn->psPCB = psPCB;
+    psConn->ui8State = CONN_STATE_REQUEST;
+    psConn->ui8Flags = 0;
+    psConn->ui32IdleMS = 0;
+    HTTPParserRequestInit(&psConn->sParser, ConnParserEvent, psConn);
+
+    tcp_setprio(psPCB, TCP_PRIO_MIN);
+    tcp_arg(psPCB, psConn);
+    tcp_recv(psPCB, ConnReceived);
+    tcp_err(psPCB, ConnError);
+
+    return(ERR_OK);
+}
+
+//*****************************************************************************
+//
+//! Start the HTTP server.
+//!
+//! \param ui16Port is the TCP port to listen on.
+//! \param psRoutes is the route table.  It must stay valid while the server
+//! runs.
+//! \param ui32NumRoutes is the number of entries in \e psRoutes.
+//!
+//! Requests for a path that is not in the table are answered with 404, and
+//! requests for a known path with a method that is not listed for it with
+//! 405.
+//!
+//! \return Returns true if the server is listening.
+//
+//*****************************************************************************
+bool
+HTTPServerInit(uint16_t ui16Port, const tHTTPServerRoute *psRoutes,
+               uint32_t ui32NumRoutes)
+{
+    struct tcp_pcb *psPCB;
+
+    memset(&g_sHTTPServer, 0, sizeof(g_sHTTPServer));
+    g_sHTTPServer.psRoutes = psRoutes;
+    g_sHTTPServer.ui32NumRoutes = ui32NumRoutes;
+
+    psPCB = tcp_new();
+    if(!psPCB)
+    {
+        return(false);
+    }
+
+    if(tcp_bind(psPCB, IP_ADDR_ANY, ui16Port) != ERR_OK)
+    {
+        tcp_close(psPCB);
+        return(false);
+    }
+
+    g_sHTTPServer.psListen = tcp_listen(psPCB);
+    if(!g_sHTTPServer.psListen)
+    {
+        tcp_close(psPCB);
+        return(false);
+    }
+
+    tcp_accept(g_sHTTPServer.psListen, ConnAccept);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Advance the server's timers.
+//!
+//! \param ui32TickMS is the time in milliseconds since the previous call.
+//!
+//! This sends the next chunk of every stream that is due and closes idle
+//! keep-alive connections.  It must be called from the lwIP context.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerTimer(uint32_t ui32TickMS)
+{
+    tHTTPServerConn *psConn;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < HTTP_SERVER_MAX_CONNS; ui32Idx++)
+    {
+        psConn = &g_sHTTPServer.psConns[ui32Idx];
+
+        if(psConn->ui8State == CONN_STATE_STREAM)
+        {
+            psConn->ui32StreamMS += ui32TickMS;
+            if(psConn->ui32StreamMS >= HTTP_SERVER_STREAM_MS)
+            {
+                psConn->ui32StreamMS = 0;
+                ConnStreamChunk(psConn);
+            }
+        }
+        else if(psConn->ui8State == CONN_STATE_REQUEST)
+        {
+            psConn->ui32IdleMS += ui32TickMS;
+            if(psConn->ui32IdleMS >= HTTP_SERVER_IDLE_MS)
+            {
+                ConnRelease(psConn);
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Answer the current request.
+//!
+//! \param psConn is the connection passed to the route handler.
+//! \param ui32Status is the HTTP status code.
+//! \param pcType is the Content-Type.  It must be a constant string.
+//! \param pfnBody writes the body; it is called twice.
+//! \param pvArg is passed to \e pfnBody.
+//!
+//! The whole response is queued at once, or not at all if the send buffer
+//! cannot take it, in which case the connection is closed.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerRespond(tHTTPServerConn *psConn, uint32_t ui32Status,
+                  const char *pcType, tHTTPServerBodyFunction pfnBody,
+                  void *pvArg)
+{
+    uint32_t ui32BodyLen, ui32Len, ui32Writes;
+    bool bClose;
+
+    psConn->ui8Flags |= CONN_FLAG_ANSWERED;
+    if(HTTPParserFlagsGet(&psConn->sParser) & HTTP_PARSER_FLAG_CLOSE)
+    {
+        psConn->ui8Flags |= CONN_FLAG_CLOSE;
+    }
+    bClose = (psConn->ui8Flags & CONN_FLAG_CLOSE) ? true : false;
+
+    //
+    // Measure the body, then the head that announces its length.
+    //
+    psConn->ui8Flags |= CONN_FLAG_COUNTING;
+    psConn->ui32Count = 0;
+    psConn->ui32Writes = 0;
+    pfnBody(psConn, pvArg);
+    ui32BodyLen = psConn->ui32Count;
+    ConnWriteHead(psConn, ui32Status, pcType, ui32BodyLen, false, bClose);
+    ui32Len = psConn->ui32Count;
+    ui32Writes = psConn->ui32Writes;
+    psConn->ui8Flags &= ~CONN_FLAG_COUNTING;
+
+    if((ui32Writes > RESPONSE_MAX_WRITES) ||
+       !ConnHasRoom(psConn, ui32Len, ui32Writes))
+    {
+        psConn->ui8Flags |= CONN_FLAG_WRITE_ERROR;
+        return;
+    }
+
+    ConnWriteHead(psConn, ui32Status, pcType, ui32BodyLen, false, bClose);
+    pfnBody(psConn, pvArg);
+    tcp_output(psConn->psPCB);
+}
+
+//*****************************************************************************
+//
+//! Answer the current request with a chunked stream.
+//!
+//! \param psConn is the connection passed to the route handler.
+//! \param pcType is the Content-Type.  It must be a constant string.
+//! \param pfnSample captures the data for the next chunk and returns false to
+//! end the stream.
+//! \param pfnBody writes one chunk; it is called twice per chunk.
+//! \param pvArg is passed to \e pfnSample and \e pfnBody.
+//!
+//! The headers are sent now and the first chunk HTTP_SERVER_STREAM_MS later.
+//! The stream runs until the client disconnects or \e pfnSample returns
+//! false; further requests on the connection are ignored.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerStreamStart(tHTTPServerConn *psConn, const char *pcType,
+                      tHTTPServerSampleFunction pfnSample,
+                      tHTTPServerBodyFunction pfnBody, void *pvArg)
+{
+    psConn->ui8Flags |= CONN_FLAG_ANSWERED;
+
+    psConn->ui32Count = 0;
+    psConn->ui32Writes = 0;
+    ConnWriteHead(psConn, 200, pcType, 0, true, false);
+    if(psConn->ui8Flags & CONN_FLAG_WRITE_ERROR)
+    {
+        return;
+    }
+    tcp_output(psConn->psPCB);
+
+    psConn->pfnSample = pfnSample;
+    psConn->pfnBody = pfnBody;
+    psConn->pvArg = pvArg;
+    psConn->ui32StreamMS = 0;
+    psConn->ui8State = CONN_STATE_STREAM;
+}
+
+//*****************************************************************************
+//
+//! Answer the current request with an error status and a small JSON body.
+//!
+//! \param psConn is the connection passed to the route handler.
+//! \param ui32Status is the HTTP status code.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerError(tHTTPServerConn *psConn, uint32_t ui32Status)
+{
+    HTTPServerRespond(psConn, ui32Status, "application/json", ErrorBody,
+                      (void *)(uintptr_t)ui32Status);
+}
+
+//*****************************************************************************
+//
+//! Write constant text to the response.
+//!
+//! \param psConn is the connection passed to the body function.
+//! \param pcText is a NUL terminated string.  It is sent in place, so it must
+//! be constant (for example a string literal) and not a buffer that changes.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerWrite(tHTTPServerConn *psConn, const char *pcText)
+{
+    ConnWrite(psConn, pcText, strlen(pcText), false);
+}
+
+//*****************************************************************************
+//
+//! Write an unsigned decimal number to the response.
+//!
+//! \param psConn is the connection passed to the body function.
+//! \param ui32Value is the number to write.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+HTTPServerWriteU32(tHTTPServerConn *psConn, uint32_t ui32Value)
+{
+    ConnWriteNumber(psConn, ui32Value, 10);
+}
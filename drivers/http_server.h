@@ -0,0 +1,133 @@
+//*****************************************************************************
+//
+// http_server.h - Minimal HTTP/1.1 server on the lwIP raw TCP API.
+//
+//*****************************************************************************
+#ifndef HTTP_SERVER_H_
+#define HTTP_SERVER_H_
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Number of simultaneous client connections.  Further connections are
+// refused until a slot frees up.
+//
+//*****************************************************************************
+#ifndef HTTP_SERVER_MAX_CONNS
+#define HTTP_SERVER_MAX_CONNS           4
+#endif
+
+//*****************************************************************************
+//
+// Largest request body accepted.  Bigger bodies are answered with 413.
+//
+//*****************************************************************************
+#ifndef HTTP_SERVER_BODY_SIZE
+#define HTTP_SERVER_BODY_SIZE           64
+#endif
+
+//*****************************************************************************
+//
+// Interval between chunks of a streamed response.
+//
+//*****************************************************************************
+#ifndef HTTP_SERVER_STREAM_MS
+#define HTTP_SERVER_STREAM_MS           500
+#endif
+
+//*****************************************************************************
+//
+// Keep-alive connections that see no request for this long are closed.
+// Streaming connections are exempt.
+//
+//*****************************************************************************
+#ifndef HTTP_SERVER_IDLE_MS
+#define HTTP_SERVER_IDLE_MS             30000
+#endif
+
+//*****************************************************************************
+//
+// A connection.  The contents are private to http_server.c.
+//
+//*****************************************************************************
+typedef struct tHTTPServerConnStruct tHTTPServerConn;
+
+//*****************************************************************************
+//
+// Writes a response body with HTTPServerWrite() and HTTPServerWriteU32().
+// It is called twice per response, first to measure the body and then to
+// send it, and must produce the same output both times.
+//
+//*****************************************************************************
+typedef void (* tHTTPServerBodyFunction)(tHTTPServerConn *psConn,
+                                         void *pvArg);
+
+//*****************************************************************************
+//
+// Captures the data for the next chunk of a streamed response, so that both
+// calls of the body function see the same values.  Returning false ends the
+// stream.
+//
+//*****************************************************************************
+typedef bool (* tHTTPServerSampleFunction)(void *pvArg);
+
+//*****************************************************************************
+//
+// Handles a complete request for a route.  pcBody is NUL terminated.  The
+// handler answers with HTTPServerRespond(), HTTPServerStreamStart() or
+// HTTPServerError(); if it does none of these the client gets a 500.
+//
+//*****************************************************************************
+typedef void (* tHTTPServerHandler)(tHTTPServerConn *psConn,
+                                    const char *pcBody, uint32_t ui32BodyLen);
+
+//*****************************************************************************
+//
+// One entry of the route table passed to HTTPServerInit().  The query string
+// of the request target is ignored when matching pcPath.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcMethod;
+    const char *pcPath;
+    tHTTPServerHandler pfnHandler;
+}
+tHTTPServerRoute;
+
+//*****************************************************************************
+//
+// Exported function prototypes.
+//
+//*****************************************************************************
+extern bool HTTPServerInit(uint16_t ui16Port, const tHTTPServerRoute *psRoutes,
+                           uint32_t ui32NumRoutes);
+extern void HTTPServerTimer(uint32_t ui32TickMS);
+
+extern void HTTPServerRespond(tHTTPServerConn *psConn, uint32_t ui32Status,
+                              const char *pcType,
+                              tHTTPServerBodyFunction pfnBody, void *pvArg);
+extern void HTTPServerStreamStart(tHTTPServerConn *psConn, const char *pcType,
+                                  tHTTPServerSampleFunction pfnSample,
+                                  tHTTPServerBodyFunction pfnBody,
+                                  void *pvArg);
+extern void HTTPServerError(tHTTPServerConn *psConn, uint32_t ui32Status);
+
+extern void HTTPServerWrite(tHTTPServerConn *psConn, const char *pcText);
+extern void HTTPServerWriteU32(tHTTPServerConn *psConn, uint32_t ui32Value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_SERVER_H_
@@ -0,0 +1,46 @@
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+/*
+ * On-chip flash map (TM4C1294NCPDT: 1 MB, 16 KB erase sectors).
+ *
+ * The linker script (TM4C1294XL.ld) gives the application the first 256 KB.
+ * Built with BOOTLOADER=1, the first sector holds the bootloader instead
+ * (bootloader/) and the application is linked at 0x4000
+ * (TM4C1294XL_bootapp.ld). Everything above 256 KB is free for data and is
+ * carved up here so that modules storing data in flash never overlap each
+ * other or the image. Every region starts and ends on an erase-sector
+ * boundary.
+ *
+ *   0x00000 - 0x03FFF  bootloader (BOOTLOADER=1 builds)
+ *   0x00000 - 0x3FFFF  application image (linker FLASH region; 0x04000 up with the bootloader)
+ *   0x40000 - 0x7BFFF  firmware update staging image (fwupdate.c)
+ *   0x7C000 - 0x7FFFF  firmware update metadata (fwupdate.h, read by the bootloader)
+ *   0x80000 - 0x9FFFF  cloud uplink store-and-forward spill (drivers/cloud_uplink.c)
+ *   0xA0000 - 0xFFFFF  RPM/duty data logger ring (flashlog.c)
+ */
+#define FLASH_SECTOR_SIZE       0x4000u
+
+#ifdef BOOTLOADER_ENABLED
+#define FLASH_BOOT_BASE         0x00000000u
+#define FLASH_BOOT_SIZE         0x00004000u
+#define FLASH_APP_BASE          0x00004000u
+#define FLASH_APP_SIZE          0x0003C000u
+#else
+#define FLASH_APP_BASE          0x00000000u
+#define FLASH_APP_SIZE          0x00040000u
+#endif
+
+#define FLASH_FWSTAGE_BASE      0x00040000u
+#define FLASH_FWSTAGE_SIZE      0x0003C000u
+
+#define FLASH_FWMETA_BASE       0x0007C000u
+#define FLASH_FWMETA_SIZE       0x00004000u
+
+#define FLASH_CLOUD_SPILL_BASE  0x00080000u
+#define FLASH_CLOUD_SPILL_SIZE  0x00020000u
+
+#define FLASH_LOG_BASE          0x000A0000u
+#define FLASH_LOG_SIZE          0x00060000u
+
+#endif /* FLASH_LAYOUT_H */
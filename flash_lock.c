@@ -0,0 +1,50 @@
+#include "flash_lock.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "modbus.h"
+#include "speedctl.h"
+#include "sspwm.h"
+#include "steptest.h"
+#include "sweep.h"
+#include "tsyn.h"
+
+static flash_owner_t g_owner = FLASH_OWNER_NONE;
+
+/* Active exception number; 0 in thread mode. */
+static uint32_t active_exception(void)
+{
+    uint32_t ipsr;
+
+    __asm__ volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return ipsr & 0x1FFU;
+}
+
+bool flash_lock(flash_owner_t who)
+{
+    /* Only the main context takes it, so no interrupt can race the check. */
+    if (active_exception() != 0U || g_owner != FLASH_OWNER_NONE) {
+        return false;
+    }
+    g_owner = who;
+    return true;
+}
+
+void flash_unlock(flash_owner_t who)
+{
+    if (g_owner == who) {
+        g_owner = FLASH_OWNER_NONE;
+    }
+}
+
+flash_owner_t flash_lock_owner(void)
+{
+    return g_owner;
+}
+
+bool flash_erase_permitted(void)
+{
+    return !modbus_is_enabled() && speedctl_get_rpm() == 0U && !tsyn_is_enabled() &&
+           !sspwm_is_enabled() && !sweep_is_running() && !steptest_is_running();
+}
@@ -0,0 +1,47 @@
+#ifndef FLASH_LOCK_H
+#define FLASH_LOCK_H
+
+#include <stdbool.h>
+
+/*
+ * One owner for the on-chip flash controller.
+ *
+ * FlashErase() and FlashProgram() each write the FMA/FMD registers and then
+ * start the operation through FMC; a second writer that runs in between
+ * corrupts both operations. Every writer in the application (flashlog.c,
+ * fwupdate.c and the cloud spill, which net.c runs) therefore takes this
+ * lock around its erases and programs, and the lock is only granted in the
+ * main context (thread mode), never in an interrupt handler. The main loop
+ * runs one task at a time, so a writer cannot be preempted by another.
+ *
+ * A request from an interrupt handler (e.g. a TCP console command, which
+ * runs in the lwIP context) is refused; the caller defers the work to its
+ * scheduler task or reports an error.
+ */
+
+typedef enum {
+    FLASH_OWNER_NONE = 0,
+    FLASH_OWNER_LOG,            /* flashlog.c */
+    FLASH_OWNER_FWUPDATE,       /* fwupdate.c */
+    FLASH_OWNER_CLOUD,          /* cloud spill (net.c) */
+} flash_owner_t;
+
+/* Take the controller for a run of erases/programs. False in an interrupt
+   handler or while another owner holds it. */
+bool flash_lock(flash_owner_t who);
+void flash_unlock(flash_owner_t who);
+
+flash_owner_t flash_lock_owner(void);
+
+/*
+ * A sector erase stalls every fetch from flash, and all code, the vector
+ * table and every ISR run from flash, so the core stops for the whole erase
+ * (tens of ms). Background erases (log pre-erase, LOG CLEAR, cloud spill) are
+ * therefore only started while nothing timing-critical runs: no Modbus on
+ * UART3, no RPM speed loop, no TSYN output, no SSPWM dither and no SWEEP or
+ * STEP measurement. Plain PWM keeps running in hardware. Programming a block
+ * (a few hundred us) is not gated.
+ */
+bool flash_erase_permitted(void);
+
+#endif /* FLASH_LOCK_H */
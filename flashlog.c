@@ -0,0 +1,599 @@
+#include "flashlog.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driverlib/flash.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+
+#include "binproto.h"
+#include "cmdline.h"
+#include "commands.h"       /* pwm_get_percent_requested(), pwm_is_enabled() */
+#include "config_store.h"
+#include "crc.h"
+#include "flash_layout.h"
+#include "flash_lock.h"
+#include "modbus.h"
+#include "tach.h"
+#include "timebase.h"
+
+#define FLOG_BLOCK_SIZE     32U
+#define FLOG_DATA_SIZE      30U     /* then CRC-16/MODBUS, little-endian */
+#define FLOG_SECTORS        (FLASH_LOG_SIZE / FLASH_SECTOR_SIZE)
+#define FLOG_BLOCKS         (FLASH_SECTOR_SIZE / FLOG_BLOCK_SIZE)  /* block 0 is the header */
+#define FLOG_MAGIC          0x474F4C46U     /* "FLOG" */
+#define FLOG_NO_SEQ         0xFFFFFFFFU
+
+/*
+ * Records, by first byte (d = two's complement delta):
+ *
+ *   0xxxxxxx               rpm += d7, duty unchanged
+ *   10xxxxxx xxxxxxxx      rpm += d14 (high bits first), duty unchanged
+ *   110ddddd rrrrrrrr      duty += d5, rpm += d8
+ *   E0 rpm16 duty8         absolute sample
+ *   E1 index32             next sample's index in the run (after drops)
+ *   F0 period16            run start: index 0, period in ms
+ *   FF                     unused rest of the block
+ *
+ * A sample's time is its index times the period. Every sector and every
+ * run starts with an absolute sample, so a lost block only costs the rest
+ * of its sector's deltas.
+ */
+#define FLOG_OP_ABS         0xE0U
+#define FLOG_OP_INDEX       0xE1U
+#define FLOG_OP_RUN         0xF0U
+#define FLOG_OP_PAD         0xFFU
+
+typedef struct {
+    uint32_t seq;           /* sector number; the sector is seq % FLOG_SECTORS */
+    uint16_t period_ms;
+    uint16_t reserved;
+    uint32_t first_sample;  /* index of the sector's first sample in its run */
+    uint32_t spare[4];
+    uint32_t magic;         /* programmed last */
+} flog_header_t;
+
+/* Config store record (CONFIG_REC_FLASHLOG). */
+typedef struct {
+    uint8_t enabled;
+    uint8_t reserved;
+    uint16_t period_ms;
+} flog_config_t;
+
+/* Dump frame: u32 seq, u16 period, u32 first sample, u16 first block,
+   u8 blocks, then the raw 32-byte blocks. */
+#define FLOG_DUMP_HDR       13U
+#define FLOG_DUMP_BLOCKS    15U
+#define FLOG_DUMP_MAX       (FLOG_DUMP_HDR + FLOG_DUMP_BLOCKS * FLOG_BLOCK_SIZE)
+
+static bool g_enabled = false;
+static uint32_t g_period_ms = FLASHLOG_DEFAULT_MS;
+static uint32_t g_last_ms = 0;
+
+/* Write position. g_block == FLOG_BLOCKS: open the next sector first. */
+static uint32_t g_seq = FLOG_NO_SEQ;
+static uint32_t g_block = FLOG_BLOCKS;
+static bool g_next_ready = false;       /* sector g_seq + 1 is erased */
+static bool g_erase_held = false;       /* an erase waits for flash_erase_permitted() */
+static uint32_t g_clear_next = FLOG_SECTORS;
+
+static uint32_t g_buf[FLOG_BLOCK_SIZE / 4U];
+static uint32_t g_fill = 0;
+static volatile bool g_close_pending = false;  /* block_close() left to flashlog_task() */
+
+/* Encoder state. */
+static bool g_run_pending = false;
+static bool g_resync = false;
+static bool g_have_base = false;
+static uint16_t g_rpm = 0;
+static uint8_t g_duty = 0;
+static uint32_t g_sample = 0;
+
+static uint32_t g_samples = 0;
+static uint32_t g_bytes = 0;
+static uint32_t g_dropped = 0;
+static uint32_t g_erases = 0;
+
+/* Dump in progress. */
+static console_t *g_dump_con = 0;
+static binproto_dump_t g_dump;
+static uint32_t g_dump_seq = 0;
+static uint32_t g_dump_block = 0;
+static uint32_t g_dump_left = 0;        /* sectors, including g_dump_seq */
+static uint32_t g_dump_last_block = 0;  /* write position in the newest one */
+static uint32_t g_dump_blocks = 0;
+
+/* ---- Flash --------------------------------------------------------------- */
+
+static uint32_t sector_addr(uint32_t seq)
+{
+    return FLASH_LOG_BASE + (seq % FLOG_SECTORS) * FLASH_SECTOR_SIZE;
+}
+
+static const flog_header_t *sector_header(uint32_t seq)
+{
+    return (const flog_header_t *)sector_addr(seq);
+}
+
+static bool words_erased(uint32_t addr, uint32_t len)
+{
+    const volatile uint32_t *p = (const volatile uint32_t *)addr;
+
+    for (uint32_t i = 0; i < len / 4U; i++) {
+        if (p[i] != 0xFFFFFFFFU) return false;
+    }
+    return true;
+}
+
+static bool erase_sector(uint32_t addr)
+{
+    if (words_erased(addr, FLASH_SECTOR_SIZE)) {
+        return true;
+    }
+    g_erases++;
+    return MAP_FlashErase(addr) == 0;
+}
+
+/* ---- Writer -------------------------------------------------------------- */
+
+/* Pad, add the CRC and program the current block. */
+static void block_close(void)
+{
+    uint8_t *b = (uint8_t *)g_buf;
+    uint32_t crc;
+
+    if (g_fill == 0U) {
+        return;
+    }
+
+    memset(b + g_fill, FLOG_OP_PAD, FLOG_DATA_SIZE - g_fill);
+    crc = crc_calc(CRC_ALG_CRC16_MODBUS, b, FLOG_DATA_SIZE);
+    b[FLOG_DATA_SIZE] = (uint8_t)crc;
+    b[FLOG_DATA_SIZE + 1U] = (uint8_t)(crc >> 8);
+
+    MAP_FlashProgram(g_buf, sector_addr(g_seq) + g_block * FLOG_BLOCK_SIZE, FLOG_BLOCK_SIZE);
+    g_block++;
+    g_fill = 0;
+}
+
+/* Program the RAM block now if the flash is free to this context (main
+   loop); from an interrupt handler (TCP console) flashlog_task() does it. */
+static void flog_flush(void)
+{
+    if (flash_lock(FLASH_OWNER_LOG)) {
+        block_close();
+        flash_unlock(FLASH_OWNER_LOG);
+    } else {
+        g_close_pending = true;
+    }
+}
+
+/* Move to the pre-erased next sector and write its header. */
+static bool sector_open(void)
+{
+    flog_header_t h;
+    uint32_t addr;
+
+    if (!g_next_ready) {
+        return false;
+    }
+
+    g_seq++;
+    addr = sector_addr(g_seq);
+
+    memset(&h, 0xFF, sizeof(h));
+    h.seq = g_seq;
+    h.period_ms = (uint16_t)g_period_ms;
+    h.first_sample = g_sample;
+    MAP_FlashProgram((uint32_t *)&h, addr, sizeof(h) - 4U);
+    h.magic = FLOG_MAGIC;
+    MAP_FlashProgram(&h.magic, addr + sizeof(h) - 4U, 4U);
+
+    g_block = 1;
+    g_fill = 0;
+    g_have_base = false;
+    g_resync = false;
+    /* The idle hook erases the one after (the oldest data). */
+    g_next_ready = false;
+    return true;
+}
+
+/* Room for len bytes in the current block; false if no sector is ready. */
+static bool flog_reserve(uint32_t len)
+{
+    if (g_block < FLOG_BLOCKS && g_fill + len > FLOG_DATA_SIZE) {
+        block_close();
+    }
+    if (g_block >= FLOG_BLOCKS) {
+        return sector_open();
+    }
+    return true;
+}
+
+static void flog_put(const uint8_t *rec, uint32_t len)
+{
+    memcpy((uint8_t *)g_buf + g_fill, rec, len);
+    g_fill += len;
+    g_bytes += len;
+}
+
+static uint32_t flog_encode(uint8_t *rec, uint16_t rpm, uint8_t duty)
+{
+    int32_t dr = (int32_t)rpm - (int32_t)g_rpm;
+    int32_t dd = (int32_t)duty - (int32_t)g_duty;
+
+    if (g_have_base && dd == 0 && dr >= -64 && dr <= 63) {
+        rec[0] = (uint8_t)((uint32_t)dr & 0x7FU);
+        return 1U;
+    }
+    if (g_have_base && dd == 0 && dr >= -8192 && dr <= 8191) {
+        rec[0] = (uint8_t)(0x80U | (((uint32_t)dr >> 8) & 0x3FU));
+        rec[1] = (uint8_t)dr;
+        return 2U;
+    }
+    if (g_have_base && dd >= -16 && dd <= 15 && dr >= -128 && dr <= 127) {
+        rec[0] = (uint8_t)(0xC0U | ((uint32_t)dd & 0x1FU));
+        rec[1] = (uint8_t)dr;
+        return 2U;
+    }
+    rec[0] = FLOG_OP_ABS;
+    (void)binproto_put_u16(&rec[1], rpm);
+    rec[3] = duty;
+    return 4U;
+}
+
+/* No sector to write to: the sample is lost, the index moves on. */
+static void flog_drop(void)
+{
+    g_dropped++;
+    g_sample++;
+    g_resync = true;
+}
+
+static void flog_sample(uint16_t rpm, uint8_t duty)
+{
+    uint8_t rec[5];
+    uint32_t len;
+
+    if (g_run_pending) {
+        if (!flog_reserve(3U)) {
+            flog_drop();
+            return;
+        }
+        rec[0] = FLOG_OP_RUN;
+        (void)binproto_put_u16(&rec[1], (uint16_t)g_period_ms);
+        flog_put(rec, 3U);
+        g_run_pending = false;
+        g_have_base = false;
+        g_resync = (g_sample != 0U);
+    }
+
+    if (g_resync) {
+        if (!flog_reserve(5U)) {
+            flog_drop();
+            return;
+        }
+        /* A new sector's header already holds the index. */
+        if (g_resync) {
+            rec[0] = FLOG_OP_INDEX;
+            (void)binproto_put_u32(&rec[1], g_sample);
+            flog_put(rec, 5U);
+            g_resync = false;
+        }
+    }
+
+    len = flog_encode(rec, rpm, duty);
+    if (!flog_reserve(len)) {
+        flog_drop();
+        return;
+    }
+    /* Absolute if that opened a sector. */
+    len = flog_encode(rec, rpm, duty);
+    flog_put(rec, len);
+
+    g_rpm = rpm;
+    g_duty = duty;
+    g_have_base = true;
+    g_sample++;
+    g_samples++;
+}
+
+/* ---- Dump ---------------------------------------------------------------- */
+
+static void dump_finish(console_t *c, const char *msg)
+{
+    g_dump_con = 0;
+    c->busy = false;
+    console_puts(c, msg);
+    console_prompt_force_next(c);
+    console_prompt_once(c);
+}
+
+static void dump_step(void)
+{
+    console_t *c = g_dump_con;
+    uint8_t p[FLOG_DUMP_MAX];
+
+    /* Aborted by a key or the end of the session. */
+    if (!c->busy) {
+        dump_finish(c, "\r\nLOG DUMP aborted\r\n");
+        return;
+    }
+    if (c->dev == UARTDEV_USER && modbus_is_enabled()) {
+        g_dump_con = 0;
+        c->busy = false;
+        return;
+    }
+
+    /* Only as much as fits in the TX ring without waiting. */
+    while (g_dump_left != 0U && uart_tx_free(c->dev) >= FLOG_DUMP_MAX + 8U) {
+        const flog_header_t *h = sector_header(g_dump_seq);
+        uint32_t end = (g_dump_left == 1U) ? g_dump_last_block : FLOG_BLOCKS;
+        uint32_t n = 0;
+        uint8_t *w = p;
+
+        /* Skip sectors erased (or reused) since the dump started. */
+        if (h->magic != FLOG_MAGIC || h->seq != g_dump_seq || g_dump_block >= end) {
+            g_dump_seq++;
+            g_dump_block = 1;
+            g_dump_left--;
+            continue;
+        }
+
+        w = binproto_put_u32(w, h->seq);
+        w = binproto_put_u16(w, h->period_ms);
+        w = binproto_put_u32(w, h->first_sample);
+        w = binproto_put_u16(w, (uint16_t)g_dump_block);
+        w++;
+        while (n < FLOG_DUMP_BLOCKS && g_dump_block < end) {
+            uint32_t addr = sector_addr(g_dump_seq) + g_dump_block * FLOG_BLOCK_SIZE;
+
+            /* The first erased block ends a sector's data. */
+            if (words_erased(addr, FLOG_BLOCK_SIZE)) {
+                g_dump_block = end;
+                break;
+            }
+            memcpy(w, (const void *)addr, FLOG_BLOCK_SIZE);
+            w += FLOG_BLOCK_SIZE;
+            g_dump_block++;
+            n++;
+        }
+        if (n != 0U) {
+            p[FLOG_DUMP_HDR - 1U] = (uint8_t)n;
+            binproto_frame(&g_dump, BP_TYPE_FLOG, p, (uint16_t)(w - p), n);
+            g_dump_blocks += n;
+        }
+    }
+
+    if (g_dump_left == 0U) {
+        binproto_end(&g_dump, BP_TYPE_FLOG);
+        dump_finish(c, "\r\n");
+    }
+}
+
+bool flashlog_dump_start(console_t *c)
+{
+    if (g_dump_con || !binproto_begin(&g_dump, &c->out)) {
+        return false;
+    }
+
+    /* Everything so far, including the block still in RAM. */
+    flog_flush();
+
+    if (g_seq == FLOG_NO_SEQ) {
+        g_dump_left = 0;
+    } else {
+        /* All sectors but the one erased ahead of the writer. */
+        g_dump_seq = (g_seq >= FLOG_SECTORS - 1U) ? g_seq - (FLOG_SECTORS - 2U) : 0U;
+        g_dump_left = g_seq - g_dump_seq + 1U;
+    }
+    g_dump_block = 1;
+    g_dump_last_block = g_block;
+    g_dump_blocks = 0;
+
+    console_puts(c, "\r\n");
+    c->busy = true;
+    g_dump_con = c;
+    return true;
+}
+
+/* ---- Public -------------------------------------------------------------- */
+
+static void flog_save_config(void)
+{
+    flog_config_t cfg;
+
+    cfg.enabled = g_enabled ? 1U : 0U;
+    cfg.reserved = 0;
+    cfg.period_ms = (uint16_t)g_period_ms;
+    (void)config_store_write(CONFIG_REC_FLASHLOG, &cfg, sizeof(cfg));
+}
+
+static void flog_start(void)
+{
+    g_enabled = true;
+    g_run_pending = true;
+    g_sample = 0;
+    g_resync = false;
+    g_last_ms = timebase_millis() - g_period_ms;
+}
+
+void flashlog_init(void)
+{
+    flog_config_t cfg;
+    bool found = false;
+
+    /* Newest valid sector header: writing resumes in it. */
+    for (uint32_t i = 0; i < FLOG_SECTORS; i++) {
+        const flog_header_t *h =
+            (const flog_header_t *)(FLASH_LOG_BASE + i * FLASH_SECTOR_SIZE);
+
+        if (h->magic != FLOG_MAGIC || (h->seq % FLOG_SECTORS) != i) {
+            continue;
+        }
+        if (!found || (int32_t)(h->seq - g_seq) > 0) {
+            g_seq = h->seq;
+            found = true;
+        }
+    }
+
+    /* Behind the last programmed block; one cut short by a reset stays
+       behind, its CRC tells the reader. */
+    if (found) {
+        uint32_t addr = sector_addr(g_seq);
+
+        g_block = FLOG_BLOCKS;
+        while (g_block > 1U &&
+               words_erased(addr + (g_block - 1U) * FLOG_BLOCK_SIZE, FLOG_BLOCK_SIZE)) {
+            g_block--;
+        }
+    }
+    g_next_ready = false;
+
+    if (config_store_read(CONFIG_REC_FLASHLOG, &cfg, sizeof(cfg))) {
+        if (cfg.period_ms >= FLASHLOG_MIN_MS && cfg.period_ms <= FLASHLOG_MAX_MS) {
+            g_period_ms = cfg.period_ms;
+        }
+        if (cfg.enabled != 0U) {
+            flog_start();
+        }
+    }
+}
+
+/* Take a sample when due. Holds the flash lock. */
+static void flog_poll(void)
+{
+    tach_snapshot_t tach;
+    uint32_t now;
+    uint32_t duty;
+
+    if (g_close_pending) {
+        g_close_pending = false;
+        block_close();
+    }
+
+    if (!g_enabled || g_clear_next < FLOG_SECTORS) {
+        return;
+    }
+
+    now = timebase_millis();
+    if ((uint32_t)(now - g_last_ms) < g_period_ms) {
+        return;
+    }
+    /* Fixed rate; after a stall, no burst of catch-up samples. */
+    g_last_ms += g_period_ms;
+    if ((uint32_t)(now - g_last_ms) >= g_period_ms) {
+        g_last_ms = now;
+    }
+
+    tach_get_snapshot(&tach);
+    duty = pwm_is_enabled() ? pwm_get_percent_requested() : 0U;
+    flog_sample((tach.rpm > 0xFFFFU) ? 0xFFFFU : (uint16_t)tach.rpm, (uint8_t)duty);
+}
+
+void flashlog_task(void)
+{
+    if (g_dump_con) {
+        dump_step();
+    }
+
+    /* Another writer holds the flash: sample on the next pass. */
+    if (!flash_lock(FLASH_OWNER_LOG)) {
+        return;
+    }
+    flog_poll();
+    flash_unlock(FLASH_OWNER_LOG);
+}
+
+/* True (and noted for LOG) if the sector at addr needs an erase that
+   control does not permit now. */
+static bool erase_held(uint32_t addr)
+{
+    g_erase_held = !flash_erase_permitted() && !words_erased(addr, FLASH_SECTOR_SIZE);
+    return g_erase_held;
+}
+
+/* One erase for the idle hook. Holds the flash lock. */
+static bool flog_erase_step(void)
+{
+    if (g_clear_next < FLOG_SECTORS) {
+        if (erase_held(FLASH_LOG_BASE + g_clear_next * FLASH_SECTOR_SIZE)) {
+            return false;
+        }
+        (void)erase_sector(FLASH_LOG_BASE + g_clear_next * FLASH_SECTOR_SIZE);
+        if (++g_clear_next == FLOG_SECTORS) {
+            g_seq = FLOG_NO_SEQ;
+            g_block = FLOG_BLOCKS;
+            g_next_ready = true;
+            if (g_enabled) {
+                flog_start();
+            }
+        }
+        return true;
+    }
+
+    /* Nothing to get ready for while LOG is off. */
+    if (g_next_ready || !g_enabled) {
+        g_erase_held = false;
+        return false;
+    }
+    if (erase_held(sector_addr(g_seq + 1U))) {
+        return false;
+    }
+    /* Retried on the next idle pass if the erase failed. */
+    g_next_ready = erase_sector(sector_addr(g_seq + 1U));
+    return true;
+}
+
+bool flashlog_idle(void)
+{
+    bool worked;
+
+    if (!flash_lock(FLASH_OWNER_LOG)) {
+        return false;
+    }
+    worked = flog_erase_step();
+    flash_unlock(FLASH_OWNER_LOG);
+    return worked;
+}
+
+void flashlog_set_enabled(bool enabled, uint32_t period_ms)
+{
+    if (enabled) {
+        if (period_ms >= FLASHLOG_MIN_MS && period_ms <= FLASHLOG_MAX_MS) {
+            g_period_ms = period_ms;
+        }
+        flog_start();
+    } else if (g_enabled) {
+        g_enabled = false;
+        flog_flush();
+    }
+    flog_save_config();
+}
+
+void flashlog_clear(void)
+{
+    /* Unwritten samples go with the rest. */
+    g_fill = 0;
+    g_close_pending = false;
+    g_clear_next = 0;
+}
+
+void flashlog_get_stats(flashlog_stats_t *st)
+{
+    st->enabled = g_enabled;
+    st->dumping = (g_dump_con != 0);
+    st->clearing = (g_clear_next < FLOG_SECTORS);
+    st->period_ms = g_period_ms;
+    st->sectors = FLOG_SECTORS;
+    st->seq = g_seq;
+    st->block = g_block;
+    st->samples = g_samples;
+    st->bytes = g_bytes;
+    st->dropped = g_dropped;
+    st->erases = g_erases;
+    st->erase_held = g_erase_held;
+    st->dumped_blocks = g_dump_blocks;
+}
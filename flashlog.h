@@ -0,0 +1,83 @@
+#ifndef FLASHLOG_H
+#define FLASHLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "console.h"
+
+/*
+ * Long-term RPM and duty log in on-chip flash (LOG command), in the
+ * FLASH_LOG region of flash_layout.h (384 KB, 24 sectors).
+ *
+ * Samples are delta-encoded, usually one byte each, into 32-byte blocks
+ * (30 data bytes and a CRC-16) that are programmed as they fill. Each
+ * sector starts with a header (sequence number, sample period, index of its
+ * first sample), so the sectors form a ring and any sector decodes on its
+ * own. While logging is on (or a LOG CLEAR runs), the sector after the
+ * current one is erased ahead of time from the scheduler's idle hook, so a
+ * write only programs a block. If the next sector is not ready when one
+ * fills, samples are dropped and counted rather than the writer waiting.
+ *
+ * The erase itself is not background work: the core and every interrupt
+ * stop for the whole erase (tens of ms). It is therefore only started when
+ * flash_erase_permitted() (flash_lock.h) says no control function is
+ * running. While one is, the erase waits and, once the current sector is
+ * full, samples are dropped and counted.
+ *
+ * After a reset the write position is found again from the headers and the
+ * first erased block. A block cut short by a power loss fails its CRC and
+ * is skipped by the reader. Samples still in the RAM block (up to 30 at
+ * one byte each) are lost.
+ *
+ * LOG DUMP sends the raw blocks as binproto.h frames from flashlog_task(),
+ * paced by the TX ring, so the rest of the firmware keeps running during a
+ * dump; tools/binproto.py decodes them.
+ */
+#ifndef FLASHLOG_DEFAULT_MS
+#define FLASHLOG_DEFAULT_MS     1000U
+#endif
+#define FLASHLOG_MIN_MS         100U
+#define FLASHLOG_MAX_MS         60000U
+
+typedef struct {
+    bool enabled;
+    bool dumping;
+    bool clearing;
+    uint32_t period_ms;
+    uint32_t sectors;           /* in the ring */
+    uint32_t seq;               /* current sector; 0xFFFFFFFF before the first */
+    uint32_t block;             /* next block in it */
+    uint32_t samples;           /* written since boot */
+    uint32_t bytes;             /* data bytes for them */
+    uint32_t dropped;           /* no erased sector to write to */
+    uint32_t erases;
+    bool erase_held;            /* next erase waits for control to stop */
+    uint32_t dumped_blocks;     /* by the last LOG DUMP */
+} flashlog_stats_t;
+
+/* Find the write position after a reset and restore LOG ON/OFF from the
+   config store. After config_store_init(). */
+void flashlog_init(void);
+
+/* Scheduler task (10 ms): take samples when due, send dump frames. */
+void flashlog_task(void);
+
+/* Scheduler idle hook: erase the next sector while logging is on, or the
+   ring on LOG CLEAR. Stalls the core for the erase (see above). */
+bool flashlog_idle(void);
+
+/* Start or stop logging and save the setting. Starting opens a new run. */
+void flashlog_set_enabled(bool enabled, uint32_t period_ms);
+
+/* Erase the whole ring, one sector per idle pass (each stalls the core,
+   so only while control permits it); logging resumes afterwards. */
+void flashlog_clear(void);
+
+/* Start a binary dump on console c (marks it busy; any key aborts).
+   False if a dump is already running. */
+bool flashlog_dump_start(console_t *c);
+
+void flashlog_get_stats(flashlog_stats_t *st);
+
+#endif /* FLASHLOG_H */
@@ -0,0 +1,367 @@
+#include "fwupdate.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/flash.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+
+#include "crc.h"
+#include "flash_lock.h"
+#include "sched.h"
+#include "timebase.h"
+
+#define FWUP_CONSOLE_BAUD   115200U
+#define FWUP_ERR_BUSY       "flash busy (retry from a UART console)"
+#define FWUP_HDR_SIZE       7U      /* type, offset, len */
+#define FWUP_UART_CONFIG    (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE)
+
+/* Block payload; word aligned for FlashProgram(). */
+static uint32_t g_blk[FWUP_BLOCK_SIZE / 4U];
+
+/* ---- metadata ------------------------------------------------------------ */
+
+static bool meta_valid(const fwup_meta_t *m)
+{
+    return m->magic == FWUP_META_MAGIC &&
+           m->check == crc_calc(CRC_ALG_CRC32, m, 3U * sizeof(uint32_t));
+}
+
+/* Bytes stored contiguously from offset 0. */
+static uint32_t meta_staged(const fwup_meta_t *m)
+{
+    uint32_t blocks = (m->size + FWUP_BLOCK_SIZE - 1U) / FWUP_BLOCK_SIZE;
+    uint32_t i = 0;
+
+    while (i < blocks && m->progress[i] == 0U) {
+        i++;
+    }
+    return (i == blocks) ? m->size : i * FWUP_BLOCK_SIZE;
+}
+
+/* Program and read back. */
+static bool flash_write(const uint32_t *src, uint32_t addr, uint32_t len)
+{
+    return MAP_FlashProgram((uint32_t *)src, addr, len) == 0 &&
+           memcmp((const void *)addr, src, len) == 0;
+}
+
+static bool flash_write_word(const volatile uint32_t *dst, uint32_t value)
+{
+    return flash_write(&value, (uint32_t)dst, sizeof(value));
+}
+
+static bool staged_image_ok(const fwup_meta_t *m)
+{
+    return meta_valid(m) && meta_staged(m) == m->size &&
+           crc_calc(CRC_ALG_CRC32, (const void *)FLASH_FWSTAGE_BASE, m->size) == m->crc &&
+           fwup_vectors_ok((const uint32_t *)FLASH_FWSTAGE_BASE);
+}
+
+void fwupdate_get_status(fwup_status_t *st)
+{
+    const fwup_meta_t *m = FWUP_META;
+
+    memset(st, 0, sizeof(*st));
+    if (!meta_valid(m)) {
+        st->state = FWUP_STATE_EMPTY;
+        return;
+    }
+
+    st->size = m->size;
+    st->crc = m->crc;
+    st->staged = meta_staged(m);
+
+    if (m->installed == FWUP_INSTALLED) {
+        st->state = FWUP_STATE_INSTALLED;
+    } else if (m->installed == FWUP_REJECTED) {
+        st->state = FWUP_STATE_REJECTED;
+    } else if (m->ready == FWUP_READY) {
+        st->state = FWUP_STATE_READY;
+    } else if (st->staged == m->size) {
+        st->state = FWUP_STATE_STAGED;
+    } else {
+        st->state = FWUP_STATE_PARTIAL;
+    }
+}
+
+bool fwupdate_begin(uint32_t size, uint32_t crc, uint32_t *next_offset, const char **err)
+{
+    const fwup_meta_t *m = FWUP_META;
+    uint32_t hdr[4];
+
+    if (size == 0U || size > FWUP_MAX_IMAGE) {
+        *err = "image size out of range";
+        return false;
+    }
+
+    /* Same image, not yet applied: continue after the last stored block. */
+    if (meta_valid(m) && m->size == size && m->crc == crc && m->ready == FWUP_ERASED) {
+        *next_offset = meta_staged(m);
+        return true;
+    }
+
+    hdr[0] = FWUP_META_MAGIC;
+    hdr[1] = size;
+    hdr[2] = crc;
+    hdr[3] = crc_calc(CRC_ALG_CRC32, hdr, 3U * sizeof(uint32_t));
+
+    if (!flash_lock(FLASH_OWNER_FWUPDATE)) {
+        *err = FWUP_ERR_BUSY;
+        return false;
+    }
+    /* Staging sectors are erased as the first block of each one arrives. */
+    if (MAP_FlashErase(FLASH_FWMETA_BASE) != 0 ||
+        !flash_write(hdr, FLASH_FWMETA_BASE, sizeof(hdr))) {
+        flash_unlock(FLASH_OWNER_FWUPDATE);
+        *err = "flash erase/program failed";
+        return false;
+    }
+    flash_unlock(FLASH_OWNER_FWUPDATE);
+
+    *next_offset = 0;
+    return true;
+}
+
+bool fwupdate_apply(const char **err)
+{
+#ifdef BOOTLOADER_ENABLED
+    const fwup_meta_t *m = FWUP_META;
+
+    if (!staged_image_ok(m) || m->installed != FWUP_ERASED) {
+        *err = "no complete, valid staged image";
+        return false;
+    }
+    if (m->ready != FWUP_READY) {
+        bool ok;
+
+        if (!flash_lock(FLASH_OWNER_FWUPDATE)) {
+            *err = FWUP_ERR_BUSY;
+            return false;
+        }
+        ok = flash_write_word(&m->ready, FWUP_READY);
+        flash_unlock(FLASH_OWNER_FWUPDATE);
+        if (!ok) {
+            *err = "flash program failed";
+            return false;
+        }
+    }
+    return true;
+#else
+    *err = "no bootloader in this build (make BOOTLOADER=1)";
+    return false;
+#endif
+}
+
+void fwupdate_reset(void)
+{
+    while (ROM_UARTBusy(UART3_BASE)) {
+    }
+    /* ~50 ms for TCP console replies (SysTick may be masked here). */
+    SysCtlDelay(timebase_sysclk_hz() / 60U);
+    MAP_SysCtlReset();
+}
+
+bool fwupdate_abort(const char **err)
+{
+    bool ok;
+
+    if (!flash_lock(FLASH_OWNER_FWUPDATE)) {
+        *err = FWUP_ERR_BUSY;
+        return false;
+    }
+    ok = MAP_FlashErase(FLASH_FWMETA_BASE) == 0;
+    flash_unlock(FLASH_OWNER_FWUPDATE);
+    if (!ok) {
+        *err = "flash erase failed";
+    }
+    return ok;
+}
+
+/* ---- binary protocol ----------------------------------------------------- */
+
+/* Next byte from UART3, or -1 after timeout_ms of silence. */
+static int32_t uart_getc(uint32_t timeout_ms)
+{
+    uint32_t t0 = 0;
+    bool waiting = false;
+
+    for (;;) {
+        int32_t c = ROM_UARTCharGetNonBlocking(UART3_BASE);
+        if (c >= 0) {
+            return c & 0xFF;
+        }
+        /* The transfer holds the scheduler for its whole duration. */
+        sched_watchdog_feed();
+        if (!waiting) {
+            t0 = timebase_millis();
+            waiting = true;
+        } else if ((uint32_t)(timebase_millis() - t0) >= timeout_ms) {
+            return -1;
+        }
+    }
+}
+
+static bool uart_read(uint8_t *dst, uint32_t len)
+{
+    while (len--) {
+        int32_t c = uart_getc(FWUP_GAP_MS);
+        if (c < 0) {
+            return false;
+        }
+        *dst++ = (uint8_t)c;
+    }
+    return true;
+}
+
+/* Discard input until the host has stopped sending. */
+static void uart_drain(void)
+{
+    while (uart_getc(20U) >= 0) {
+    }
+    ROM_UARTRxErrorClear(UART3_BASE);
+}
+
+static void reply(uint8_t status, uint32_t next)
+{
+    uint8_t r[5] = { status, (uint8_t)next, (uint8_t)(next >> 8),
+                     (uint8_t)(next >> 16), (uint8_t)(next >> 24) };
+    uint32_t i;
+
+    for (i = 0; i < sizeof(r); i++) {
+        ROM_UARTCharPut(UART3_BASE, r[i]);
+    }
+}
+
+static void uart_set_baud(uint32_t baud)
+{
+    while (ROM_UARTBusy(UART3_BASE)) {
+    }
+    ROM_UARTConfigSetExpClk(UART3_BASE, timebase_sysclk_hz(), baud, FWUP_UART_CONFIG);
+    ROM_UARTFIFOEnable(UART3_BASE);
+}
+
+/*
+ * Store one block at off (len bytes in g_blk). A block that is already there
+ * (resend after a lost reply, or a reset between programming and recording
+ * it) is only recorded; one that partly disagrees with flash is refused.
+ */
+static uint8_t store_block(const fwup_meta_t *m, uint32_t off, uint32_t len)
+{
+    const uint32_t *dst = (const uint32_t *)(FLASH_FWSTAGE_BASE + off);
+    uint32_t words = (len + 3U) / 4U;
+    uint32_t i;
+
+    memset((uint8_t *)g_blk + len, 0xFF, words * 4U - len);
+
+    if ((off % FLASH_SECTOR_SIZE) == 0U && MAP_FlashErase(FLASH_FWSTAGE_BASE + off) != 0) {
+        return FWUP_ST_FLASH;
+    }
+
+    for (i = 0; i < words; i++) {
+        if ((dst[i] & g_blk[i]) != g_blk[i]) {
+            return FWUP_ST_FLASH;
+        }
+    }
+    if (memcmp(dst, g_blk, words * 4U) != 0 &&
+        !flash_write(g_blk, FLASH_FWSTAGE_BASE + off, words * 4U)) {
+        return FWUP_ST_FLASH;
+    }
+
+    return flash_write_word(&m->progress[off / FWUP_BLOCK_SIZE], 0U) ? FWUP_ST_OK : FWUP_ST_FLASH;
+}
+
+void fwupdate_receive(uint32_t baud, fwup_result_t *res)
+{
+    const fwup_meta_t *m = FWUP_META;
+    uint32_t t0 = timebase_millis();
+    uint32_t next = meta_staged(m);
+    bool done = false;
+
+    memset(res, 0, sizeof(*res));
+
+    /* Held for the whole transfer; the scheduler is stalled anyway. */
+    if (!flash_lock(FLASH_OWNER_FWUPDATE)) {
+        res->last_status = FWUP_ST_FLASH;
+        return;
+    }
+
+    MAP_IntDisable(INT_UART3);
+    uart_set_baud(baud);
+    uart_drain();
+
+    while (!done) {
+        uint8_t hdr[FWUP_HDR_SIZE];
+        uint8_t tail[4];
+        uint32_t off, len, crc, status;
+        int32_t c = uart_getc(FWUP_IDLE_MS);
+
+        if (c < 0) {
+            res->last_status = 0;
+            break;
+        }
+
+        hdr[0] = (uint8_t)c;
+        off = 0;
+        len = 0;
+        if (uart_read(&hdr[1], FWUP_HDR_SIZE - 1U)) {
+            off = hdr[1] | ((uint32_t)hdr[2] << 8) | ((uint32_t)hdr[3] << 16) | ((uint32_t)hdr[4] << 24);
+            len = hdr[5] | ((uint32_t)hdr[6] << 8);
+        } else {
+            len = FWUP_BLOCK_SIZE + 1U;
+        }
+
+        if (len > FWUP_BLOCK_SIZE || !uart_read((uint8_t *)g_blk, len) || !uart_read(tail, 4U)) {
+            crc = 0;
+            status = FWUP_ST_CRC;
+        } else {
+            crc = tail[0] | ((uint32_t)tail[1] << 8) | ((uint32_t)tail[2] << 16) | ((uint32_t)tail[3] << 24);
+            status = (crc_continue(CRC_ALG_CRC32, crc_calc(CRC_ALG_CRC32, hdr, sizeof(hdr)),
+                                   g_blk, len) == crc) ? FWUP_ST_OK : FWUP_ST_CRC;
+        }
+
+        if (status == FWUP_ST_CRC) {
+            res->retries++;
+            uart_drain();
+        } else if (hdr[0] == 'B') {
+            if (off != next) {
+                status = FWUP_ST_SEQ;
+            } else if (len == 0U || off + len > m->size ||
+                       (len < FWUP_BLOCK_SIZE && off + len != m->size)) {
+                status = FWUP_ST_BAD;
+            } else {
+                status = store_block(m, off, len);
+                if (status == FWUP_ST_OK) {
+                    next += len;
+                    res->blocks++;
+                }
+            }
+        } else if (hdr[0] == 'E') {
+            status = staged_image_ok(m) ? FWUP_ST_DONE : FWUP_ST_BAD;
+            done = true;
+        } else if (hdr[0] == 'A') {
+            done = true;
+        } else {
+            status = FWUP_ST_CRC;
+        }
+
+        reply((uint8_t)status, next);
+        res->last_status = (uint8_t)status;
+    }
+
+    /* Back to the console; give the host time to switch its baud rate too. */
+    uart_set_baud(FWUP_CONSOLE_BAUD);
+    uart_drain();
+    ROM_UARTIntClear(UART3_BASE, ROM_UARTIntStatus(UART3_BASE, false));
+    MAP_IntEnable(INT_UART3);
+    flash_unlock(FLASH_OWNER_FWUPDATE);
+
+    res->ms = timebase_millis() - t0;
+}
@@ -0,0 +1,146 @@
+#ifndef FWUPDATE_H
+#define FWUPDATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash_layout.h"
+
+/*
+ * Serial firmware update over UART3.
+ *
+ * `FWUPDATE BEGIN size crc [baud]` switches UART3 to a binary block protocol
+ * (tools/fwupdate.py), optionally at a higher baud rate, and stores the
+ * image in the staging region. Every block carries its own CRC-32 and is
+ * programmed, read back and recorded in the metadata sector before it is
+ * acknowledged, so an interrupted transfer resumes where it stopped when
+ * BEGIN is repeated with the same size and CRC. `FWUPDATE APPLY` checks the
+ * whole staged image (CRC-32 and vector table), marks it ready and resets;
+ * the bootloader (bootloader/, BOOTLOADER=1 builds) copies it over the
+ * application, checks the copy and records the result. A copy interrupted by
+ * a reset is simply redone, the staged image stays intact until the next
+ * BEGIN.
+ *
+ * Binary protocol (little endian), one frame at a time:
+ *   host:   type(1) offset(4) len(2) data(len) crc32(4)   crc over all before it
+ *           type 'B' = block, 'E' = end of transfer, 'A' = abort (len 0)
+ *   device: status(1) next_offset(4)
+ * Blocks are FWUP_BLOCK_SIZE bytes at offset == next_offset; only the last one
+ * may be shorter. The device leaves binary mode (and restores 115200) after
+ * 'E', 'A' or FWUP_IDLE_MS of silence.
+ */
+
+#define FWUP_BLOCK_SIZE     1024U
+#define FWUP_MAX_BLOCKS     (FLASH_FWSTAGE_SIZE / FWUP_BLOCK_SIZE)
+
+/* Largest image BEGIN accepts: it must fit the staging region (and
+   progress[]) as well as the application region. */
+#define FWUP_MAX_IMAGE      ((FLASH_APP_SIZE < FLASH_FWSTAGE_SIZE) ? FLASH_APP_SIZE : FLASH_FWSTAGE_SIZE)
+
+/* APPLY installs any staged image, so the staging region must be able to
+   hold a full application. */
+#if defined(BOOTLOADER_ENABLED) && (FLASH_APP_SIZE > FLASH_FWSTAGE_SIZE)
+#error "FLASH_APP_SIZE must not exceed FLASH_FWSTAGE_SIZE in BOOTLOADER builds"
+#endif
+
+#ifndef FWUP_IDLE_MS
+#define FWUP_IDLE_MS        5000U
+#endif
+/* A gap this long inside a frame drops it (the host resends). */
+#ifndef FWUP_GAP_MS
+#define FWUP_GAP_MS         200U
+#endif
+#ifndef FWUP_BAUD_DEFAULT
+#define FWUP_BAUD_DEFAULT   921600U
+#endif
+#define FWUP_BAUD_MAX       3000000U
+
+/* Reply status bytes. */
+#define FWUP_ST_OK          'K'     /* block stored */
+#define FWUP_ST_CRC         'C'     /* frame CRC/format error or gap: resend */
+#define FWUP_ST_SEQ         'S'     /* wrong offset: continue at next_offset */
+#define FWUP_ST_FLASH       'F'     /* program/verify failed: start over */
+#define FWUP_ST_DONE        'V'     /* after 'E': whole image verified */
+#define FWUP_ST_BAD         'X'     /* after 'E': image incomplete or CRC/vector check failed */
+
+/*
+ * Metadata sector (FLASH_FWMETA_BASE). Words are only ever programmed once
+ * between erases; the sector is erased by a fresh BEGIN and by ABORT.
+ */
+#define FWUP_META_MAGIC     0x46575531U     /* "FWU1" */
+#define FWUP_READY          0x52454459U     /* "REDY": staged image verified, install on boot */
+#define FWUP_INSTALLED      0x494E5354U     /* "INST": bootloader copied and verified it */
+#define FWUP_REJECTED       0x52454A54U     /* "REJT": bootloader found it damaged */
+#define FWUP_ERASED         0xFFFFFFFFU
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;          /* image bytes */
+    uint32_t crc;           /* CRC-32 of the image */
+    uint32_t check;         /* CRC-32 of the three words above */
+    uint32_t ready;         /* FWUP_READY or erased */
+    uint32_t installed;     /* FWUP_INSTALLED / FWUP_REJECTED or erased */
+    uint32_t reserved[10];
+    uint32_t progress[FWUP_MAX_BLOCKS];     /* 0 once block i is stored and verified */
+} fwup_meta_t;
+
+#define FWUP_META ((const fwup_meta_t *)FLASH_FWMETA_BASE)
+
+/* Plausible application vector table: SP in SRAM, reset handler in the app region. */
+static inline bool fwup_vectors_ok(const uint32_t *vec)
+{
+    return vec[0] > 0x20000000U && vec[0] <= 0x20040000U && (vec[0] & 3U) == 0U &&
+           (vec[1] & 1U) != 0U &&
+           vec[1] > FLASH_APP_BASE && vec[1] < FLASH_APP_BASE + FLASH_APP_SIZE;
+}
+
+typedef enum {
+    FWUP_STATE_EMPTY = 0,   /* no transfer */
+    FWUP_STATE_PARTIAL,     /* transfer started, blocks missing */
+    FWUP_STATE_STAGED,      /* all blocks stored */
+    FWUP_STATE_READY,       /* APPLY done, waiting for the bootloader */
+    FWUP_STATE_INSTALLED,
+    FWUP_STATE_REJECTED,
+} fwup_state_t;
+
+typedef struct {
+    fwup_state_t state;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t staged;        /* bytes stored (contiguous from 0) */
+} fwup_status_t;
+
+typedef struct {
+    uint32_t blocks;        /* stored this session */
+    uint32_t retries;       /* 'C' replies */
+    uint32_t ms;            /* BEGIN to leaving binary mode */
+    uint8_t last_status;    /* last reply, or 0 if the host went silent */
+} fwup_result_t;
+
+void fwupdate_get_status(fwup_status_t *st);
+
+/*
+ * Validate the request, prepare the staging area (or resume) and return the
+ * offset to continue from. Returns false with *err set for a bad size or
+ * a flash failure.
+ */
+bool fwupdate_begin(uint32_t size, uint32_t crc, uint32_t *next_offset, const char **err);
+
+/*
+ * Run the binary protocol on UART3 until 'E', 'A' or silence. Polls the UART
+ * with its interrupt masked; call from the main loop only, after the reply
+ * to BEGIN has been sent.
+ */
+void fwupdate_receive(uint32_t baud, fwup_result_t *res);
+
+/* Verify the staged image and mark it for the bootloader. Does not reset. */
+bool fwupdate_apply(const char **err);
+
+/* Reset into the bootloader once pending console output has gone out. */
+void fwupdate_reset(void);
+
+/* Forget any staged image. False with *err set if the flash is busy or
+   the erase failed. */
+bool fwupdate_abort(const char **err);
+
+#endif /* FWUPDATE_H */
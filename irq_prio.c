@@ -0,0 +1,77 @@
+#include "irq_prio.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+
+#include "atomic.h"
+#include "tach.h"       /* TACH_GPIO_INT */
+
+#ifndef IRQ_PRIO_BITS
+#define IRQ_PRIO_BITS 3U
+#endif
+
+static irq_defer_fn_t g_defer_fn[IRQ_DEFER_COUNT];
+static volatile uint32_t g_defer_pending = 0;
+
+void irq_prio_init(void)
+{
+    /* All implemented bits preempt; no sub-priorities. */
+    IntPriorityGroupingSet(IRQ_PRIO_BITS);
+
+    IntPrioritySet(TACH_GPIO_INT, IRQ_PRIO_TACH);
+    IntPrioritySet(INT_TIMER4A, IRQ_PRIO_TSYN);
+    IntPrioritySet(INT_PWM0_1, IRQ_PRIO_PWM);
+    IntPrioritySet(FAULT_SYSTICK, IRQ_PRIO_TIMEBASE);
+    IntPrioritySet(INT_UART0, IRQ_PRIO_UART);
+    IntPrioritySet(INT_UART3, IRQ_PRIO_UART);
+    IntPrioritySet(INT_TIMER5A, IRQ_PRIO_UART);
+#ifdef NET_ENABLED
+    IntPrioritySet(INT_EMAC0, IRQ_PRIO_NET);
+#endif
+    IntPrioritySet(FAULT_PENDSV, IRQ_PRIO_DEFERRED);
+}
+
+uint32_t irq_lock(uint32_t level)
+{
+    uint32_t old = IntPriorityMaskGet();
+
+    /* BASEPRI 0 masks nothing; otherwise a lower value masks more. */
+    if (old == 0U || old > level) {
+        IntPriorityMaskSet(level);
+    }
+    return old;
+}
+
+void irq_unlock(uint32_t key)
+{
+    IntPriorityMaskSet(key);
+}
+
+void irq_defer_register(irq_defer_t job, irq_defer_fn_t fn)
+{
+    if (job < IRQ_DEFER_COUNT) {
+        g_defer_fn[job] = fn;
+    }
+}
+
+void irq_defer_post(irq_defer_t job)
+{
+    if (job >= IRQ_DEFER_COUNT) return;
+
+    atomic_or_u32(&g_defer_pending, 1UL << job);
+    IntPendSet(FAULT_PENDSV);
+}
+
+void PendSVIntHandler(void)
+{
+    uint32_t pending = atomic_xchg_u32(&g_defer_pending, 0U);
+
+    for (uint32_t job = 0; job < IRQ_DEFER_COUNT; job++) {
+        if ((pending & (1UL << job)) && g_defer_fn[job]) {
+            g_defer_fn[job]();
+        }
+    }
+}
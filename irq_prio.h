@@ -0,0 +1,68 @@
+#ifndef IRQ_PRIO_H
+#define IRQ_PRIO_H
+
+#include <stdint.h>
+
+/*
+ * Interrupt priority plan. The TM4C1294 implements 3 priority bits (the top
+ * bits of the byte); a lower value preempts a higher one.
+ *
+ *   0x00  tach edge capture (GPIOM), TSYN burst timer (Timer4A)
+ *   0x20  SSPWM period update (PWM0 generator 1, must finish within a
+ *         period). Below tach: it fires at the PF2 reload, where the tach
+ *         blanking needs its counter read first.
+ *   0x40  SysTick (timebase)
+ *   0x80  UART0, UART3 and the Modbus t3.5 timer (Timer5A)
+ *   0xC0  Ethernet (lwIP)
+ *   0xE0  PendSV: deferred work (irq_defer_post())
+ *
+ * UART3 and Timer5A must share a level: the Modbus receive and transmit
+ * paths rely on not preempting each other. Readers of a seqlock in an ISR
+ * must not outrank its writer (seqlock.h): the tach and TSYN snapshots are
+ * written at the top level and read at the UART/Ethernet levels.
+ */
+#define IRQ_PRIO_TACH       0x00U
+#define IRQ_PRIO_TSYN       0x00U
+#define IRQ_PRIO_PWM        0x20U
+#define IRQ_PRIO_TIMEBASE   0x40U
+#define IRQ_PRIO_UART       0x80U
+#define IRQ_PRIO_NET        0xC0U
+#define IRQ_PRIO_DEFERRED   0xE0U
+
+/* Apply the map. Call once before the interrupts are enabled. */
+void irq_prio_init(void);
+
+/*
+ * Critical section by priority: masks every interrupt at `level` and below
+ * (numerically >= level) through BASEPRI, while the more urgent ones keep
+ * running. Only ever raises the mask, so sections nest; pass the returned
+ * value to irq_unlock().
+ *
+ *   uint32_t key = irq_lock(IRQ_PRIO_UART);
+ *   ...                    (UART ISRs held off, tach/TSYN/SysTick not)
+ *   irq_unlock(key);
+ *
+ * Level 0x00 cannot be masked through BASEPRI; shared state with the top
+ * level uses atomic.h/seqlock.h instead.
+ */
+uint32_t irq_lock(uint32_t level);
+void irq_unlock(uint32_t key);
+
+/*
+ * Deferred work: an ISR posts a job, and PendSV runs it at the lowest
+ * priority once no other interrupt is active.
+ */
+typedef enum {
+    IRQ_DEFER_NET_TICK = 0,     /* lwIP/EthClient timers (net.c) */
+    IRQ_DEFER_SSPWM,            /* dither table rebuild (sspwm.c) */
+    IRQ_DEFER_COUNT
+} irq_defer_t;
+
+typedef void (*irq_defer_fn_t)(void);
+
+void irq_defer_register(irq_defer_t job, irq_defer_fn_t fn);
+void irq_defer_post(irq_defer_t job);
+
+void PendSVIntHandler(void);
+
+#endif /* IRQ_PRIO_H */
@@ -0,0 +1,103 @@
+#ifndef LWIPOPTS_H
+#define LWIPOPTS_H
+
+/*
+ * lwIP configuration for the NET=1 build (see net.c).
+ *
+ * Bare-metal (NO_SYS) raw API only. The stack runs from the Ethernet
+ * interrupt: SysTick posts EthClientTick() to PendSV (via net_systick_1ms()),
+ * which pends INT_EMAC0; TivaWare's lwiplib then services the lwIP timers and calls
+ * lwIPHostTimerHandler() every HOST_TMR_INTERVAL ms.
+ *
+ * Sized for the 32 KB SRAM region the linker script grants: a handful of TCP
+ * connections (HTTP server + cloud uplink) with small windows.
+ */
+
+/* ---- Platform ---------------------------------------------------------- */
+#define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            1
+#define LWIP_PROVIDE_ERRNO              1
+#define MEM_ALIGNMENT                   4
+
+/* Period of lwIPHostTimerHandler() (eth_client_lwip.c, net.c hook). */
+#define HOST_TMR_INTERVAL               100
+
+/* ---- TM4C129 EMAC port (third_party/lwip-1.4.1/ports/tiva-tm4c129) ----- */
+#define EMAC_PHY_CONFIG                 (EMAC_PHY_TYPE_INTERNAL |             \
+                                         EMAC_PHY_INT_MDIX_EN |               \
+                                         EMAC_PHY_AN_100B_T_FULL_DUPLEX)
+#define PHY_PHYS_ADDR                   0
+#define NUM_TX_DESCRIPTORS              8
+#define NUM_RX_DESCRIPTORS              4
+
+/* The EMAC inserts/validates IP, TCP and UDP checksums in hardware. */
+#define CHECKSUM_GEN_IP                 0
+#define CHECKSUM_GEN_UDP                0
+#define CHECKSUM_GEN_TCP                0
+#define CHECKSUM_CHECK_IP               0
+#define CHECKSUM_CHECK_UDP              0
+#define CHECKSUM_CHECK_TCP              0
+
+/* ---- Memory ------------------------------------------------------------ */
+#define MEM_SIZE                        (6 * 1024)
+#define PBUF_POOL_SIZE                  8
+#define PBUF_POOL_BUFSIZE               512
+
+/*
+ * The HTTP server queues constant response text by reference (one PBUF_ROM
+ * per piece), so a response can take a few dozen pbufs and queue entries.
+ */
+#define MEMP_NUM_PBUF                   64
+/* HTTP_SERVER_MAX_CONNS + NET_CONSOLE_MAX_SESSIONS + cloud uplink + 1 spare. */
+#define MEMP_NUM_TCP_PCB                9
+#define MEMP_NUM_TCP_PCB_LISTEN         2
+#define MEMP_NUM_TCP_SEG                64
+#define MEMP_NUM_SYS_TIMEOUT            4
+
+/* ---- Protocols --------------------------------------------------------- */
+#define LWIP_ARP                        1
+#define LWIP_ICMP                       1
+#define LWIP_UDP                        1
+#define LWIP_TCP                        1
+#define LWIP_DHCP                       1
+#define LWIP_DNS                        1
+#define DNS_TABLE_SIZE                  2
+/* lwIP keeps answers for their TTL; cap it so a long TTL cannot pin a stale
+   server address (lwIP's default cap is a week). */
+#define DNS_MAX_TTL                     3600
+#define LWIP_AUTOIP                     0
+#define LWIP_IGMP                       0
+#define LWIP_RAW                        0
+
+#define TCP_MSS                         1460
+#define TCP_WND                         (2 * TCP_MSS)
+#define TCP_SND_BUF                     (2 * TCP_MSS)
+#define TCP_SND_QUEUELEN                64
+#define TCP_LISTEN_BACKLOG              0
+
+/* ---- APIs not used on bare metal --------------------------------------- */
+#define LWIP_NETCONN                    0
+#define LWIP_SOCKET                     0
+#define LWIP_NETIF_API                  0
+
+/* ---- Statistics -------------------------------------------------------- */
+/* LWIP_DEBUG is tested with #ifdef, so it is deliberately left undefined. */
+/*
+ * Counters for net_stats.c (NETSTATS, /status): usage, high-watermark and
+ * allocation failures of the heap and every pool, plus link/TCP drops.
+ * Costs ~200 bytes of RAM and an increment per event.
+ */
+#define LWIP_STATS                      1
+#define LWIP_STATS_DISPLAY              0
+#define LINK_STATS                      1
+#define TCP_STATS                       1
+#define MEM_STATS                       1
+#define MEMP_STATS                      1
+#define ETHARP_STATS                    0
+#define IP_STATS                        0
+#define IPFRAG_STATS                    0
+#define ICMP_STATS                      0
+#define UDP_STATS                       0
+#define SYS_STATS                       0
+
+#endif /* LWIPOPTS_H */
@@ -42,7 +42,7 @@ extern void * _sbrk(ptrdiff_t incr);
 // diagnose memory allocations and all that
 #include "diag_uart.h"
 
-#include "ui_uart3.h"
+#include "console.h"
 #include "commands.h"
 
 #include "inc/hw_ints.h"
@@ -64,9 +64,28 @@ extern void * _sbrk(ptrdiff_t incr);
 
 #include "utils/ustdlib.h"
 
+#include "atomic.h"
 #include "timebase.h"
 #include "tach.h"
 #include "tsyn.h"
+#include "config_store.h"
+#include "crc.h"
+#include "modbus.h"
+#include "retain.h"
+#include "boot_prof.h"
+#include "irq_prio.h"
+#include "flashlog.h"
+#include "rrd.h"
+#include "sweep.h"
+#include "steptest.h"
+#include "speedctl.h"
+#include "sspwm.h"
+#include "watch.h"
+#include "sched.h"
+#include "pt.h"
+#ifdef NET_ENABLED
+#include "net.h"
+#endif
 
 
 uint32_t g_ui32SysClock;
@@ -87,13 +106,8 @@ uint32_t g_ui32SysClock;
 static uint32_t g_pwmPeriod = 0;
 static uint32_t g_pwmPulse  = 0;
 static bool g_pwm_enabled = true;
-static uint32_t g_pwm_percent_requested = TARGET_DUTY_PERCENT_INIT;
-
-/* UART RX buffer - simple accumulator */
-static volatile char user_rx_buf[UART_RX_BUF_SIZE];
-
-static volatile uint32_t user_rx_len = 0;
-static volatile bool user_cmd_ready = false;
+/* Written by commands (any console, Modbus, TCP), read by Timer4AIntHandler. */
+static volatile uint32_t g_pwm_percent_requested = TARGET_DUTY_PERCENT_INIT;
 
 /* Hidden keystroke feature: 5 consecutive 'P' typed on UART3 triggers UART0 GOTCHA. */
 static volatile uint8_t g_uart3_p_run = 0;
@@ -102,21 +116,25 @@ static const char g_uart0_gotcha_msg[] = "\r\nGOTCHA: PPPPP detected on UART3\r\
 
 /* Software-requested close of the UART3 session (EXIT command). */
 static volatile bool g_uart3_force_disconnect = false;
-/* When a software EXIT closes the session, require a DTR release (idle/high)
-    before allowing a new session to begin. This prevents immediate auto-reopen
-    when the host keeps DTR asserted. */
-static volatile bool g_uart3_require_dtr_release = false;
 static volatile bool g_uart3_sw_disconnect_requested = false;
 
-static void flash_pf4_gotcha(uint32_t flashes)
+/* PF4 flashes left to show for the hidden GOTCHA (gotcha_task). */
+#define GOTCHA_FLASHES      5U
+#define GOTCHA_TOGGLE_MS    75U
+static uint32_t g_gotcha_toggles = 0;
+
+static void gotcha_task(void)
 {
+    if (g_uart3_gotcha_pending) {
+        g_uart3_gotcha_pending = false;
+        UARTSend((const uint8_t *)g_uart0_gotcha_msg, (uint32_t)(sizeof(g_uart0_gotcha_msg) - 1U), UARTDEV_ICDI);
+        g_gotcha_toggles = 2U * GOTCHA_FLASHES;
+    }
+
     /* PF4 is already configured as GPIO output in setup_uarts(). */
-    const uint32_t delay_ticks = g_ui32SysClock / 40U; /* ~75ms at 120MHz (SysCtlDelay loop is ~3 cycles) */
-    for (uint32_t i = 0; i < flashes; i++) {
-        ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_PIN_4);
-        SysCtlDelay(delay_ticks);
-        ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, 0);
-        SysCtlDelay(delay_ticks);
+    if (g_gotcha_toggles > 0U) {
+        g_gotcha_toggles--;
+        ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, (g_gotcha_toggles & 1U) ? GPIO_PIN_4 : 0);
     }
 }
 
@@ -140,23 +158,22 @@ void uart3_request_disconnect(void)
 }
 
 /* Forward declarations */
+static void enable_boot_peripherals(void);
 static void setup_system_clock(void);
-static void setup_pwm_pf2(void);
+static void setup_pwm_pf2(uint32_t init_percent);
 static void set_pwm_percent(uint32_t percent);
 static void setup_uarts(void);
-static void process_user_line(const char *line);
-static void user_uart3_consume_pending_input(void);
 
 /* Expose PWM setter to higher-level command module without changing ISR logic. */
 void pwm_set_percent(uint32_t percent)
 {
-    g_pwm_percent_requested = percent;
+    atomic_store_u32(&g_pwm_percent_requested, percent);
     set_pwm_percent(percent);
 }
 
 uint32_t pwm_get_percent_requested(void)
 {
-    return g_pwm_percent_requested;
+    return atomic_load_u32(&g_pwm_percent_requested);
 }
 
 void pwm_set_enabled(bool enabled)
@@ -165,7 +182,9 @@ void pwm_set_enabled(bool enabled)
         /* Restore PF2 to PWM function and enable output. */
         GPIOPinConfigure(GPIO_PF2_M0PWM2);
         GPIOPinTypePWM(GPIO_PORTF_BASE, GPIO_PIN_2);
-        PWMPulseWidthSet(PWM0_BASE, PWM_OUT_2, g_pwmPulse);
+        if (!sspwm_is_enabled()) {
+            PWMPulseWidthSet(PWM0_BASE, PWM_OUT_2, g_pwmPulse);
+        }
         PWMOutputState(PWM0_BASE, PWM_OUT_2_BIT, true);
         g_pwm_enabled = true;
         return;
@@ -184,7 +203,7 @@ bool pwm_is_enabled(void)
 }
 
 
-/* ICDI UART0 ISR - echo only */
+/* ICDI UART0 ISR - command console (console.c) */
 void ICDIUARTIntHandler(void)
 {
     uint32_t ui32Status = ROM_UARTIntStatus(UART0_BASE, true);
@@ -192,205 +211,63 @@ void ICDIUARTIntHandler(void)
     ROM_UARTIntClear(UART0_BASE, ui32Status);
 
     while (ROM_UARTCharsAvail(UART0_BASE)) {
+        uint8_t c = (uint8_t)ROM_UARTCharGetNonBlocking(UART0_BASE);
 
-        ROM_UARTCharPutNonBlocking(UART0_BASE, ROM_UARTCharGetNonBlocking(UART0_BASE));
-        GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, GPIO_PIN_0);
-        SysCtlDelay(g_ui32SysClock / (1000 * 3));
-        GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, 0);
+        /* Toggle PN0 LED on each received byte */
+        static uint8_t led = 0;
+        led = !led;
+        ROM_GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, led ? GPIO_PIN_0 : 0);
 
+        console_rx(&g_console_uart0, c);
     }
 
+    /* Queued output (command replies, echo, diagnostics). */
+    uart_tx_isr(UARTDEV_ICDI);
 }
 
 
-/* USER UART3 ISR - echo + accumulate, exactly as in your pwm.c */
+/* USER UART3 ISR - command console (console.c) + hidden GOTCHA */
 void USERUARTIntHandler(void)
 {
+    /* UART3 handed over to the Modbus RTU slave (MODBUS ON). */
+    if (modbus_is_enabled()) {
+        modbus_uart_isr();
+        return;
+    }
+
     uint32_t ui32Status = ROM_UARTIntStatus(UART3_BASE, true);
 
     ROM_UARTIntClear(UART3_BASE, ui32Status);
 
     while (ROM_UARTCharsAvail(UART3_BASE)) {
+        uint8_t c = (uint8_t)ROM_UARTCharGetNonBlocking(UART3_BASE);
 
-        uint8_t c = ROM_UARTCharGetNonBlocking(UART3_BASE);
-
-        if (user_cmd_ready) {
-            /* Ignore extra RX bytes until main loop consumes the line. */
-            continue;
-        }
-
-        /* Handle backspace/delete locally (do not allow erasing prompt). */
-        if (c == '\b' || c == 0x7FU) {
-            g_uart3_p_run = 0;
-            if (user_rx_len > 0) {
-                user_rx_len--;
-                ROM_UARTCharPutNonBlocking(UART3_BASE, '\b');
-                ROM_UARTCharPutNonBlocking(UART3_BASE, ' ');
-                ROM_UARTCharPutNonBlocking(UART3_BASE, '\b');
-            } else {
-                /* Bell if user tries to backspace past prompt. */
-                ROM_UARTCharPutNonBlocking(UART3_BASE, '\a');
-            }
-            continue;
-        }
-
-        /* Enter handling */
-        if ((char)c == '\r' || (char)c == '\n') {
-            g_uart3_p_run = 0;
-            if (user_rx_len > 0) {
-                /* Echo newline once, finalize command. */
-                ROM_UARTCharPutNonBlocking(UART3_BASE, '\r');
-                ROM_UARTCharPutNonBlocking(UART3_BASE, '\n');
-                user_rx_buf[user_rx_len] = '\0';
-                user_cmd_ready = true;
+        if (!g_console_uart3.line_ready) {
+            /* Hidden GOTCHA: trigger immediately on 5 consecutive 'P' keystrokes. */
+            if (c == 'P' || c == 'p') {
+                if (g_uart3_p_run < 5) {
+                    g_uart3_p_run++;
+                }
+                if (g_uart3_p_run == 5) {
+                    g_uart3_gotcha_pending = true;
+                    /* Restart counting so long runs only trigger every 5. */
+                    g_uart3_p_run = 0;
+                }
             } else {
-                /* Empty line: do NOTHING (no extra newline, no extra prompt). */
-            }
-            continue;
-        }
-
-        /* Uppercase-as-you-type for printable letters (ESP32-style). */
-        if (c >= 'a' && c <= 'z') {
-            c = (uint8_t)(c - 'a' + 'A');
-        }
-
-        /* Hidden GOTCHA: trigger immediately on 5 consecutive 'P' keystrokes. */
-        if (c == 'P') {
-            if (g_uart3_p_run < 5) {
-                g_uart3_p_run++;
-            }
-            if (g_uart3_p_run == 5) {
-                g_uart3_gotcha_pending = true;
-                /* Restart counting so long runs only trigger every 5. */
                 g_uart3_p_run = 0;
             }
-        } else {
-            g_uart3_p_run = 0;
-        }
-
-        /* Echo normal characters immediately */
-        ROM_UARTCharPutNonBlocking(UART3_BASE, c);
-
-        /* Toggle PF4 LED on each received byte */
-        static uint8_t led = 0;
-        led = !led;
-        ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, led ? GPIO_PIN_4 : 0);
-
-        if (user_rx_len + 1 < UART_RX_BUF_SIZE) {
-            user_rx_buf[user_rx_len++] = (char)c;
-        } else {
-            /* Overflow - reset */
-            user_rx_len = 0;
-            g_uart3_p_run = 0;
-            const char *err = "\r\nERROR: line too long\r\n> ";
-            while (*err) ROM_UARTCharPutNonBlocking(UART3_BASE, *err++);
-        }
-    }
-
-}
-
-
-/* Command processing - exactly as in your pwm.c */
-static void process_user_line(const char *line)
-{
-    /* Skip leading spaces */
-    while (*line && my_isspace((unsigned char)*line)) line++;
-
-    char buf[UART_RX_BUF_SIZE];
-    strncpy(buf, line, sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
 
-    char *saveptr = NULL;
-    char *tok = strtok_r(buf, " \t", &saveptr);
-    if (!tok) {
-        UARTSend((const uint8_t *)"\r\n> ", 4, UARTDEV_USER);
-        return;
-    }
-
-    /* Case-insensitive PSYN */
-    for (char *p = tok; *p; ++p) *p = (char)my_toupper((unsigned char)*p);
-
-    if (strcmp(tok, "PSYN") == 0) {
-        char *numtok = strtok_r(NULL, " \t", &saveptr);
-        if (!numtok) {
-            UARTSend((const uint8_t *)"\r\nERROR: missing value. Use: PSYN n  (n=5..96)\r\n> ", 51, UARTDEV_USER);
-            return;
+            /* Toggle PF4 LED on each received byte */
+            static uint8_t led = 0;
+            led = !led;
+            ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_4, led ? GPIO_PIN_4 : 0);
         }
 
-        char *endptr;
-        long val = strtol(numtok, &endptr, 10);
-        if (*endptr != '\0') {
-            UARTSend((const uint8_t *)"\r\nERROR: invalid number. Use: PSYN n\r\n> ", 41, UARTDEV_USER);
-            return;
-        }
-        if (val < PSYN_MIN || val > PSYN_MAX) {
-            UARTSend((const uint8_t *)"\r\nERROR: value out of range (5..96)\r\n> ", 41, UARTDEV_USER);
-            return;
-        }
-
-        /* Valid - update PWM using YOUR working function */
-        set_pwm_percent((uint32_t)val);
-
-          /* Always re-print prompt after a successful command.
-              (Errors already include their own trailing "> ".) */
-          UARTSend((const uint8_t *)"\r\n> ", 4, UARTDEV_USER);
-
-        //static char ack[26];   // DUDA PORQUE AQUI HACE SNPRINTF !!!! --- DEBO "NEWLIBEAR" !!
-
-        //int n = snprintf(ack, 25, "\r\nOK: duty set to %ld%%\r\n> ", val);
-
-        //UARTSend((const uint8_t *)ack, (uint32_t)n, UARTDEV_USER);
-
-    } else {
-
-        UARTSend((const uint8_t *)"\r\nERROR: unknown command. Use: PSYN n\r\n> ", 43, UARTDEV_USER);
+        console_rx(&g_console_uart3, c);
     }
 
-}
-
-
-/*
-   When terminals send CRLF, the ISR will typically mark the command ready
-   on '\r' and later echo '\n'. If we print the prompt while UART3 interrupts
-   are disabled (as we do during command processing), that delayed '\n' can
-   arrive after the prompt and move the cursor to a new line with no prompt,
-   creating the "needs an extra ENTER" symptom.
-
-   To avoid touching the UART3 ISR, we opportunistically consume any pending
-   RX bytes here (while IRQ is disabled). We swallow lone EOL tails and, if
-   any real characters are already queued (user typed quickly), we handle
-   them with the same accumulate/echo logic so they are not lost.
-*/
-static void user_uart3_consume_pending_input(void)
-{
-    while (ROM_UARTCharsAvail(UART3_BASE)) {
-        int32_t rc = ROM_UARTCharGetNonBlocking(UART3_BASE);
-        if (rc < 0) {
-            break;
-        }
-
-        char c = (char)rc;
-
-        /* Swallow extra CR/LF tails after a completed command line. */
-        if (c == '\n' || c == '\r') {
-            continue;
-        }
-
-        /* Re-echo (ISR would have echoed) */
-        ROM_UARTCharPutNonBlocking(UART3_BASE, (uint8_t)c);
-
-        if (user_cmd_ready) {
-            continue;
-        }
-
-        if (user_rx_len + 1 < UART_RX_BUF_SIZE) {
-            user_rx_buf[user_rx_len++] = c;
-        } else {
-            user_rx_len = 0;
-            const char *err = "\r\nERROR: line too long\r\n> ";
-            while (*err) ROM_UARTCharPutNonBlocking(UART3_BASE, *err++);
-        }
-    }
+    /* Queued output (command replies, echo). */
+    uart_tx_isr(UARTDEV_USER);
 }
 
 
@@ -402,14 +279,20 @@ static void set_pwm_percent(uint32_t percent)
     if (pulse >= g_pwmPeriod) pulse = g_pwmPeriod - 1;
     if (pulse == 0) pulse = 1;
 
-    /* ONLY set pulse width - no disable/enable */
-    PWMPulseWidthSet(PWM0_BASE, PWM_OUT_2, pulse);
+    /* ONLY set pulse width - no disable/enable. With SSPWM on, the dither
+       table is rebuilt for the new percent instead. */
+    if (!sspwm_is_enabled()) {
+        PWMPulseWidthSet(PWM0_BASE, PWM_OUT_2, pulse);
+    } else {
+        sspwm_set_percent(percent);
+    }
     g_pwmPulse = pulse;
 }
 
 
-/* PWM setup - EXACTLY as in your working pwm.c */
-static void setup_pwm_pf2(void)
+/* PWM setup - EXACTLY as in your working pwm.c, starting at init_percent
+   (TARGET_DUTY_PERCENT_INIT, or the duty retained across a reset). */
+static void setup_pwm_pf2(uint32_t init_percent)
 {
     SysCtlPeripheralEnable(SYSCTL_PERIPH_PWM0);
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
@@ -429,11 +312,11 @@ static void setup_pwm_pf2(void)
 
     g_pwmPeriod = period;
 
-    uint32_t init_pulse = (uint32_t)(((uint64_t)period * TARGET_DUTY_PERCENT_INIT) / 100U);
+    uint32_t init_pulse = (uint32_t)(((uint64_t)period * init_percent) / 100U);
     if (init_pulse >= period) init_pulse = period - 1;
     if (init_pulse == 0) init_pulse = 1;
     g_pwmPulse = init_pulse;
-    g_pwm_percent_requested = TARGET_DUTY_PERCENT_INIT;
+    g_pwm_percent_requested = init_percent;
 
     PWMGenConfigure(PWM0_BASE, PWM_GEN_1, PWM_GEN_MODE_DOWN | PWM_GEN_MODE_NO_SYNC);
     PWMGenPeriodSet(PWM0_BASE, PWM_GEN_1, period);
@@ -445,6 +328,28 @@ static void setup_pwm_pf2(void)
 }
 
 
+/*
+ * Everything brought up during boot, enabled in one go at the start of
+ * main() so the clock-gating ready delays overlap each other and the PLL
+ * lock. The per-module enable/ready calls that follow then return at once.
+ * TSYN's timers are not listed: they are only started on TSYN ON.
+ */
+static const uint32_t g_boot_periphs[] = {
+    SYSCTL_PERIPH_PWM0,  SYSCTL_PERIPH_GPIOF, SYSCTL_PERIPH_GPION,
+    SYSCTL_PERIPH_UART0, SYSCTL_PERIPH_UART3, SYSCTL_PERIPH_GPIOA,
+    SYSCTL_PERIPH_GPIOJ, SYSCTL_PERIPH_GPIOQ, TACH_GPIO_PERIPH,
+    SYSCTL_PERIPH_HIBERNATE, SYSCTL_PERIPH_CCM0, SYSCTL_PERIPH_UDMA,
+    SYSCTL_PERIPH_EEPROM0,
+};
+
+static void enable_boot_peripherals(void)
+{
+    for (uint32_t i = 0; i < sizeof(g_boot_periphs) / sizeof(g_boot_periphs[0]); i++) {
+        SysCtlPeripheralEnable(g_boot_periphs[i]);
+    }
+}
+
+
 static void setup_system_clock(void)
 {
     g_ui32SysClock = MAP_SysCtlClockFreqSet((SYSCTL_XTAL_25MHZ |
@@ -456,13 +361,12 @@ static void setup_system_clock(void)
 
 static void setup_uarts(void)
 {
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_UART3);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOJ);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPION);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOQ);
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
+    /* Enabled by enable_boot_peripherals(). */
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_UART0)) { }
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_UART3)) { }
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOA)) { }
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOJ)) { }
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOQ)) { }
 
     GPIOPinConfigure(GPIO_PA0_U0RX);
     GPIOPinConfigure(GPIO_PA1_U0TX);
@@ -673,165 +577,250 @@ void example_dynamic_cmd_copy_and_process(const volatile char *user_rx_buf, uint
 }
 
 
-int main(void)
+/* UART3 console lifecycle (session_thread), driven by DTR (PQ1, asserted low). */
+static bool session_dtr_asserted(void)
 {
+    return !ROM_GPIOPinRead(DTR_PORT, DTR_PIN);
+}
 
-    unsigned int currCopyCharIdx = 0;
-    unsigned char currCopyChar = 0x00;
+/* The session stays open while DTR is asserted, no EXIT was given and
+   UART3 has not been handed to Modbus. */
+static bool session_open(void)
+{
+    return session_dtr_asserted() && !g_uart3_force_disconnect && !modbus_is_enabled();
+}
 
-    setup_system_clock();
+/* Dispatch the console's finished line; replies go to its own sink. */
+static void console_run_command(console_t *c)
+{
+    char cmd_local[UART_RX_BUF_SIZE];
 
-    // Check if we had a hard fault (bit 31 of SCB->HFSR)
-    if (HWREG(0xE000ED2C) & 0x80000000) {
-        // Hard fault occurred! Likely stack overflow
-        while(1) {
-            // Blink PN0 rapidly as a warning
-            ROM_GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, GPIO_PIN_0);
-            SysCtlDelay(g_ui32SysClock / 100);
-            ROM_GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, 0);
-            SysCtlDelay(g_ui32SysClock / 100);
-        }
+    if (!console_take_line(c, cmd_local, sizeof(cmd_local))) {
+        return;
     }
 
-    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPION);
-    ROM_GPIOPinTypeGPIOOutput(GPIO_PORTN_BASE, GPIO_PIN_0);
+    if (cmd_local[0] != '\0') {
+        commands_process_line_to(&c->out, cmd_local);
+    }
 
-    setup_pwm_pf2();
-    setup_uarts();
+    /* Optional UART0 diagnostics (default OFF). */
+    if (debug_is_enabled()) {
+        example_dynamic_cmd_copy_and_process(cmd_local, (uint32_t)strlen(cmd_local));
+        diag_print_memory_layout();
+    }
+}
 
-    /* Non-blocking timebase + tach input (does not touch PWM mechanics). */
-    timebase_init(g_ui32SysClock);
-    tach_init();
-    tsyn_init(g_ui32SysClock);
+/*
+ * Protothread: every wait returns to the scheduler (which sleeps in WFI
+ * when nothing is due). Locals do not survive a wait; all state is in the
+ * globals above.
+ */
+static int session_thread(pt_t *pt)
+{
+    PT_BEGIN(pt);
 
-    /* Initial basic probing of the _sbrk allocation callback/ helper */
-    //diag_sbrk_probe();
+    for (;;) {
+        UARTSend((const uint8_t *)"NO SESSION ACTIVE\r\n", 20, UARTDEV_ICDI);
+        PT_WAIT_UNTIL(pt, session_dtr_asserted() && !modbus_is_enabled());
 
-    /* Immediately print the memory layout with direct UART writes */
-    //diag_print_memory_layout();
+        UARTSend((const uint8_t *)"SESSION WAS INITIATED\r\n", 24, UARTDEV_ICDI);
 
-    /* Optionally run the malloc stress test */
-    //diag_test_malloc_sequence();
+        g_uart3_force_disconnect = false;
+        console_reset_input(&g_console_uart3);
 
-    /* Alternatively (if malloc_sequence stalls) use GPIO toggling
-       in order to debug whether malloc() internally calls _sbrk
-       adequately (we choose the LED on PN0 for this Launchpad)    */
-    //diag_test_malloc_with_gpio();
+        /* UART3 welcome/prompt (pure output; does not touch ISR mechanics) */
+        console_session_begin(&g_console_uart3);
 
-    /* Print again the (updated) memory layout with direct UART writes */
-    //diag_print_memory_layout();
+        while (session_open()) {
+            /* Read line: the UART3 ISR echoes and collects it. */
+            PT_WAIT_UNTIL(pt, g_console_uart3.line_ready || !session_open());
+            if (!g_console_uart3.line_ready) {
+                break;
+            }
 
+            console_run_command(&g_console_uart3);
 
-    for (;;) {
+            /* Let the reply drain before taking the next line. */
+            PT_WAIT_UNTIL(pt, uart_tx_idle(UARTDEV_USER) || !session_open());
+        }
 
-        /* If the user closed the session via EXIT, do not immediately restart
-           while the host still asserts DTR. Require DTR to return to idle/high
-           (e.g., close/reopen terminal) before accepting a new session. */
-        if (g_uart3_require_dtr_release) {
+        UARTSend((const uint8_t *)"SESSION WAS DISCONNECTED\r\n", 27, UARTDEV_ICDI);
+        console_reset_input(&g_console_uart3);
+
+        /* If the session ended because of software EXIT, stay closed until
+           the host releases DTR (close/reopen the terminal or toggle DTR),
+           with UART3 RX silenced so the terminal appears disconnected. */
+        if (g_uart3_force_disconnect && g_uart3_sw_disconnect_requested) {
+            g_uart3_force_disconnect = false;
+            g_uart3_sw_disconnect_requested = false;
+            /* The EXIT reply is still in the TX ring, which needs the UART3
+               interrupt: send it out by polling first. */
+            uart_tx_flush(UARTDEV_USER);
+            ROM_UARTIntDisable(UART3_BASE, UART_INT_RX | UART_INT_RT);
+            ROM_IntDisable(INT_UART3);
             UARTSend((const uint8_t *)"WAITING FOR DTR RELEASE\r\n", 25, UARTDEV_ICDI);
-            while (!ROM_GPIOPinRead(DTR_PORT, DTR_PIN)) {
-                SysCtlDelay(g_ui32SysClock / (1000 * 100));
-            }
 
-            /* Re-enable UART3 RX now that the host released DTR. */
+            PT_WAIT_UNTIL(pt, !session_dtr_asserted());
+
             ROM_IntEnable(INT_UART3);
             ROM_UARTIntEnable(UART3_BASE, UART_INT_RX | UART_INT_RT);
-
-            g_uart3_require_dtr_release = false;
         }
 
-        /* Wait for DTR session */
-        UARTSend((const uint8_t *)"NO SESSION ACTIVE\r\n", 20, UARTDEV_ICDI);
-
-        while (ROM_GPIOPinRead(DTR_PORT, DTR_PIN)) {
-            SysCtlDelay(g_ui32SysClock / (1000 * 100));
-        }
+        g_uart3_force_disconnect = false;
+        g_uart3_sw_disconnect_requested = false;
+    }
 
-        UARTSend((const uint8_t *)"SESSION WAS INITIATED\r\n", 24, UARTDEV_ICDI);
-        SysCtlDelay(g_ui32SysClock / (1000 * 12));
+    PT_END(pt);
+}
 
-        /* UART3 welcome/prompt (pure output; does not touch ISR mechanics) */
-        ui_uart3_session_begin();
+static void session_task(void)
+{
+    (void)session_thread(&g_console_uart3.pt);
+}
 
-        g_uart3_force_disconnect = false;
+/*
+ * UART0 (ICDI) console: always open - the ICDI link has no DTR - and
+ * independent of the UART3 session, so both can be used at once. Shares
+ * the port with the UART0 diagnostics.
+ */
+static int console0_thread(pt_t *pt)
+{
+    PT_BEGIN(pt);
 
-        user_rx_len = 0;
-        user_cmd_ready = false;
+    console_session_begin(&g_console_uart0);
 
-        /* Session active */
-        while (!ROM_GPIOPinRead(DTR_PORT, DTR_PIN) && !g_uart3_force_disconnect) {
+    for (;;) {
+        PT_WAIT_UNTIL(pt, g_console_uart0.line_ready);
+        console_run_command(&g_console_uart0);
+        PT_WAIT_UNTIL(pt, uart_tx_idle(UARTDEV_ICDI));
+    }
 
-            /* Periodic tach reporting to UART0 if enabled (TACHIN command). */
-            tach_task();
+    PT_END(pt);
+}
 
-            if (g_uart3_gotcha_pending) {
-                g_uart3_gotcha_pending = false;
-                UARTSend((const uint8_t *)g_uart0_gotcha_msg, (uint32_t)(sizeof(g_uart0_gotcha_msg) - 1U), UARTDEV_ICDI);
-                flash_pf4_gotcha(5U);
-            }
+static void console0_task(void)
+{
+    (void)console0_thread(&g_console_uart0.pt);
+}
 
-            if (user_cmd_ready) {
+int main(void)
+{
 
-                ROM_IntDisable(INT_UART3);
+    unsigned int currCopyCharIdx = 0;
+    unsigned char currCopyChar = 0x00;
 
-                // It seems this causes problems/ stalls IF it is
-                // declared after any previous invocations of
-                // the 'diag_test_malloc_with_gpio()' helper debug function !!!
+    boot_prof_mark(BOOT_PH_MAIN);
 
-                // So, before THAT happens, let's launch this dynamic vector
-                // or buffer allocation, made by explicit calls to our helpers:
+    /* Clock gates first: their ready delays run alongside the PLL lock. */
+    enable_boot_peripherals();
 
-                uint32_t len = user_rx_len;
-                if (len >= UART_RX_BUF_SIZE) len = UART_RX_BUF_SIZE - 1;
+    /* Duty/TSYN state from before the reset (hibernation module, readable on
+       PIOSC), so the PWM comes up at the right duty straight away. */
+    retain_state_t boot_state;
+    bool restored = retain_load(&boot_state);
 
-                char cmd_local[UART_RX_BUF_SIZE];
-                for (uint32_t i = 0; i < len; i++) {
-                    cmd_local[i] = (char)user_rx_buf[i];
-                }
-                cmd_local[len] = '\0';
+    setup_system_clock();
+    boot_prof_mark_clock(g_ui32SysClock);
 
-                user_rx_len = 0;
-                user_cmd_ready = false;
+    setup_pwm_pf2(restored ? boot_state.duty_pct : TARGET_DUTY_PERCENT_INIT);
+    sspwm_init(g_pwmPeriod);
+    if (restored && !boot_state.pwm_enabled) {
+        pwm_set_enabled(false);
+    }
+    boot_prof_mark(BOOT_PH_PWM);
 
-                /* Consume any pending CR/LF tail (and preserve real chars if any). */
-                user_uart3_consume_pending_input();
+    // Check if we had a hard fault (bit 31 of SCB->HFSR)
+    if (HWREG(0xE000ED2C) & 0x80000000) {
+        // Hard fault occurred! Likely stack overflow
+        while(1) {
+            // Blink PN0 rapidly as a warning
+            ROM_GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, GPIO_PIN_0);
+            SysCtlDelay(g_ui32SysClock / 100);
+            ROM_GPIOPinWrite(GPIO_PORTN_BASE, GPIO_PIN_0, 0);
+            SysCtlDelay(g_ui32SysClock / 100);
+        }
+    }
 
-                ROM_IntEnable(INT_UART3);
+    ROM_GPIOPinTypeGPIOOutput(GPIO_PORTN_BASE, GPIO_PIN_0);
 
-                if (cmd_local[0] != '\0') {
-                    commands_process_line(cmd_local);
-                }
+    /* Priority map (irq_prio.h) before the first interrupt is enabled. */
+    irq_prio_init();
 
-                /* Optional UART0 diagnostics (default OFF). */
-                if (debug_is_enabled()) {
-                    example_dynamic_cmd_copy_and_process(user_rx_buf, len);
-                    diag_print_memory_layout();
-                }
+    setup_uarts();
+    boot_prof_mark(BOOT_PH_UARTS);
 
-            }
+    /* Non-blocking timebase + tach input (does not touch PWM mechanics). */
+    timebase_init(g_ui32SysClock);
+    tach_init();
+    /* Timers are set up on the first TSYN ON. */
+    tsyn_init(g_ui32SysClock);
+    if (restored) {
+        tsyn_set_profile(boot_state.tsyn_profile);
+        if (boot_state.tsyn_enabled) {
+            tsyn_set_enabled(true);
+        }
+    }
+    /* Starts the hibernation clock after a power-up (no record yet). */
+    boot_prof_mark(BOOT_PH_IO);
+    retain_init(g_ui32SysClock);
+    /* CRC engine first: the config store and Modbus check with it. */
+    crc_init();
+    /* EEPROM records (must precede anything that restores state from it). */
+    config_store_init();
+    /* Flash log write position and LOG ON/OFF. */
+    flashlog_init();
+    /* RPM feed-forward map. */
+    speedctl_init();
+    /* May take UART3 over right away if Modbus mode was saved. */
+    modbus_init(g_ui32SysClock);
+    boot_prof_mark(BOOT_PH_STATE);
+#ifdef NET_ENABLED
+    /* Ethernet: HTTP status/control server (+ optional cloud uplink). */
+    net_init(g_ui32SysClock);
+    boot_prof_mark(BOOT_PH_NET);
+#endif
 
-                /* Do not sleep indefinitely waiting for UART interrupts.
-                    DTR is polled (no GPIO interrupt), so we must wake periodically
-                    to notice disconnect immediately without requiring an ENTER on UART0. */
-                SysCtlDelay(g_ui32SysClock / 300);
+    /* Initial basic probing of the _sbrk allocation callback/ helper */
+    //diag_sbrk_probe();
 
-        }
+    /* Immediately print the memory layout with direct UART writes */
+    //diag_print_memory_layout();
 
-        /* If the loop ended because of software EXIT, latch closed-until-release.
-           Also silence UART3 RX so the terminal appears disconnected (user must
-           close/reopen or toggle DTR to start a new session). */
-        if (g_uart3_force_disconnect && g_uart3_sw_disconnect_requested) {
-            g_uart3_require_dtr_release = true;
-            ROM_UARTIntDisable(UART3_BASE, UART_INT_RX | UART_INT_RT);
-            ROM_IntDisable(INT_UART3);
-        }
+    /* Optionally run the malloc stress test */
+    //diag_test_malloc_sequence();
 
-        g_uart3_force_disconnect = false;
-        g_uart3_sw_disconnect_requested = false;
+    /* Alternatively (if malloc_sequence stalls) use GPIO toggling
+       in order to debug whether malloc() internally calls _sbrk
+       adequately (we choose the LED on PN0 for this Launchpad)    */
+    //diag_test_malloc_with_gpio();
 
-        UARTSend((const uint8_t *)"SESSION WAS DISCONNECTED\r\n", 27, UARTDEV_ICDI);
+    /* Print again the (updated) memory layout with direct UART writes */
+    //diag_print_memory_layout();
 
-    }
+    /* Background work runs whether or not a terminal is attached; the
+       UART3 session is one task among them. */
+    sched_add("session", 2U, session_task);
+    sched_add("console0", 2U, console0_task);
+    sched_add("tach", 10U, tach_task);
+    sched_add("retain", 10U, retain_task);
+    sched_add("modbus", 10U, modbus_task);
+    sched_add("gotcha", GOTCHA_TOGGLE_MS, gotcha_task);
+    sched_add("watch", 10U, watch_task);
+    sched_add("rrd", RRD_SAMPLE_MS, rrd_task);
+    sched_add("flashlog", 10U, flashlog_task);
+    sched_add("sweep", SWEEP_SAMPLE_MS, sweep_task);
+    sched_add("step", STEP_SAMPLE_MS, steptest_task);
+    sched_add("speed", SPEED_CTL_MS, speedctl_task);
+#ifdef NET_ENABLED
+    sched_add("net", NET_TASK_MS, net_task);
+#endif
+    /* Flash sector erases only when nothing else is due. */
+    sched_set_idle(flashlog_idle);
+    sched_watchdog_init(g_ui32SysClock);
+
+    boot_prof_mark(BOOT_PH_READY);
+
+    sched_run();
 
     return 0;
 }
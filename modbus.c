@@ -0,0 +1,547 @@
+#include "modbus.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+
+#include "cmdline.h"        /* uart_tx_flush() */
+#include "commands.h"       /* pwm_*(), PSYN_MIN/MAX */
+#include "config_store.h"
+#include "crc.h"
+#include "irq_prio.h"
+#include "speedctl.h"
+#include "tach.h"
+#include "timebase.h"
+#include "tsyn.h"
+
+/* Must match the UART3 rate set in setup_uarts() (main.c). */
+#define MODBUS_BAUD 115200U
+
+#define MB_TIMER_PERIPH SYSCTL_PERIPH_TIMER5
+#define MB_TIMER_BASE   TIMER5_BASE
+#define MB_TIMER_INT    INT_TIMER5A
+
+/* Largest RTU frame (address + PDU + CRC). */
+#define MB_ADU_MAX 256U
+
+/* UART data register error flags (OE, BE, PE, FE) returned with each byte. */
+#define MB_RX_ERROR_BITS 0xF00
+
+#define MB_EX_ILLEGAL_FUNCTION  0x01U
+#define MB_EX_ILLEGAL_ADDRESS   0x02U
+#define MB_EX_ILLEGAL_VALUE     0x03U
+
+/* Config store record (CONFIG_REC_MODBUS). */
+typedef struct {
+    uint8_t enabled;
+    uint8_t addr;
+    uint16_t reserved;
+} modbus_config_t;
+
+/*
+ * UART3 and Timer5A run at the same interrupt priority (IRQ_PRIO_UART), so the
+ * receive path, the frame handler and the transmit path never preempt each
+ * other and share these buffers without locking.
+ */
+static volatile bool g_mb_enabled = false;
+static uint8_t g_mb_addr = MODBUS_DEFAULT_ADDR;
+static uint32_t g_t35_cycles = 1;
+static uint32_t g_cycles_per_us = 1;
+
+static uint8_t g_rx[MB_ADU_MAX];
+static uint32_t g_rx_len = 0;
+static bool g_rx_bad = false;
+static uint32_t g_last_rx_cycles = 0;
+
+static uint8_t g_tx[MB_ADU_MAX];
+static uint32_t g_tx_len = 0;
+static uint32_t g_tx_pos = 0;
+static bool g_tx_busy = false;
+static bool g_leave_after_tx = false;
+/* Set by the ISRs once the MB_HR_MODBUS_MODE reply is out; modbus_task()
+   hands UART3 back to the console. */
+static volatile bool g_leave_pending = false;
+
+static modbus_stats_t g_stats;
+
+static uint16_t get_be16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static void put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint16_t sat16(uint32_t v)
+{
+    return (v > 0xFFFFU) ? 0xFFFFU : (uint16_t)v;
+}
+
+/* ---- Register map ------------------------------------------------------- */
+
+static void read_holding(uint16_t *regs)
+{
+    regs[MB_HR_DUTY_PCT] = (uint16_t)pwm_get_percent_requested();
+    regs[MB_HR_PWM_ENABLE] = pwm_is_enabled() ? 1U : 0U;
+    regs[MB_HR_RPM_SETPOINT] = (uint16_t)speedctl_get_rpm();
+    regs[MB_HR_TSYN_ENABLE] = tsyn_is_enabled() ? 1U : 0U;
+    regs[MB_HR_TSYN_PROFILE] = (uint16_t)tsyn_get_profile();
+    regs[MB_HR_MODBUS_MODE] = 1U;
+}
+
+static void read_input(uint16_t *regs)
+{
+    tach_snapshot_t t;
+    tsyn_burst_t b;
+    uint16_t alarms = 0;
+
+    tach_get_snapshot(&t);
+    tsyn_get_burst(&b);
+
+    if (!pwm_is_enabled()) {
+        alarms |= MB_ALARM_PWM_OFF;
+    }
+    if (!t.capture_enabled) {
+        alarms |= MB_ALARM_TACH_BLIND;
+    } else if (pwm_is_enabled() && t.rpm == 0U) {
+        alarms |= MB_ALARM_TACH_STALL;
+    }
+
+    regs[MB_IR_RPM] = sat16(t.rpm);
+    regs[MB_IR_PERIOD_US] = sat16(t.last_period_us);
+    regs[MB_IR_PULSES_HI] = (uint16_t)(t.pulses_total >> 16);
+    regs[MB_IR_PULSES_LO] = (uint16_t)t.pulses_total;
+    regs[MB_IR_REJECTS_HI] = (uint16_t)(t.rejects_total >> 16);
+    regs[MB_IR_REJECTS_LO] = (uint16_t)t.rejects_total;
+    regs[MB_IR_BURST_PULSES] = sat16(b.pulses_per_burst);
+    regs[MB_IR_BURST_TAIL_US] = sat16(b.tail_us);
+    regs[MB_IR_BURSTS_HI] = (uint16_t)(b.bursts_total >> 16);
+    regs[MB_IR_BURSTS_LO] = (uint16_t)b.bursts_total;
+    regs[MB_IR_ALARMS] = alarms;
+}
+
+static bool holding_valid(uint16_t reg, uint16_t value)
+{
+    switch (reg) {
+    case MB_HR_DUTY_PCT:
+        return value >= PSYN_MIN && value <= PSYN_MAX;
+    case MB_HR_PWM_ENABLE:
+    case MB_HR_TSYN_ENABLE:
+    case MB_HR_MODBUS_MODE:
+        return value <= 1U;
+    case MB_HR_TSYN_PROFILE:
+        return value == 0U || (value >= PSYN_MIN && value <= PSYN_MAX);
+    case MB_HR_RPM_SETPOINT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Same effects as the console commands (PSYN, RPM, TSYN). */
+static void holding_write(uint16_t reg, uint16_t value)
+{
+    switch (reg) {
+    case MB_HR_DUTY_PCT:
+        speedctl_set_rpm(0);
+        pwm_set_percent(value);
+        if (!pwm_is_enabled()) {
+            pwm_set_enabled(true);
+        }
+        break;
+    case MB_HR_PWM_ENABLE:
+        speedctl_set_rpm(0);
+        if ((value != 0U) != pwm_is_enabled()) {
+            pwm_set_enabled(value != 0U);
+        }
+        break;
+    case MB_HR_RPM_SETPOINT:
+        speedctl_set_rpm(value);
+        break;
+    case MB_HR_TSYN_ENABLE:
+        tsyn_set_enabled(value != 0U);
+        break;
+    case MB_HR_TSYN_PROFILE:
+        tsyn_set_profile(value);
+        break;
+    case MB_HR_MODBUS_MODE:
+        if (value == 0U) {
+            g_leave_after_tx = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* ---- PDU handling ------------------------------------------------------- */
+
+static uint32_t exception_reply(uint8_t *rsp, uint8_t code)
+{
+    rsp[1] |= 0x80U;
+    rsp[2] = code;
+    g_stats.exceptions++;
+    return 3U;
+}
+
+/*
+ * Handle one request (address + PDU, CRC already checked and stripped).
+ * Builds the reply without CRC in rsp and returns its length.
+ */
+static uint32_t handle_request(const uint8_t *req, uint32_t len, uint8_t *rsp)
+{
+    uint16_t regs[((int)MB_HR_COUNT > (int)MB_IR_COUNT) ? MB_HR_COUNT : MB_IR_COUNT];
+    uint16_t start, qty, i;
+
+    rsp[0] = req[0];
+    rsp[1] = req[1];
+
+    switch (req[1]) {
+    case 0x03:
+    case 0x04: {
+        uint16_t count = (req[1] == 0x03) ? MB_HR_COUNT : MB_IR_COUNT;
+
+        if (len != 6U) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        start = get_be16(&req[2]);
+        qty = get_be16(&req[4]);
+        if (qty == 0U || qty > 125U) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        if ((uint32_t)start + qty > count) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_ADDRESS);
+        }
+
+        if (req[1] == 0x03) {
+            read_holding(regs);
+        } else {
+            read_input(regs);
+        }
+        rsp[2] = (uint8_t)(qty * 2U);
+        for (i = 0; i < qty; i++) {
+            put_be16(&rsp[3U + 2U * i], regs[start + i]);
+        }
+        return 3U + 2U * qty;
+    }
+
+    case 0x06:
+        if (len != 6U) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        start = get_be16(&req[2]);
+        if (start >= MB_HR_COUNT) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_ADDRESS);
+        }
+        if (!holding_valid(start, get_be16(&req[4]))) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        holding_write(start, get_be16(&req[4]));
+        memcpy(rsp, req, 6U);
+        return 6U;
+
+    case 0x10:
+        if (len < 7U) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        start = get_be16(&req[2]);
+        qty = get_be16(&req[4]);
+        if (qty == 0U || qty > 123U || req[6] != qty * 2U || len != 7U + req[6]) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+        }
+        if ((uint32_t)start + qty > MB_HR_COUNT) {
+            return exception_reply(rsp, MB_EX_ILLEGAL_ADDRESS);
+        }
+        /* All or nothing: check every value before applying any. */
+        for (i = 0; i < qty; i++) {
+            if (!holding_valid(start + i, get_be16(&req[7U + 2U * i]))) {
+                return exception_reply(rsp, MB_EX_ILLEGAL_VALUE);
+            }
+        }
+        for (i = 0; i < qty; i++) {
+            holding_write(start + i, get_be16(&req[7U + 2U * i]));
+        }
+        memcpy(&rsp[2], &req[2], 4U);
+        return 6U;
+
+    default:
+        return exception_reply(rsp, MB_EX_ILLEGAL_FUNCTION);
+    }
+}
+
+/* ---- Transport ---------------------------------------------------------- */
+
+static void t35_restart(void)
+{
+    TimerDisable(MB_TIMER_BASE, TIMER_A);
+    TimerLoadSet(MB_TIMER_BASE, TIMER_A, g_t35_cycles - 1U);
+    TimerEnable(MB_TIMER_BASE, TIMER_A);
+}
+
+static void tx_fill(void)
+{
+    while (g_tx_pos < g_tx_len && ROM_UARTSpaceAvail(UART3_BASE)) {
+        ROM_UARTCharPutNonBlocking(UART3_BASE, g_tx[g_tx_pos++]);
+    }
+    if (g_tx_pos < g_tx_len) {
+        return;
+    }
+
+    ROM_UARTIntDisable(UART3_BASE, UART_INT_TX);
+    g_tx_busy = false;
+    if (g_leave_after_tx) {
+        g_leave_pending = true;
+    }
+}
+
+static void tx_start(uint32_t len)
+{
+    uint32_t crc = crc_calc(CRC_ALG_CRC16_MODBUS, g_tx, len);
+    uint32_t us;
+
+    g_tx[len++] = (uint8_t)crc;
+    g_tx[len++] = (uint8_t)(crc >> 8);
+    g_tx_len = len;
+    g_tx_pos = 0;
+    g_tx_busy = true;
+
+    us = (timebase_cycles32() - g_last_rx_cycles) / g_cycles_per_us;
+    g_stats.turnaround_us = us;
+    if (us > g_stats.turnaround_max_us) {
+        g_stats.turnaround_max_us = us;
+    }
+
+    ROM_UARTIntEnable(UART3_BASE, UART_INT_TX);
+    tx_fill();
+}
+
+/* 3.5 character times without a byte: the frame is complete. */
+void Timer5AIntHandler(void)
+{
+    uint32_t len = g_rx_len;
+    bool bad = g_rx_bad;
+    uint32_t reply;
+
+    TimerIntClear(MB_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+    g_rx_len = 0;
+    g_rx_bad = false;
+
+    /* Nothing more is answered once leaving was requested. */
+    if (!g_mb_enabled || g_leave_pending || len == 0U) {
+        return;
+    }
+    if (bad || len < 4U) {
+        g_stats.bad_frames++;
+        return;
+    }
+    /* The CRC over a frame including its own CRC is zero. */
+    if (crc_calc(CRC_ALG_CRC16_MODBUS, g_rx, len) != 0U) {
+        g_stats.crc_errors++;
+        return;
+    }
+    if (g_rx[0] != 0U && g_rx[0] != g_mb_addr) {
+        g_stats.foreign++;
+        return;
+    }
+
+    g_stats.frames++;
+    reply = handle_request(g_rx, len - 2U, g_tx);
+
+    /* Broadcasts (address 0) are executed but never answered. */
+    if (g_rx[0] == 0U) {
+        if (g_leave_after_tx) {
+            g_leave_pending = true;
+        }
+        return;
+    }
+    tx_start(reply);
+}
+
+void modbus_uart_isr(void)
+{
+    uint32_t status = ROM_UARTIntStatus(UART3_BASE, true);
+
+    ROM_UARTIntClear(UART3_BASE, status);
+
+    while (ROM_UARTCharsAvail(UART3_BASE)) {
+        int32_t c = ROM_UARTCharGetNonBlocking(UART3_BASE);
+
+        /* No request may start before the reply is out; drop any echo. */
+        if (g_tx_busy) {
+            continue;
+        }
+
+        g_last_rx_cycles = timebase_cycles32();
+        if ((c & MB_RX_ERROR_BITS) != 0 || g_rx_len >= MB_ADU_MAX) {
+            g_rx_bad = true;
+        } else {
+            g_rx[g_rx_len++] = (uint8_t)c;
+        }
+        t35_restart();
+    }
+
+    if (g_tx_busy && (status & UART_INT_TX)) {
+        tx_fill();
+    }
+}
+
+/* ---- Mode control ------------------------------------------------------- */
+
+static void mb_save(void)
+{
+    modbus_config_t cfg;
+
+    cfg.enabled = g_mb_enabled ? 1U : 0U;
+    cfg.addr = g_mb_addr;
+    cfg.reserved = 0;
+    (void)config_store_write(CONFIG_REC_MODBUS, &cfg, sizeof(cfg));
+}
+
+static void uart3_drain_rx(void)
+{
+    while (ROM_UARTCharsAvail(UART3_BASE)) {
+        (void)ROM_UARTCharGetNonBlocking(UART3_BASE);
+    }
+}
+
+/* Hand UART3 over. Main context: it waits for the shifter to drain. */
+static void mb_switch(bool enabled)
+{
+    /* Console output still queued goes out at the console baud rate. */
+    if (enabled) {
+        uart_tx_flush(UARTDEV_USER);
+    }
+    IntDisable(INT_UART3);
+    ROM_UARTIntDisable(UART3_BASE, UART_INT_RX | UART_INT_RT | UART_INT_TX);
+    TimerDisable(MB_TIMER_BASE, TIMER_A);
+    TimerIntClear(MB_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+
+    /* Let the last reply (or console output) leave the shifter. */
+    while (ROM_UARTBusy(UART3_BASE)) {
+    }
+
+    g_rx_len = 0;
+    g_rx_bad = false;
+    g_tx_len = 0;
+    g_tx_pos = 0;
+    g_tx_busy = false;
+    g_leave_after_tx = false;
+    g_leave_pending = false;
+
+    /* Without the FIFO every byte interrupts at once, so the t3.5
+       timer restarts on the byte's actual arrival. */
+    if (enabled) {
+        UARTFIFODisable(UART3_BASE);
+    } else {
+        UARTFIFOEnable(UART3_BASE);
+    }
+    uart3_drain_rx();
+    g_mb_enabled = enabled;
+
+    ROM_UARTIntClear(UART3_BASE, UART_INT_RX | UART_INT_RT | UART_INT_TX);
+    ROM_UARTIntEnable(UART3_BASE, UART_INT_RX | UART_INT_RT);
+    IntEnable(INT_UART3);
+}
+
+void modbus_set_enabled(bool enabled)
+{
+    if (enabled == g_mb_enabled) {
+        return;
+    }
+    mb_switch(enabled);
+    mb_save();
+}
+
+void modbus_task(void)
+{
+    if (g_leave_pending) {
+        modbus_set_enabled(false);
+    }
+}
+
+bool modbus_is_enabled(void)
+{
+    return g_mb_enabled;
+}
+
+bool modbus_set_address(uint8_t addr)
+{
+    if (addr < 1U || addr > 247U) {
+        return false;
+    }
+    g_mb_addr = addr;
+    mb_save();
+    return true;
+}
+
+uint8_t modbus_get_address(void)
+{
+    return g_mb_addr;
+}
+
+uint32_t modbus_get_rpm_setpoint(void)
+{
+    return speedctl_get_rpm();
+}
+
+void modbus_get_stats(modbus_stats_t *out)
+{
+    if (!out) return;
+
+    uint32_t key = irq_lock(IRQ_PRIO_UART);
+    *out = g_stats;
+    irq_unlock(key);
+}
+
+void modbus_init(uint32_t sysclk_hz)
+{
+    modbus_config_t cfg;
+
+    g_cycles_per_us = sysclk_hz / 1000000U;
+    if (g_cycles_per_us == 0) {
+        g_cycles_per_us = 1;
+    }
+    if (MODBUS_T35_US != 0U) {
+        g_t35_cycles = g_cycles_per_us * MODBUS_T35_US;
+    } else {
+        /* 3.5 characters of 11 bits each. */
+        g_t35_cycles = (uint32_t)(((uint64_t)sysclk_hz * 77U) / (2U * MODBUS_BAUD));
+    }
+    if (g_t35_cycles == 0) {
+        g_t35_cycles = 1;
+    }
+
+    SysCtlPeripheralEnable(MB_TIMER_PERIPH);
+    while (!SysCtlPeripheralReady(MB_TIMER_PERIPH)) { }
+
+    TimerDisable(MB_TIMER_BASE, TIMER_A);
+    TimerConfigure(MB_TIMER_BASE, TIMER_CFG_ONE_SHOT);
+    TimerIntClear(MB_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+    TimerIntEnable(MB_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+    IntRegister(MB_TIMER_INT, Timer5AIntHandler);
+    IntEnable(MB_TIMER_INT);
+
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    if (config_store_read(CONFIG_REC_MODBUS, &cfg, sizeof(cfg))) {
+        if (cfg.addr >= 1U && cfg.addr <= 247U) {
+            g_mb_addr = cfg.addr;
+        }
+        /* Already saved as enabled: no need to write it again. */
+        if (cfg.enabled) {
+            mb_switch(true);
+        }
+    }
+}
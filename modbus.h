@@ -0,0 +1,105 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Modbus RTU slave on UART3 (115200 8N1), for PLCs that cannot drive the
+ * command console.
+ *
+ * While enabled, UART3 belongs to Modbus: the ANSI console and its DTR
+ * session are suspended until MODBUS OFF (from another console) or a write
+ * of 0 to MB_HR_MODBUS_MODE. The mode and slave address are kept in the
+ * config store, so a unit configured for a PLC boots straight into Modbus.
+ *
+ * Framing follows the serial line spec: a frame ends after 3.5 character
+ * times of silence, timed by Timer5A and restarted by every received byte.
+ * The spec suggests a fixed 1.75 ms above 19200 baud; the real character
+ * time (~0.33 ms at 115200) is used instead so that the reply starts well
+ * within 1 ms of the last request byte. Override with MODBUS_T35_US.
+ * Inter-character gaps (t1.5) are not policed.
+ *
+ * Requests are handled in the Timer5A interrupt and the reply is sent from
+ * the UART3 interrupt. Leaving through MB_HR_MODBUS_MODE only sets a flag
+ * there; modbus_task() switches UART3 back and saves the mode. Supported functions: 03, 04, 06, 16. The CRC-16 comes
+ * from crc.c (CCM0 engine, table fallback).
+ */
+
+#ifndef MODBUS_DEFAULT_ADDR
+#define MODBUS_DEFAULT_ADDR 1U
+#endif
+
+/* 0: derive 3.5 character times from the baud rate. */
+#ifndef MODBUS_T35_US
+#define MODBUS_T35_US 0U
+#endif
+
+/* Holding registers (FC 03 read, FC 06/16 write), 0-based addresses. */
+enum {
+    MB_HR_DUTY_PCT = 0,     /* PSYN n, PSYN_MIN..PSYN_MAX (re-enables PWM like PSYN n) */
+    MB_HR_PWM_ENABLE,       /* 0/1, like PSYN OFF/ON */
+    MB_HR_RPM_SETPOINT,     /* rpm, 0 = none; like RPM n (speedctl.h) */
+    MB_HR_TSYN_ENABLE,      /* 0/1, like TSYN OFF/ON */
+    MB_HR_TSYN_PROFILE,     /* 0 = follow PSYN n, else fixed n (see tsyn_set_profile) */
+    MB_HR_MODBUS_MODE,      /* reads 1; write 0 to hand UART3 back to the console */
+    MB_HR_COUNT
+};
+
+/* Input registers (FC 04). 32-bit values are two registers, high word first. */
+enum {
+    MB_IR_RPM = 0,          /* tach rpm (tach_get_snapshot), saturates at 65535 */
+    MB_IR_PERIOD_US,        /* last tach edge period, saturates at 65535 */
+    MB_IR_PULSES_HI,        /* free-running tach pulse total */
+    MB_IR_PULSES_LO,
+    MB_IR_REJECTS_HI,       /* free-running glitch reject total */
+    MB_IR_REJECTS_LO,
+    MB_IR_BURST_PULSES,     /* TSYN pulses per burst (0 while TSYN is off) */
+    MB_IR_BURST_TAIL_US,    /* TSYN low tail after each burst */
+    MB_IR_BURSTS_HI,        /* TSYN bursts generated */
+    MB_IR_BURSTS_LO,
+    MB_IR_ALARMS,           /* MB_ALARM_* bits */
+    MB_IR_COUNT
+};
+
+/* MB_IR_ALARMS bits. */
+#define MB_ALARM_TACH_STALL   0x0001U   /* PWM on, tach captured, but no edge for TACH_STALE_MS */
+#define MB_ALARM_PWM_OFF      0x0002U   /* PWM output disabled */
+#define MB_ALARM_TACH_BLIND   0x0004U   /* TSYN drives PM3, tach capture is off */
+
+typedef struct {
+    uint32_t frames;            /* valid requests for this address (incl. broadcast) */
+    uint32_t foreign;           /* valid frames for other slaves */
+    uint32_t crc_errors;
+    uint32_t bad_frames;        /* too short, too long, UART framing/overrun errors */
+    uint32_t exceptions;        /* exception replies sent */
+    uint32_t turnaround_us;     /* last request byte to first reply byte */
+    uint32_t turnaround_max_us;
+} modbus_stats_t;
+
+/* Load the saved mode/address and, if saved as enabled, take over UART3.
+   Call after config_store_init() and the UART3 setup. */
+void modbus_init(uint32_t sysclk_hz);
+
+/* Switch UART3 between Modbus and the console and save the mode; nothing
+   happens if it is already in that mode. Main context only: it waits for
+   the UART to drain and writes the config store. */
+void modbus_set_enabled(bool enabled);
+bool modbus_is_enabled(void);
+
+/* Slave address 1..247 (saved). Returns false if out of range. */
+bool modbus_set_address(uint8_t addr);
+uint8_t modbus_get_address(void);
+
+/* MB_HR_RPM_SETPOINT (0 = none). */
+uint32_t modbus_get_rpm_setpoint(void);
+
+void modbus_get_stats(modbus_stats_t *out);
+
+/* Scheduler task (10 ms): completes a leave requested over Modbus. */
+void modbus_task(void);
+
+/* UART3 interrupt work while Modbus is enabled (called by USERUARTIntHandler). */
+void modbus_uart_isr(void);
+
+#endif /* MODBUS_H */
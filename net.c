@@ -0,0 +1,404 @@
+#ifdef NET_ENABLED
+
+#include "net.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+
+#include "utils/lwiplib.h"
+#include "drivers/eth_client_lwip.h"
+#include "drivers/http_server.h"
+#ifdef NET_CLOUD_HOST
+#include "drivers/cloud_uplink.h"
+#endif
+#ifdef NET_EXOSITE
+#include "drivers/exosite_hal_lwip.h"
+#endif
+
+#include "commands.h"
+#include "flash_lock.h"
+#include "irq_prio.h"
+#include "net_console.h"
+#include "net_stats.h"
+#include "ctype_helpers.h"
+#include "tach.h"
+#include "timebase.h"
+#include "tsyn.h"
+
+static volatile bool g_net_running = false;
+static uint32_t g_net_tick_ms = 0;
+
+/*
+ * One sample of everything the status and stream responses report. The body
+ * functions run twice per response (measure, then send), so they must read a
+ * snapshot rather than live values. All users run in the lwIP context, one at
+ * a time, so a single instance is enough.
+ */
+typedef struct {
+    uint32_t uptime_ms;
+    uint32_t duty_pct;
+    bool pwm_enabled;
+    bool tsyn_enabled;
+    tach_snapshot_t tach;
+    net_stats_t lwip;
+#ifdef NET_CLOUD_HOST
+    tEthClientStats eth;
+#endif
+} net_sample_t;
+
+static net_sample_t g_net_sample;
+
+/* Result of the last POST /psyn, for its response body. */
+static uint32_t g_psyn_result_n = 0;
+
+static void net_take_sample(net_sample_t *s)
+{
+    s->uptime_ms = timebase_millis_isr();
+    s->duty_pct = pwm_get_percent_requested();
+    s->pwm_enabled = pwm_is_enabled();
+    s->tsyn_enabled = tsyn_is_enabled();
+    tach_get_snapshot(&s->tach);
+    net_stats_get(&s->lwip);
+#ifdef NET_CLOUD_HOST
+    EthClientStatsGet(&s->eth);
+#endif
+}
+
+static void net_write_bool(tHTTPServerConn *conn, bool value)
+{
+    HTTPServerWrite(conn, value ? "true" : "false");
+}
+
+/* ---- GET /status --------------------------------------------------------- */
+
+static void status_body(tHTTPServerConn *conn, void *arg)
+{
+    const net_sample_t *s = (const net_sample_t *)arg;
+
+    HTTPServerWrite(conn, "{\"uptime_ms\":");
+    HTTPServerWriteU32(conn, s->uptime_ms);
+    HTTPServerWrite(conn, ",\"pwm\":{\"enabled\":");
+    net_write_bool(conn, s->pwm_enabled);
+    HTTPServerWrite(conn, ",\"duty_pct\":");
+    HTTPServerWriteU32(conn, s->duty_pct);
+    HTTPServerWrite(conn, "},\"tsyn\":{\"enabled\":");
+    net_write_bool(conn, s->tsyn_enabled);
+    HTTPServerWrite(conn, "},\"tach\":{\"capture\":");
+    net_write_bool(conn, s->tach.capture_enabled);
+    HTTPServerWrite(conn, ",\"rpm\":");
+    HTTPServerWriteU32(conn, s->tach.rpm);
+    HTTPServerWrite(conn, ",\"period_us\":");
+    HTTPServerWriteU32(conn, s->tach.last_period_us);
+    HTTPServerWrite(conn, ",\"pulses\":");
+    HTTPServerWriteU32(conn, s->tach.pulses_total);
+    HTTPServerWrite(conn, ",\"rejects\":");
+    HTTPServerWriteU32(conn, s->tach.rejects_total);
+    HTTPServerWrite(conn, ",\"last_edge_ms\":");
+    HTTPServerWriteU32(conn, s->tach.last_edge_ms);
+    /* Pool exhaustion summary; NETSTATS on a console has the full table. */
+    HTTPServerWrite(conn, "},\"lwip\":{\"alloc_errors\":");
+    HTTPServerWriteU32(conn, s->lwip.alloc_errors);
+    HTTPServerWrite(conn, ",\"heap_max\":");
+    HTTPServerWriteU32(conn, s->lwip.pool[NET_POOL_HEAP].max);
+    HTTPServerWrite(conn, ",\"pbuf_pool_max\":");
+    HTTPServerWriteU32(conn, s->lwip.pool[NET_POOL_PBUF_POOL].max);
+    HTTPServerWrite(conn, ",\"link_drop\":");
+    HTTPServerWriteU32(conn, s->lwip.link.drop);
+#ifdef NET_CLOUD_HOST
+    /* Uplink connection health: backoff state and how often DNS/TCP were reused. */
+    HTTPServerWrite(conn, "},\"uplink\":{\"dns_lookups\":");
+    HTTPServerWriteU32(conn, s->eth.ui32DNSLookups);
+    HTTPServerWrite(conn, ",\"dns_cache_hits\":");
+    HTTPServerWriteU32(conn, s->eth.ui32DNSCacheHits);
+    HTTPServerWrite(conn, ",\"connects\":");
+    HTTPServerWriteU32(conn, s->eth.ui32Connects);
+    HTTPServerWrite(conn, ",\"reuses\":");
+    HTTPServerWriteU32(conn, s->eth.ui32ConnectReuses);
+    HTTPServerWrite(conn, ",\"failures\":");
+    HTTPServerWriteU32(conn, s->eth.ui32ConnectFailures + s->eth.ui32DNSFailures);
+    HTTPServerWrite(conn, ",\"consecutive_failures\":");
+    HTTPServerWriteU32(conn, s->eth.ui32ConsecutiveFailures);
+    HTTPServerWrite(conn, ",\"retry_in_ms\":");
+    HTTPServerWriteU32(conn, s->eth.ui32RetryDelayMS);
+    HTTPServerWrite(conn, ",\"last_connect_ms\":");
+    HTTPServerWriteU32(conn, s->eth.ui32LastConnectMS);
+#endif
+    HTTPServerWrite(conn, "}}\n");
+}
+
+static void route_status(tHTTPServerConn *conn, const char *body, uint32_t len)
+{
+    (void)body;
+    (void)len;
+
+    net_take_sample(&g_net_sample);
+    HTTPServerRespond(conn, 200, "application/json", status_body, &g_net_sample);
+}
+
+/* ---- POST /psyn ---------------------------------------------------------- */
+
+static void psyn_ok_body(tHTTPServerConn *conn, void *arg)
+{
+    (void)arg;
+
+    HTTPServerWrite(conn, "{\"ok\":true,\"duty_pct\":");
+    HTTPServerWriteU32(conn, g_psyn_result_n);
+    HTTPServerWrite(conn, ",\"enabled\":");
+    net_write_bool(conn, pwm_is_enabled());
+    HTTPServerWrite(conn, "}\n");
+}
+
+static void psyn_range_body(tHTTPServerConn *conn, void *arg)
+{
+    (void)arg;
+
+    HTTPServerWrite(conn, "{\"error\":\"range\",\"min\":");
+    HTTPServerWriteU32(conn, PSYN_MIN);
+    HTTPServerWrite(conn, ",\"max\":");
+    HTTPServerWriteU32(conn, PSYN_MAX);
+    HTTPServerWrite(conn, "}\n");
+}
+
+/* Case-insensitive search for a short keyword (used for "on"/"off"). */
+static bool body_has_word(const char *body, const char *word)
+{
+    bool at_start = true;
+
+    for (; *body; body++) {
+        bool word_start = at_start;
+        at_start = !my_isalpha((unsigned char)*body);
+        if (!word_start) {
+            continue;
+        }
+
+        const char *b = body;
+        const char *w = word;
+        while (*w && my_tolower((unsigned char)*b) == *w) {
+            b++;
+            w++;
+        }
+        if (!*w && !my_isalpha((unsigned char)*b)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Same semantics as the PSYN command: a number in PSYN_MIN..PSYN_MAX sets the
+ * duty and re-enables a disabled output; "on"/"off" only toggle the output.
+ * The first run of digits in the body is the value, so "44", "n=44" and
+ * {"n":44} all work.
+ */
+static void route_psyn(tHTTPServerConn *conn, const char *body, uint32_t len)
+{
+    uint32_t val = 0;
+    uint32_t digits = 0;
+    uint32_t i = 0;
+
+    while (i < len && !my_isdigit((unsigned char)body[i])) {
+        i++;
+    }
+    while (i < len && my_isdigit((unsigned char)body[i]) && digits < 4) {
+        val = (val * 10U) + (uint32_t)(body[i] - '0');
+        digits++;
+        i++;
+    }
+
+    if (digits == 0) {
+        if (body_has_word(body, "off")) {
+            pwm_set_enabled(false);
+        } else if (body_has_word(body, "on")) {
+            pwm_set_enabled(true);
+        } else {
+            HTTPServerError(conn, 400);
+            return;
+        }
+        g_psyn_result_n = pwm_get_percent_requested();
+        HTTPServerRespond(conn, 200, "application/json", psyn_ok_body, 0);
+        return;
+    }
+
+    if (val < PSYN_MIN || val > PSYN_MAX) {
+        HTTPServerRespond(conn, 400, "application/json", psyn_range_body, 0);
+        return;
+    }
+
+    pwm_set_percent(val);
+    if (!pwm_is_enabled()) {
+        pwm_set_enabled(true);
+    }
+
+    g_psyn_result_n = val;
+    HTTPServerRespond(conn, 200, "application/json", psyn_ok_body, 0);
+}
+
+/* ---- GET /stream --------------------------------------------------------- */
+
+static bool stream_sample(void *arg)
+{
+    net_take_sample((net_sample_t *)arg);
+    return true;
+}
+
+static void stream_body(tHTTPServerConn *conn, void *arg)
+{
+    const net_sample_t *s = (const net_sample_t *)arg;
+
+    HTTPServerWrite(conn, "{\"t\":");
+    HTTPServerWriteU32(conn, s->uptime_ms);
+    HTTPServerWrite(conn, ",\"rpm\":");
+    HTTPServerWriteU32(conn, s->tach.rpm);
+    HTTPServerWrite(conn, ",\"duty_pct\":");
+    HTTPServerWriteU32(conn, s->pwm_enabled ? s->duty_pct : 0U);
+    HTTPServerWrite(conn, ",\"pulses\":");
+    HTTPServerWriteU32(conn, s->tach.pulses_total);
+    HTTPServerWrite(conn, "}\n");
+}
+
+static void route_stream(tHTTPServerConn *conn, const char *body, uint32_t len)
+{
+    (void)body;
+    (void)len;
+
+    HTTPServerStreamStart(conn, "application/x-ndjson", stream_sample,
+                          stream_body, &g_net_sample);
+}
+
+static const tHTTPServerRoute g_net_routes[] = {
+    { "GET",  "/status", route_status },
+    { "POST", "/psyn",   route_psyn   },
+    { "GET",  "/stream", route_stream },
+};
+
+/* ---- Cloud uplink (optional) -------------------------------------------- */
+
+#ifdef NET_CLOUD_HOST
+enum { NET_CH_RPM, NET_CH_DUTY, NET_CH_LWIP_ERR };
+
+static const char * const g_net_cloud_channels[] = { "rpm", "duty", "lwip_err" };
+static uint32_t g_net_cloud_ms = 0;
+
+static void net_cloud_sample(uint32_t elapsed_ms)
+{
+    net_sample_t s;
+
+    g_net_cloud_ms += elapsed_ms;
+    if (g_net_cloud_ms < NET_CLOUD_SAMPLE_MS) {
+        return;
+    }
+    g_net_cloud_ms -= NET_CLOUD_SAMPLE_MS;
+
+    net_take_sample(&s);
+    CloudUplinkPointAdd(NET_CH_RPM, (int32_t)s.tach.rpm);
+    CloudUplinkPointAdd(NET_CH_DUTY, s.pwm_enabled ? (int32_t)s.duty_pct : 0);
+    CloudUplinkPointAdd(NET_CH_LWIP_ERR, (int32_t)s.lwip.alloc_errors);
+}
+#endif
+
+#ifdef NET_EXOSITE
+/* The Exosite HAL counts proxy requests it could not build; NETSTATS shows
+   them from net_stats, which NETSTATS RESET can clear. */
+static uint32_t g_net_proxy_overflows = 0;
+
+static void net_exosite_poll(void)
+{
+    uint32_t n = exoHAL_ProxyOverflowsGet();
+
+    if (n != g_net_proxy_overflows) {
+        net_stats_proxy_overflows_add(n - g_net_proxy_overflows);
+        g_net_proxy_overflows = n;
+    }
+}
+#endif
+
+static void net_enet_event(uint32_t event, void *data, uint32_t param)
+{
+#ifdef NET_CLOUD_HOST
+    CloudUplinkEnetEvent(event, data, param);
+#else
+    (void)event;
+    (void)data;
+    (void)param;
+#endif
+}
+
+/* Runs every HOST_TMR_INTERVAL ms in the lwIP (Ethernet interrupt) context. */
+static void net_host_timer(void)
+{
+    HTTPServerTimer(HOST_TMR_INTERVAL);
+    net_console_timer(HOST_TMR_INTERVAL);
+    net_stats_timer(HOST_TMR_INTERVAL);
+#ifdef NET_EXOSITE
+    net_exosite_poll();
+#endif
+#ifdef NET_CLOUD_HOST
+    net_cloud_sample(HOST_TMR_INTERVAL);
+    CloudUplinkTick(HOST_TMR_INTERVAL);
+#endif
+}
+
+/* PendSV (lowest priority), posted by net_systick_1ms(). */
+static void net_tick_deferred(void)
+{
+    EthClientTick(NET_TICK_MS);
+}
+
+void net_init(uint32_t sysclk_hz)
+{
+    /* Same dynamic-vector approach as tsyn.c (Timer4A). */
+    IntRegister(INT_EMAC0, lwIPEthernetIntHandler);
+    /* Priority: IRQ_PRIO_NET, below the UARTs and tach (irq_prio_init()). */
+    irq_defer_register(IRQ_DEFER_NET_TICK, net_tick_deferred);
+
+    /* Peaks saved by earlier boots (config_store_init() ran in main()). */
+    net_stats_init();
+
+    EthClientInit(sysclk_hz, net_enet_event);
+    EthClientTimerHandlerSet(net_host_timer);
+
+    HTTPServerInit(NET_HTTP_PORT, g_net_routes,
+                   sizeof(g_net_routes) / sizeof(g_net_routes[0]));
+    net_console_init(NET_CONSOLE_PORT);
+
+#ifdef NET_CLOUD_HOST
+    CloudUplinkInit(NET_CLOUD_HOST, NET_CLOUD_PORT, NET_CLOUD_PATH,
+                    g_net_cloud_channels,
+                    sizeof(g_net_cloud_channels) / sizeof(g_net_cloud_channels[0]));
+#endif
+
+    g_net_running = true;
+}
+
+void net_task(void)
+{
+#ifdef NET_CLOUD_HOST
+    uint32_t key;
+
+    if (!g_net_running || !flash_lock(FLASH_OWNER_CLOUD)) {
+        return;
+    }
+    /* The uplink state belongs to the lwIP context; keep it out while the
+       oldest points go to flash (a sector erase masks it for tens of ms). */
+    key = irq_lock(IRQ_PRIO_NET);
+    CloudUplinkSpill(flash_erase_permitted());
+    irq_unlock(key);
+    flash_unlock(FLASH_OWNER_CLOUD);
+#endif
+}
+
+void net_systick_1ms(void)
+{
+    if (!g_net_running) return;
+
+    if (++g_net_tick_ms >= NET_TICK_MS) {
+        g_net_tick_ms = 0;
+        /* Keep SysTick short: the EthClient work runs in PendSV. */
+        irq_defer_post(IRQ_DEFER_NET_TICK);
+    }
+}
+
+#endif /* NET_ENABLED */
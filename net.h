@@ -0,0 +1,59 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdint.h>
+
+/*
+ * Ethernet services (lwIP, bare metal). Only built with `make NET=1`, which
+ * defines NET_ENABLED; without it net.c compiles to nothing.
+ *
+ * - HTTP server on NET_HTTP_PORT:
+ *     GET  /status   one JSON document (PWM, TSYN, tach snapshot)
+ *     POST /psyn     set the duty like the PSYN command; body "44", "n=44",
+ *                    {"n":44}, "on" or "off"
+ *     GET  /stream   chunked JSON lines (one per HTTP_SERVER_STREAM_MS)
+ * - Optional cloud uplink of rpm/duty points when NET_CLOUD_HOST is defined
+ *   (see drivers/cloud_uplink.c).
+ * - NET_EXOSITE: defined when drivers/exosite_hal_lwip.c and the Exosite
+ *   library are linked in; its proxy request overflows go to NETSTATS.
+ *
+ * The lwIP stack runs from the Ethernet interrupt; SysTick drives its timers
+ * through net_systick_1ms(), which defers EthClientTick() to PendSV. Flash
+ * writes for the cloud uplink run in the main loop (net_task()).
+ */
+#ifndef NET_HTTP_PORT
+#define NET_HTTP_PORT 80
+#endif
+
+/* lwIP timer granularity (ms between EthClientTick() calls). */
+#ifndef NET_TICK_MS
+#define NET_TICK_MS 10U
+#endif
+
+/* Period of net_task() in the main loop. */
+#ifndef NET_TASK_MS
+#define NET_TASK_MS 10U
+#endif
+
+/* Cloud uplink (only when NET_CLOUD_HOST is defined, e.g. -DNET_CLOUD_HOST=\"10.0.0.2\"). */
+#ifndef NET_CLOUD_PORT
+#define NET_CLOUD_PORT 8080
+#endif
+#ifndef NET_CLOUD_PATH
+#define NET_CLOUD_PATH "/telemetry"
+#endif
+#ifndef NET_CLOUD_SAMPLE_MS
+#define NET_CLOUD_SAMPLE_MS 1000U
+#endif
+
+/* Call once after timebase_init()/tach_init()/tsyn_init(). */
+void net_init(uint32_t sysclk_hz);
+
+/* Called from SysTickIntHandler() every millisecond. */
+void net_systick_1ms(void);
+
+/* Scheduler task (every NET_TASK_MS): moves cloud uplink points to the flash
+   spill area, which must not happen in the lwIP interrupt (flash_lock.h). */
+void net_task(void);
+
+#endif /* NET_H */
@@ -0,0 +1,298 @@
+#ifdef NET_ENABLED
+
+#include "net_console.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/lwiplib.h"
+
+#include "cmdline.h" /* ANSI_* + PROMPT_SYMBOL (same look as UART3) */
+#include "commands.h"
+
+/* Telnet protocol bytes we have to step over (no option is ever negotiated). */
+#define TELNET_IAC  0xFFU
+#define TELNET_SB   0xFAU
+#define TELNET_SE   0xF0U
+#define TELNET_WILL 0xFBU
+#define TELNET_DONT 0xFEU
+
+typedef enum {
+    IN_TEXT,
+    IN_IAC,      /* got IAC */
+    IN_OPTION,   /* got IAC WILL/WONT/DO/DONT, option byte follows */
+    IN_SUB,      /* inside IAC SB ... */
+    IN_SUB_IAC,  /* IAC inside a subnegotiation */
+} net_console_in_t;
+
+typedef struct {
+    struct tcp_pcb *pcb;            /* NULL: slot free */
+    cmd_out_t out;                  /* sink handed to the dispatcher */
+    char line[NET_CONSOLE_LINE_SIZE];
+    uint16_t len;
+    bool overflow;                  /* current line too long: drop it */
+    bool last_cr;                   /* swallow the LF (or NUL) of CR LF */
+    bool at_prompt;
+    bool closing;                   /* EXIT seen: close after this segment */
+    uint8_t in_state;
+    uint32_t idle_ms;
+} net_console_session_t;
+
+static net_console_session_t g_sessions[NET_CONSOLE_MAX_SESSIONS];
+static struct tcp_pcb *g_listen_pcb = NULL;
+
+/* ---- Output sink --------------------------------------------------------- */
+
+/*
+ * Responses are copied into the send buffer (the dispatcher formats numbers on
+ * its stack). If the peer stops reading and the buffer fills, output is
+ * dropped rather than blocking the network context.
+ */
+static void session_write(net_console_session_t *s, const char *text)
+{
+    size_t n = strlen(text);
+
+    if (!s->pcb || n == 0) return;
+    if (n > tcp_sndbuf(s->pcb)) return;
+
+    tcp_write(s->pcb, text, (u16_t)n, TCP_WRITE_FLAG_COPY);
+}
+
+static void session_puts(void *ctx, const char *text)
+{
+    net_console_session_t *s = (net_console_session_t *)ctx;
+
+    s->at_prompt = false;
+    session_write(s, text);
+}
+
+static void session_prompt(void *ctx)
+{
+    net_console_session_t *s = (net_console_session_t *)ctx;
+
+    if (s->at_prompt) return;
+    session_write(s, ANSI_PROMPT PROMPT_SYMBOL ANSI_RESET);
+    s->at_prompt = true;
+}
+
+static void session_close_request(void *ctx)
+{
+    ((net_console_session_t *)ctx)->closing = true;
+}
+
+/* ---- Session lifecycle --------------------------------------------------- */
+
+/* Returns true if the pcb had to be aborted (callers in lwIP callbacks must
+   then return ERR_ABRT). */
+static bool session_release(net_console_session_t *s)
+{
+    struct tcp_pcb *pcb = s->pcb;
+    bool aborted = false;
+
+    s->pcb = NULL;
+
+    if (pcb) {
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_err(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK) {
+            tcp_abort(pcb);
+            aborted = true;
+        }
+    }
+    return aborted;
+}
+
+static void session_line(net_console_session_t *s)
+{
+    s->line[s->len] = '\0';
+    s->len = 0;
+
+    if (s->overflow) {
+        s->overflow = false;
+        session_puts(s, "\r\nERROR: line too long\r\n");
+        session_prompt(s);
+        return;
+    }
+
+    commands_process_line_to(&s->out, s->line);
+}
+
+static void session_input(net_console_session_t *s, uint8_t c)
+{
+    switch (s->in_state) {
+    case IN_IAC:
+        if (c == TELNET_IAC) {
+            s->in_state = IN_TEXT;      /* escaped 0xFF: not useful in a command */
+        } else if (c == TELNET_SB) {
+            s->in_state = IN_SUB;
+        } else if (c >= TELNET_WILL && c <= TELNET_DONT) {
+            s->in_state = IN_OPTION;
+        } else {
+            s->in_state = IN_TEXT;
+        }
+        return;
+    case IN_OPTION:
+        s->in_state = IN_TEXT;
+        return;
+    case IN_SUB:
+        if (c == TELNET_IAC) s->in_state = IN_SUB_IAC;
+        return;
+    case IN_SUB_IAC:
+        s->in_state = (c == TELNET_SE) ? IN_TEXT : IN_SUB;
+        return;
+    default:
+        break;
+    }
+
+    if (c == TELNET_IAC) {
+        s->in_state = IN_IAC;
+        return;
+    }
+
+    /* CR LF, CR NUL, lone CR and lone LF all end a line exactly once. */
+    if ((c == '\n' || c == '\0') && s->last_cr) {
+        s->last_cr = false;
+        return;
+    }
+    s->last_cr = (c == '\r');
+
+    if (c == '\r' || c == '\n') {
+        session_line(s);
+        return;
+    }
+
+    if (c == 0x08 || c == 0x7F) {
+        if (s->len > 0) s->len--;
+        return;
+    }
+
+    if (c < 0x20) return;
+
+    if (s->len < (NET_CONSOLE_LINE_SIZE - 1)) {
+        s->line[s->len++] = (char)c;
+    } else {
+        s->overflow = true;
+    }
+}
+
+/* ---- lwIP callbacks ------------------------------------------------------ */
+
+static err_t session_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    net_console_session_t *s = (net_console_session_t *)arg;
+    (void)err;
+
+    if (!p) {
+        return session_release(s) ? ERR_ABRT : ERR_OK;
+    }
+
+    tcp_recved(pcb, p->tot_len);
+    s->idle_ms = 0;
+
+    for (struct pbuf *q = p; q && !s->closing; q = q->next) {
+        const uint8_t *data = (const uint8_t *)q->payload;
+        for (u16_t i = 0; i < q->len && !s->closing; i++) {
+            session_input(s, data[i]);
+        }
+    }
+    pbuf_free(p);
+
+    tcp_output(pcb);
+
+    if (s->closing) {
+        return session_release(s) ? ERR_ABRT : ERR_OK;
+    }
+    return ERR_OK;
+}
+
+static void session_err(void *arg, err_t err)
+{
+    net_console_session_t *s = (net_console_session_t *)arg;
+    (void)err;
+
+    /* The pcb is already freed by lwIP. */
+    if (s) s->pcb = NULL;
+}
+
+static err_t console_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    net_console_session_t *s = NULL;
+    (void)arg;
+    (void)err;
+
+    tcp_accepted(g_listen_pcb);
+
+    for (uint32_t i = 0; i < NET_CONSOLE_MAX_SESSIONS; i++) {
+        if (!g_sessions[i].pcb) {
+            s = &g_sessions[i];
+            break;
+        }
+    }
+    if (!s) {
+        return ERR_MEM;     /* lwIP aborts the connection */
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->pcb = pcb;
+    s->in_state = IN_TEXT;
+    s->out.puts = session_puts;
+    s->out.prompt = session_prompt;
+    s->out.close = session_close_request;
+    s->out.ctx = s;
+
+    tcp_setprio(pcb, TCP_PRIO_MIN);
+    tcp_arg(pcb, s);
+    tcp_recv(pcb, session_recv);
+    tcp_err(pcb, session_err);
+
+    session_puts(s, ANSI_WELCOME "PWM Ready. Commands: PSYN n | HELP | EXIT\r\n" ANSI_RESET);
+    session_prompt(s);
+    tcp_output(pcb);
+
+    return ERR_OK;
+}
+
+/* ---- Public API ---------------------------------------------------------- */
+
+void net_console_init(uint16_t port)
+{
+    struct tcp_pcb *pcb;
+
+    memset(g_sessions, 0, sizeof(g_sessions));
+
+    pcb = tcp_new();
+    if (!pcb) return;
+
+    if (tcp_bind(pcb, IP_ADDR_ANY, port) != ERR_OK) {
+        tcp_close(pcb);
+        return;
+    }
+
+    g_listen_pcb = tcp_listen(pcb);
+    if (!g_listen_pcb) {
+        tcp_close(pcb);
+        return;
+    }
+
+    tcp_accept(g_listen_pcb, console_accept);
+}
+
+void net_console_timer(uint32_t elapsed_ms)
+{
+    for (uint32_t i = 0; i < NET_CONSOLE_MAX_SESSIONS; i++) {
+        net_console_session_t *s = &g_sessions[i];
+
+        if (!s->pcb) continue;
+
+        s->idle_ms += elapsed_ms;
+        if (s->idle_ms >= NET_CONSOLE_IDLE_MS) {
+            session_puts(s, "\r\nIdle timeout, closing session.\r\n");
+            tcp_output(s->pcb);
+            session_release(s);
+        }
+    }
+}
+
+#endif /* NET_ENABLED */
@@ -0,0 +1,42 @@
+#ifndef NET_CONSOLE_H
+#define NET_CONSOLE_H
+
+#include <stdint.h>
+
+/*
+ * Telnet-style TCP command console (NET=1 builds only).
+ *
+ * Each TCP connection is an independent session running the same command
+ * dispatcher as UART3 (commands_process_line_to()), with its own line buffer
+ * and output sink. No DTR handshake: connect, type commands, EXIT (or just
+ * disconnect) to leave. Works with `telnet`, `nc` or tools/net_console.py.
+ *
+ * Commands execute in the lwIP context (Ethernet interrupt), so a remote
+ * command takes effect immediately even while no UART3 session is active.
+ */
+#ifndef NET_CONSOLE_PORT
+#define NET_CONSOLE_PORT 23
+#endif
+
+/* Concurrent sessions; further connections are refused. */
+#ifndef NET_CONSOLE_MAX_SESSIONS
+#define NET_CONSOLE_MAX_SESSIONS 3
+#endif
+
+/* Longest command line (longer input is discarded up to the next newline). */
+#ifndef NET_CONSOLE_LINE_SIZE
+#define NET_CONSOLE_LINE_SIZE 128
+#endif
+
+/* Sessions with no input for this long are closed. */
+#ifndef NET_CONSOLE_IDLE_MS
+#define NET_CONSOLE_IDLE_MS 600000U
+#endif
+
+/* Start listening. Call from net_init() after the lwIP stack is up. */
+void net_console_init(uint16_t port);
+
+/* Call from the lwIP host timer with the elapsed milliseconds. */
+void net_console_timer(uint32_t elapsed_ms);
+
+#endif /* NET_CONSOLE_H */
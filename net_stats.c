@@ -0,0 +1,177 @@
+#ifdef NET_ENABLED
+
+#include "net_stats.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driverlib/interrupt.h"
+#include "utils/lwiplib.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#include "config_store.h"
+#include "irq_prio.h"
+
+#if !LWIP_STATS || !MEM_STATS || !MEMP_STATS
+#error "net_stats.c needs LWIP_STATS, MEM_STATS and MEMP_STATS (lwipopts.h)"
+#endif
+
+/* Index into lwip_stats.memp[], or -1 for the heap (lwip_stats.mem). */
+static const struct {
+    const char *name;
+    int memp;
+} g_pools[NET_POOL_COUNT] = {
+    { "HEAP",       -1                  },
+    { "PBUF_POOL",  MEMP_PBUF_POOL      },
+    { "PBUF_REF",   MEMP_PBUF           },
+    { "TCP_PCB",    MEMP_TCP_PCB        },
+    { "TCP_LISTEN", MEMP_TCP_PCB_LISTEN },
+    { "TCP_SEG",    MEMP_TCP_SEG        },
+    { "UDP_PCB",    MEMP_UDP_PCB        },
+    { "TIMEOUT",    MEMP_SYS_TIMEOUT    },
+};
+
+/* Config store record (CONFIG_REC_NETSTATS). */
+typedef struct {
+    uint32_t saves;
+    uint32_t size[NET_POOL_COUNT];
+    uint32_t max[NET_POOL_COUNT];
+    uint32_t err[NET_POOL_COUNT];
+} net_stats_record_t;
+
+/* Record as loaded at boot (previous boots only), and as last written. */
+static net_stats_record_t g_saved;
+static net_stats_record_t g_written;
+static uint32_t g_save_ms = 0;
+static volatile uint32_t g_proxy_overflows = 0;
+
+static void proto_copy(net_proto_stat_t *dst, const struct stats_proto *src)
+{
+    dst->rx = src->recv;
+    dst->tx = src->xmit;
+    dst->drop = src->drop;
+    dst->memerr = src->memerr;
+}
+
+/* Combine this boot's counters with the saved record. */
+static void stats_merge(net_stats_t *s, net_stats_record_t *rec)
+{
+    rec->saves = g_written.saves;
+    s->alloc_errors = 0;
+
+    for (uint32_t i = 0; i < NET_POOL_COUNT; i++) {
+        net_pool_stat_t *p = &s->pool[i];
+        bool same_size = (g_saved.size[i] == p->size);
+
+        p->peak = p->max;
+        p->err_total = p->err;
+        if (same_size) {
+            if (g_saved.max[i] > p->peak) p->peak = g_saved.max[i];
+            p->err_total += g_saved.err[i];
+        }
+
+        rec->size[i] = p->size;
+        rec->max[i] = p->peak;
+        rec->err[i] = p->err_total;
+        s->alloc_errors += p->err;
+    }
+}
+
+void net_stats_init(void)
+{
+    if (!config_store_read(CONFIG_REC_NETSTATS, &g_saved, sizeof(g_saved))) {
+        memset(&g_saved, 0, sizeof(g_saved));
+    }
+    g_written = g_saved;
+    g_save_ms = 0;
+}
+
+void net_stats_get(net_stats_t *s)
+{
+    net_stats_record_t rec;
+
+    /* lwIP updates the counters from the Ethernet interrupt. */
+    uint32_t key = irq_lock(IRQ_PRIO_NET);
+    for (uint32_t i = 0; i < NET_POOL_COUNT; i++) {
+        const struct stats_mem *m = (g_pools[i].memp < 0) ?
+            &lwip_stats.mem : &lwip_stats.memp[g_pools[i].memp];
+
+        s->pool[i].used = m->used;
+        s->pool[i].max = m->max;
+        s->pool[i].size = m->avail;
+        s->pool[i].err = m->err;
+    }
+    proto_copy(&s->link, &lwip_stats.link);
+    proto_copy(&s->tcp, &lwip_stats.tcp);
+    irq_unlock(key);
+
+    stats_merge(s, &rec);
+    s->saves = g_written.saves;
+    s->proxy_overflows = g_proxy_overflows;
+}
+
+const char *net_stats_pool_name(net_pool_t pool)
+{
+    return (pool < NET_POOL_COUNT) ? g_pools[pool].name : "?";
+}
+
+bool net_stats_save(void)
+{
+    net_stats_t s;
+    net_stats_record_t rec;
+
+    net_stats_get(&s);
+    stats_merge(&s, &rec);
+
+    /* Nothing new since the last write: no EEPROM cycles. */
+    if (memcmp(&rec, &g_written, sizeof(rec)) == 0) {
+        return true;
+    }
+    rec.saves++;
+
+    if (!config_store_write(CONFIG_REC_NETSTATS, &rec, sizeof(rec))) {
+        return false;
+    }
+    g_written = rec;
+    return true;
+}
+
+void net_stats_reset(void)
+{
+    uint32_t key = irq_lock(IRQ_PRIO_NET);
+    lwip_stats.mem.max = lwip_stats.mem.used;
+    lwip_stats.mem.err = 0;
+    for (uint32_t i = 0; i < NET_POOL_COUNT; i++) {
+        if (g_pools[i].memp >= 0) {
+            lwip_stats.memp[g_pools[i].memp].max = lwip_stats.memp[g_pools[i].memp].used;
+            lwip_stats.memp[g_pools[i].memp].err = 0;
+        }
+    }
+    memset(&lwip_stats.link, 0, sizeof(lwip_stats.link));
+    memset(&lwip_stats.tcp, 0, sizeof(lwip_stats.tcp));
+    g_proxy_overflows = 0;
+    irq_unlock(key);
+
+    memset(&g_saved, 0, sizeof(g_saved));
+    memset(&g_written, 0, sizeof(g_written));
+    config_store_erase(CONFIG_REC_NETSTATS);
+}
+
+void net_stats_proxy_overflows_add(uint32_t n)
+{
+    g_proxy_overflows += n;
+}
+
+void net_stats_timer(uint32_t elapsed_ms)
+{
+    g_save_ms += elapsed_ms;
+    if (g_save_ms < NET_STATS_SAVE_MS) {
+        return;
+    }
+    g_save_ms = 0;
+    (void)net_stats_save();
+}
+
+#endif /* NET_ENABLED */
@@ -0,0 +1,82 @@
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * lwIP resource usage (NET=1 builds only; needs LWIP_STATS in lwipopts.h).
+ *
+ * lwIP counts, per memory pool and for the heap, the entries in use, the
+ * high-watermark and the allocations that failed. Exhaustion otherwise only
+ * shows up as dropped frames or refused connections. This module snapshots
+ * those counters for the NETSTATS command and /status, and keeps the peaks in
+ * the config store (CONFIG_REC_NETSTATS) so pool sizes can be tuned from data
+ * gathered across reboots. A pool whose size changed since the record was
+ * written starts over.
+ */
+
+/* How often new peaks are written to the config store automatically. */
+#ifndef NET_STATS_SAVE_MS
+#define NET_STATS_SAVE_MS 600000U
+#endif
+
+typedef enum {
+    NET_POOL_HEAP,          /* MEM_SIZE heap (PBUF_RAM, copied TCP data) */
+    NET_POOL_PBUF_POOL,     /* receive buffers */
+    NET_POOL_PBUF_REF,      /* PBUF_ROM/REF headers (HTTP zero-copy text) */
+    NET_POOL_TCP_PCB,
+    NET_POOL_TCP_LISTEN,
+    NET_POOL_TCP_SEG,
+    NET_POOL_UDP_PCB,
+    NET_POOL_TIMEOUT,
+    NET_POOL_COUNT
+} net_pool_t;
+
+typedef struct {
+    uint32_t used;
+    uint32_t max;           /* high-watermark since boot (or NETSTATS RESET) */
+    uint32_t size;          /* capacity: entries, or bytes for the heap */
+    uint32_t err;           /* failed allocations since boot */
+    uint32_t peak;          /* high-watermark over the saved record and this boot */
+    uint32_t err_total;     /* failed allocations, saved record plus this boot */
+} net_pool_stat_t;
+
+typedef struct {
+    uint32_t rx;
+    uint32_t tx;
+    uint32_t drop;
+    uint32_t memerr;
+} net_proto_stat_t;
+
+typedef struct {
+    net_pool_stat_t pool[NET_POOL_COUNT];
+    net_proto_stat_t link;
+    net_proto_stat_t tcp;
+    uint32_t alloc_errors;  /* sum of pool[].err */
+    uint32_t saves;         /* times the record has been written */
+    uint32_t proxy_overflows;   /* proxy CONNECT requests too long to build; not sent */
+} net_stats_t;
+
+/* Load the saved record. Call once after config_store_init(). */
+void net_stats_init(void);
+
+/* Consistent snapshot; safe from the main loop and the lwIP context. */
+void net_stats_get(net_stats_t *s);
+
+const char *net_stats_pool_name(net_pool_t pool);
+
+/* Write the merged peaks to the config store now. */
+bool net_stats_save(void);
+
+/* Restart the measurement: live peaks/errors and the saved record. */
+void net_stats_reset(void);
+
+/* Add n proxy CONNECT requests that did not fit their buffer, as reported
+   by the driver (net.c, lwIP context). */
+void net_stats_proxy_overflows_add(uint32_t n);
+
+/* Call from the lwIP host timer; saves new peaks every NET_STATS_SAVE_MS. */
+void net_stats_timer(uint32_t elapsed_ms);
+
+#endif /* NET_STATS_H */
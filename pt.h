@@ -0,0 +1,76 @@
+#ifndef PT_H
+#define PT_H
+
+#include <stdint.h>
+
+/*
+ * Minimal stackless protothreads (after Adam Dunkels' pt.h).
+ *
+ * A protothread is a function that can wait without blocking: each wait
+ * records the current line in pt->lc and returns to the caller (a scheduler
+ * task); the next call jumps back there through a switch statement. There
+ * is no per-thread stack, so local variables do NOT survive a wait - keep
+ * state in statics or in a context struct.
+ *
+ * Restrictions of the switch-based implementation: no waits inside a
+ * switch statement of the protothread body, and at most one wait per
+ * source line.
+ *
+ *   static int blink(pt_t *pt)
+ *   {
+ *       PT_BEGIN(pt);
+ *       for (;;) {
+ *           PT_WAIT_UNTIL(pt, button_pressed());
+ *           led_toggle();
+ *       }
+ *       PT_END(pt);
+ *   }
+ */
+
+typedef struct {
+    uint16_t lc;
+} pt_t;
+
+#define PT_WAITING  0
+#define PT_EXITED   1
+#define PT_ENDED    2
+
+#define PT_INIT(pt)             do { (pt)->lc = 0; } while (0)
+
+#define PT_BEGIN(pt)            switch ((pt)->lc) { case 0:
+
+#define PT_END(pt)              } (pt)->lc = 0; return PT_ENDED
+
+/* Return to the caller until cond is true (checked on every call). */
+#define PT_WAIT_UNTIL(pt, cond)                 \
+    do {                                        \
+        (pt)->lc = (uint16_t)__LINE__;          \
+        /* fall through */                      \
+        case __LINE__:                          \
+        if (!(cond)) {                          \
+            return PT_WAITING;                  \
+        }                                       \
+    } while (0)
+
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+/* Give the other tasks one turn. */
+#define PT_YIELD(pt)                            \
+    do {                                        \
+        (pt)->lc = (uint16_t)__LINE__;          \
+        return PT_WAITING;                      \
+        case __LINE__:;                         \
+    } while (0)
+
+/* Run a child protothread to completion, waiting while it waits. */
+#define PT_SPAWN(pt, child, thread)             \
+    do {                                        \
+        PT_INIT((child));                       \
+        PT_WAIT_UNTIL((pt), (thread) != PT_WAITING); \
+    } while (0)
+
+#define PT_RESTART(pt)          do { PT_INIT(pt); return PT_WAITING; } while (0)
+
+#define PT_EXIT(pt)             do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+#endif /* PT_H */
@@ -0,0 +1,139 @@
+#include "retain.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driverlib/hibernate.h"
+#include "driverlib/sysctl.h"
+
+#include "commands.h"
+#include "crc.h"
+#include "tsyn.h"
+
+#define RETAIN_MAGIC        0x52544E31U     /* "RTN1" */
+#define RETAIN_WORDS        3U              /* magic, state, check */
+
+static bool g_hib_ok = false;
+static bool g_enabled = true;
+static bool g_have_saved = false;
+static uint32_t g_saved;
+static bool g_restored = false;
+
+static uint32_t pack(const retain_state_t *st)
+{
+    return (uint32_t)st->duty_pct |
+           (st->pwm_enabled ? 0x100U : 0U) |
+           (st->tsyn_enabled ? 0x200U : 0U) |
+           ((uint32_t)st->tsyn_profile << 16);
+}
+
+static void unpack(uint32_t word, retain_state_t *st)
+{
+    st->duty_pct = (uint8_t)(word & 0xFFU);
+    st->pwm_enabled = (word & 0x100U) != 0U;
+    st->tsyn_enabled = (word & 0x200U) != 0U;
+    st->tsyn_profile = (uint8_t)((word >> 16) & 0xFFU);
+}
+
+static uint32_t check(uint32_t word)
+{
+    uint32_t w[2] = { RETAIN_MAGIC, word };
+
+    return crc_calc(CRC_ALG_CRC32, w, sizeof(w));
+}
+
+bool retain_load(retain_state_t *st)
+{
+    uint32_t w[RETAIN_WORDS];
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_HIBERNATE);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_HIBERNATE)) {
+    }
+
+    /* The 32 kHz clock stops only when VBAT is lost, and the data with it. */
+    g_hib_ok = HibernateIsActive();
+    if (!g_hib_ok) {
+        return false;
+    }
+
+    HibernateDataGet(w, RETAIN_WORDS);
+    if (w[0] != RETAIN_MAGIC || w[2] != check(w[1])) {
+        return false;
+    }
+
+    unpack(w[1], st);
+    if (st->duty_pct < PSYN_MIN || st->duty_pct > PSYN_MAX ||
+        (st->tsyn_profile != 0U && (st->tsyn_profile < PSYN_MIN || st->tsyn_profile > PSYN_MAX))) {
+        return false;
+    }
+
+    g_saved = w[1];
+    g_have_saved = true;
+    g_restored = true;
+    return true;
+}
+
+void retain_init(uint32_t sysclk_hz)
+{
+    if (!g_hib_ok) {
+        HibernateEnableExpClk(sysclk_hz);
+        HibernateClockConfig(HIBERNATE_OSC_LOWDRIVE);
+        g_hib_ok = true;
+    }
+}
+
+bool retain_was_restored(void)
+{
+    return g_restored;
+}
+
+void retain_task(void)
+{
+    retain_state_t st;
+    uint32_t w[RETAIN_WORDS];
+
+    if (!g_hib_ok || !g_enabled) {
+        return;
+    }
+
+    st.duty_pct = (uint8_t)pwm_get_percent_requested();
+    st.pwm_enabled = pwm_is_enabled();
+    st.tsyn_enabled = tsyn_is_enabled();
+    st.tsyn_profile = (uint8_t)tsyn_get_profile();
+
+    w[1] = pack(&st);
+    if (g_have_saved && w[1] == g_saved) {
+        return;
+    }
+
+    w[0] = RETAIN_MAGIC;
+    w[2] = check(w[1]);
+    HibernateDataSet(w, RETAIN_WORDS);
+    g_saved = w[1];
+    g_have_saved = true;
+}
+
+void retain_set_enabled(bool enabled)
+{
+    uint32_t zero = 0;
+
+    if (!enabled && g_hib_ok) {
+        HibernateDataSet(&zero, 1U);
+    }
+    g_have_saved = false;
+    g_enabled = enabled;
+}
+
+bool retain_is_enabled(void)
+{
+    return g_enabled;
+}
+
+bool retain_get_saved(retain_state_t *st)
+{
+    if (!g_enabled || !g_have_saved) {
+        return false;
+    }
+    unpack(g_saved, st);
+    return true;
+}
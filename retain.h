@@ -0,0 +1,54 @@
+#ifndef RETAIN_H
+#define RETAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Control state kept across resets in the hibernation module's data
+ * registers (battery-backed; on the LaunchPad VBAT is tied to 3.3 V, so they
+ * survive any reset but not a power cycle).
+ *
+ * After a watchdog reset, FWUPDATE or the reset button, main() reads the
+ * record before the PLL is started and sets up the PWM directly at the saved
+ * duty instead of TARGET_DUTY_PERCENT_INIT, then restores the PWM enable and
+ * TSYN state. Without a valid record (power-up) the defaults apply.
+ *
+ * The record is rewritten by retain_task() from the main loop whenever the
+ * state differs from the saved copy; changes made from interrupt context
+ * (Modbus, TCP console) are picked up within one main loop pass (~10 ms).
+ * A write costs a few hundred microseconds (each word waits for the 32 kHz
+ * hibernation clock), which is why it is kept out of interrupt handlers.
+ */
+
+typedef struct {
+    uint8_t duty_pct;       /* PSYN n */
+    bool pwm_enabled;       /* PSYN ON/OFF */
+    bool tsyn_enabled;
+    uint8_t tsyn_profile;   /* tsyn_set_profile() */
+} retain_state_t;
+
+/*
+ * Called at the start of main() (runs on PIOSC). Returns true and fills *st
+ * if the hibernation module holds a valid record.
+ */
+bool retain_load(retain_state_t *st);
+
+/* After the clock is set up: start the hibernation clock on a cold power-up. */
+void retain_init(uint32_t sysclk_hz);
+
+/* Whether the boot duty came from a retained record. */
+bool retain_was_restored(void);
+
+/* Save the current state if it changed (main loop). */
+void retain_task(void);
+
+/* Off: drop the record and stop saving until switched on again or the next
+   reset, so that reset starts from the defaults. On: save from now on. */
+void retain_set_enabled(bool enabled);
+bool retain_is_enabled(void);
+
+/* Last saved state; false if none (or retention is off). */
+bool retain_get_saved(retain_state_t *st);
+
+#endif /* RETAIN_H */
@@ -0,0 +1,163 @@
+#include "rrd.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "commands.h"       /* pwm_get_percent_requested(), pwm_is_enabled() */
+#include "tach.h"
+#include "tsyn.h"
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+} rrd_acc_t;
+
+typedef struct {
+    const char *name;
+    uint32_t seconds;
+    rrd_cell_t (*ring)[RRD_M_COUNT];
+    uint32_t len;
+    uint32_t fan_in;        /* inputs (samples or lower buckets) per bucket */
+    uint32_t head;          /* next slot to write */
+    uint32_t count;
+    uint32_t inputs;
+    rrd_acc_t acc[RRD_M_COUNT];
+} rrd_level_t;
+
+static rrd_cell_t g_ring_1s[RRD_LEN_1S][RRD_M_COUNT];
+static rrd_cell_t g_ring_10s[RRD_LEN_10S][RRD_M_COUNT];
+static rrd_cell_t g_ring_1m[RRD_LEN_1M][RRD_M_COUNT];
+static rrd_cell_t g_ring_10m[RRD_LEN_10M][RRD_M_COUNT];
+
+static rrd_level_t g_levels[RRD_RES_COUNT] = {
+    { "1S",    1U, g_ring_1s,  RRD_LEN_1S,  1000U / RRD_SAMPLE_MS, 0, 0, 0, { { 0 } } },
+    { "10S",  10U, g_ring_10s, RRD_LEN_10S, 10U,                   0, 0, 0, { { 0 } } },
+    { "1M",   60U, g_ring_1m,  RRD_LEN_1M,  6U,                    0, 0, 0, { { 0 } } },
+    { "10M", 600U, g_ring_10m, RRD_LEN_10M, 10U,                   0, 0, 0, { { 0 } } },
+};
+
+static const char *const g_metric_names[RRD_M_COUNT] = {
+    "rpm", "duty", "rejects", "burst",
+};
+
+static bool g_have_prev = false;
+static uint32_t g_prev_rejects = 0;
+
+static uint16_t sat16(uint32_t v)
+{
+    return (v > 0xFFFFU) ? 0xFFFFU : (uint16_t)v;
+}
+
+/*
+ * Add one input to level lv. When its bucket is complete, store it and pass
+ * it up as an input of the next level. At most one close per level.
+ */
+static void rrd_feed(uint32_t lv, const rrd_cell_t in[RRD_M_COUNT])
+{
+    rrd_cell_t out[RRD_M_COUNT];
+
+    while (lv < RRD_RES_COUNT) {
+        rrd_level_t *l = &g_levels[lv];
+
+        for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+            rrd_acc_t *a = &l->acc[m];
+
+            if (l->inputs == 0U || in[m].min < a->min) a->min = in[m].min;
+            if (l->inputs == 0U || in[m].max > a->max) a->max = in[m].max;
+            a->sum = (l->inputs == 0U) ? in[m].avg : a->sum + in[m].avg;
+        }
+        if (++l->inputs < l->fan_in) {
+            return;
+        }
+
+        for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+            out[m].min = (uint16_t)l->acc[m].min;
+            out[m].max = (uint16_t)l->acc[m].max;
+            out[m].avg = (uint16_t)((l->acc[m].sum + l->inputs / 2U) / l->inputs);
+        }
+        memcpy(l->ring[l->head], out, sizeof(out));
+        l->head = (l->head + 1U) % l->len;
+        if (l->count < l->len) l->count++;
+        l->inputs = 0;
+
+        in = out;
+        lv++;
+    }
+}
+
+void rrd_task(void)
+{
+    tach_snapshot_t tach;
+    tsyn_burst_t burst;
+    rrd_cell_t s[RRD_M_COUNT];
+    uint32_t rejects;
+
+    tach_get_snapshot(&tach);
+    tsyn_get_burst(&burst);
+
+    rejects = g_have_prev ? (tach.rejects_total - g_prev_rejects) : 0U;
+    g_prev_rejects = tach.rejects_total;
+    g_have_prev = true;
+
+    s[RRD_M_RPM].avg = sat16(tach.rpm);
+    s[RRD_M_DUTY].avg = pwm_is_enabled() ? sat16(pwm_get_percent_requested()) : 0U;
+    s[RRD_M_REJECTS].avg = sat16(rejects * (1000U / RRD_SAMPLE_MS));
+    s[RRD_M_BURST].avg = sat16(burst.pulses_per_burst);
+    for (uint32_t m = 0; m < RRD_M_COUNT; m++) {
+        s[m].min = s[m].avg;
+        s[m].max = s[m].avg;
+    }
+
+    rrd_feed(0U, s);
+}
+
+uint32_t rrd_count(rrd_res_t res)
+{
+    return (res < RRD_RES_COUNT) ? g_levels[res].count : 0U;
+}
+
+uint32_t rrd_capacity(rrd_res_t res)
+{
+    return (res < RRD_RES_COUNT) ? g_levels[res].len : 0U;
+}
+
+uint32_t rrd_res_seconds(rrd_res_t res)
+{
+    return (res < RRD_RES_COUNT) ? g_levels[res].seconds : 0U;
+}
+
+const char *rrd_res_name(rrd_res_t res)
+{
+    return (res < RRD_RES_COUNT) ? g_levels[res].name : "?";
+}
+
+const char *rrd_metric_name(rrd_metric_t m)
+{
+    return (m < RRD_M_COUNT) ? g_metric_names[m] : "?";
+}
+
+bool rrd_get(rrd_res_t res, uint32_t index, rrd_cell_t cells[RRD_M_COUNT])
+{
+    const rrd_level_t *l;
+    uint32_t slot;
+
+    if (res >= RRD_RES_COUNT) return false;
+    l = &g_levels[res];
+    if (index >= l->count) return false;
+
+    /* Oldest bucket sits at head once the ring is full, else at 0. */
+    slot = (l->head + l->len - l->count + index) % l->len;
+    memcpy(cells, l->ring[slot], sizeof(rrd_cell_t) * RRD_M_COUNT);
+    return true;
+}
+
+void rrd_clear(void)
+{
+    for (uint32_t lv = 0; lv < RRD_RES_COUNT; lv++) {
+        g_levels[lv].head = 0;
+        g_levels[lv].count = 0;
+        g_levels[lv].inputs = 0;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef RRD_H
+#define RRD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Round-robin history of the fan metrics in RAM (HISTORY command).
+ *
+ * rrd_task() samples RPM, duty, tach rejects and TSYN burst length every
+ * RRD_SAMPLE_MS and keeps min/max/avg per bucket at four resolutions:
+ *
+ *   1 s   x RRD_LEN_1S    (default 60:  the last minute)
+ *   10 s  x RRD_LEN_10S   (default 30:  5 minutes)
+ *   1 min x RRD_LEN_1M    (default 30:  30 minutes)
+ *   10 min x RRD_LEN_10M  (default 36:  6 hours)
+ *
+ * Each level consolidates the buckets of the one below as they close
+ * (min of mins, max of maxes, mean of means), so a sample costs O(1) and
+ * the memory is fixed: 24 bytes per bucket, ~3.7 KB with the defaults.
+ * Values are 16-bit and saturate (RPM above 65535 reads 65535).
+ */
+#ifndef RRD_SAMPLE_MS
+#define RRD_SAMPLE_MS   100U
+#endif
+#ifndef RRD_LEN_1S
+#define RRD_LEN_1S      60U
+#endif
+#ifndef RRD_LEN_10S
+#define RRD_LEN_10S     30U
+#endif
+#ifndef RRD_LEN_1M
+#define RRD_LEN_1M      30U
+#endif
+#ifndef RRD_LEN_10M
+#define RRD_LEN_10M     36U
+#endif
+
+typedef enum {
+    RRD_M_RPM = 0,
+    RRD_M_DUTY,         /* requested duty, % (0 while PWM is off) */
+    RRD_M_REJECTS,      /* tach glitch rejects per second */
+    RRD_M_BURST,        /* TSYN pulses per burst (0 while off) */
+    RRD_M_COUNT
+} rrd_metric_t;
+
+typedef enum {
+    RRD_RES_1S = 0,
+    RRD_RES_10S,
+    RRD_RES_1M,
+    RRD_RES_10M,
+    RRD_RES_COUNT
+} rrd_res_t;
+
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+    uint16_t avg;
+} rrd_cell_t;
+
+/* Scheduler task, period RRD_SAMPLE_MS. */
+void rrd_task(void);
+
+/* Buckets held / capacity at a resolution. */
+uint32_t rrd_count(rrd_res_t res);
+uint32_t rrd_capacity(rrd_res_t res);
+uint32_t rrd_res_seconds(rrd_res_t res);
+const char *rrd_res_name(rrd_res_t res);
+const char *rrd_metric_name(rrd_metric_t m);
+
+/* Bucket `index` (0 = oldest) of a resolution, one cell per metric. */
+bool rrd_get(rrd_res_t res, uint32_t index, rrd_cell_t cells[RRD_M_COUNT]);
+
+/* Drop all history. */
+void rrd_clear(void);
+
+#endif /* RRD_H */
@@ -0,0 +1,191 @@
+#include "sched.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/cpu.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/watchdog.h"
+
+#include "timebase.h"
+
+#define SCHED_LOAD_WINDOW_MS    1000U
+
+typedef struct {
+    const char *name;
+    sched_fn_t fn;
+    uint32_t period_ms;
+    uint32_t next_ms;
+    uint32_t runs;
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+} sched_task_t;
+
+static sched_task_t g_tasks[SCHED_MAX_TASKS];
+static uint32_t g_task_count = 0;
+
+static bool g_wdog_on = false;
+static bool g_wdog_reset = false;
+
+static volatile uint32_t g_load_pct = 0;
+
+static sched_idle_fn_t g_idle = 0;
+
+bool sched_add(const char *name, uint32_t period_ms, sched_fn_t fn)
+{
+    sched_task_t *t;
+
+    if (g_task_count >= SCHED_MAX_TASKS || fn == 0 || period_ms == 0U) {
+        return false;
+    }
+
+    t = &g_tasks[g_task_count++];
+    t->name = name;
+    t->fn = fn;
+    t->period_ms = period_ms;
+    t->next_ms = timebase_millis();
+    t->runs = 0;
+    t->last_cycles = 0;
+    t->max_cycles = 0;
+    return true;
+}
+
+void sched_set_idle(sched_idle_fn_t fn)
+{
+    g_idle = fn;
+}
+
+void sched_watchdog_init(uint32_t sysclk_hz)
+{
+    uint32_t cause = SysCtlResetCauseGet();
+
+    g_wdog_reset = (cause & SYSCTL_CAUSE_WDOG0) != 0U;
+    SysCtlResetCauseClear(cause);
+
+#if SCHED_WDOG_MS > 0
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_WDOG0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_WDOG0)) { }
+
+    /* The first time-out only flags the (unused) interrupt; the second one
+       resets, hence half the period. */
+    WatchdogReloadSet(WATCHDOG0_BASE, (sysclk_hz / 1000U) * (SCHED_WDOG_MS / 2U));
+    WatchdogResetEnable(WATCHDOG0_BASE);
+    /* Hold the count while a debugger has the core halted. */
+    WatchdogStallEnable(WATCHDOG0_BASE);
+    WatchdogEnable(WATCHDOG0_BASE);
+    g_wdog_on = true;
+#else
+    (void)sysclk_hz;
+#endif
+}
+
+void sched_watchdog_feed(void)
+{
+    if (g_wdog_on) {
+        /* Clearing the time-out reloads the counter. */
+        WatchdogIntClear(WATCHDOG0_BASE);
+    }
+}
+
+bool sched_watchdog_caused_reset(void)
+{
+    return g_wdog_reset;
+}
+
+void sched_run(void)
+{
+    uint32_t win_ms = timebase_millis();
+    uint32_t win_cyc = timebase_cycles32();
+    uint32_t idle_cyc = 0;
+
+    for (;;) {
+        uint32_t now = timebase_millis();
+        bool ran = false;
+
+        for (uint32_t i = 0; i < g_task_count; i++) {
+            sched_task_t *t = &g_tasks[i];
+            uint32_t c0;
+
+            if ((int32_t)(now - t->next_ms) < 0) {
+                continue;
+            }
+
+            c0 = timebase_cycles32();
+            t->fn();
+            t->last_cycles = timebase_cycles32() - c0;
+            if (t->last_cycles > t->max_cycles) {
+                t->max_cycles = t->last_cycles;
+            }
+            t->runs++;
+            ran = true;
+
+            /* Fixed rate; after an overrun, skip the missed periods. */
+            t->next_ms += t->period_ms;
+            if ((int32_t)(now - t->next_ms) >= 0) {
+                t->next_ms = now + t->period_ms;
+            }
+        }
+
+        sched_watchdog_feed();
+
+        if ((uint32_t)(now - win_ms) >= SCHED_LOAD_WINDOW_MS) {
+            uint32_t cyc = timebase_cycles32();
+            uint32_t total = cyc - win_cyc;
+
+            g_load_pct = (total == 0U) ? 0U :
+                (uint32_t)(100U - (uint32_t)(((uint64_t)idle_cyc * 100U) / total));
+            win_ms = now;
+            win_cyc = cyc;
+            idle_cyc = 0;
+        }
+
+        /* Idle work counts as load, not sleep. */
+        if (!ran && g_idle != 0 && g_idle()) {
+            ran = true;
+        }
+
+#if SCHED_USE_WFI
+        if (!ran) {
+            uint32_t c0 = timebase_cycles32();
+            /* An interrupt that lands just before this only delays the
+               tasks it makes due until the next SysTick (1 ms). */
+            CPUwfi();
+            idle_cyc += timebase_cycles32() - c0;
+        }
+#else
+        (void)ran;
+#endif
+    }
+}
+
+uint32_t sched_task_count(void)
+{
+    return g_task_count;
+}
+
+bool sched_get_task(uint32_t index, sched_task_info_t *out)
+{
+    const sched_task_t *t;
+    uint32_t mhz = timebase_sysclk_hz() / 1000000U;
+
+    if (index >= g_task_count || out == 0) {
+        return false;
+    }
+    if (mhz == 0U) {
+        mhz = 1U;
+    }
+
+    t = &g_tasks[index];
+    out->name = t->name;
+    out->period_ms = t->period_ms;
+    out->runs = t->runs;
+    out->last_us = t->last_cycles / mhz;
+    out->max_us = t->max_cycles / mhz;
+    return true;
+}
+
+uint32_t sched_cpu_load_pct(void)
+{
+    return g_load_pct;
+}
@@ -0,0 +1,70 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Cooperative run-to-completion scheduler for the main loop.
+ *
+ * Each task is a plain function called every period_ms (SysTick
+ * milliseconds). Tasks must return quickly; anything that waits keeps its
+ * own state and checks again on the next call. When nothing is due the
+ * core sleeps (WFI) until the next interrupt, at the latest the next
+ * SysTick, and the time asleep gives the CPU load.
+ *
+ * The watchdog (Watchdog 0) is fed once per scheduler pass, so a task that
+ * hangs resets the unit. Code that legitimately blocks for longer (firmware
+ * transfer) calls sched_watchdog_feed() itself.
+ */
+
+#ifndef SCHED_MAX_TASKS
+#define SCHED_MAX_TASKS     16U
+#endif
+
+/* Reset after this long without a scheduler pass; 0 leaves the watchdog off.
+   Generous because DEBUG ON dumps run at 9600 baud from the session task. */
+#ifndef SCHED_WDOG_MS
+#define SCHED_WDOG_MS       4000U
+#endif
+
+/* Core sleep while idle; 0 busy-polls (e.g. if WFI upsets a debug probe). */
+#ifndef SCHED_USE_WFI
+#define SCHED_USE_WFI       1
+#endif
+
+typedef void (*sched_fn_t)(void);
+
+/* Idle work; returns true if it did something (then the core stays awake). */
+typedef bool (*sched_idle_fn_t)(void);
+
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    uint32_t runs;
+    uint32_t last_us;
+    uint32_t max_us;
+} sched_task_info_t;
+
+/* Register a task (before sched_run()); false if the table is full. */
+bool sched_add(const char *name, uint32_t period_ms, sched_fn_t fn);
+
+/* Called on a pass where no task was due, before the core sleeps. Meant for
+   slow housekeeping that may run late (flash sector erase). One hook. */
+void sched_set_idle(sched_idle_fn_t fn);
+
+/* Start Watchdog 0 (SCHED_WDOG_MS) and note whether it caused this reset. */
+void sched_watchdog_init(uint32_t sysclk_hz);
+void sched_watchdog_feed(void);
+bool sched_watchdog_caused_reset(void);
+
+/* Run the task table forever. */
+void sched_run(void);
+
+uint32_t sched_task_count(void);
+bool sched_get_task(uint32_t index, sched_task_info_t *out);
+
+/* Percent of the last full second spent outside WFI. */
+uint32_t sched_cpu_load_pct(void);
+
+#endif /* SCHED_H */
@@ -0,0 +1,60 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "atomic.h"
+
+/*
+ * Sequence lock: one writer publishes a multi-word snapshot, readers copy it
+ * and retry if it changed under them. Neither side masks interrupts.
+ *
+ *   writer (e.g. an ISR):          reader:
+ *     seqlock_write_begin(&l);       uint32_t s;
+ *     g_a = ...; g_b = ...;          do {
+ *     seqlock_write_end(&l);             s = seqlock_read_begin(&l);
+ *                                        a = g_a; b = g_b;
+ *                                    } while (seqlock_read_retry(&l, s));
+ *
+ * The count is odd while a write is in progress. Rules:
+ * - One writer per lock (or writers that cannot preempt each other).
+ * - A reader must not be able to preempt the writer: an ISR that reads
+ *   needs a priority no higher than the writing ISR, otherwise it would
+ *   retry forever on a half-written snapshot. Main-context readers are
+ *   always fine.
+ */
+
+typedef struct {
+    volatile uint32_t seq;
+} seqlock_t;
+
+#define SEQLOCK_INIT    { 0U }
+
+static inline void seqlock_write_begin(seqlock_t *l)
+{
+    l->seq++;
+    atomic_barrier();
+}
+
+static inline void seqlock_write_end(seqlock_t *l)
+{
+    atomic_barrier();
+    l->seq++;
+}
+
+static inline uint32_t seqlock_read_begin(const seqlock_t *l)
+{
+    uint32_t s = l->seq;
+    atomic_barrier();
+    return s;
+}
+
+/* True if the copy taken since seqlock_read_begin() is torn. */
+static inline bool seqlock_read_retry(const seqlock_t *l, uint32_t start)
+{
+    atomic_barrier();
+    return (start & 1U) != 0U || l->seq != start;
+}
+
+#endif /* SEQLOCK_H */
@@ -0,0 +1,295 @@
+#include "speedctl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "commands.h"       /* pwm_set_percent(), pwm_set_enabled(), PSYN_MIN/MAX */
+#include "config_store.h"
+#include "steptest.h"
+#include "sweep.h"
+#include "tach.h"
+#include "tsyn.h"
+
+/* Config store record: points sorted by duty, RPM strictly rising. */
+typedef struct {
+    uint8_t count;
+    uint8_t reserved[3];
+    uint8_t duty[SPEED_MAP_MAX];
+    uint16_t rpm[SPEED_MAP_MAX];
+} speed_map_rec_t;
+
+static speed_map_rec_t g_map;
+
+/* Dense feed-forward table: entry i is the duty for i * g_ff_step rpm. */
+static uint16_t g_ff[SPEED_FF_LEN];
+static uint32_t g_ff_step = 0;
+
+/* Written by the RPM command and the Modbus ISR; the task follows it. */
+static volatile uint32_t g_setpoint = 0;
+static uint32_t g_active = 0;       /* setpoint the task last acted on */
+static bool g_map_changed = false;
+static int32_t g_ff_q8 = 0;
+static int32_t g_trim_q8 = 0;
+static uint32_t g_duty = 0;
+static uint32_t g_rpm = 0;
+static bool g_paused = false;
+
+/* ---- Feed-forward -------------------------------------------------------- */
+
+/*
+ * Fritsch-Carlson slopes for the monotone cubic through (rpm, duty): the
+ * mean of the neighbouring secants (0 at a local extremum), limited to 3x
+ * each adjacent secant, the sufficient condition for no overshoot.
+ * Fixed point like the rest of the control path: slopes are duty in 1/256 %
+ * per RPM, scaled by 2^16.
+ */
+static void ff_slopes(const int32_t *x, const int32_t *y, uint32_t n, int64_t *m)
+{
+    int64_t d[SPEED_MAP_MAX];
+
+    for (uint32_t k = 0; k + 1U < n; k++) {
+        d[k] = ((int64_t)(y[k + 1U] - y[k]) * 65536) / (x[k + 1U] - x[k]);
+    }
+    m[0] = d[0];
+    m[n - 1U] = d[n - 2U];
+    for (uint32_t k = 1; k + 1U < n; k++) {
+        bool extremum = (d[k - 1U] <= 0) != (d[k] <= 0) || d[k - 1U] == 0 || d[k] == 0;
+
+        m[k] = extremum ? 0 : (d[k - 1U] + d[k]) / 2;
+    }
+    for (uint32_t k = 0; k + 1U < n; k++) {
+        if (d[k] == 0) {
+            m[k] = 0;
+            m[k + 1U] = 0;
+            continue;
+        }
+        if (m[k] > 3 * d[k]) m[k] = 3 * d[k];
+        if (m[k + 1U] > 3 * d[k]) m[k + 1U] = 3 * d[k];
+    }
+}
+
+/* Sample the cubic into g_ff (off the control path: on a map change only). */
+static void ff_build(void)
+{
+    int32_t x[SPEED_MAP_MAX];
+    int32_t y[SPEED_MAP_MAX];      /* duty, 1/256 % */
+    int64_t m[SPEED_MAP_MAX];
+    uint32_t n = g_map.count;
+    uint32_t k = 0;
+
+    if (n == 0U) {
+        g_ff_step = 0;
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = g_map.rpm[i];
+        y[i] = (int32_t)g_map.duty[i] * 256;
+    }
+    if (n >= 2U) {
+        ff_slopes(x, y, n, m);
+    }
+
+    g_ff_step = (g_map.rpm[n - 1U] + SPEED_FF_LEN - 2U) / (SPEED_FF_LEN - 1U);
+    if (g_ff_step == 0U) g_ff_step = 1;
+
+    for (uint32_t i = 0; i < SPEED_FF_LEN; i++) {
+        int32_t xi = (int32_t)(i * g_ff_step);
+        int64_t yi;
+
+        if (n == 1U || xi <= x[0]) {
+            yi = y[0];
+        } else if (xi >= x[n - 1U]) {
+            yi = y[n - 1U];
+        } else {
+            int64_t h, t, t2, t3, hm0, hm1;
+
+            while (xi > x[k + 1U]) k++;
+            /* Hermite basis with t in Q16; h * m is duty (1/256 %) in Q16. */
+            h = x[k + 1U] - x[k];
+            t = ((int64_t)(xi - x[k]) * 65536) / h;
+            t2 = (t * t) >> 16;
+            t3 = (t2 * t) >> 16;
+            hm0 = h * m[k];
+            hm1 = h * m[k + 1U];
+            yi = (2 * t3 - 3 * t2 + 65536) * y[k] + ((t3 - 2 * t2 + t) * hm0 >> 16) +
+                 (-2 * t3 + 3 * t2) * y[k + 1U] + ((t3 - t2) * hm1 >> 16);
+            yi = (yi + 32768) >> 16;
+        }
+        if (yi < 0) yi = 0;
+        if (yi > 0xFFFF) yi = 0xFFFF;
+        g_ff[i] = (uint16_t)yi;
+    }
+}
+
+int32_t speedctl_ff_q8(uint32_t rpm)
+{
+    uint32_t i;
+
+    if (g_ff_step == 0U) return -1;
+    i = (rpm + g_ff_step / 2U) / g_ff_step;
+    if (i >= SPEED_FF_LEN) i = SPEED_FF_LEN - 1U;
+    return g_ff[i];
+}
+
+/* ---- Control ------------------------------------------------------------- */
+
+static void apply(int32_t duty_q8)
+{
+    uint32_t pct;
+
+    if (duty_q8 < (int32_t)PSYN_MIN * 256) duty_q8 = (int32_t)PSYN_MIN * 256;
+    if (duty_q8 > (int32_t)PSYN_MAX * 256) duty_q8 = (int32_t)PSYN_MAX * 256;
+    pct = ((uint32_t)duty_q8 + 128U) >> 8;
+    g_duty = pct;
+    /* A manual duty may have turned the loop off meanwhile. */
+    if (g_setpoint != 0U && pct != pwm_get_percent_requested()) {
+        pwm_set_percent(pct);
+    }
+}
+
+void speedctl_task(void)
+{
+    const int32_t trim_max = SPEED_TRIM_MAX_PCT * 256;
+    uint32_t sp = g_setpoint;
+    tach_snapshot_t t;
+    int32_t e;
+    int32_t p;
+    int32_t out;
+
+    g_paused = sweep_is_running() || steptest_is_running();
+    if (sp == 0U || g_paused) {
+        g_active = 0;
+        return;
+    }
+
+    if (g_active == 0U) {
+        /* Loop engaged: without a map, start from the duty in use. */
+        g_ff_q8 = (int32_t)(pwm_get_percent_requested() * 256U);
+        g_trim_q8 = 0;
+        if (!pwm_is_enabled()) {
+            pwm_set_enabled(true);
+        }
+    }
+    if (sp != g_active || g_map_changed) {
+        int32_t ff = speedctl_ff_q8(sp);
+
+        g_active = sp;
+        g_map_changed = false;
+        if (ff >= 0) {
+            /* The map gives the new operating point; the old trim does not apply. */
+            g_ff_q8 = ff;
+            g_trim_q8 = 0;
+        }
+    }
+
+    if (tsyn_is_enabled()) {
+        /* TSYN owns the tach pin: feed-forward and the held trim only. */
+        apply(g_ff_q8 + g_trim_q8);
+        return;
+    }
+
+    tach_get_snapshot(&t);
+    g_rpm = t.rpm;
+    e = (int32_t)sp - (int32_t)t.rpm;
+    p = (int32_t)(((int64_t)e * SPEED_KP_Q16) >> 8);
+    out = g_ff_q8 + p + g_trim_q8;
+
+    /* Integrate unless the output is pinned at a limit in the same direction. */
+    if (!((out >= (int32_t)PSYN_MAX * 256 && e > 0) || (out <= (int32_t)PSYN_MIN * 256 && e < 0))) {
+        g_trim_q8 += (int32_t)(((int64_t)e * SPEED_KI_Q16 * (int32_t)SPEED_CTL_MS / 1000) >> 8);
+        if (g_trim_q8 > trim_max) g_trim_q8 = trim_max;
+        if (g_trim_q8 < -trim_max) g_trim_q8 = -trim_max;
+    }
+
+    apply(g_ff_q8 + p + g_trim_q8);
+}
+
+void speedctl_set_rpm(uint32_t rpm)
+{
+    g_setpoint = (rpm > 0xFFFFU) ? 0xFFFFU : rpm;
+}
+
+uint32_t speedctl_get_rpm(void)
+{
+    return g_setpoint;
+}
+
+void speedctl_get_status(speedctl_status_t *st)
+{
+    st->setpoint = g_setpoint;
+    st->paused = g_paused;
+    st->rpm = g_rpm;
+    st->ff_q8 = g_ff_q8;
+    st->trim_q8 = g_trim_q8;
+    st->duty = g_duty;
+    st->map_points = g_map.count;
+    st->ff_step_rpm = g_ff_step;
+}
+
+/* ---- Map ----------------------------------------------------------------- */
+
+uint32_t speedctl_map_load_sweep(void)
+{
+    speed_map_rec_t map;
+    sweep_point_t pts[SWEEP_MAX_POINTS];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; n < SWEEP_MAX_POINTS && sweep_get(i, &pts[n]); i++) {
+        if (!pts[n].timeout && pts[n].rpm != 0U) {
+            n++;
+        }
+    }
+
+    /* By duty (a sweep may run downwards), insertion sort. */
+    for (uint32_t i = 1; i < n; i++) {
+        sweep_point_t v = pts[i];
+        uint32_t j = i;
+
+        while (j > 0U && pts[j - 1U].duty > v.duty) {
+            pts[j] = pts[j - 1U];
+            j--;
+        }
+        pts[j] = v;
+    }
+
+    /* Keep RPM strictly rising so duty(rpm) is a function. */
+    memset(&map, 0, sizeof(map));
+    for (uint32_t i = 0; i < n && map.count < SPEED_MAP_MAX; i++) {
+        if (map.count != 0U && pts[i].rpm <= map.rpm[map.count - 1U]) continue;
+        map.duty[map.count] = pts[i].duty;
+        map.rpm[map.count] = (uint16_t)((pts[i].rpm > 0xFFFFU) ? 0xFFFFU : pts[i].rpm);
+        map.count++;
+    }
+    if (map.count == 0U) return 0;
+
+    g_map = map;
+    ff_build();
+    g_map_changed = true;
+    (void)config_store_write(CONFIG_REC_SPEEDMAP, &g_map, sizeof(g_map));
+    return g_map.count;
+}
+
+void speedctl_map_clear(void)
+{
+    memset(&g_map, 0, sizeof(g_map));
+    ff_build();
+    g_map_changed = true;
+    config_store_erase(CONFIG_REC_SPEEDMAP);
+}
+
+bool speedctl_map_get(uint32_t index, speed_point_t *p)
+{
+    if (index >= g_map.count) return false;
+    p->duty = g_map.duty[index];
+    p->rpm = g_map.rpm[index];
+    return true;
+}
+
+void speedctl_init(void)
+{
+    if (!config_store_read(CONFIG_REC_SPEEDMAP, &g_map, sizeof(g_map)) || g_map.count > SPEED_MAP_MAX) {
+        memset(&g_map, 0, sizeof(g_map));
+    }
+    ff_build();
+}
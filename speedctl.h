@@ -0,0 +1,82 @@
+#ifndef SPEEDCTL_H
+#define SPEEDCTL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * RPM speed control (RPM command, Modbus holding register 2).
+ *
+ * duty = feed-forward(setpoint) + PI trim on the tach RPM.
+ *
+ * The feed-forward comes from a duty -> RPM characterization map (up to
+ * SPEED_MAP_MAX points, normally copied from the last SWEEP with RPM MAP
+ * LOAD and kept in the config store). When the map changes, a monotone
+ * cubic (Fritsch-Carlson) through its points is sampled into a dense table
+ * of SPEED_FF_LEN duties over 0..max RPM, so the lookup on a setpoint change
+ * is one index. A setpoint change then lands close to the target in one
+ * step and the PI only trims the rest; without a map the PI works from the
+ * duty the loop started with.
+ *
+ * Any manual duty (PSYN, Modbus duty/enable) turns the loop off. It pauses
+ * while a SWEEP or STEP runs and holds its trim while TSYN is on (no tach).
+ * The gains are in 1/65536 % duty per RPM (and per RPM-second); set them
+ * from STEP measurements of the fan.
+ */
+#ifndef SPEED_CTL_MS
+#define SPEED_CTL_MS        100U
+#endif
+#ifndef SPEED_KP_Q16
+#define SPEED_KP_Q16        819     /* 0.0125 % per rpm */
+#endif
+#ifndef SPEED_KI_Q16
+#define SPEED_KI_Q16        1311    /* 0.02 % per rpm per second */
+#endif
+#ifndef SPEED_TRIM_MAX_PCT
+#define SPEED_TRIM_MAX_PCT  20
+#endif
+#define SPEED_MAP_MAX       16U
+#ifndef SPEED_FF_LEN
+#define SPEED_FF_LEN        128U
+#endif
+
+typedef struct {
+    uint8_t duty;
+    uint16_t rpm;
+} speed_point_t;
+
+typedef struct {
+    uint32_t setpoint;          /* 0 = loop off */
+    bool paused;                /* SWEEP or STEP running */
+    uint32_t rpm;
+    int32_t ff_q8;              /* duty %, 1/256 units */
+    int32_t trim_q8;
+    uint32_t duty;              /* last duty applied */
+    uint32_t map_points;
+    uint32_t ff_step_rpm;       /* RPM per dense table entry; 0 without a map */
+} speedctl_status_t;
+
+/* Load the map from the config store. After config_store_init(). */
+void speedctl_init(void);
+
+/* Scheduler task, period SPEED_CTL_MS. */
+void speedctl_task(void);
+
+/* New setpoint in RPM (0 turns the loop off); the task enables PWM when the
+   loop engages. Safe to call from interrupt handlers (Modbus). */
+void speedctl_set_rpm(uint32_t rpm);
+uint32_t speedctl_get_rpm(void);
+
+void speedctl_get_status(speedctl_status_t *st);
+
+/* Replace the map with the settled SWEEP points and save it. Returns the
+   points kept (RPM must rise with duty); 0 leaves the map unchanged. */
+uint32_t speedctl_map_load_sweep(void);
+void speedctl_map_clear(void);
+bool speedctl_map_get(uint32_t index, speed_point_t *p);
+
+/* Feed-forward duty for an RPM from the dense table (percent, 1/256 units),
+   or -1 without a map. */
+int32_t speedctl_ff_q8(uint32_t rpm);
+
+#endif /* SPEEDCTL_H */
@@ -0,0 +1,235 @@
+#include "sspwm.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_pwm.h"
+#include "inc/hw_types.h"
+
+#include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
+
+#include "commands.h"       /* pwm_get_percent_requested() */
+#include "irq_prio.h"
+
+#define SSPWM_GEN (PWM0_BASE + PWM_GEN_1)
+
+#if (SSPWM_TABLE_LEN & (SSPWM_TABLE_LEN - 1U)) != 0
+#error "SSPWM_TABLE_LEN must be a power of two"
+#endif
+
+/* One dither cycle of LOAD | CMPA << 16 register pairs. */
+typedef struct {
+    uint32_t pair[SSPWM_TABLE_LEN];
+    uint32_t period_min;
+    uint32_t period_max;
+} sspwm_table_t;
+
+/* Double buffered: sspwm_rebuild() fills the idle table and then switches
+   g_table with one store, so the ISR never sees a half-built table. */
+static sspwm_table_t g_tables[2];
+static sspwm_table_t *volatile g_table = &g_tables[0];
+
+static uint32_t g_period_nom = 0;
+static volatile sspwm_mode_t g_mode = SSPWM_OFF;        /* what the ISR runs */
+static volatile sspwm_mode_t g_req_mode = SSPWM_OFF;    /* what was asked for */
+static volatile uint32_t g_span_pct = SSPWM_DEFAULT_SPAN_PCT;
+
+/* ISR state. */
+static uint32_t g_idx = 0;
+static uint32_t g_rand = 0x2545F491U;
+static volatile uint32_t g_updates = 0;
+
+/* Register pairs of the period in progress and of the one latched next,
+   each published with a single store. */
+static volatile uint32_t g_cur_pair = 0;
+static volatile uint32_t g_next_pair = 0;
+
+/* Same rounding as set_pwm_percent() in main.c (the period fits 16 bits,
+   so the product fits 32). */
+static uint32_t pulse_for(uint32_t period, uint32_t percent)
+{
+    uint32_t pulse;
+
+    if (percent > 100U) percent = 100U;
+    pulse = (period * percent) / 100U;
+    if (pulse >= period) pulse = period - 1U;
+    if (pulse == 0U) pulse = 1U;
+    return pulse;
+}
+
+/* Down count: LOAD = period - 1, CMPA = LOAD - pulse (PWMGenPeriodSet(),
+   PWMPulseWidthSet()). */
+static uint32_t pair_for(uint32_t period, uint32_t percent)
+{
+    uint32_t load = period - 1U;
+
+    return load | ((load - pulse_for(period, percent)) << 16);
+}
+
+static uint32_t xorshift32(void)
+{
+    uint32_t x = g_rand;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g_rand = x;
+    return x;
+}
+
+/* PWM0 generator 1 counter zero: write the next period's pair. */
+void PWM0Gen1IntHandler(void)
+{
+    const sspwm_table_t *t = g_table;
+    uint32_t pair;
+
+    if (g_mode == SSPWM_TRI) {
+        g_idx = (g_idx + 1U) & (SSPWM_TABLE_LEN - 1U);
+        pair = t->pair[g_idx];
+    } else {
+        pair = t->pair[xorshift32() & (SSPWM_TABLE_LEN - 1U)];
+    }
+
+    /* Both latch at the next zero: the period and its pulse change together. */
+    HWREG(SSPWM_GEN + PWM_O_X_LOAD) = pair & 0xFFFFU;
+    HWREG(SSPWM_GEN + PWM_O_X_CMPA) = pair >> 16;
+
+    /* Shift before the clear: while the zero is still flagged, g_next_pair
+       is the pair in effect. */
+    g_cur_pair = g_next_pair;
+    HWREG(SSPWM_GEN + PWM_O_X_ISC) = PWM_INT_CNT_ZERO;
+    g_next_pair = pair;
+    g_updates++;
+}
+
+/*
+ * Fill the idle table for the requested mode, span and the current duty,
+ * then switch to it; start the ISR if it is not running yet. Deferred work
+ * (IRQ_DEFER_SSPWM): every rebuild runs in PendSV, so two never overlap.
+ */
+static void sspwm_rebuild(void)
+{
+    sspwm_mode_t mode = g_req_mode;
+    sspwm_table_t *t = (g_table == &g_tables[0]) ? &g_tables[1] : &g_tables[0];
+    uint32_t percent = pwm_get_percent_requested();
+    int32_t span;
+
+    if (mode == SSPWM_OFF) return;
+
+    span = (int32_t)(g_period_nom * g_span_pct / 100U);
+    if (span == 0) span = 1;
+    /* The 16-bit LOAD register bounds the longest period. */
+    if (g_period_nom + (uint32_t)span > 0xFFFFU) span = (int32_t)(0xFFFFU - g_period_nom);
+
+    t->period_min = g_period_nom;
+    t->period_max = g_period_nom;
+    for (uint32_t i = 0; i < SSPWM_TABLE_LEN; i++) {
+        const int32_t n = (int32_t)SSPWM_TABLE_LEN;
+        int32_t k = (int32_t)i;
+        int32_t offset;
+        uint32_t period;
+
+        if (mode == SSPWM_TRI) {
+            /* One triangle, -span up to +span and back, per table. */
+            offset = (k < n / 2) ? -span + (4 * span * k) / n
+                                 : span - (4 * span * (k - n / 2)) / n;
+        } else {
+            /* Evenly spread over the band; the ISR picks them at random. */
+            offset = -span + (2 * span * k) / (n - 1);
+        }
+        period = (uint32_t)((int32_t)g_period_nom + offset);
+        t->pair[i] = pair_for(period, percent);
+        if (period < t->period_min) t->period_min = period;
+        if (period > t->period_max) t->period_max = period;
+    }
+    g_table = t;
+
+    if (g_mode != mode) {
+        uint32_t regs = HWREG(SSPWM_GEN + PWM_O_X_LOAD) | (HWREG(SSPWM_GEN + PWM_O_X_CMPA) << 16);
+
+        /* With the ISR off, a flagged zero means the registers have
+           latched; otherwise the ISR's last g_cur_pair is still running. */
+        if (HWREG(SSPWM_GEN + PWM_O_X_RIS) & PWM_INT_CNT_ZERO) {
+            g_cur_pair = regs;
+        }
+        g_next_pair = regs;
+        g_idx = 0;
+        g_updates = 0;
+        g_mode = mode;
+        HWREG(SSPWM_GEN + PWM_O_X_ISC) = PWM_INT_CNT_ZERO;
+        IntEnable(INT_PWM0_1);
+    }
+}
+
+bool sspwm_set_mode(sspwm_mode_t mode, uint32_t span_pct)
+{
+    if (mode != SSPWM_OFF && (span_pct == 0U || span_pct > SSPWM_MAX_SPAN_PCT)) {
+        return false;
+    }
+
+    g_req_mode = mode;
+    if (mode == SSPWM_OFF) {
+        IntDisable(INT_PWM0_1);
+        g_mode = SSPWM_OFF;
+        PWMGenPeriodSet(PWM0_BASE, PWM_GEN_1, g_period_nom);
+        PWMPulseWidthSet(PWM0_BASE, PWM_OUT_2, pulse_for(g_period_nom, pwm_get_percent_requested()));
+        /* Latches at the next zero. */
+        g_next_pair = pair_for(g_period_nom, pwm_get_percent_requested());
+        return true;
+    }
+
+    /* Start, or restart from a new table on a mode or span change. */
+    IntDisable(INT_PWM0_1);
+    g_mode = SSPWM_OFF;
+    g_span_pct = span_pct;
+    irq_defer_post(IRQ_DEFER_SSPWM);
+    return true;
+}
+
+void sspwm_set_percent(uint32_t percent)
+{
+    (void)percent;      /* sspwm_rebuild() reads pwm_get_percent_requested() */
+    if (g_req_mode != SSPWM_OFF) {
+        irq_defer_post(IRQ_DEFER_SSPWM);
+    }
+}
+
+bool sspwm_is_enabled(void)
+{
+    return g_req_mode != SSPWM_OFF;
+}
+
+bool sspwm_get_pairs(uint32_t *cur, uint32_t *next)
+{
+    *cur = g_cur_pair;
+    *next = g_next_pair;
+    return g_mode != SSPWM_OFF;
+}
+
+void sspwm_get_stats(sspwm_stats_t *st)
+{
+    const sspwm_table_t *t = g_table;
+
+    st->mode = g_req_mode;
+    st->span_pct = g_span_pct;
+    st->period_nom = g_period_nom;
+    st->period_min = (g_mode != SSPWM_OFF) ? t->period_min : g_period_nom;
+    st->period_max = (g_mode != SSPWM_OFF) ? t->period_max : g_period_nom;
+    st->updates = g_updates;
+}
+
+void sspwm_init(uint32_t period_nom)
+{
+    g_period_nom = period_nom;
+
+    /* Registered at boot, like TSYN's timer: IntRegister() may move the
+       vector table to SRAM. The interrupt stays off until SSPWM TRI/RAND. */
+    IntRegister(INT_PWM0_1, PWM0Gen1IntHandler);
+    IntDisable(INT_PWM0_1);
+    PWMGenIntTrigEnable(PWM0_BASE, PWM_GEN_1, PWM_INT_CNT_ZERO);
+    PWMIntEnable(PWM0_BASE, PWM_INT_GEN_1);
+    irq_defer_register(IRQ_DEFER_SSPWM, sspwm_rebuild);
+}
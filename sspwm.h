@@ -0,0 +1,78 @@
+#ifndef SSPWM_H
+#define SSPWM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Spread-spectrum PWM on PF2 (SSPWM command).
+ *
+ * The fixed 21.5 kHz carrier couples into the tach line as a comb of
+ * glitches at one frequency (the phantom ~1,000,000 RPM readings of the tach
+ * notes). Dithering the PWM period within +/-span% spreads that energy over
+ * a band, so fewer glitches line up with the tach filter.
+ *
+ *   TRI   triangular sweep of the period over the band, one full triangle
+ *         every SSPWM_TABLE_LEN PWM periods
+ *   RAND  a new pseudo-random period every PWM period, one of
+ *         SSPWM_TABLE_LEN spread evenly over the band
+ *
+ * The duty ratio is kept: each period's pulse is scaled from the requested
+ * percent. The LOAD/CMPA pairs of one dither cycle (SSPWM_TABLE_LEN periods)
+ * are precomputed outside the ISR, double buffered, and rebuilt as PendSV
+ * deferred work on a duty, mode or span change. PWM0 generator 1 latches
+ * LOAD and CMPA at counter zero, so PWM0Gen1IntHandler(), on the zero event,
+ * only picks the next pair (TRI: in order, RAND: an xorshift32() index) and
+ * writes both registers; they take effect together at the period boundary.
+ * It runs at IRQ_PRIO_PWM, below the tach capture.
+ */
+#ifndef SSPWM_DEFAULT_SPAN_PCT
+#define SSPWM_DEFAULT_SPAN_PCT  5U
+#endif
+#define SSPWM_MAX_SPAN_PCT      10U
+/* One triangle (TRI), or the periods RAND picks from. A power of two. */
+#ifndef SSPWM_TABLE_LEN
+#define SSPWM_TABLE_LEN         64U
+#endif
+
+typedef enum {
+    SSPWM_OFF = 0,
+    SSPWM_TRI,
+    SSPWM_RAND,
+} sspwm_mode_t;
+
+typedef struct {
+    sspwm_mode_t mode;
+    uint32_t span_pct;
+    uint32_t period_nom;        /* PWM clocks */
+    uint32_t period_min;        /* band of the active table */
+    uint32_t period_max;
+    uint32_t updates;
+} sspwm_stats_t;
+
+/* After the PWM generator is set up, with its nominal period in clocks. */
+void sspwm_init(uint32_t period_nom);
+
+/* Start dithering (span 1..SSPWM_MAX_SPAN_PCT) or, with SSPWM_OFF, return to
+   the nominal period. False if span is out of range. */
+bool sspwm_set_mode(sspwm_mode_t mode, uint32_t span_pct);
+
+/* Duty change while dithering: rebuild the table. From any context
+   (pwm_set_percent(), including the Modbus ISR). */
+void sspwm_set_percent(uint32_t percent);
+
+bool sspwm_is_enabled(void);
+
+/* LOAD | CMPA << 16 register pairs: cur for the PWM period in progress and
+   next for the one written for the next period (latched at the next zero;
+   until the ISR has handled that zero, next is in effect). Each is published
+   with one store, so a pair is never mixed. True while dithering; while off
+   the registers are in effect and these are the last pairs (for the period
+   still running when SSPWM was turned off). */
+bool sspwm_get_pairs(uint32_t *cur, uint32_t *next);
+
+void sspwm_get_stats(sspwm_stats_t *st);
+
+void PWM0Gen1IntHandler(void);
+
+#endif /* SSPWM_H */
@@ -0,0 +1,393 @@
+#include "steptest.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "commands.h"       /* pwm_set_percent(), pwm_set_enabled(), PSYN_MIN/MAX */
+#include "modbus.h"
+#include "sweep.h"
+#include "tach.h"
+#include "timebase.h"
+#include "tsyn.h"
+
+/* Samples in the baseline and final-value windows (1 s). */
+#define STEP_WIN            (1000U / STEP_SAMPLE_MS)
+
+typedef enum {
+    STEP_PHASE_HOLD = 0,        /* at `from`, baseline in the last second */
+    STEP_PHASE_TRACE,           /* at `to`, recording */
+} step_phase_t;
+
+static console_t *g_con = 0;
+static uint32_t g_from = 0;
+static uint32_t g_to = 0;
+static uint32_t g_reps = 0;
+static uint32_t g_hold_n = 0;       /* samples per phase */
+static step_phase_t g_phase = STEP_PHASE_HOLD;
+static uint32_t g_n = 0;
+
+/* Baseline window. */
+static uint32_t g_base_sum = 0;
+static uint64_t g_base_sumsq = 0;
+static uint32_t g_base_pulses = 0;
+
+/* From the step on. */
+static uint32_t g_t0_ms = 0;
+static uint32_t g_rpm0 = 0;
+static uint64_t g_band0 = 0;        /* squared: 3 sd or 1% of the baseline */
+static bool g_have_dead = false;
+static uint32_t g_dead_ms = 0;
+static uint16_t g_trace_rpm[STEP_TRACE_LEN];
+static uint8_t g_trace_pulses[STEP_TRACE_LEN];
+
+static uint32_t g_saved_duty = 0;
+static bool g_saved_enabled = false;
+
+static step_result_t g_results[STEP_MAX_REPS];
+static uint32_t g_count = 0;
+
+/* Fields summarized by steptest_summary(), in column order. */
+static const uint8_t g_fields[] = {
+    offsetof(step_result_t, rpm0),
+    offsetof(step_result_t, rpm1),
+    offsetof(step_result_t, dead_ms),
+    offsetof(step_result_t, rise_ms),
+    offsetof(step_result_t, over_pct),
+    offsetof(step_result_t, settle_ms),
+    offsetof(step_result_t, pulses0),
+    offsetof(step_result_t, pulses1),
+    offsetof(step_result_t, burst_dead_ms),
+    offsetof(step_result_t, burst_settle_ms),
+};
+#define STEP_FIELDS     (sizeof(g_fields) / sizeof(g_fields[0]))
+
+/* Column widths of g_fields in the rows. */
+static const uint8_t g_widths[STEP_FIELDS] = { 6, 6, 6, 6, 6, 8, 4, 4, 7, 8 };
+
+static uint32_t *field(step_result_t *r, uint32_t f)
+{
+    return (uint32_t *)((uint8_t *)r + g_fields[f]);
+}
+
+static uint64_t sq(int32_t v)
+{
+    return (uint64_t)((int64_t)v * v);
+}
+
+/* ---- Output -------------------------------------------------------------- */
+
+const char *steptest_header(void)
+{
+    return "  rep  rpm0  rpm1  dead  rise over%  settle  p0  p1  bdead bsettle\r\n";
+}
+
+void steptest_format_row(char *dst, const char *label, const step_result_t *r)
+{
+    uint32_t len = (uint32_t)strlen(label);
+
+    if (len > 5U) len = 5U;
+    memset(dst, ' ', 5U - len);
+    memcpy(dst + (5U - len), label, len);
+    dst += 5;
+    for (uint32_t f = 0; f < STEP_FIELDS; f++) {
+        dst = console_put_col(dst, *field((step_result_t *)r, f), g_widths[f]);
+    }
+    if (r->no_response) {
+        memcpy(dst, " no response", 12);
+        dst += 12;
+    }
+    memcpy(dst, "\r\n", 3);
+}
+
+/* ---- Analysis ------------------------------------------------------------ */
+
+/*
+ * Sample i of the trace was taken (i + 1) sample periods after the step, so
+ * times below are (i + 1) * STEP_SAMPLE_MS.
+ */
+static void analyze(step_result_t *r)
+{
+    const uint32_t n = g_hold_n;
+    const uint32_t k = (n < STEP_WIN) ? n : STEP_WIN;
+    uint32_t sum = 0;
+    uint64_t sumsq = 0;
+    uint32_t psum = 0;
+    uint64_t var1;
+    uint64_t band;
+    int32_t y0 = (int32_t)g_rpm0;
+    int32_t y1;
+    int32_t d;
+    int32_t sgn;
+    int32_t peak = 0;
+    uint32_t t10 = n;
+    uint32_t t90 = n;
+    uint32_t last_out = n;
+
+    memset(r, 0, sizeof(*r));
+
+    for (uint32_t i = n - k; i < n; i++) {
+        sum += g_trace_rpm[i];
+        sumsq += (uint64_t)g_trace_rpm[i] * g_trace_rpm[i];
+        psum += g_trace_pulses[i];
+    }
+    y1 = (int32_t)((sum + k / 2U) / k);
+    var1 = ((uint64_t)k * sumsq - (uint64_t)sum * sum) / ((uint64_t)k * k);
+
+    r->rpm0 = g_rpm0;
+    r->rpm1 = (uint32_t)y1;
+    r->pulses0 = (g_base_pulses + STEP_WIN / 2U) / STEP_WIN;
+    r->pulses1 = (psum + k / 2U) / k;
+
+    d = y1 - y0;
+    sgn = (d < 0) ? -1 : 1;
+    d *= sgn;
+
+    /* Burst shape: first move and last miss by more than one pulse. */
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t p = g_trace_pulses[i];
+
+        if (r->burst_dead_ms == 0U && (p > (int32_t)r->pulses0 + 1 || p < (int32_t)r->pulses0 - 1)) {
+            r->burst_dead_ms = (i + 1U) * STEP_SAMPLE_MS;
+        }
+        if (p > (int32_t)r->pulses1 + 1 || p < (int32_t)r->pulses1 - 1) {
+            r->burst_settle_ms = (i + 1U) * STEP_SAMPLE_MS;
+        }
+    }
+
+    if (sq(d) <= g_band0) {
+        r->no_response = true;
+        return;
+    }
+
+    /* Settling band: 2% of the change, at least the final noise (3 sd). */
+    band = sq(d / 50);
+    if (band < 9U * var1) band = 9U * var1;
+    if (band < 1U) band = 1U;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t y = (int32_t)g_trace_rpm[i];
+        int32_t rel = (y - y0) * sgn;
+
+        if (t10 == n && rel * 10 >= d) t10 = i;
+        if (t90 == n && rel * 10 >= d * 9) t90 = i;
+        if (rel > peak) peak = rel;
+        if (sq(y - y1) > band) last_out = i;
+        if (!g_have_dead && sq(y - y0) > g_band0) {
+            /* No edge seen leaving the band (e.g. the fan started from 0). */
+            g_have_dead = true;
+            g_dead_ms = (i + 1U) * STEP_SAMPLE_MS;
+        }
+    }
+
+    r->dead_ms = g_have_dead ? g_dead_ms : 0U;
+    r->rise_ms = (t10 < n && t90 < n) ? (t90 - t10) * STEP_SAMPLE_MS : 0U;
+    r->over_pct = (peak > d) ? (uint32_t)((peak - d) * 100 / d) : 0U;
+    r->settle_ms = (last_out < n) ? (last_out + 1U) * STEP_SAMPLE_MS : 0U;
+}
+
+/* ---- Test ---------------------------------------------------------------- */
+
+static void steptest_restore(void)
+{
+    pwm_set_percent(g_saved_duty);
+    pwm_set_enabled(g_saved_enabled);
+    g_con = 0;
+}
+
+static void print_summary(console_t *c)
+{
+    step_result_t mn, mean, mx;
+    char row[STEP_ROW_MAX];
+
+    if (!steptest_summary(&mn, &mean, &mx)) return;
+    steptest_format_row(row, "min", &mn);
+    console_puts(c, row);
+    steptest_format_row(row, "mean", &mean);
+    console_puts(c, row);
+    steptest_format_row(row, "max", &mx);
+    console_puts(c, row);
+}
+
+static void steptest_finish(console_t *c, const char *msg)
+{
+    steptest_restore();
+    c->busy = false;
+    print_summary(c);
+    console_puts(c, msg);
+    console_prompt_force_next(c);
+    console_prompt_once(c);
+}
+
+static void begin_hold(void)
+{
+    pwm_set_percent(g_from);
+    g_phase = STEP_PHASE_HOLD;
+    g_n = 0;
+    g_base_sum = 0;
+    g_base_sumsq = 0;
+    g_base_pulses = 0;
+}
+
+static void begin_trace(void)
+{
+    uint64_t var0 = ((uint64_t)STEP_WIN * g_base_sumsq - (uint64_t)g_base_sum * g_base_sum) /
+                    ((uint64_t)STEP_WIN * STEP_WIN);
+
+    g_rpm0 = (g_base_sum + STEP_WIN / 2U) / STEP_WIN;
+    g_band0 = 9U * var0;
+    if (g_band0 < sq((int32_t)(g_rpm0 / 100U))) g_band0 = sq((int32_t)(g_rpm0 / 100U));
+    if (g_band0 < 1U) g_band0 = 1U;
+    g_have_dead = false;
+    g_dead_ms = 0;
+
+    pwm_set_percent(g_to);
+    g_t0_ms = timebase_millis();
+    g_phase = STEP_PHASE_TRACE;
+    g_n = 0;
+}
+
+void steptest_task(void)
+{
+    console_t *c = g_con;
+    tach_snapshot_t t;
+    tach_burst_t b;
+
+    if (!c) return;
+
+    /* Aborted by a key or the end of the session. */
+    if (!c->busy) {
+        steptest_finish(c, "\r\nSTEP aborted\r\n");
+        return;
+    }
+    if (c->dev == UARTDEV_USER && modbus_is_enabled()) {
+        steptest_restore();
+        c->busy = false;
+        return;
+    }
+    if (tsyn_is_enabled()) {
+        steptest_finish(c, "\r\nSTEP aborted: TSYN was turned on\r\n");
+        return;
+    }
+
+    tach_get_snapshot(&t);
+    tach_get_burst(&b);
+    if (t.rpm > 0xFFFFU) t.rpm = 0xFFFFU;
+    if (b.pulses_per_burst > 0xFFU) b.pulses_per_burst = 0xFFU;
+
+    if (g_phase == STEP_PHASE_HOLD) {
+        if (++g_n > g_hold_n - STEP_WIN) {
+            g_base_sum += t.rpm;
+            g_base_sumsq += (uint64_t)t.rpm * t.rpm;
+            g_base_pulses += b.pulses_per_burst;
+        }
+        if (g_n >= g_hold_n) {
+            begin_trace();
+        }
+        return;
+    }
+
+    /* Dead time from the edge that produced this RPM, not the sample time. */
+    if (!g_have_dead && (int32_t)(t.last_edge_ms - g_t0_ms) >= 0 &&
+        sq((int32_t)t.rpm - (int32_t)g_rpm0) > g_band0) {
+        g_have_dead = true;
+        g_dead_ms = t.last_edge_ms - g_t0_ms;
+    }
+    g_trace_rpm[g_n] = (uint16_t)t.rpm;
+    g_trace_pulses[g_n] = (uint8_t)b.pulses_per_burst;
+    if (++g_n < g_hold_n) return;
+
+    {
+        step_result_t *r = &g_results[g_count];
+        char label[4];
+        char row[STEP_ROW_MAX];
+
+        analyze(r);
+        g_count++;
+        *console_put_col(label, g_count, 0) = '\0';
+        steptest_format_row(row, label, r);
+        console_puts(c, row);
+    }
+
+    if (g_count >= g_reps) {
+        steptest_finish(c, "STEP done\r\n");
+        return;
+    }
+    begin_hold();
+}
+
+step_err_t steptest_start(console_t *c, uint32_t from, uint32_t to, uint32_t reps, uint32_t hold_s)
+{
+    if (g_con || sweep_is_running()) return STEP_ERR_BUSY;
+    if (tsyn_is_enabled()) return STEP_ERR_TSYN;
+    if (from < PSYN_MIN || from > PSYN_MAX || to < PSYN_MIN || to > PSYN_MAX || from == to ||
+        reps == 0U || reps > STEP_MAX_REPS || hold_s < 2U || hold_s > STEP_MAX_HOLD_S) {
+        return STEP_ERR_RANGE;
+    }
+
+    g_saved_duty = pwm_get_percent_requested();
+    g_saved_enabled = pwm_is_enabled();
+    g_from = from;
+    g_to = to;
+    g_reps = reps;
+    g_hold_n = hold_s * 1000U / STEP_SAMPLE_MS;
+    g_count = 0;
+
+    pwm_set_enabled(true);
+    begin_hold();
+
+    console_puts(c, "\r\nSTEP running (any key aborts)\r\n");
+    console_puts(c, steptest_header());
+    c->busy = true;
+    g_con = c;
+    return STEP_OK;
+}
+
+bool steptest_is_running(void)
+{
+    return g_con != 0;
+}
+
+uint32_t steptest_count(void)
+{
+    return g_count;
+}
+
+bool steptest_get(uint32_t index, step_result_t *r)
+{
+    if (index >= g_count) return false;
+    *r = g_results[index];
+    return true;
+}
+
+bool steptest_summary(step_result_t *min, step_result_t *mean, step_result_t *max)
+{
+    uint32_t sums[STEP_FIELDS] = { 0 };
+    uint32_t n = 0;
+
+    memset(min, 0, sizeof(*min));
+    memset(mean, 0, sizeof(*mean));
+    memset(max, 0, sizeof(*max));
+
+    for (uint32_t i = 0; i < g_count; i++) {
+        step_result_t *r = &g_results[i];
+
+        if (r->no_response) continue;
+        for (uint32_t f = 0; f < STEP_FIELDS; f++) {
+            uint32_t v = *field(r, f);
+
+            if (n == 0U || v < *field(min, f)) *field(min, f) = v;
+            if (n == 0U || v > *field(max, f)) *field(max, f) = v;
+            sums[f] += v;
+        }
+        n++;
+    }
+    if (n == 0U) return false;
+
+    for (uint32_t f = 0; f < STEP_FIELDS; f++) {
+        *field(mean, f) = (sums[f] + n / 2U) / n;
+    }
+    return true;
+}
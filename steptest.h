@@ -0,0 +1,87 @@
+#ifndef STEPTEST_H
+#define STEPTEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "console.h"
+
+/*
+ * Step-response measurement of the fan (STEP command).
+ *
+ * Each repetition holds duty `from` for hold_s seconds (the last second is
+ * the baseline), steps to `to`, and records RPM and pulses per burst every
+ * STEP_SAMPLE_MS for another hold_s seconds (the last second is the final
+ * value). From that trace:
+ *
+ *   dead    step to the first tach edge whose RPM leaves the baseline band
+ *           (3 standard deviations, at least 1%); 1 ms resolution from the
+ *           edge timestamp
+ *   rise    10% to 90% of the RPM change
+ *   over    overshoot past the final RPM, % of the change
+ *   settle  step to the last sample outside 2% of the change (at least
+ *           the final noise band) around the final RPM
+ *
+ * and for the burst shape (tach_get_burst()) the time until the pulses per
+ * burst first move by more than one, and until they stay within one of
+ * their final value. Running several repetitions gives min/mean/max.
+ * TSYN must be off, since it drives the pin the tach reads.
+ */
+#ifndef STEP_SAMPLE_MS
+#define STEP_SAMPLE_MS      20U
+#endif
+#define STEP_MAX_HOLD_S     10U
+#define STEP_TRACE_LEN      (STEP_MAX_HOLD_S * 1000U / STEP_SAMPLE_MS)
+#ifndef STEP_MAX_REPS
+#define STEP_MAX_REPS       20U
+#endif
+#define STEP_DEFAULT_FROM   30U
+#define STEP_DEFAULT_TO     60U
+#define STEP_DEFAULT_REPS   5U
+#define STEP_DEFAULT_HOLD_S 5U
+
+typedef struct {
+    uint32_t rpm0;              /* baseline at `from` */
+    uint32_t rpm1;              /* final at `to` */
+    uint32_t dead_ms;
+    uint32_t rise_ms;
+    uint32_t over_pct;
+    uint32_t settle_ms;
+    uint32_t pulses0;           /* pulses per burst, baseline and final */
+    uint32_t pulses1;
+    uint32_t burst_dead_ms;
+    uint32_t burst_settle_ms;
+    bool no_response;           /* RPM change within the baseline band */
+} step_result_t;
+
+typedef enum {
+    STEP_OK = 0,
+    STEP_ERR_BUSY,              /* a STEP or SWEEP is already running */
+    STEP_ERR_TSYN,              /* TSYN is on */
+    STEP_ERR_RANGE,
+} step_err_t;
+
+/* Start `reps` repetitions of the from -> to step on console c (marked busy;
+   any key aborts). The duty and PWM state are restored at the end. */
+step_err_t steptest_start(console_t *c, uint32_t from, uint32_t to, uint32_t reps, uint32_t hold_s);
+
+bool steptest_is_running(void);
+
+/* Scheduler task, period STEP_SAMPLE_MS. */
+void steptest_task(void);
+
+/* Results of the last (or running) test, one per repetition. */
+uint32_t steptest_count(void);
+bool steptest_get(uint32_t index, step_result_t *r);
+
+/* Min, mean and max of each field over the results (no_response ones
+   excluded). False if there are none. */
+bool steptest_summary(step_result_t *min, step_result_t *mean, step_result_t *max);
+
+/* Column header and one row under it, labelled with a repetition number or
+   "min"/"mean"/"max" (at most 4 characters), both CRLF-terminated. */
+#define STEP_ROW_MAX        96U
+const char *steptest_header(void);
+void steptest_format_row(char *dst, const char *label, const step_result_t *r);
+
+#endif /* STEPTEST_H */
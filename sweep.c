@@ -0,0 +1,294 @@
+#include "sweep.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "commands.h"       /* pwm_set_percent(), pwm_set_enabled(), PSYN_MIN/MAX */
+#include "modbus.h"
+#include "steptest.h"
+#include "tach.h"
+#include "timebase.h"
+#include "tsyn.h"
+
+/* RPM and burst sums over one window of SWEEP_WIN samples. */
+typedef struct {
+    uint32_t start_ms;
+    uint32_t n;
+    uint32_t sum;
+    uint64_t sumsq;
+    uint32_t bursts;
+    uint32_t pulses;
+    uint32_t tail_us;
+    uint32_t carrier_hz;
+} sweep_win_t;
+
+static console_t *g_con = 0;
+static uint32_t g_to = 0;
+static int32_t g_step = 0;
+static uint32_t g_max_ms = 0;
+static uint32_t g_duty = 0;
+static uint32_t g_step_ms = 0;
+
+static sweep_win_t g_win;
+static sweep_win_t g_prev;
+static bool g_have_prev = false;
+static uint32_t g_last_bursts = 0;
+
+static uint32_t g_saved_duty = 0;
+static bool g_saved_enabled = false;
+
+static sweep_point_t g_points[SWEEP_MAX_POINTS];
+static uint32_t g_count = 0;
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit != 0U) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static uint32_t win_mean(const sweep_win_t *w)
+{
+    return (w->sum + w->n / 2U) / w->n;
+}
+
+/* Population variance of the window, in RPM^2. */
+static uint64_t win_var(const sweep_win_t *w)
+{
+    uint64_t n = w->n;
+    uint64_t s = w->sum;
+
+    return (n * w->sumsq - s * s) / (n * n);
+}
+
+static bool win_quiet(const sweep_win_t *w)
+{
+    uint64_t m = win_mean(w);
+
+    return win_var(w) * 10000U <= m * m * (SWEEP_CV_PCT * SWEEP_CV_PCT);
+}
+
+/*
+ * Both windows quiet and no drift between them: the difference of the means
+ * within two standard errors, or within 1% (a fan that is steady to the RPM
+ * has almost no variance to compare against).
+ */
+static bool steady(const sweep_win_t *a, const sweep_win_t *b)
+{
+    uint32_t ma = win_mean(a);
+    uint32_t mb = win_mean(b);
+    uint64_t d = (ma > mb) ? ma - mb : mb - ma;
+
+    if (!win_quiet(a) || !win_quiet(b)) return false;
+    if (d * 100U <= mb) return true;
+    return d * d * SWEEP_WIN <= 4U * (win_var(a) + win_var(b));
+}
+
+static void win_reset(uint32_t now)
+{
+    memset(&g_win, 0, sizeof(g_win));
+    g_win.start_ms = now;
+}
+
+/* ---- Output -------------------------------------------------------------- */
+
+const char *sweep_header(void)
+{
+    return "  duty    rpm     sd  pulses  tail_us  carrier_hz  settle_ms\r\n";
+}
+
+void sweep_format_row(char *dst, const sweep_point_t *p)
+{
+    dst = console_put_col(dst, p->duty, 6);
+    dst = console_put_col(dst, p->rpm, 7);
+    dst = console_put_col(dst, p->rpm_sd, 7);
+    dst = console_put_col(dst, p->pulses_per_burst, 8);
+    dst = console_put_col(dst, p->tail_us, 9);
+    dst = console_put_col(dst, p->carrier_hz, 12);
+    dst = console_put_col(dst, p->settle_ms, 11);
+    if (p->timeout) {
+        memcpy(dst, " timeout", 8);
+        dst += 8;
+    }
+    memcpy(dst, "\r\n", 3);
+}
+
+/* ---- Sweep --------------------------------------------------------------- */
+
+static void sweep_restore(void)
+{
+    pwm_set_percent(g_saved_duty);
+    pwm_set_enabled(g_saved_enabled);
+    g_con = 0;
+}
+
+static void sweep_finish(console_t *c, const char *msg)
+{
+    sweep_restore();
+    c->busy = false;
+    console_puts(c, msg);
+    console_prompt_force_next(c);
+    console_prompt_once(c);
+}
+
+static void set_duty(uint32_t duty, uint32_t now)
+{
+    tach_burst_t b;
+
+    g_duty = duty;
+    pwm_set_percent(duty);
+    g_step_ms = now;
+    g_have_prev = false;
+    win_reset(now);
+
+    /* Only bursts completed at the new duty count. */
+    tach_get_burst(&b);
+    g_last_bursts = b.bursts_total;
+}
+
+/* Store the point from window w and move to the next duty. */
+static void record(console_t *c, const sweep_win_t *w, uint32_t settle_ms, bool timeout, uint32_t now)
+{
+    sweep_point_t *p = &g_points[g_count++];
+    char row[SWEEP_ROW_MAX];
+
+    p->duty = (uint8_t)g_duty;
+    p->timeout = timeout ? 1U : 0U;
+    p->rpm = win_mean(w);
+    p->rpm_sd = isqrt64(win_var(w));
+    p->settle_ms = settle_ms;
+    if (w->bursts != 0U) {
+        p->pulses_per_burst = (uint16_t)((w->pulses + w->bursts / 2U) / w->bursts);
+        p->tail_us = (w->tail_us + w->bursts / 2U) / w->bursts;
+        p->carrier_hz = (w->carrier_hz + w->bursts / 2U) / w->bursts;
+    } else {
+        p->pulses_per_burst = 0;
+        p->tail_us = 0;
+        p->carrier_hz = 0;
+    }
+
+    sweep_format_row(row, p);
+    console_puts(c, row);
+
+    if (g_duty == g_to || g_count >= SWEEP_MAX_POINTS) {
+        sweep_finish(c, "SWEEP done (SWEEP TABLE for the tables)\r\n");
+        return;
+    }
+    if (g_step > 0) {
+        set_duty((g_duty + (uint32_t)g_step < g_to) ? g_duty + (uint32_t)g_step : g_to, now);
+    } else {
+        set_duty((g_duty > g_to + (uint32_t)-g_step) ? g_duty - (uint32_t)-g_step : g_to, now);
+    }
+}
+
+void sweep_task(void)
+{
+    console_t *c = g_con;
+    tach_snapshot_t t;
+    tach_burst_t b;
+    uint32_t now;
+
+    if (!c) return;
+
+    /* Aborted by a key or the end of the session. */
+    if (!c->busy) {
+        sweep_finish(c, "\r\nSWEEP aborted\r\n");
+        return;
+    }
+    if (c->dev == UARTDEV_USER && modbus_is_enabled()) {
+        sweep_restore();
+        c->busy = false;
+        return;
+    }
+    if (tsyn_is_enabled()) {
+        sweep_finish(c, "\r\nSWEEP aborted: TSYN was turned on\r\n");
+        return;
+    }
+
+    now = timebase_millis();
+    tach_get_snapshot(&t);
+    tach_get_burst(&b);
+
+    g_win.n++;
+    g_win.sum += t.rpm;
+    g_win.sumsq += (uint64_t)t.rpm * t.rpm;
+    if (b.bursts_total != g_last_bursts) {
+        g_last_bursts = b.bursts_total;
+        g_win.bursts++;
+        g_win.pulses += b.pulses_per_burst;
+        g_win.tail_us += b.tail_us;
+        g_win.carrier_hz += b.carrier_hz;
+    }
+    if (g_win.n < SWEEP_WIN) return;
+
+    if (g_have_prev && steady(&g_prev, &g_win)) {
+        record(c, &g_win, g_prev.start_ms - g_step_ms, false, now);
+        return;
+    }
+    if (now - g_step_ms >= g_max_ms) {
+        record(c, &g_win, now - g_step_ms, true, now);
+        return;
+    }
+    g_prev = g_win;
+    g_have_prev = true;
+    win_reset(now);
+}
+
+sweep_err_t sweep_start(console_t *c, uint32_t from, uint32_t to, uint32_t step, uint32_t max_s)
+{
+    uint32_t span = (from > to) ? from - to : to - from;
+
+    if (g_con || steptest_is_running()) return SWEEP_ERR_BUSY;
+    if (tsyn_is_enabled()) return SWEEP_ERR_TSYN;
+    if (from < PSYN_MIN || from > PSYN_MAX || to < PSYN_MIN || to > PSYN_MAX ||
+        step == 0U || (span + step - 1U) / step + 1U > SWEEP_MAX_POINTS ||
+        max_s == 0U || max_s > SWEEP_MAX_S_LIMIT) {
+        return SWEEP_ERR_RANGE;
+    }
+
+    g_saved_duty = pwm_get_percent_requested();
+    g_saved_enabled = pwm_is_enabled();
+    g_to = to;
+    g_step = (from <= to) ? (int32_t)step : -(int32_t)step;
+    g_max_ms = max_s * 1000U;
+    g_count = 0;
+
+    pwm_set_enabled(true);
+    set_duty(from, timebase_millis());
+
+    console_puts(c, "\r\nSWEEP running (any key aborts)\r\n");
+    console_puts(c, sweep_header());
+    c->busy = true;
+    g_con = c;
+    return SWEEP_OK;
+}
+
+bool sweep_is_running(void)
+{
+    return g_con != 0;
+}
+
+uint32_t sweep_count(void)
+{
+    return g_count;
+}
+
+bool sweep_get(uint32_t index, sweep_point_t *p)
+{
+    if (index >= g_count) return false;
+    *p = g_points[index];
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "console.h"
+
+/*
+ * Fan characterization sweep (SWEEP command): steps the PSYN duty over a
+ * grid and, at each point, waits for the RPM to settle, then records RPM,
+ * the tach burst shape (pulses per burst, tail, carrier; tach_get_burst())
+ * and how long it took to settle.
+ *
+ * Steady state is decided from the RPM samples rather than a fixed delay:
+ * two consecutive windows of SWEEP_WIN samples must each have a coefficient
+ * of variation under SWEEP_CV_PCT, and their means must agree within the
+ * noise of the windows (or 1%). A point that has not settled after max_s
+ * seconds is recorded anyway and marked as a timeout.
+ *
+ * The results replace the hand-measured tables: SWEEP TABLE prints them as
+ * C initializers for tsyn.c g_points and a duty -> RPM feed-forward table.
+ * TSYN must be off, since it drives the same pin the tach reads.
+ */
+#ifndef SWEEP_SAMPLE_MS
+#define SWEEP_SAMPLE_MS     50U
+#endif
+#ifndef SWEEP_WIN
+#define SWEEP_WIN           20U
+#endif
+#ifndef SWEEP_CV_PCT
+#define SWEEP_CV_PCT        3U
+#endif
+#ifndef SWEEP_MAX_POINTS
+#define SWEEP_MAX_POINTS    32U
+#endif
+#define SWEEP_DEFAULT_FROM  10U
+#define SWEEP_DEFAULT_TO    90U
+#define SWEEP_DEFAULT_STEP  10U
+#define SWEEP_DEFAULT_MAX_S 30U
+#define SWEEP_MAX_S_LIMIT   600U
+
+typedef struct {
+    uint8_t duty;
+    uint8_t timeout;            /* did not settle within max_s */
+    uint16_t pulses_per_burst;  /* mean over the last window; 0 = no bursts */
+    uint32_t rpm;               /* mean over the last window */
+    uint32_t rpm_sd;
+    uint32_t tail_us;
+    uint32_t carrier_hz;
+    uint32_t settle_ms;         /* step to the start of the steady windows */
+} sweep_point_t;
+
+typedef enum {
+    SWEEP_OK = 0,
+    SWEEP_ERR_BUSY,             /* a SWEEP or STEP is already running */
+    SWEEP_ERR_TSYN,             /* TSYN is on */
+    SWEEP_ERR_RANGE,            /* grid outside PSYN_MIN..PSYN_MAX or too many points */
+} sweep_err_t;
+
+/* Start a sweep from duty `from` to `to` (either direction) in steps of
+   `step`, reporting each point on console c (marked busy; any key aborts). */
+sweep_err_t sweep_start(console_t *c, uint32_t from, uint32_t to, uint32_t step, uint32_t max_s);
+
+bool sweep_is_running(void);
+
+/* Scheduler task, period SWEEP_SAMPLE_MS. */
+void sweep_task(void);
+
+/* Points of the last (or running) sweep, in sweep order. */
+uint32_t sweep_count(void);
+bool sweep_get(uint32_t index, sweep_point_t *p);
+
+/* Column header and one result row under it, both CRLF-terminated. */
+#define SWEEP_ROW_MAX       80U
+const char *sweep_header(void);
+void sweep_format_row(char *dst, const sweep_point_t *p);
+
+#endif /* SWEEP_H */
@@ -2,14 +2,23 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "inc/hw_ints.h"
+#include "inc/hw_pwm.h"
+#include "inc/hw_types.h"
 
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
 #include "driverlib/rom.h"
 #include "driverlib/sysctl.h"
 
+#include "atomic.h"
+#include "cmdline.h"
+#include "commands.h"       /* pwm_is_enabled() */
+#include "seqlock.h"
+#include "sspwm.h"
 #include "timebase.h"
 
 /* Reject edges closer than this (microseconds). Helps ignore 21.5kHz PWM coupling. */
@@ -17,22 +26,126 @@
 #define TACH_MIN_EDGE_US 200U
 #endif
 
-/* Count of detected TACH pulses (falling edges). Updated in ISR. */
+/* PF2's generator (setup_pwm_pf2() in main.c). */
+#define TACH_BLANK_PWM_GEN (PWM0_BASE + PWM_GEN_1)
+
+/* Count of detected TACH pulses (falling edges) in the current TACHIN window.
+   Added in the ISR, taken with atomic_xchg_u32() by tach_task(). */
 static volatile uint32_t g_tach_pulses = 0;
 static volatile uint32_t g_tach_rejects = 0;
 static volatile uint32_t g_last_edge_cycles = 0;
 
+/* Free-running totals and last edge period for tach_get_snapshot(),
+   published by the ISR under g_snap_lock. */
+static seqlock_t g_snap_lock = SEQLOCK_INIT;
+static volatile uint32_t g_tach_pulses_total = 0;
+static volatile uint32_t g_tach_rejects_total = 0;
+static volatile uint32_t g_tach_blanked_total = 0;
+static volatile uint32_t g_last_period_cycles = 0;
+static volatile uint32_t g_last_edge_ms = 0;
+static volatile bool g_have_edge = false;
+
+/* Burst analysis on the raw edges (tach_get_burst()); the burst fields are
+   published under g_snap_lock too. */
+static uint32_t g_raw_last_cycles = 0;
+static uint32_t g_run_intervals = 0;
+static uint32_t g_run_cycles = 0;
+static volatile uint32_t g_burst_pulses = 0;
+static volatile uint32_t g_burst_period_cycles = 0;
+static volatile uint32_t g_burst_tail_cycles = 0;
+static volatile uint32_t g_bursts_total = 0;
+
+/* PWM blanking window in sysclk cycles; 0 = off. */
+static volatile uint32_t g_blank_cycles = 0;
+static uint32_t g_blank_ns = TACH_BLANK_NS;
+
 static volatile bool g_tach_capture_enabled = true;
 
 static volatile bool g_tach_reporting = false;
 static uint32_t g_next_report_ms = 0;
 
+/* Every raw edge: count carrier intervals, close the burst on a gap. */
+static void tach_burst_edge(uint32_t now, uint32_t cycles_per_us)
+{
+    uint32_t d = now - g_raw_last_cycles;
+
+    g_raw_last_cycles = now;
+
+    if (d < TACH_BURST_GAP_US * cycles_per_us) {
+        g_run_intervals++;
+        g_run_cycles += d;
+        return;
+    }
+
+    if (g_run_intervals != 0U && d < TACH_BURST_MAX_GAP_US * cycles_per_us) {
+        uint32_t period = g_run_cycles / g_run_intervals;
+
+        seqlock_write_begin(&g_snap_lock);
+        g_burst_pulses = g_run_intervals + 1U;
+        g_burst_period_cycles = period;
+        g_burst_tail_cycles = d - period;
+        g_bursts_total++;
+        seqlock_write_end(&g_snap_lock);
+    }
+    g_run_intervals = 0;
+    g_run_cycles = 0;
+}
+
+/* The LOAD | CMPA << 16 pair with load >= count, preferring a; 0 if neither. */
+static uint32_t pick_pair(uint32_t a, uint32_t b, uint32_t count)
+{
+    if (count <= (a & 0xFFFFU)) return a;
+    if (count <= (b & 0xFFFFU)) return b;
+    return 0;
+}
+
+/*
+ * PWM clocks since PF2 last switched, from the zero flag and counter value
+ * read on ISR entry. The generator counts down from LOAD: PF2 switches at
+ * the reload and where the count passes CMPA. Which LOAD/CMPA pair is in
+ * effect:
+ * - SSPWM on: the ISR's current pair, or its next one if a zero is flagged
+ *   that the (lower priority) PWM ISR has not handled yet. A count above
+ *   that LOAD means the zero fell between the two reads: the other pair.
+ * - SSPWM off: the registers. A count above LOAD is the dithered period
+ *   still running when SSPWM was turned off: sspwm's last pairs.
+ * 0xFFFFFFFF (not blanked) only if no pair fits; the spacing backstop
+ * still applies.
+ */
+static uint32_t pwm_since_transition(bool zero, uint32_t count)
+{
+    uint32_t cur;
+    uint32_t next;
+    uint32_t pair;
+    uint32_t cmpa;
+
+    if (sspwm_get_pairs(&cur, &next)) {
+        pair = zero ? pick_pair(next, cur, count) : pick_pair(cur, next, count);
+    } else {
+        pair = HWREG(TACH_BLANK_PWM_GEN + PWM_O_X_LOAD) |
+               (HWREG(TACH_BLANK_PWM_GEN + PWM_O_X_CMPA) << 16);
+        pair = pick_pair(pair, pick_pair(cur, next, count), count);
+    }
+    if (pair == 0U) {
+        return 0xFFFFFFFFU;
+    }
+
+    cmpa = pair >> 16;
+    if (count <= cmpa) {
+        return cmpa - count;
+    }
+    return (pair & 0xFFFFU) - count;
+}
+
 /*
  * GPIO Port K ISR (vector must point here).
  * Counts falling edges from open-collector TACH.
  */
 void GPIOMIntHandler(void)
 {
+    /* First, so the PWM phase is read as close to the edge as possible. */
+    bool pwm_zero = (HWREG(TACH_BLANK_PWM_GEN + PWM_O_X_RIS) & PWM_INT_CNT_ZERO) != 0U;
+    uint32_t pwm_count = HWREG(TACH_BLANK_PWM_GEN + PWM_O_X_COUNT);
     uint32_t status = GPIOIntStatus(TACH_GPIO_BASE, true);
     GPIOIntClear(TACH_GPIO_BASE, status);
 
@@ -43,27 +156,52 @@ void GPIOMIntHandler(void)
 
         uint32_t sysclk = timebase_sysclk_hz();
         uint32_t min_cycles = (sysclk / 1000000U) * TACH_MIN_EDGE_US;
+
+        tach_burst_edge(now, sysclk / 1000000U);
+
+        if (g_blank_cycles != 0U) {
+            if (pwm_is_enabled() && pwm_since_transition(pwm_zero, pwm_count) < g_blank_cycles) {
+                seqlock_write_begin(&g_snap_lock);
+                g_tach_blanked_total++;
+                seqlock_write_end(&g_snap_lock);
+                return;
+            }
+            /* Behind the blanking, a shorter spacing filter as a backstop. */
+            min_cycles = (sysclk / 1000000U) * TACH_BLANK_MIN_EDGE_US;
+        }
         if (min_cycles == 0) {
             min_cycles = 1;
         }
 
         if (delta < min_cycles) {
-            g_tach_rejects++;
+            atomic_add_u32(&g_tach_rejects, 1U);
+            seqlock_write_begin(&g_snap_lock);
+            g_tach_rejects_total++;
+            seqlock_write_end(&g_snap_lock);
             return;
         }
 
+        /* The first edge after init or after a long gap (the cycle counter
+           wraps every few tens of seconds) has no usable predecessor. */
+        uint32_t now_ms = timebase_millis_isr();
+        bool fresh = g_have_edge && (now_ms - g_last_edge_ms) < TACH_STALE_MS;
+
+        seqlock_write_begin(&g_snap_lock);
+        g_last_period_cycles = fresh ? delta : 0U;
+        g_have_edge = true;
+        g_last_edge_ms = now_ms;
+        g_tach_pulses_total++;
+        seqlock_write_end(&g_snap_lock);
+
         g_last_edge_cycles = now;
-        g_tach_pulses++;
+        atomic_add_u32(&g_tach_pulses, 1U);
     }
 }
 
 static void uart0_puts(const char *s)
 {
     if (!s) return;
-    const char *p = s;
-    while (*p) {
-        ROM_UARTCharPut(UART0_BASE, *p++);
-    }
+    UARTSend((const uint8_t *)s, (uint32_t)strlen(s), UARTDEV_ICDI);
 }
 
 static void uart0_put_u32(uint32_t v)
@@ -78,16 +216,20 @@ static void uart0_put_u32(uint32_t v)
     } while (n != 0U && i < sizeof(buf));
 
     while (i > 0) {
-        ROM_UARTCharPut(UART0_BASE, buf[--i]);
+        uint8_t c = (uint8_t)buf[--i];
+        UARTSend(&c, 1U, UARTDEV_ICDI);
     }
 }
 
 static void uart0_put_hex32(uint32_t v)
 {
     static const char hex[] = "0123456789ABCDEF";
-    for (int shift = 28; shift >= 0; shift -= 4) {
-        ROM_UARTCharPut(UART0_BASE, hex[(v >> shift) & 0xFU]);
+    uint8_t buf[8];
+
+    for (int i = 0; i < 8; i++) {
+        buf[i] = (uint8_t)hex[(v >> (28 - 4 * i)) & 0xFU];
     }
+    UARTSend(buf, sizeof(buf), UARTDEV_ICDI);
 }
 
 void tach_init(void)
@@ -112,6 +254,19 @@ void tach_init(void)
     g_tach_pulses = 0;
     g_tach_rejects = 0;
     g_last_edge_cycles = 0;
+    g_tach_pulses_total = 0;
+    g_tach_rejects_total = 0;
+    g_tach_blanked_total = 0;
+    g_last_period_cycles = 0;
+    g_last_edge_ms = 0;
+    g_have_edge = false;
+    g_raw_last_cycles = 0;
+    g_run_intervals = 0;
+    g_run_cycles = 0;
+    g_burst_pulses = 0;
+    g_burst_period_cycles = 0;
+    g_burst_tail_cycles = 0;
+    g_bursts_total = 0;
     g_tach_reporting = false;
     g_next_report_ms = 0;
 }
@@ -163,11 +318,9 @@ void tach_set_reporting(bool enabled)
 
     if (!enabled) {
         /* Reset counter when stopping to simplify the next start. */
-        IntMasterDisable();
-        g_tach_pulses = 0;
-        g_tach_rejects = 0;
-        g_last_edge_cycles = 0;
-        IntMasterEnable();
+        (void)atomic_xchg_u32(&g_tach_pulses, 0U);
+        (void)atomic_xchg_u32(&g_tach_rejects, 0U);
+        atomic_store_u32(&g_last_edge_cycles, 0U);
     }
 }
 
@@ -187,15 +340,10 @@ void tach_task(void)
 
     g_next_report_ms += 500U;
 
-    /* Atomically snapshot and clear pulse count. */
-    uint32_t pulses;
-    uint32_t rejects;
-    IntMasterDisable();
-    pulses = g_tach_pulses;
-    g_tach_pulses = 0;
-    rejects = g_tach_rejects;
-    g_tach_rejects = 0;
-    IntMasterEnable();
+    /* Take and clear the window counts; an edge in between lands in the
+       next window instead of being lost. */
+    uint32_t pulses = atomic_xchg_u32(&g_tach_pulses, 0U);
+    uint32_t rejects = atomic_xchg_u32(&g_tach_rejects, 0U);
 
     /* Window is 0.5s. User's model: RPM = pulses_per_sec * 30.
        pulses_per_sec = pulses / 0.5 = 2*pulses => RPM = 60*pulses. */
@@ -209,3 +357,93 @@ void tach_task(void)
     uart0_put_u32(rpm);
     uart0_puts("\r\n");
 }
+
+void tach_get_snapshot(tach_snapshot_t *out)
+{
+    uint32_t period_cycles;
+    uint32_t cycles_per_us;
+    bool have_edge;
+    uint32_t seq;
+
+    if (!out) return;
+
+    /* Readers in other ISRs must not outrank GPIOMIntHandler (seqlock.h). */
+    do {
+        seq = seqlock_read_begin(&g_snap_lock);
+        out->pulses_total = g_tach_pulses_total;
+        out->rejects_total = g_tach_rejects_total;
+        out->blanked_total = g_tach_blanked_total;
+        out->last_edge_ms = g_last_edge_ms;
+        period_cycles = g_last_period_cycles;
+        have_edge = g_have_edge;
+    } while (seqlock_read_retry(&g_snap_lock, seq));
+    out->capture_enabled = g_tach_capture_enabled;
+
+    cycles_per_us = timebase_sysclk_hz() / 1000000U;
+    if (cycles_per_us == 0) {
+        cycles_per_us = 1;
+    }
+    out->last_period_us = period_cycles / cycles_per_us;
+
+    out->rpm = 0;
+    if (have_edge && out->last_period_us != 0 &&
+        (uint32_t)(timebase_millis_isr() - out->last_edge_ms) < TACH_STALE_MS) {
+        /* pulses_per_sec = 1e6 / period_us; rpm = pulses_per_sec * 30. */
+        out->rpm = 30000000U / out->last_period_us;
+    }
+}
+
+bool tach_set_blanking(bool enabled, uint32_t ns)
+{
+    uint32_t cycles;
+
+    if (ns != 0U && (ns < TACH_BLANK_MIN_NS || ns > TACH_BLANK_MAX_NS)) {
+        return false;
+    }
+    if (ns != 0U) {
+        g_blank_ns = ns;
+    }
+    if (!enabled) {
+        g_blank_cycles = 0;
+        return true;
+    }
+
+    cycles = (uint32_t)(((uint64_t)timebase_sysclk_hz() * g_blank_ns + 999999999U) / 1000000000U);
+    g_blank_cycles = (cycles != 0U) ? cycles : 1U;
+    return true;
+}
+
+bool tach_is_blanking(void)
+{
+    return g_blank_cycles != 0U;
+}
+
+uint32_t tach_get_blank_ns(void)
+{
+    return g_blank_ns;
+}
+
+void tach_get_burst(tach_burst_t *out)
+{
+    uint32_t period_cycles;
+    uint32_t tail_cycles;
+    uint32_t cycles_per_us;
+    uint32_t seq;
+
+    if (!out) return;
+
+    do {
+        seq = seqlock_read_begin(&g_snap_lock);
+        out->pulses_per_burst = g_burst_pulses;
+        out->bursts_total = g_bursts_total;
+        period_cycles = g_burst_period_cycles;
+        tail_cycles = g_burst_tail_cycles;
+    } while (seqlock_read_retry(&g_snap_lock, seq));
+
+    cycles_per_us = timebase_sysclk_hz() / 1000000U;
+    if (cycles_per_us == 0) {
+        cycles_per_us = 1;
+    }
+    out->tail_us = tail_cycles / cycles_per_us;
+    out->carrier_hz = (period_cycles != 0U) ? timebase_sysclk_hz() / period_cycles : 0U;
+}
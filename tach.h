@@ -43,4 +43,80 @@ bool tach_is_reporting(void);
 /* Call periodically from the main loop. */
 void tach_task(void);
 
+/*
+ * Consistent view of the tach input for other modules (network status, etc.).
+ * Unlike the TACHIN report this does not reset any counter: totals are free
+ * running and wrap at 2^32. rpm is derived from the last accepted edge period
+ * (same model as TACHIN: rpm = pulses_per_sec * 30) and reads 0 once no edge
+ * has been seen for TACH_STALE_MS. Safe to call from interrupt handlers.
+ */
+#ifndef TACH_STALE_MS
+#define TACH_STALE_MS 1000U
+#endif
+
+typedef struct {
+    bool capture_enabled;
+    uint32_t pulses_total;
+    uint32_t rejects_total;
+    uint32_t blanked_total;    /* edges dropped by the PWM blanking window */
+    uint32_t last_period_us;   /* 0 until two edges have been seen */
+    uint32_t rpm;
+    uint32_t last_edge_ms;     /* timebase_millis() of the last accepted edge */
+} tach_snapshot_t;
+
+void tach_get_snapshot(tach_snapshot_t *out);
+
+/*
+ * Burst structure of the fan's tach (LEEME_MOSA_TACH_ANALYSIS.TXT): trains
+ * of pulses at a ~21.5 kHz carrier separated by a low tail. Measured from
+ * the raw falling edges, before the TACH_MIN_EDGE_US filter: an edge
+ * interval above TACH_BURST_GAP_US ends a burst. Values describe the last
+ * complete burst (all 0 until one is seen); tail_us is the gap interval
+ * minus one carrier period. Safe to call from interrupt handlers.
+ */
+#ifndef TACH_BURST_GAP_US
+#define TACH_BURST_GAP_US 70U
+#endif
+/* Longer gaps are a stopped fan, not a burst tail. */
+#ifndef TACH_BURST_MAX_GAP_US
+#define TACH_BURST_MAX_GAP_US 10000U
+#endif
+
+typedef struct {
+    uint32_t pulses_per_burst;
+    uint32_t tail_us;
+    uint32_t carrier_hz;
+    uint32_t bursts_total;
+} tach_burst_t;
+
+void tach_get_burst(tach_burst_t *out);
+
+/*
+ * PWM-synchronized blanking (TACHBLANK command). TACH_MIN_EDGE_US judges an
+ * edge by its spacing alone. With blanking on, the tach ISR reads the PF2
+ * generator's zero flag and counter (PWM0 gen 1, clocked at sysclk) on entry
+ * and drops an edge that arrives within the window after a PF2 transition
+ * (counter reload or CMPA), where the switching couples into the tach line.
+ * Under SSPWM the LOAD/CMPA pair in effect comes from sspwm_get_pairs().
+ * The edges left then only pass the much shorter TACH_BLANK_MIN_EDGE_US
+ * spacing filter, a backstop for glitches outside the window. The window is
+ * measured at the counter read, so it includes the interrupt entry latency
+ * (about 0.3 us at 120 MHz). No blanking while PSYN is off.
+ */
+#ifndef TACH_BLANK_NS
+#define TACH_BLANK_NS 2000U
+#endif
+#define TACH_BLANK_MIN_NS 100U
+#define TACH_BLANK_MAX_NS 20000U
+/* Over two 21.5 kHz PWM periods, far under the shortest real tach period
+   (3 ms at 10,000 RPM, 2 pulses per revolution). */
+#ifndef TACH_BLANK_MIN_EDGE_US
+#define TACH_BLANK_MIN_EDGE_US 100U
+#endif
+
+/* ns 0 keeps the current window. False if ns is out of range. */
+bool tach_set_blanking(bool enabled, uint32_t ns);
+bool tach_is_blanking(void);
+uint32_t tach_get_blank_ns(void);
+
 #endif /* TACH_H */
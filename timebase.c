@@ -6,6 +6,12 @@
 #include "driverlib/interrupt.h"
 #include "driverlib/systick.h"
 
+#include "atomic.h"
+
+#ifdef NET_ENABLED
+#include "net.h"
+#endif
+
 static volatile uint32_t g_ms_ticks = 0;
 static uint32_t g_sysclk_hz = 0;
 static uint32_t g_systick_reload = 0;
@@ -13,6 +19,9 @@ static uint32_t g_systick_reload = 0;
 void SysTickIntHandler(void)
 {
     g_ms_ticks++;
+#ifdef NET_ENABLED
+    net_systick_1ms();
+#endif
 }
 
 void timebase_init(uint32_t sysClockHz)
@@ -33,11 +42,14 @@ void timebase_init(uint32_t sysClockHz)
 
 uint32_t timebase_millis(void)
 {
-    uint32_t t;
-    IntMasterDisable();
-    t = g_ms_ticks;
-    IntMasterEnable();
-    return t;
+    /* One aligned word: the load is atomic, no need to mask (which also
+       re-enabled interrupts for callers that had them off). */
+    return atomic_load_u32(&g_ms_ticks);
+}
+
+uint32_t timebase_millis_isr(void)
+{
+    return g_ms_ticks;
 }
 
 uint32_t timebase_sysclk_hz(void)
@@ -12,6 +12,12 @@
 void timebase_init(uint32_t sysClockHz);
 uint32_t timebase_millis(void);
 
+/*
+ * Same as timebase_millis() but leaves the interrupt mask alone, so it may be
+ * called from interrupt handlers (a single aligned 32-bit read is atomic).
+ */
+uint32_t timebase_millis_isr(void);
+
 /*
  * Returns a 32-bit cycle counter based on SysTick.
  * Wraps naturally; intended for short delta measurements.
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+"""Read a binary dump from the firmware console (binproto.c) and write CSV.
+
+Sends a command such as `HISTORY 1M BIN` on a UART console, collects the
+frames up to the END frame, checks sequence numbers and CRCs, and prints
+the decoded records as CSV (or writes them to --out).
+
+Frame: 'B' 'P' type seq len(u16) payload crc(u16), little-endian, with
+CRC-16/MODBUS over type..payload.
+
+Example:
+
+    python3 tools/binproto.py --port /dev/ttyUSB1 "HISTORY 1S BIN"
+    python3 tools/binproto.py --port /dev/ttyACM0 --out 10m.csv "HISTORY 10M BIN"
+    python3 tools/binproto.py --port /dev/ttyUSB1 --timeout 5 --out log.csv "LOG DUMP"
+
+Requires: pyserial.
+"""
+
+from __future__ import annotations
+
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import serial  # type: ignore
+except Exception:  # pragma: no cover
+    print("ERROR: pyserial is required. Try: pip3 install pyserial", file=sys.stderr)
+    raise
+
+SYNC = b"BP"
+BP_TYPE_RRD = 0x01
+BP_TYPE_FLOG = 0x02
+BP_TYPE_END = 0x7F
+
+RRD_RES_NAMES = ["1S", "10S", "1M", "10M"]
+RRD_METRICS = ["rpm", "duty", "rejects", "burst"]
+
+
+def crc16(data: bytes) -> int:
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def read_frames(port: serial.Serial, timeout: float) -> list[tuple[int, bytes]]:
+    """Return [(type, payload)] up to and including the END frame."""
+    frames: list[tuple[int, bytes]] = []
+    buf = b""
+    expect_seq = 0
+    deadline = time.monotonic() + timeout
+
+    while time.monotonic() < deadline:
+        buf += port.read(port.in_waiting or 1)
+        while True:
+            i = buf.find(SYNC)
+            if i < 0:
+                buf = buf[-1:]
+                break
+            buf = buf[i:]
+            if len(buf) < 6:
+                break
+            ftype, seq, length = buf[2], buf[3], struct.unpack_from("<H", buf, 4)[0]
+            if len(buf) < 8 + length:
+                break
+            body = buf[2:6 + length]
+            (crc,) = struct.unpack_from("<H", buf, 6 + length)
+            if crc16(body) != crc:
+                # Not a frame (or a corrupted one): resync past this 'B'.
+                buf = buf[1:]
+                continue
+            if seq != expect_seq:
+                raise RuntimeError(f"lost frame: seq {seq}, expected {expect_seq}")
+            expect_seq = (seq + 1) & 0xFF
+            frames.append((ftype, buf[6:6 + length]))
+            buf = buf[8 + length:]
+            deadline = time.monotonic() + timeout
+            if ftype == BP_TYPE_END:
+                return frames
+    raise RuntimeError(f"timeout after {len(frames)} frames (no END frame)")
+
+
+def decode_rrd(frames: list[bytes]) -> tuple[list[str], list[list[int]], int]:
+    header = ["ago_s"] + [f"{m}_{s}" for m in RRD_METRICS for s in ("min", "max", "avg")]
+    rows: list[tuple[int, int, list[int]]] = []
+    for p in frames:
+        res, nmetrics, seconds, first, nrows = struct.unpack_from("<BBHHH", p, 0)
+        vals = struct.unpack_from(f"<{nrows * nmetrics * 3}H", p, 8)
+        width = nmetrics * 3
+        for r in range(nrows):
+            rows.append((first + r, seconds, list(vals[r * width:(r + 1) * width])))
+    n = len(rows)
+    return header, [[(n - 1 - idx) * secs] + vals for idx, secs, vals in rows], n
+
+
+def sext(v: int, bits: int) -> int:
+    return v - (1 << bits) if v & (1 << (bits - 1)) else v
+
+
+def decode_flog(frames: list[bytes]) -> tuple[list[str], list[list[int]], int]:
+    """flashlog.c blocks -> run, t_ms, rpm, duty (record format in flashlog.c)."""
+    rows: list[list[int]] = []
+    blocks = bad = 0
+    run, seq_prev = 0, None
+    period = idx = rpm = duty = 0
+    base = False
+
+    for p in frames:
+        seq, hdr_period, first, _block, n = struct.unpack_from("<IHIHB", p, 0)
+        if seq != seq_prev:
+            # Every sector decodes on its own from its header.
+            period, idx, base, seq_prev = hdr_period, first, False, seq
+        for k in range(n):
+            blk = p[13 + 32 * k:13 + 32 * (k + 1)]
+            blocks += 1
+            if crc16(blk[:30]) != struct.unpack_from("<H", blk, 30)[0]:
+                bad += 1
+                base = False
+                continue
+            i = 0
+            while i < 30:
+                op = blk[i]
+                if op == 0xFF:
+                    break
+                if op == 0xF0:
+                    period = struct.unpack_from("<H", blk, i + 1)[0]
+                    run, idx, base = run + 1, 0, False
+                    i += 3
+                    continue
+                if op == 0xE1:
+                    idx = struct.unpack_from("<I", blk, i + 1)[0]
+                    i += 5
+                    continue
+                if op == 0xE0:
+                    rpm, duty = struct.unpack_from("<HB", blk, i + 1)
+                    base = True
+                    i += 4
+                elif op < 0x80:
+                    rpm += sext(op, 7)
+                    i += 1
+                elif op < 0xC0:
+                    rpm += sext(((op & 0x3F) << 8) | blk[i + 1], 14)
+                    i += 2
+                elif op < 0xE0:
+                    duty += sext(op & 0x1F, 5)
+                    rpm += sext(blk[i + 1], 8)
+                    i += 2
+                else:
+                    break  # unknown record: the rest of the block is lost
+                if base:
+                    rows.append([run, idx * period, rpm & 0xFFFF, duty])
+                idx += 1
+    if bad:
+        print(f"WARNING: {bad} blocks failed their CRC (power loss while writing)", file=sys.stderr)
+    return ["run", "t_ms", "rpm", "duty"], rows, blocks
+
+
+DECODERS = {BP_TYPE_RRD: decode_rrd, BP_TYPE_FLOG: decode_flog}
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port", default="/dev/ttyUSB1")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=2.0, help="seconds of silence before giving up")
+    ap.add_argument("--out", help="CSV file (default: stdout)")
+    ap.add_argument("command", help='console command, e.g. "HISTORY 1M BIN"')
+    args = ap.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+        port.reset_input_buffer()
+        port.write(args.command.encode("ascii") + b"\r")
+        port.flush()
+        frames = read_frames(port, args.timeout)
+
+    ftype, end = frames[-1]
+    dumped, nframes, nrecords = struct.unpack_from("<BII", end, 0)
+    data = [p for t, p in frames[:-1] if t == dumped]
+    if nframes != len(frames) - 1:
+        print(f"ERROR: END reports {nframes} frames, got {len(frames) - 1}", file=sys.stderr)
+        return 1
+    if dumped not in DECODERS:
+        print(f"ERROR: no decoder for frame type 0x{dumped:02X}", file=sys.stderr)
+        return 1
+
+    header, rows, nseen = DECODERS[dumped](data)
+    if nseen != nrecords:
+        print(f"ERROR: END reports {nrecords} records, got {nseen}", file=sys.stderr)
+        return 1
+
+    f = open(args.out, "w") if args.out else sys.stdout
+    try:
+        f.write(",".join(header) + "\n")
+        for row in rows:
+            f.write(",".join(str(v) for v in row) + "\n")
+    finally:
+        if f is not sys.stdout:
+            f.close()
+    print(f"{len(rows)} records in {nframes} frames", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Local stand-in for the cloud telemetry endpoint (drivers/cloud_uplink.c).
+
+Accepts the batched POSTs the firmware uplink sends:
+
+    {"up": <uptime ms>, "p": [[<time ms>, "<channel>", <value>], ...]}
+
+and prints one line per request plus a summary on exit. It speaks HTTP/1.1
+with keep-alive, so connection reuse can be checked from the "conn" column.
+
+Failure injection, to exercise retry, store-and-forward and replay pacing:
+
+- --fail-rate 0.2      answer 20% of requests with 503 (batch must be resent)
+- --outage 30:60       answer 503 between t=30 s and t=60 s after start
+- --close-every 5      send "Connection: close" on every 5th response
+- --chunked            reply with a chunked body instead of Content-Length
+- --delay 0.5          wait before answering (exercise response timeouts)
+
+Example:
+
+    python3 tools/cloud_standin.py --port 8080 --fail-rate 0.1 --close-every 20
+
+Then point the firmware at the host running it (CloudUplinkInit()).
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import random
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Optional, Tuple
+
+
+class _Stats:
+    def __init__(self) -> None:
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.accepted = 0
+        self.rejected = 0
+        self.points = 0
+        self.connections = 0
+        self.duplicates = 0
+        self.seen: set = set()
+        self.last_arrival: Optional[float] = None
+        self.min_gap: Optional[float] = None
+
+
+def _parse_outage(text: Optional[str]) -> Optional[Tuple[float, float]]:
+    if not text:
+        return None
+    start, _, end = text.partition(":")
+    return float(start), float(end)
+
+
+def make_handler(args: argparse.Namespace, stats: _Stats, t0: float):
+    outage = _parse_outage(args.outage)
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def setup(self) -> None:
+            super().setup()
+            with stats.lock:
+                stats.connections += 1
+                self.conn_id = stats.connections
+
+        def log_message(self, fmt: str, *a) -> None:  # quiet default logging
+            if args.verbose:
+                super().log_message(fmt, *a)
+
+        def _reply(self, code: int, body: bytes, close: bool) -> None:
+            self.send_response(code)
+            self.send_header("Content-Type", "application/json")
+            if close:
+                self.send_header("Connection", "close")
+                self.close_connection = True
+            if args.chunked:
+                self.send_header("Transfer-Encoding", "chunked")
+                self.end_headers()
+                if body:
+                    self.wfile.write(b"%x\r\n%s\r\n" % (len(body), body))
+                self.wfile.write(b"0\r\n\r\n")
+            else:
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+        def do_POST(self) -> None:  # noqa: N802 (http.server naming)
+            length = int(self.headers.get("Content-Length", "0"))
+            raw = self.rfile.read(length)
+            now = time.monotonic()
+            rel = now - t0
+
+            with stats.lock:
+                stats.requests += 1
+                n = stats.requests
+                gap = None if stats.last_arrival is None else now - stats.last_arrival
+                stats.last_arrival = now
+                if gap is not None and (stats.min_gap is None or gap < stats.min_gap):
+                    stats.min_gap = gap
+
+            close = bool(args.close_every) and (n % args.close_every == 0)
+
+            try:
+                doc = json.loads(raw.decode("utf-8"))
+                points = doc["p"]
+                uptime = int(doc["up"])
+            except Exception as exc:
+                with stats.lock:
+                    stats.rejected += 1
+                print(f"#{n:5d} conn={self.conn_id:3d} 400 bad body ({exc}): {raw[:80]!r}")
+                self._reply(400, b'{"error":"bad body"}', True)
+                return
+
+            if args.delay:
+                time.sleep(args.delay)
+
+            in_outage = outage is not None and outage[0] <= rel < outage[1]
+            if in_outage or random.random() < args.fail_rate:
+                with stats.lock:
+                    stats.rejected += 1
+                why = "outage" if in_outage else "injected"
+                print(f"#{n:5d} conn={self.conn_id:3d} 503 ({why}) points={len(points)}")
+                self._reply(503, b'{"error":"unavailable"}', close)
+                return
+
+            dups = 0
+            with stats.lock:
+                stats.accepted += 1
+                stats.points += len(points)
+                for p in points:
+                    key = (p[0], p[1])
+                    if key in stats.seen:
+                        dups += 1
+                    stats.seen.add(key)
+                stats.duplicates += dups
+
+            oldest = (uptime - points[0][0]) / 1000.0 if points else 0.0
+            gap_txt = "   -  " if gap is None else f"{gap:6.2f}"
+            print(
+                f"#{n:5d} conn={self.conn_id:3d} 200 points={len(points):3d} "
+                f"oldest={oldest:8.1f}s gap={gap_txt}s dup={dups}"
+                + (" close" if close else "")
+            )
+            self._reply(200, b'{"ok":true}', close)
+
+    return Handler
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--fail-rate", type=float, default=0.0)
+    ap.add_argument("--outage", help="START:END seconds after start to answer 503")
+    ap.add_argument("--close-every", type=int, default=0)
+    ap.add_argument("--chunked", action="store_true")
+    ap.add_argument("--delay", type=float, default=0.0)
+    ap.add_argument("--verbose", action="store_true")
+    args = ap.parse_args()
+
+    stats = _Stats()
+    t0 = time.monotonic()
+    server = ThreadingHTTPServer((args.host, args.port), make_handler(args, stats, t0))
+    print(f"cloud stand-in listening on {args.host}:{args.port}")
+
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+    with stats.lock:
+        print(
+            f"\nrequests={stats.requests} accepted={stats.accepted} "
+            f"rejected={stats.rejected} points={stats.points} "
+            f"duplicates={stats.duplicates} connections={stats.connections}"
+        )
+        if stats.min_gap is not None:
+            print(f"min gap between requests: {stats.min_gap:.3f}s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Serial firmware update over UART3 (fwupdate.c / bootloader/).
+
+Sends FWUPDATE BEGIN on the console, switches both ends to --baud and streams
+the image in CRC-32 checked 1 KB blocks. If the transfer is interrupted, run
+the same command again: the firmware reports how much of this image it
+already holds and the transfer continues from there.
+
+Example:
+
+    python3 tools/fwupdate.py --port /dev/ttyUSB1 integr_V03.bin
+    python3 tools/fwupdate.py --port /dev/ttyUSB1 --apply integr_V03.bin
+    python3 tools/fwupdate.py --port /dev/ttyUSB1 --status
+    python3 tools/fwupdate.py --port /dev/ttyUSB1 --abort
+
+The image must be built with `make BOOTLOADER=1` (linked at 0x4000);
+--apply then resets the unit into the bootloader, which installs it.
+
+Requires: pyserial.
+"""
+
+from __future__ import annotations
+
+import argparse
+import re
+import struct
+import sys
+import time
+import zlib
+
+try:
+    import serial  # type: ignore
+except Exception:  # pragma: no cover
+    print("ERROR: pyserial is required. Try: pip3 install pyserial", file=sys.stderr)
+    raise
+
+CONSOLE_BAUD = 115200
+PROMPT = r"> (\x1b\[0m)?$"
+BLOCK = 1024
+REPLY_TIMEOUT = 2.0      # a block is programmed before the reply; a sector erase takes longer
+MAX_RETRIES = 10
+
+STATUS = {
+    b"K": "stored", b"C": "resend", b"S": "sequence", b"F": "flash error",
+    b"V": "verified", b"X": "verification failed",
+}
+
+
+def read_until(port: serial.Serial, pattern: str, timeout: float) -> str:
+    """Read console output until the regex matches; return everything read."""
+    buf = ""
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        chunk = port.read(port.in_waiting or 1)
+        if chunk:
+            buf += chunk.decode("ascii", "replace")
+            if re.search(pattern, buf):
+                return buf
+    raise RuntimeError(f"timeout waiting for {pattern!r}; got {buf[-200:]!r}")
+
+
+def command(port: serial.Serial, line: str, pattern: str = PROMPT, timeout: float = 3.0) -> str:
+    port.reset_input_buffer()
+    port.write(line.encode("ascii") + b"\r")
+    return read_until(port, pattern, timeout)
+
+
+def frame(kind: bytes, offset: int, data: bytes = b"") -> bytes:
+    body = kind + struct.pack("<IH", offset, len(data)) + data
+    return body + struct.pack("<I", zlib.crc32(body))
+
+
+def exchange(port: serial.Serial, pkt: bytes) -> tuple[bytes, int] | None:
+    port.write(pkt)
+    reply = port.read(5)
+    if len(reply) != 5:
+        return None
+    return reply[:1], struct.unpack("<I", reply[1:])[0]
+
+
+def open_session(dev: str) -> serial.Serial:
+    port = serial.Serial(dev, CONSOLE_BAUD, timeout=0.2)
+    port.dtr = True                      # the console only listens during a DTR session
+    time.sleep(0.5)                      # session banner
+    return port
+
+
+def transfer(port: serial.Serial, image: bytes, baud: int) -> None:
+    size, crc = len(image), zlib.crc32(image)
+    out = command(port, f"FWUPDATE BEGIN {size} {crc:08X} {baud}",
+                  r"FWUP READY \d+ \d+\r\n|ERROR[^\r]*\r\n", timeout=5.0)
+    m = re.search(r"FWUP READY (\d+) (\d+)", out)
+    if not m:
+        raise RuntimeError(out.strip().splitlines()[-1])
+    offset = int(m.group(1))
+    if offset:
+        print(f"resuming at {offset} of {size} bytes")
+
+    port.baudrate = baud
+    port.timeout = REPLY_TIMEOUT
+    time.sleep(0.05)                     # let the firmware switch too
+
+    t0 = time.monotonic()
+    sent = retries = 0
+    try:
+        while offset < size:
+            data = image[offset:offset + BLOCK]
+            r = exchange(port, frame(b"B", offset, data))
+            if r is None or r[0] == b"C":
+                retries += 1
+                if retries > MAX_RETRIES:
+                    raise RuntimeError(f"too many retries at offset {offset}")
+                # After a lost reply, wait out the firmware's frame gap so a
+                # late reply is not taken for the next one.
+                time.sleep(0.05 if r else 0.3)
+                port.reset_input_buffer()
+                continue
+            status, nxt = r
+            if status == b"K":
+                sent += len(data)
+                offset = nxt
+                print(f"\r{offset * 100 // size:3d}%  {offset}/{size}", end="", flush=True)
+            elif status == b"S":
+                offset = nxt
+            else:
+                raise RuntimeError(f"offset {offset}: {STATUS.get(status, status)}")
+
+        r = exchange(port, frame(b"E", offset))
+        print()
+        if r is None or r[0] != b"V":
+            raise RuntimeError("image " + (STATUS.get(r[0], "?") if r else "end: no reply"))
+    finally:
+        port.baudrate = CONSOLE_BAUD
+        port.timeout = 0.2
+
+    dt = time.monotonic() - t0
+    print(f"sent {sent} bytes in {dt:.2f} s ({sent / max(dt, 1e-6) / 1024:.1f} KB/s), "
+          f"{retries} retries; image verified (crc32 {crc:08X})")
+    read_until(port, PROMPT, 3.0)
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("image", nargs="?", help="raw binary (make BOOTLOADER=1 -> integr_V03.bin)")
+    ap.add_argument("--port", default="/dev/ttyUSB1")
+    ap.add_argument("--baud", type=int, default=921600, help="transfer baud rate (console stays 115200)")
+    ap.add_argument("--apply", action="store_true", help="install after a verified transfer (resets)")
+    ap.add_argument("--status", action="store_true", help="print FWUPDATE status and exit")
+    ap.add_argument("--abort", action="store_true", help="discard the staged image and exit")
+    args = ap.parse_args()
+
+    port = open_session(args.port)
+    try:
+        if args.status or args.abort:
+            print(command(port, "FWUPDATE ABORT" if args.abort else "FWUPDATE").strip())
+            return 0
+        if not args.image:
+            ap.error("image required")
+        with open(args.image, "rb") as f:
+            image = f.read()
+        transfer(port, image, args.baud)
+        if args.apply:
+            print(command(port, "FWUPDATE APPLY", r"OK:[^\r]*\r\n|ERROR[^\r]*\r\n", 10.0).strip())
+    except RuntimeError as e:
+        print(f"ERROR: {e}", file=sys.stderr)
+        return 1
+    finally:
+        port.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
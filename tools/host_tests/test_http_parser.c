@@ -0,0 +1,200 @@
+/*
+ * Host test: drivers/http.c incremental parser with header lines that do not
+ * fit HTTP_PARSER_LINE_SIZE, and Content-Length values that do not fit 32 bits. The parser is heap allocated so AddressSanitizer
+ * sees any write past pcLine[].
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+} while (0)
+
+typedef struct {
+    uint32_t headers;
+    uint32_t body_len;
+    uint32_t completes;
+    uint32_t errors;
+    uint32_t last_name_len;
+} events_t;
+
+static void on_event(void *pvCBData, uint32_t ui32Event, const char *pcData1, uint32_t ui32Len1,
+                     const char *pcData2, uint32_t ui32Len2)
+{
+    events_t *ev = (events_t *)pvCBData;
+
+    (void)pcData2;
+    (void)ui32Len2;
+    switch (ui32Event) {
+    case HTTP_PARSE_EVENT_HEADER:
+        ev->headers++;
+        ev->last_name_len = ui32Len1;
+        CHECK(strlen(pcData1) == ui32Len1);
+        break;
+    case HTTP_PARSE_EVENT_BODY:
+        ev->body_len += ui32Len1;
+        break;
+    case HTTP_PARSE_EVENT_COMPLETE:
+        ev->completes++;
+        break;
+    case HTTP_PARSE_EVENT_ERROR:
+        ev->errors++;
+        break;
+    default:
+        break;
+    }
+}
+
+/* A response with one header named name_len 'X's, then a framed body. */
+static void feed_long_name(uint32_t name_len, bool split, events_t *ev, uint32_t *flags)
+{
+    tHTTPParser *parser = malloc(sizeof(*parser));
+    char *msg = malloc(name_len + 128);
+    uint32_t len = 0;
+
+    memset(ev, 0, sizeof(*ev));
+    len += (uint32_t)sprintf(msg + len, "HTTP/1.1 200 OK\r\n");
+    memset(msg + len, 'X', name_len);
+    len += name_len;
+    len += (uint32_t)sprintf(msg + len, ": value\r\nContent-Length: 4\r\n\r\nbody");
+
+    HTTPParserInit(parser, on_event, ev);
+    if (split) {
+        /* One byte at a time, as from a slow peer. */
+        for (uint32_t i = 0; i < len; i++) {
+            HTTPParserFeed(parser, &msg[i], 1);
+        }
+    } else {
+        HTTPParserFeed(parser, msg, len);
+    }
+    *flags = HTTPParserFlagsGet(parser);
+
+    free(msg);
+    free(parser);
+}
+
+static void test_header_name_lengths(void)
+{
+    static const uint32_t lens[] = { 1, 125, 126, 127, 128, 200, 1000 };
+    events_t ev;
+    uint32_t flags;
+
+    for (uint32_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        for (int split = 0; split < 2; split++) {
+            feed_long_name(lens[i], split != 0, &ev, &flags);
+
+            /* The rest of the response still parses. */
+            CHECK(ev.errors == 0);
+            CHECK(ev.completes == 1);
+            CHECK(ev.body_len == 4);
+            if (lens[i] < HTTP_PARSER_LINE_SIZE - 1) {
+                /* Name and the Content-Length header both reported. */
+                CHECK(ev.headers == 2);
+            } else {
+                /* No room to split the name off: the line is skipped. */
+                CHECK(ev.headers == 1);
+                CHECK(ev.last_name_len == 14);
+                CHECK(flags & HTTP_PARSER_FLAG_TRUNCATED);
+            }
+        }
+    }
+}
+
+static void test_long_value(void)
+{
+    tHTTPParser *parser = malloc(sizeof(*parser));
+    char msg[512];
+    uint32_t len;
+    events_t ev;
+
+    memset(&ev, 0, sizeof(ev));
+    len = (uint32_t)sprintf(msg, "HTTP/1.1 200 OK\r\nName: ");
+    memset(msg + len, 'v', 300);
+    len += 300;
+    len += (uint32_t)sprintf(msg + len, "\r\nContent-Length: 0\r\n\r\n");
+
+    HTTPParserInit(parser, on_event, &ev);
+    HTTPParserFeed(parser, msg, len);
+    CHECK(ev.headers == 2);
+    CHECK(ev.completes == 1);
+    CHECK(HTTPParserFlagsGet(parser) & HTTP_PARSER_FLAG_TRUNCATED);
+    free(parser);
+}
+
+static void test_long_request_line(void)
+{
+    tHTTPParser *parser = malloc(sizeof(*parser));
+    char msg[512];
+    uint32_t len;
+    events_t ev;
+
+    memset(&ev, 0, sizeof(ev));
+    len = (uint32_t)sprintf(msg, "GET /");
+    memset(msg + len, 'p', 300);
+    len += 300;
+    len += (uint32_t)sprintf(msg + len, " HTTP/1.1\r\nHost: x\r\n\r\n");
+
+    /* The version falls off the end: a malformed request, not an overrun. */
+    HTTPParserRequestInit(parser, on_event, &ev);
+    HTTPParserFeed(parser, msg, len);
+    CHECK(ev.errors == 1);
+    CHECK(ev.completes == 0);
+    free(parser);
+}
+
+/* Content-Length v with a 4-byte body: errors and completes seen. */
+static void feed_length(const char *v, events_t *ev)
+{
+    tHTTPParser *parser = malloc(sizeof(*parser));
+    char msg[256];
+    uint32_t len;
+
+    memset(ev, 0, sizeof(*ev));
+    len = (uint32_t)sprintf(msg, "HTTP/1.1 200 OK\r\nContent-Length: %s\r\n\r\nbody", v);
+    HTTPParserInit(parser, on_event, ev);
+    HTTPParserFeed(parser, msg, len);
+    free(parser);
+}
+
+static void test_content_length_overflow(void)
+{
+    events_t ev;
+
+    /* Largest that fits: no error, the body is still being waited for. */
+    feed_length("4294967295", &ev);
+    CHECK(ev.errors == 0);
+    CHECK(ev.completes == 0);
+    CHECK(ev.body_len == 4);
+
+    /* 2^32 + 4 would wrap to 4 and complete; rejected instead. */
+    feed_length("4294967300", &ev);
+    CHECK(ev.errors == 1);
+    CHECK(ev.completes == 0);
+    CHECK(ev.body_len == 0);
+
+    feed_length("99999999999999999999", &ev);
+    CHECK(ev.errors == 1);
+    CHECK(ev.completes == 0);
+
+    feed_length("4", &ev);
+    CHECK(ev.errors == 0);
+    CHECK(ev.completes == 1);
+}
+
+int main(void)
+{
+    test_header_name_lengths();
+    test_long_value();
+    test_long_request_line();
+    test_content_length_overflow();
+
+    printf("%s: %s\n", __FILE__, g_failed ? "FAILED" : "ok");
+    return g_failed;
+}
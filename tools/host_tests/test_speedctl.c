@@ -0,0 +1,152 @@
+/*
+ * Host test: the stored feed-forward map is rebuilt at boot.
+ *
+ * main() calls speedctl_init() after config_store_init(); with a map in the
+ * config store that rebuilds the dense table before the scheduler starts,
+ * so anything that faults there reset-loops the board. speedctl.c is built
+ * here with -mgeneral-regs-only: the build fails if the map code needs the
+ * FPU again.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config_store.h"
+#include "speedctl.h"
+#include "sweep.h"
+#include "tach.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+} while (0)
+
+/* Same layout as the CONFIG_REC_SPEEDMAP record in speedctl.c. */
+typedef struct {
+    uint8_t count;
+    uint8_t reserved[3];
+    uint8_t duty[SPEED_MAP_MAX];
+    uint16_t rpm[SPEED_MAP_MAX];
+} map_rec_t;
+
+static map_rec_t g_stored;
+static bool g_have_stored = false;
+
+/* ---- Stubs ---------------------------------------------------------------- */
+
+bool config_store_read(config_rec_t id, void *data, uint32_t len)
+{
+    if (id != CONFIG_REC_SPEEDMAP || !g_have_stored || len != sizeof(g_stored)) return false;
+    memcpy(data, &g_stored, len);
+    return true;
+}
+
+bool config_store_write(config_rec_t id, const void *data, uint32_t len)
+{
+    (void)id; (void)data; (void)len;
+    return true;
+}
+
+void config_store_erase(config_rec_t id)
+{
+    (void)id;
+}
+
+static uint32_t g_duty = 50;
+static bool g_enabled = false;
+
+void pwm_set_percent(uint32_t percent) { g_duty = percent; }
+uint32_t pwm_get_percent_requested(void) { return g_duty; }
+void pwm_set_enabled(bool enabled) { g_enabled = enabled; }
+bool pwm_is_enabled(void) { return g_enabled; }
+bool tsyn_is_enabled(void) { return false; }
+bool sweep_is_running(void) { return false; }
+bool steptest_is_running(void) { return false; }
+bool sweep_get(uint32_t index, sweep_point_t *p) { (void)index; (void)p; return false; }
+
+void tach_get_snapshot(tach_snapshot_t *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+/* ---- Tests ---------------------------------------------------------------- */
+
+static void store(const uint8_t *duty, const uint16_t *rpm, uint8_t n)
+{
+    memset(&g_stored, 0, sizeof(g_stored));
+    g_stored.count = n;
+    memcpy(g_stored.duty, duty, n);
+    memcpy(g_stored.rpm, rpm, n * sizeof(rpm[0]));
+    g_have_stored = true;
+}
+
+static void test_boot_with_stored_map(void)
+{
+    static const uint8_t duty[] = { 10, 20, 30, 40, 50, 60, 80, 90 };
+    static const uint16_t rpm[] = { 400, 800, 1500, 1550, 2600, 3000, 3600, 3700 };
+    speed_point_t p;
+    int32_t prev = -1;
+
+    store(duty, rpm, 8);
+    speedctl_init();
+
+    CHECK(speedctl_map_get(7, &p) && p.duty == 90 && p.rpm == 3700);
+    CHECK(!speedctl_map_get(8, &p));
+
+    /* Through the points, within the table step (30 rpm here)... */
+    CHECK(speedctl_ff_q8(0) == 10 * 256);
+    CHECK(speedctl_ff_q8(1500) >= 29 * 256 && speedctl_ff_q8(1500) <= 31 * 256);
+    CHECK(speedctl_ff_q8(3700) >= 88 * 256 && speedctl_ff_q8(3700) <= 90 * 256);
+    CHECK(speedctl_ff_q8(60000) == 90 * 256);
+
+    /* ...and monotone between them: no overshoot anywhere. */
+    for (uint32_t r = 0; r <= 4000; r += 10) {
+        int32_t f = speedctl_ff_q8(r);
+
+        CHECK(f >= 10 * 256 && f <= 90 * 256);
+        CHECK(f >= prev);
+        prev = f;
+    }
+}
+
+static void test_boot_single_point(void)
+{
+    static const uint8_t duty[] = { 40 };
+    static const uint16_t rpm[] = { 2000 };
+
+    store(duty, rpm, 1);
+    speedctl_init();
+    CHECK(speedctl_ff_q8(0) == 40 * 256);
+    CHECK(speedctl_ff_q8(5000) == 40 * 256);
+}
+
+static void test_boot_without_map(void)
+{
+    g_have_stored = false;
+    speedctl_init();
+    CHECK(speedctl_ff_q8(1000) == -1);
+}
+
+static void test_boot_corrupt_count(void)
+{
+    static const uint8_t duty[] = { 40 };
+    static const uint16_t rpm[] = { 2000 };
+
+    store(duty, rpm, 1);
+    g_stored.count = SPEED_MAP_MAX + 1U;
+    speedctl_init();
+    CHECK(speedctl_ff_q8(1000) == -1);
+}
+
+int main(void)
+{
+    test_boot_with_stored_map();
+    test_boot_single_point();
+    test_boot_without_map();
+    test_boot_corrupt_count();
+
+    printf("%s: %s\n", __FILE__, g_failed ? "FAILED" : "ok");
+    return g_failed;
+}
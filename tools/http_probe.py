@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Exercise the firmware's HTTP server (net.c, drivers/http_server.c).
+
+Commands:
+
+    status              GET /status and pretty-print the JSON
+    psyn VALUE          POST /psyn (VALUE: 5..96, "on" or "off")
+    stream [-n COUNT]   GET /stream and print each chunked JSON line
+    check               status, an out-of-range psyn (expects 400), an unknown
+                        path (expects 404), a wrong method (expects 405) and
+                        three more requests on the same keep-alive connection
+
+Example:
+
+    python3 tools/http_probe.py --host 192.168.1.50 status
+    python3 tools/http_probe.py --host 192.168.1.50 psyn 44
+    python3 tools/http_probe.py --host 192.168.1.50 stream -n 10
+"""
+
+from __future__ import annotations
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def _conn(args: argparse.Namespace) -> http.client.HTTPConnection:
+    return http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+
+
+def _request(conn, method: str, path: str, body: str | None = None):
+    headers = {"Content-Type": "text/plain"} if body is not None else {}
+    t0 = time.monotonic()
+    conn.request(method, path, body=body, headers=headers)
+    resp = conn.getresponse()
+    data = resp.read()
+    return resp.status, data, (time.monotonic() - t0) * 1000.0
+
+
+def cmd_status(args: argparse.Namespace) -> int:
+    status, data, ms = _request(_conn(args), "GET", "/status")
+    print(f"{status} ({ms:.1f} ms)")
+    print(json.dumps(json.loads(data), indent=2))
+    return 0 if status == 200 else 1
+
+
+def cmd_psyn(args: argparse.Namespace) -> int:
+    status, data, ms = _request(_conn(args), "POST", "/psyn", args.value)
+    print(f"{status} ({ms:.1f} ms) {data.decode().strip()}")
+    return 0 if status == 200 else 1
+
+
+def cmd_stream(args: argparse.Namespace) -> int:
+    conn = _conn(args)
+    conn.request("GET", "/stream")
+    resp = conn.getresponse()
+    if resp.status != 200:
+        print(f"unexpected status {resp.status}")
+        return 1
+    print(f"Transfer-Encoding: {resp.getheader('Transfer-Encoding')}")
+    count = 0
+    try:
+        # http.client removes the chunk framing; each chunk is one JSON line.
+        while args.count == 0 or count < args.count:
+            line = resp.readline()
+            if not line:
+                break
+            sample = json.loads(line)
+            print(f"{time.strftime('%H:%M:%S')} {sample}")
+            count += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        conn.close()
+    return 0
+
+
+def cmd_check(args: argparse.Namespace) -> int:
+    failures = 0
+
+    def expect(what: str, got: int, want: int) -> None:
+        nonlocal failures
+        ok = got == want
+        failures += 0 if ok else 1
+        print(f"{'ok  ' if ok else 'FAIL'} {what}: {got} (expected {want})")
+
+    conn = _conn(args)
+    status, data, _ = _request(conn, "GET", "/status")
+    expect("GET /status", status, 200)
+    json.loads(data)
+    status, _, _ = _request(conn, "POST", "/psyn", "200")
+    expect("POST /psyn 200 (out of range)", status, 400)
+    status, _, _ = _request(conn, "GET", "/nope")
+    expect("GET /nope", status, 404)
+    status, _, _ = _request(conn, "POST", "/status", "")
+    expect("POST /status", status, 405)
+
+    times = []
+    for _ in range(3):
+        status, _, ms = _request(conn, "GET", "/status")
+        expect("keep-alive GET /status", status, 200)
+        times.append(ms)
+    conn.close()
+    print("keep-alive latency ms: " + ", ".join(f"{t:.1f}" for t in times))
+    return 1 if failures else 0
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--timeout", type=float, default=5.0)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("status").set_defaults(func=cmd_status)
+    p = sub.add_parser("psyn")
+    p.add_argument("value")
+    p.set_defaults(func=cmd_psyn)
+    p = sub.add_parser("stream")
+    p.add_argument("-n", "--count", type=int, default=0, help="stop after COUNT lines (0: forever)")
+    p.set_defaults(func=cmd_stream)
+    sub.add_parser("check").set_defaults(func=cmd_check)
+    args = ap.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Minimal Modbus RTU master for the firmware's UART3 slave (modbus.c).
+
+Reads or writes registers and prints the reply time (last request byte
+written to last reply byte read; includes USB-serial latency, so it is an
+upper bound on the firmware's turnaround, which `MODBUS` reports itself).
+
+Example:
+
+    python3 tools/modbus_rtu.py --port /dev/ttyUSB1 input 0 11
+    python3 tools/modbus_rtu.py --port /dev/ttyUSB1 holding 0 6
+    python3 tools/modbus_rtu.py --port /dev/ttyUSB1 write 0 44
+    python3 tools/modbus_rtu.py --port /dev/ttyUSB1 write 2 1500 1 40
+    python3 tools/modbus_rtu.py --port /dev/ttyUSB1 poll --count 100
+
+Requires: pyserial.
+"""
+
+from __future__ import annotations
+
+import argparse
+import struct
+import sys
+import time
+
+try:
+    import serial  # type: ignore
+except Exception:  # pragma: no cover
+    print("ERROR: pyserial is required. Try: pip3 install pyserial", file=sys.stderr)
+    raise
+
+INPUT_NAMES = [
+    "rpm", "period_us", "pulses_hi", "pulses_lo", "rejects_hi", "rejects_lo",
+    "burst_pulses", "burst_tail_us", "bursts_hi", "bursts_lo", "alarms",
+]
+HOLDING_NAMES = [
+    "duty_pct", "pwm_enable", "rpm_setpoint", "tsyn_enable", "tsyn_profile", "modbus_mode",
+]
+EXCEPTIONS = {1: "illegal function", 2: "illegal data address", 3: "illegal data value"}
+
+
+def crc16(data: bytes) -> int:
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def transact(port: serial.Serial, pdu: bytes, addr: int, expect: int) -> tuple[bytes, float]:
+    """Send addr+pdu+crc; return (reply pdu, seconds) or raise on error."""
+    frame = bytes([addr]) + pdu
+    frame += struct.pack("<H", crc16(frame))
+    port.reset_input_buffer()
+    port.write(frame)
+    port.flush()
+    t0 = time.perf_counter()
+
+    reply = port.read(3)
+    if len(reply) == 3 and reply[1] & 0x80:
+        reply += port.read(2)
+    else:
+        reply += port.read(expect + 3 - len(reply))
+    elapsed = time.perf_counter() - t0
+
+    if len(reply) < 5:
+        raise RuntimeError(f"timeout ({len(reply)} bytes)")
+    if crc16(reply) != 0:
+        raise RuntimeError("bad CRC in reply: " + reply.hex(" "))
+    if reply[1] & 0x80:
+        raise RuntimeError(f"exception {reply[2]} ({EXCEPTIONS.get(reply[2], '?')})")
+    return reply[1:-2], elapsed
+
+
+def read_regs(port, addr, fc, start, count):
+    pdu, dt = transact(port, struct.pack(">BHH", fc, start, count), addr, 2 + 2 * count)
+    return list(struct.unpack(f">{count}H", pdu[2:])), dt
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port", default="/dev/ttyUSB1")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--addr", type=int, default=1)
+    ap.add_argument("--timeout", type=float, default=0.2)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    for name in ("input", "holding"):
+        p = sub.add_parser(name)
+        p.add_argument("start", type=int, nargs="?", default=0)
+        p.add_argument("count", type=int, nargs="?",
+                       default=len(INPUT_NAMES if name == "input" else HOLDING_NAMES))
+    p = sub.add_parser("write", help="write one (FC 06) or several (FC 16) holding registers")
+    p.add_argument("start", type=int)
+    p.add_argument("values", type=int, nargs="+")
+    p = sub.add_parser("poll", help="read all input registers repeatedly, report timing")
+    p.add_argument("--count", type=int, default=50)
+    args = ap.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=args.timeout) as port:
+        if args.cmd in ("input", "holding"):
+            fc = 4 if args.cmd == "input" else 3
+            names = INPUT_NAMES if fc == 4 else HOLDING_NAMES
+            regs, dt = read_regs(port, args.addr, fc, args.start, args.count)
+            for i, v in enumerate(regs):
+                idx = args.start + i
+                label = names[idx] if idx < len(names) else "?"
+                print(f"{idx:3d} {label:14s} {v}")
+            print(f"reply in {dt * 1000:.2f} ms")
+        elif args.cmd == "write":
+            if len(args.values) == 1:
+                pdu = struct.pack(">BHH", 6, args.start, args.values[0])
+            else:
+                n = len(args.values)
+                pdu = struct.pack(f">BHHB{n}H", 16, args.start, n, 2 * n, *args.values)
+            _, dt = transact(port, pdu, args.addr, 5)
+            print(f"OK, reply in {dt * 1000:.2f} ms")
+        else:
+            times = []
+            errors = 0
+            for _ in range(args.count):
+                try:
+                    _, dt = read_regs(port, args.addr, 4, 0, len(INPUT_NAMES))
+                    times.append(dt)
+                except RuntimeError as exc:
+                    errors += 1
+                    print("error:", exc)
+            if times:
+                times.sort()
+                print(f"{len(times)} ok, {errors} errors; reply ms min {times[0] * 1000:.2f} "
+                      f"median {times[len(times) // 2] * 1000:.2f} max {times[-1] * 1000:.2f}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
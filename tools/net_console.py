@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Talk to the firmware's TCP command console (net_console.c, port 23).
+
+Without -c the console is interactive (stdin lines are sent, output printed).
+With -c each command is sent in turn and its reply printed, and with
+--sessions N the same commands run on N concurrent connections, each
+reporting the round-trip time per command.
+
+Example:
+
+    python3 tools/net_console.py --host 192.168.1.50
+    python3 tools/net_console.py --host 192.168.1.50 -c "PSYN 44" -c HELP
+    python3 tools/net_console.py --host 192.168.1.50 --sessions 3 -c "PSYN 50"
+"""
+
+from __future__ import annotations
+
+import argparse
+import re
+import socket
+import sys
+import threading
+import time
+
+PROMPT = b"> "
+ANSI = re.compile(rb"\x1b\[[0-9;]*m")
+
+
+def _read_until_prompt(sock: socket.socket, timeout: float) -> bytes:
+    sock.settimeout(timeout)
+    data = b""
+    while True:
+        chunk = sock.recv(1024)
+        if not chunk:
+            return data
+        data += chunk
+        if ANSI.sub(b"", data).endswith(PROMPT):
+            return data
+
+
+def _text(data: bytes) -> str:
+    text = ANSI.sub(b"", data).decode(errors="replace").replace("\r\n", "\n")
+    if text.endswith(PROMPT.decode()):
+        text = text[: -len(PROMPT)]
+    return text.strip("\n")
+
+
+def run_commands(args: argparse.Namespace, tag: str, results: list) -> None:
+    try:
+        with socket.create_connection((args.host, args.port), timeout=args.timeout) as sock:
+            _read_until_prompt(sock, args.timeout)  # welcome banner
+            for cmd in args.command:
+                t0 = time.monotonic()
+                sock.sendall(cmd.encode() + b"\r\n")
+                reply = _read_until_prompt(sock, args.timeout)
+                ms = (time.monotonic() - t0) * 1000.0
+                results.append(f"{tag}{cmd!r} ({ms:.1f} ms)\n{_text(reply)}")
+            sock.sendall(b"EXIT\r\n")
+    except OSError as exc:
+        results.append(f"{tag}error: {exc}")
+
+
+def cmd_batch(args: argparse.Namespace) -> int:
+    results: list[str] = []
+    if args.sessions <= 1:
+        run_commands(args, "", results)
+    else:
+        threads = [
+            threading.Thread(target=run_commands, args=(args, f"[{i}] ", results))
+            for i in range(args.sessions)
+        ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    for r in results:
+        print(r)
+    return 1 if any("error:" in r for r in results) else 0
+
+
+def cmd_interactive(args: argparse.Namespace) -> int:
+    sock = socket.create_connection((args.host, args.port), timeout=args.timeout)
+    sock.settimeout(None)
+
+    def reader() -> None:
+        while True:
+            data = sock.recv(1024)
+            if not data:
+                print("\n[connection closed]")
+                return
+            sys.stdout.write(data.decode(errors="replace"))
+            sys.stdout.flush()
+
+    t = threading.Thread(target=reader, daemon=True)
+    t.start()
+    try:
+        for line in sys.stdin:
+            sock.sendall(line.rstrip("\r\n").encode() + b"\r\n")
+            if not t.is_alive():
+                break
+    except (KeyboardInterrupt, OSError):
+        pass
+    finally:
+        sock.close()
+    return 0
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", required=True)
+    ap.add_argument("--port", type=int, default=23)
+    ap.add_argument("--timeout", type=float, default=5.0)
+    ap.add_argument("-c", "--command", action="append", default=[], help="command to send (repeatable)")
+    ap.add_argument("--sessions", type=int, default=1, help="run the commands on N concurrent sessions")
+    args = ap.parse_args()
+    if args.command:
+        return cmd_batch(args)
+    return cmd_interactive(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -13,6 +13,7 @@
 #include "driverlib/timer.h"
 
 #include "commands.h" /* pwm_get_percent_requested() */
+#include "seqlock.h"
 #include "tach.h"     /* tach_set_capture_enabled() */
 
 /* Based on lab notes in LEEME_MOSA_TACH_ANALYSIS.TXT (2026-01-10). */
@@ -63,9 +64,15 @@ static volatile tsyn_state_t g_state = TSYN_STATE_OFF;
 
 static uint32_t g_sysclk_hz = 0;
 static uint32_t g_pwm_period_cycles = 0;
+static bool g_timers_ready = false;
 
-static uint32_t g_curr_pulses = 0;
-static uint32_t g_curr_tail_us = 0;
+/* Current burst, published by Timer4AIntHandler for tsyn_get_burst(). */
+static seqlock_t g_burst_lock = SEQLOCK_INIT;
+static volatile uint32_t g_curr_pulses = 0;
+static volatile uint32_t g_curr_tail_us = 0;
+static volatile uint32_t g_bursts_total = 0;
+
+static volatile uint32_t g_profile_n = 0;
 
 static void tsyn_interpolate_from_psyn(uint32_t psyn_n, uint32_t *pulses_out, uint32_t *tail_us_out)
 {
@@ -149,8 +156,16 @@ static void tsyn_schedule_cycles(uint32_t cycles)
 
 static void tsyn_start_pulse_burst(void)
 {
-    uint32_t psyn_n = pwm_get_percent_requested();
-    tsyn_interpolate_from_psyn(psyn_n, &g_curr_pulses, &g_curr_tail_us);
+    uint32_t psyn_n = g_profile_n ? g_profile_n : pwm_get_percent_requested();
+    uint32_t pulses;
+    uint32_t tail_us;
+
+    tsyn_interpolate_from_psyn(psyn_n, &pulses, &tail_us);
+    seqlock_write_begin(&g_burst_lock);
+    g_curr_pulses = pulses;
+    g_curr_tail_us = tail_us;
+    g_bursts_total++;
+    seqlock_write_end(&g_burst_lock);
 
     /* Switch PM3 to timer output and enable the 21.5kHz carrier. */
     pm3_set_timer_pwm();
@@ -196,13 +211,10 @@ void Timer4AIntHandler(void)
     tsyn_start_pulse_burst();
 }
 
-void tsyn_init(uint32_t sysclk_hz)
+/* Timer3B carrier + Timer4A scheduler; deferred to the first TSYN ON so
+   that boot does not wait for two timers it rarely needs. */
+static void tsyn_timers_init(void)
 {
-    g_sysclk_hz = sysclk_hz;
-
-    SysCtlPeripheralEnable(TSYN_GPIO_PERIPH);
-    while (!SysCtlPeripheralReady(TSYN_GPIO_PERIPH)) { }
-
     SysCtlPeripheralEnable(TSYN_PWM_TIMER_PERIPH);
     while (!SysCtlPeripheralReady(TSYN_PWM_TIMER_PERIPH)) { }
 
@@ -227,6 +239,18 @@ void tsyn_init(uint32_t sysclk_hz)
     TimerIntClear(TSYN_SCHED_TIMER_BASE, TIMER_TIMA_TIMEOUT);
     TimerIntEnable(TSYN_SCHED_TIMER_BASE, TIMER_TIMA_TIMEOUT);
 
+    g_timers_ready = true;
+}
+
+void tsyn_init(uint32_t sysclk_hz)
+{
+    g_sysclk_hz = sysclk_hz;
+
+    SysCtlPeripheralEnable(TSYN_GPIO_PERIPH);
+    while (!SysCtlPeripheralReady(TSYN_GPIO_PERIPH)) { }
+
+    /* Registered here rather than on first use: IntRegister() may have to
+       move the vector table to SRAM, which is best done at boot. */
     IntRegister(TSYN_SCHED_INT, Timer4AIntHandler);
     /* Keep IRQ disabled until TSYN is explicitly enabled. */
     IntDisable(TSYN_SCHED_INT);
@@ -243,6 +267,10 @@ void tsyn_set_enabled(bool enabled)
     if (enabled) {
         if (g_tsyn_enabled) return;
 
+        if (!g_timers_ready) {
+            tsyn_timers_init();
+        }
+
         /* Avoid race with a pending Timer4A timeout. */
         IntDisable(TSYN_SCHED_INT);
         TimerDisable(TSYN_SCHED_TIMER_BASE, TIMER_A);
@@ -255,8 +283,10 @@ void tsyn_set_enabled(bool enabled)
 
         /* Start in tail->pulses transition immediately. */
         g_state = TSYN_STATE_TAIL;
+        seqlock_write_begin(&g_burst_lock);
         g_curr_pulses = 0;
         g_curr_tail_us = 1;
+        seqlock_write_end(&g_burst_lock);
 
         IntEnable(TSYN_SCHED_INT);
         tsyn_schedule_cycles(1);
@@ -284,3 +314,28 @@ bool tsyn_is_enabled(void)
 {
     return g_tsyn_enabled;
 }
+
+void tsyn_set_profile(uint32_t n)
+{
+    g_profile_n = n;
+}
+
+uint32_t tsyn_get_profile(void)
+{
+    return g_profile_n;
+}
+
+void tsyn_get_burst(tsyn_burst_t *out)
+{
+    if (!out) return;
+
+    bool enabled = g_tsyn_enabled;
+    uint32_t seq;
+
+    do {
+        seq = seqlock_read_begin(&g_burst_lock);
+        out->pulses_per_burst = enabled ? g_curr_pulses : 0U;
+        out->tail_us = enabled ? g_curr_tail_us : 0U;
+        out->bursts_total = g_bursts_total;
+    } while (seqlock_read_retry(&g_burst_lock, seq));
+}
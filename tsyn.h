@@ -17,4 +17,22 @@ void tsyn_init(uint32_t sysclk_hz);
 void tsyn_set_enabled(bool enabled);
 bool tsyn_is_enabled(void);
 
+/*
+ * Burst shape source: 0 (default) follows the applied PSYN n; a value in
+ * PSYN_MIN..PSYN_MAX pins the shape to that n regardless of PSYN. Takes
+ * effect at the next burst.
+ */
+void tsyn_set_profile(uint32_t n);
+uint32_t tsyn_get_profile(void);
+
+/* Shape of the burst being generated (0/0 while TSYN is off) and a free
+   running count of bursts started. Safe to call from interrupt handlers. */
+typedef struct {
+    uint32_t pulses_per_burst;
+    uint32_t tail_us;
+    uint32_t bursts_total;
+} tsyn_burst_t;
+
+void tsyn_get_burst(tsyn_burst_t *out);
+
 #endif /* TSYN_H */
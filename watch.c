@@ -0,0 +1,309 @@
+#include "watch.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "commands.h"       /* pwm_get_percent_requested(), pwm_is_enabled() */
+#include "modbus.h"
+#include "sched.h"
+#include "tach.h"
+#include "timebase.h"
+#include "tsyn.h"
+
+/* Full redraw is ~600 bytes; a refresh is much less. */
+#define WATCH_FRAME_MAX     768U
+#define WATCH_FIELD_MAX     10U
+
+/* Row the cursor is left on when the watch stops (below the dashboard). */
+#define WATCH_END_ROW       11U
+
+/* Value columns (1-based). */
+#define C1  17U
+#define C2  34U
+#define C3  54U
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    const char *text;
+} watch_label_t;
+
+static const watch_label_t g_labels[] = {
+    { 1,  1, "FAN CONTROL WATCH   (any key stops)" },
+    { 3,  1, "PWM" },     { 3, 10, "duty %" },  { 3, 26, "output" },
+    { 4,  1, "Tach" },    { 4, 10, "rpm" },     { 4, 26, "pulses" },   { 4, 46, "rejects" },
+    { 5,  1, "TSYN" },    { 5, 10, "state" },   { 5, 26, "pulses" },   { 5, 46, "tail us" },
+                                                { 6, 26, "bursts" },
+    { 7,  1, "CPU" },     { 7, 10, "load %" },  { 7, 26, "uptime s" },
+    { 9,  1, "Refresh" }, { 9, 10, "ms" },      { 9, 26, "bytes" },    { 9, 46, "full" },
+};
+
+typedef enum {
+    W_DUTY = 0,
+    W_PWM,
+    W_RPM,
+    W_PULSES,
+    W_REJECTS,
+    W_TSYN,
+    W_BURST_PULSES,
+    W_TAIL_US,
+    W_BURSTS,
+    W_LOAD,
+    W_UPTIME,
+    W_PERIOD,
+    W_BYTES,
+    W_FULL,
+    W_COUNT
+} watch_field_t;
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    uint8_t width;
+} watch_pos_t;
+
+static const watch_pos_t g_pos[W_COUNT] = {
+    [W_DUTY]         = { 3, C1,  7 },
+    [W_PWM]          = { 3, C2, 10 },
+    [W_RPM]          = { 4, C1,  7 },
+    [W_PULSES]       = { 4, C2, 10 },
+    [W_REJECTS]      = { 4, C3, 10 },
+    [W_TSYN]         = { 5, C1,  7 },
+    [W_BURST_PULSES] = { 5, C2, 10 },
+    [W_TAIL_US]      = { 5, C3, 10 },
+    [W_BURSTS]       = { 6, C2, 10 },
+    [W_LOAD]         = { 7, C1,  7 },
+    [W_UPTIME]       = { 7, C2, 10 },
+    [W_PERIOD]       = { 9, C1,  7 },
+    [W_BYTES]        = { 9, C2, 10 },
+    [W_FULL]         = { 9, C3, 10 },
+};
+
+static console_t *g_watch = 0;
+static uint32_t g_period_ms = WATCH_DEFAULT_MS;
+static uint32_t g_last_ms = 0;
+static bool g_redraw = false;
+static uint32_t g_last_bytes = 0;
+static uint32_t g_full_bytes = 0;
+
+/* What the terminal shows now, per field. */
+static char g_shown[W_COUNT][WATCH_FIELD_MAX];
+
+static char g_frame[WATCH_FRAME_MAX + 1U];
+static uint32_t g_frame_len = 0;
+
+/* ---- Frame buffer -------------------------------------------------------- */
+
+static void frame_putc(char ch)
+{
+    if (g_frame_len < WATCH_FRAME_MAX) {
+        g_frame[g_frame_len++] = ch;
+    }
+}
+
+static void frame_puts(const char *s)
+{
+    while (*s) {
+        frame_putc(*s++);
+    }
+}
+
+static void frame_put_u32(uint32_t v)
+{
+    char tmp[10];
+    uint32_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + (v % 10U));
+        v /= 10U;
+    } while (v != 0U);
+
+    while (n > 0U) {
+        frame_putc(tmp[--n]);
+    }
+}
+
+/* CSI row;col H */
+static void frame_goto(uint32_t row, uint32_t col)
+{
+    frame_puts("\x1B[");
+    frame_put_u32(row);
+    frame_putc(';');
+    frame_put_u32(col);
+    frame_putc('H');
+}
+
+/* ---- Field values -------------------------------------------------------- */
+
+static void fmt_right(char *dst, uint32_t width, const char *s)
+{
+    uint32_t len = (uint32_t)strlen(s);
+
+    if (len > width) len = width;
+    memset(dst, ' ', width - len);
+    memcpy(dst + (width - len), s, len);
+}
+
+static void fmt_u32(char *dst, uint32_t width, uint32_t v)
+{
+    char tmp[11];
+    uint32_t n = sizeof(tmp) - 1U;
+
+    tmp[n] = '\0';
+    do {
+        tmp[--n] = (char)('0' + (v % 10U));
+        v /= 10U;
+    } while (v != 0U && n > 0U);
+
+    fmt_right(dst, width, &tmp[n]);
+}
+
+static void watch_format(char val[W_COUNT][WATCH_FIELD_MAX])
+{
+    tach_snapshot_t tach;
+    tsyn_burst_t burst;
+    bool tsyn_on = tsyn_is_enabled();
+
+    tach_get_snapshot(&tach);
+    tsyn_get_burst(&burst);
+
+    fmt_u32(val[W_DUTY], g_pos[W_DUTY].width, pwm_get_percent_requested());
+    fmt_right(val[W_PWM], g_pos[W_PWM].width, pwm_is_enabled() ? "on" : "off");
+    fmt_u32(val[W_RPM], g_pos[W_RPM].width, tach.rpm);
+    fmt_u32(val[W_PULSES], g_pos[W_PULSES].width, tach.pulses_total);
+    fmt_u32(val[W_REJECTS], g_pos[W_REJECTS].width, tach.rejects_total);
+    fmt_right(val[W_TSYN], g_pos[W_TSYN].width, tsyn_on ? "on" : "off");
+    fmt_u32(val[W_BURST_PULSES], g_pos[W_BURST_PULSES].width, burst.pulses_per_burst);
+    fmt_u32(val[W_TAIL_US], g_pos[W_TAIL_US].width, burst.tail_us);
+    fmt_u32(val[W_BURSTS], g_pos[W_BURSTS].width, burst.bursts_total);
+    fmt_u32(val[W_LOAD], g_pos[W_LOAD].width, sched_cpu_load_pct());
+    fmt_u32(val[W_UPTIME], g_pos[W_UPTIME].width, timebase_millis() / 1000U);
+    fmt_u32(val[W_PERIOD], g_pos[W_PERIOD].width, g_period_ms);
+    fmt_u32(val[W_BYTES], g_pos[W_BYTES].width, g_last_bytes);
+    fmt_u32(val[W_FULL], g_pos[W_FULL].width, g_full_bytes);
+}
+
+/* ---- Refresh ------------------------------------------------------------- */
+
+static void watch_refresh(console_t *c)
+{
+    char val[W_COUNT][WATCH_FIELD_MAX];
+
+    g_frame_len = 0;
+
+    if (g_redraw) {
+        /* Hide the cursor, clear, draw the labels. */
+        frame_puts("\x1B[?25l\x1B[2J");
+        for (uint32_t i = 0; i < sizeof(g_labels) / sizeof(g_labels[0]); i++) {
+            frame_goto(g_labels[i].row, g_labels[i].col);
+            frame_puts(g_labels[i].text);
+        }
+        memset(g_shown, 0, sizeof(g_shown));
+    }
+
+    watch_format(val);
+
+    /* Per field, send only the span from the first to the last changed
+       character; a digit ticking over costs one cursor move and one byte. */
+    for (uint32_t f = 0; f < W_COUNT; f++) {
+        uint32_t w = g_pos[f].width;
+        uint32_t first = 0;
+        uint32_t last = w;
+
+        while (first < w && val[f][first] == g_shown[f][first]) first++;
+        if (first == w) {
+            continue;
+        }
+        while (last > first && val[f][last - 1U] == g_shown[f][last - 1U]) last--;
+
+        frame_goto(g_pos[f].row, g_pos[f].col + first);
+        for (uint32_t i = first; i < last; i++) {
+            frame_putc(val[f][i]);
+        }
+        memcpy(g_shown[f], val[f], w);
+    }
+
+    if (g_frame_len == 0U) {
+        return;
+    }
+
+    g_frame[g_frame_len] = '\0';
+    console_puts(c, g_frame);
+
+    g_last_bytes = g_frame_len;
+    if (g_redraw) {
+        g_full_bytes = g_frame_len;
+        g_redraw = false;
+    }
+}
+
+static void watch_finish(console_t *c, bool restore)
+{
+    g_watch = 0;
+    c->busy = false;
+
+    if (restore) {
+        g_frame_len = 0;
+        frame_puts("\x1B[?25h");
+        frame_goto(WATCH_END_ROW, 1U);
+        frame_puts("WATCH stopped\r\n");
+        g_frame[g_frame_len] = '\0';
+        console_puts(c, g_frame);
+        console_prompt_force_next(c);
+        console_prompt_once(c);
+    }
+}
+
+bool watch_start(console_t *c, uint32_t period_ms)
+{
+    if (g_watch && g_watch != c) {
+        return false;
+    }
+
+    if (period_ms < WATCH_MIN_MS) period_ms = WATCH_MIN_MS;
+    g_period_ms = period_ms;
+    g_redraw = true;
+    g_last_bytes = 0;
+    g_last_ms = timebase_millis() - period_ms;
+
+    c->busy = true;
+    g_watch = c;
+    return true;
+}
+
+bool watch_is_active(void)
+{
+    return g_watch != 0;
+}
+
+void watch_task(void)
+{
+    console_t *c = g_watch;
+    uint32_t now;
+
+    if (!c) return;
+
+    /* Stopped by a key (console_rx()) or the end of the session. */
+    if (!c->busy) {
+        watch_finish(c, true);
+        return;
+    }
+    /* UART3 handed over to Modbus: nothing left to draw on. */
+    if (c->dev == UARTDEV_USER && modbus_is_enabled()) {
+        watch_finish(c, false);
+        return;
+    }
+
+    now = timebase_millis();
+    if ((uint32_t)(now - g_last_ms) < g_period_ms) {
+        return;
+    }
+    /* Never queue frames behind each other: skip while one is going out. */
+    if (!uart_tx_idle(c->dev)) {
+        return;
+    }
+    g_last_ms = now;
+    watch_refresh(c);
+}
@@ -0,0 +1,33 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "console.h"
+
+/*
+ * Live ANSI dashboard (WATCH command) on a UART console: duty, RPM, tach
+ * counters, TSYN burst, CPU load. The labels are drawn once; each refresh
+ * sends only a cursor move plus the changed characters of each field, so a
+ * typical refresh is a few dozen bytes instead of a full screen.
+ *
+ * Any key on the watching console stops it and returns to the prompt.
+ */
+#ifndef WATCH_DEFAULT_MS
+#define WATCH_DEFAULT_MS    100U
+#endif
+#ifndef WATCH_MIN_MS
+#define WATCH_MIN_MS        20U
+#endif
+
+/* Start watching on c (one console at a time), refreshing every period_ms.
+   False if another console is already watching. */
+bool watch_start(console_t *c, uint32_t period_ms);
+
+bool watch_is_active(void);
+
+/* Scheduler task: refreshes when due and the previous frame has drained. */
+void watch_task(void);
+
+#endif /* WATCH_H */